@@ -0,0 +1,398 @@
+/*
+	grive-fuse: mount Google Drive with grive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#define FUSE_USE_VERSION 31
+
+#include "util/Config.hh"
+
+#include "base/DriveView.hh"
+#include "drive2/Syncer2.hh"
+#include "drive3/Syncer3.hh"
+
+#include "http/CurlAgent.hh"
+#include "protocol/AuthAgent.hh"
+#include "protocol/OAuth2.hh"
+#include "json/Val.hh"
+
+#include "util/Exception.hh"
+#include "util/log/Log.hh"
+#include "util/log/CompositeLog.hh"
+#include "util/log/DefaultLog.hh"
+
+#include <boost/exception/all.hpp>
+#include <boost/program_options.hpp>
+
+#include <gcrypt.h>
+#include <fuse.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+using namespace gr ;
+namespace po = boost::program_options;
+
+namespace
+{
+	DriveView *view = 0 ;
+
+	void InitGCrypt()
+	{
+		if ( !gcry_check_version(GCRYPT_VERSION) )
+			throw std::runtime_error( "libgcrypt version mismatch" ) ;
+		gcry_control(GCRYCTL_DISABLE_SECMEM, 0);
+		gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+	}
+
+	void InitLog( const po::variables_map& vm )
+	{
+		std::unique_ptr<log::CompositeLog> comp_log( new log::CompositeLog ) ;
+		std::unique_ptr<LogBase> def_log( new log::DefaultLog );
+		LogBase* console_log = comp_log->Add( def_log ) ;
+
+		if ( vm.count( "log" ) )
+		{
+			std::unique_ptr<LogBase> file_log( new log::DefaultLog( vm["log"].as<std::string>() ) ) ;
+			file_log->Enable( log::debug ) ;
+			file_log->Enable( log::verbose ) ;
+			file_log->Enable( log::info ) ;
+			file_log->Enable( log::warning ) ;
+			file_log->Enable( log::error ) ;
+			file_log->Enable( log::critical ) ;
+			comp_log->Add( file_log ) ;
+		}
+
+		if ( vm.count( "verbose" ) )
+			console_log->Enable( log::verbose ) ;
+		if ( vm.count( "debug" ) )
+		{
+			console_log->Enable( log::verbose ) ;
+			console_log->Enable( log::debug ) ;
+		}
+		LogBase::Inst( comp_log.release() ) ;
+	}
+
+	// turn exceptions into error codes at the FUSE boundary
+	template <typename F>
+	int Guard( const char *op, const char *path, F f )
+	{
+		try
+		{
+			return f() ;
+		}
+		catch ( Exception& e )
+		{
+			Log( "%1% %2% failed: %3%", op, path, boost::diagnostic_information(e), log::error ) ;
+		}
+		catch ( std::exception& e )
+		{
+			Log( "%1% %2% failed: %3%", op, path, e.what(), log::error ) ;
+		}
+		return -EIO ;
+	}
+
+	void* Init( fuse_conn_info*, fuse_config *cfg )
+	{
+		// the tree is read before the first request is served
+		cfg->kernel_cache = 1 ;
+		Log( "Reading remote server file list", log::info ) ;
+		view->Load() ;
+		Log( "Ready", log::info ) ;
+		return 0 ;
+	}
+
+	int GetAttr( const char *path, struct stat *st, fuse_file_info* )
+	{
+		return Guard( "getattr", path, [=]() -> int
+		{
+			DriveView::Attr attr ;
+			if ( !view->GetAttr( path, attr ) )
+				return -ENOENT ;
+
+			std::memset( st, 0, sizeof(*st) ) ;
+			st->st_mode		= attr.is_dir ? ( S_IFDIR | 0755 ) : ( S_IFREG | ( attr.editable ? 0644 : 0444 ) ) ;
+			st->st_nlink	= attr.is_dir ? 2 : 1 ;
+			st->st_size		= attr.size ;
+			st->st_uid		= ::getuid() ;
+			st->st_gid		= ::getgid() ;
+			st->st_mtim.tv_sec	= attr.mtime.Sec() ;
+			st->st_mtim.tv_nsec	= attr.mtime.NanoSec() ;
+			st->st_atim		= st->st_mtim ;
+			st->st_ctim		= st->st_mtim ;
+			return 0 ;
+		} ) ;
+	}
+
+	int ReadDir( const char *path, void *buf, fuse_fill_dir_t filler, off_t, fuse_file_info*, fuse_readdir_flags )
+	{
+		return Guard( "readdir", path, [=]() -> int
+		{
+			std::vector<std::string> names ;
+			if ( !view->List( path, names ) )
+				return -ENOENT ;
+
+			filler( buf, ".", 0, 0, fuse_fill_dir_flags() ) ;
+			filler( buf, "..", 0, 0, fuse_fill_dir_flags() ) ;
+			for ( std::size_t i = 0 ; i < names.size() ; i++ )
+				filler( buf, names[i].c_str(), 0, 0, fuse_fill_dir_flags() ) ;
+			return 0 ;
+		} ) ;
+	}
+
+	int Open( const char *path, fuse_file_info *fi )
+	{
+		return Guard( "open", path, [=]() -> int
+		{
+			// read-only opens don't need a local copy
+			if ( ( fi->flags & O_ACCMODE ) == O_RDONLY )
+			{
+				DriveView::Attr attr ;
+				return view->GetAttr( path, attr ) ? 0 : -ENOENT ;
+			}
+			return view->Open( path, ( fi->flags & O_TRUNC ) != 0 ) ? 0 : -ENOENT ;
+		} ) ;
+	}
+
+	int Read( const char *path, char *buf, size_t size, off_t offset, fuse_file_info* )
+	{
+		return Guard( "read", path, [=]() -> int
+		{
+			return static_cast<int>( view->Read( path, offset, buf, size ) ) ;
+		} ) ;
+	}
+
+	int Write( const char *path, const char *buf, size_t size, off_t offset, fuse_file_info* )
+	{
+		return Guard( "write", path, [=]() -> int
+		{
+			return static_cast<int>( view->Write( path, offset, buf, size ) ) ;
+		} ) ;
+	}
+
+	int Truncate( const char *path, off_t size, fuse_file_info* )
+	{
+		return Guard( "truncate", path, [=]() -> int
+		{
+			return view->Truncate( path, size ) ? 0 : -ENOENT ;
+		} ) ;
+	}
+
+	int Release( const char *path, fuse_file_info *fi )
+	{
+		if ( ( fi->flags & O_ACCMODE ) == O_RDONLY )
+			return 0 ;
+
+		return Guard( "release", path, [=]() -> int
+		{
+			view->Release( path ) ;
+			return 0 ;
+		} ) ;
+	}
+
+	int Create( const char *path, mode_t, fuse_file_info* )
+	{
+		return Guard( "create", path, [=]() -> int
+		{
+			return view->Create( path ) ? 0 : -EEXIST ;
+		} ) ;
+	}
+
+	int Mkdir( const char *path, mode_t )
+	{
+		return Guard( "mkdir", path, [=]() -> int
+		{
+			return view->Mkdir( path ) ? 0 : -EEXIST ;
+		} ) ;
+	}
+
+	int Unlink( const char *path )
+	{
+		return Guard( "unlink", path, [=]() -> int
+		{
+			return view->Remove( path ) ? 0 : -ENOENT ;
+		} ) ;
+	}
+
+	int Rmdir( const char *path )
+	{
+		return Guard( "rmdir", path, [=]() -> int
+		{
+			std::vector<std::string> names ;
+			if ( !view->List( path, names ) )
+				return -ENOENT ;
+			if ( !names.empty() )
+				return -ENOTEMPTY ;
+			return view->Remove( path ) ? 0 : -ENOENT ;
+		} ) ;
+	}
+
+	// times are set by the server on upload
+	int Utimens( const char*, const struct timespec[2], fuse_file_info* )
+	{
+		return 0 ;
+	}
+}
+
+int Main( int argc, char **argv )
+{
+	InitGCrypt() ;
+
+	po::options_description desc( "grive-fuse options" );
+	desc.add_options()
+		( "help,h",		"Produce help message" )
+		( "version,v",	"Display version" )
+		( "path,p",		po::value<std::string>(), "Directory with the .grive configuration" )
+		( "api",		po::value<std::string>(), "Google Drive API version to use: v2 (default) or v3" )
+		( "cache-dir",	po::value<std::string>(), "Directory for cached file content "
+						"(default: <path>/.grive_cache)" )
+		( "cache-size",	po::value<unsigned>(), "Size of the content cache in MB (default: 1024)" )
+		( "foreground,f", "Do not detach from the terminal" )
+		( "option,o",	po::value<std::vector<std::string> >(), "Mount options, passed to FUSE" )
+		( "verbose,V",	"Verbose mode. Enable more messages than normal." )
+		( "debug,d",	"Enable debug level messages. Implies -V." )
+		( "log,l",		po::value<std::string>(), "Set log output filename." )
+		( "mountpoint",	po::value<std::string>(), "Where to mount the drive" )
+	;
+	po::positional_options_description pos ;
+	pos.add( "mountpoint", 1 ) ;
+
+	po::variables_map vm;
+	try
+	{
+		po::store( po::command_line_parser( argc, argv ).options( desc ).positional( pos ).run(), vm );
+	}
+	catch( po::error &e )
+	{
+		std::cerr << "Options are incorrect. Use -h for help\n";
+		return -1;
+	}
+	po::notify( vm );
+
+	if ( vm.count("help") || vm.count( "mountpoint" ) == 0 )
+	{
+		std::cout << "Usage: grive-fuse [options] <mountpoint>\n" << desc << std::endl ;
+		return vm.count("help") ? 0 : -1 ;
+	}
+	else if ( vm.count( "version" ) )
+	{
+		std::cout << "grive-fuse version " << VERSION << std::endl ;
+		return 0 ;
+	}
+
+	InitLog( vm ) ;
+
+	Config config( vm ) ;
+	std::string refresh_token, id, secret, redirect_uri ;
+	try
+	{
+		refresh_token = config.Get("refresh_token").Str() ;
+		id = config.Get("id").Str() ;
+		secret = config.Get("secret").Str() ;
+		redirect_uri = config.Get("redirect-uri").Str() ;
+	}
+	catch ( Exception& e )
+	{
+		Log( "Please run grive with the \"-a\" option to authorize access first", log::critical ) ;
+		return -1;
+	}
+
+	std::unique_ptr<http::Agent> http( new http::CurlAgent );
+	OAuth2 token( http.get(), refresh_token, id, secret, redirect_uri ) ;
+	AuthAgent agent( token, http.get() ) ;
+
+	std::unique_ptr<Syncer> syncer ;
+	std::string api = vm.count( "api" ) > 0 ? vm["api"].as<std::string>() : "v2" ;
+	if ( api == "v3" )
+		syncer.reset( new v3::Syncer3( &agent ) ) ;
+	else if ( api == "v2" )
+		syncer.reset( new v2::Syncer2( &agent ) ) ;
+	else
+	{
+		std::cerr << "Unknown API version " << api << ". Use v2 or v3\n" ;
+		return -1 ;
+	}
+
+	fs::path cache_dir = vm.count( "cache-dir" ) > 0
+		? fs::path( vm["cache-dir"].as<std::string>() )
+		: fs::path( config.Get( "path" ).Str() ) / ".grive_cache" ;
+	u64_t cache_size = ( vm.count( "cache-size" ) > 0 ? vm["cache-size"].as<unsigned>() : 1024 ) * 1024ULL * 1024 ;
+
+	DriveView drive( syncer.get(), fs::absolute( cache_dir ), cache_size ) ;
+	view = &drive ;
+
+	fuse_operations ops ;
+	std::memset( &ops, 0, sizeof(ops) ) ;
+	ops.init		= &Init ;
+	ops.getattr		= &GetAttr ;
+	ops.readdir		= &ReadDir ;
+	ops.open		= &Open ;
+	ops.read		= &Read ;
+	ops.write		= &Write ;
+	ops.truncate	= &Truncate ;
+	ops.release		= &Release ;
+	ops.create		= &Create ;
+	ops.mkdir		= &Mkdir ;
+	ops.unlink		= &Unlink ;
+	ops.rmdir		= &Rmdir ;
+	ops.utimens		= &Utimens ;
+
+	std::vector<std::string> args ;
+	args.push_back( argv[0] ) ;
+	args.push_back( vm["mountpoint"].as<std::string>() ) ;
+	if ( vm.count( "foreground" ) )
+		args.push_back( "-f" ) ;
+	if ( vm.count( "option" ) )
+	{
+		const std::vector<std::string>& opts = vm["option"].as<std::vector<std::string> >() ;
+		for ( std::size_t i = 0 ; i < opts.size() ; i++ )
+		{
+			args.push_back( "-o" ) ;
+			args.push_back( opts[i] ) ;
+		}
+	}
+
+	std::vector<char*> fuse_argv ;
+	for ( std::size_t i = 0 ; i < args.size() ; i++ )
+		fuse_argv.push_back( &args[i][0] ) ;
+
+	return fuse_main( static_cast<int>( fuse_argv.size() ), &fuse_argv[0], &ops, 0 ) ;
+}
+
+int main( int argc, char **argv )
+{
+	try
+	{
+		return Main( argc, argv ) ;
+	}
+	catch ( Exception& e )
+	{
+		Log( "exception: %1%", boost::diagnostic_information(e), log::critical ) ;
+	}
+	catch ( std::exception& e )
+	{
+		Log( "exception: %1%", e.what(), log::critical ) ;
+	}
+	catch ( ... )
+	{
+		Log( "unexpected exception", log::critical ) ;
+	}
+	return -1 ;
+}
@@ -18,14 +18,24 @@
 */
 
 #include "util/Config.hh"
+#include "util/EventStream.hh"
+#include "util/MemStats.hh"
+#include "util/OS.hh"
+#include "util/PageCache.hh"
 #include "util/ProgressBar.hh"
 
 #include "base/Drive.hh"
+#include "base/MultiRoot.hh"
+#include "base/Resource.hh"
+#include "base/State.hh"
 #include "drive2/Syncer2.hh"
+#include "drive3/Syncer3.hh"
 
 #include "http/CurlAgent.hh"
+#include "http/Lanes.hh"
 #include "protocol/AuthAgent.hh"
 #include "protocol/OAuth2.hh"
+#include "json/JsonWriter.hh"
 #include "json/Val.hh"
 
 #include "bfd/Backtrace.hh"
@@ -108,6 +118,16 @@ void InitLog( const po::variables_map& vm )
 	LogBase::Inst( comp_log.release() ) ;
 }
 
+// one JSON object per line, for scripts
+void PrintStatus( const std::string& change, const Resource *res )
+{
+	Val line ;
+	line.Add( "status", Val( change ) ) ;
+	line.Add( "type", Val( res->Kind() ) ) ;
+	line.Add( "path", Val( res->RelPath().string() ) ) ;
+	std::cout << WriteJson( line ) << std::endl ;
+}
+
 // AuthCode reads an authorization code from the "code" query parameter passed
 // via client-side redirect to the redirect uri specified in uri
 std::string AuthCode( std::string uri )
@@ -179,6 +199,7 @@ int Main( int argc, char **argv )
                 ( "secret,e",           po::value<std::string>(), "Authentication secret")
                 ( "print-url",          "Only print url for request")
 		( "path,p",		po::value<std::string>(), "Path to working copy root")
+		( "api",		po::value<std::string>(), "Google Drive API version to use: v2 (default) or v3")
 		( "redirect-uri",	po::value<std::string>(), "local URI on which to listen for auth redirect")
 		( "dir,s",		po::value<std::string>(), "Single subdirectory to sync")
 		( "verbose,V",	"Verbose mode. Enable more messages than normal.")
@@ -190,11 +211,55 @@ int Main( int argc, char **argv )
 						"instead of uploading it." )
 		( "upload-only,u", "Do not download anything from Google Drive, only upload local changes" )
 		( "no-remote-new,n", "Download only files that are changed in Google Drive and already exist locally" )
+		( "paths-from",	po::value<std::string>(), "Only look at the local paths listed in this file "
+						"(or - for the standard input), one per line. Other files are taken "
+						"as unchanged since the last sync." )
 		( "dry-run",	"Only detect which files need to be uploaded/downloaded, "
 						"without actually performing them." )
-		( "upload-speed,U", po::value<unsigned>(), "Limit upload speed in kbytes per second" )
-		( "download-speed,D", po::value<unsigned>(), "Limit download speed in kbytes per second" )
+		( "upload-speed,U", po::value<unsigned>(), "Limit upload speed in kbytes per second, "
+						"for all connections together" )
+		( "bulk-threads", po::value<unsigned>(), "Number of connections for uploads and downloads, "
+						"apart from the one for the other requests. 0 sends everything in turn "
+						"on one connection. The default is 1." )
+		( "download-speed,D", po::value<unsigned>(), "Limit download speed in kbytes per second, "
+						"for all connections together" )
 		( "progress-bar,P", "Enable progress bar for upload/download of files")
+		( "memory-limit", po::value<unsigned>(), "Sync one top-level folder at a time to bound memory use. "
+						"Up to a quarter of the limit (in MB) buffers the remote file list. Each "
+						"top-level folder is still in memory as a whole, with a warning if it takes more." )
+		( "state-depth", po::value<unsigned>(), "Keep the sync state of folders at this depth "
+						"in separate files, loaded only when needed. 0, the default, keeps a single file." )
+		( "list-threads", po::value<unsigned>(), "Read the remote file list folder by folder "
+						"over this many connections." )
+		( "status",		"Only list the local changes since the last sync, one JSON object "
+						"per line, without connecting to Google Drive." )
+		( "no-hash",	"With --status, take files with a newer change time as changed "
+						"without comparing checksums." )
+		( "verify",		"Check that the content of the local files matches Google Drive, "
+						"without syncing." )
+		( "repair",		"With --verify, download corrupted files again and fix wrong "
+						"checksums in the state." )
+		( "verify-threads", po::value<unsigned>(), "Number of threads reading files for --verify." )
+		( "verify-rate", po::value<unsigned>(), "Limit --verify reads in MB per second." )
+		( "roots",		po::value<std::string>(), "Sync all the roots listed in this JSON file "
+						"in one process, sharing connections and access tokens." )
+		( "root-threads", po::value<unsigned>(), "Number of roots synced at the same time with --roots." )
+		( "roots-interval", po::value<unsigned>(), "With --roots, keep running and sync all roots "
+						"again every this many seconds, less often while they don't change." )
+		( "polite-io",	"Keep the files read and written by grive out of the page cache, "
+						"to leave it to the other programs." )
+		( "idle-io",	"Only read and write local files when no other program uses the disk." )
+		( "events",		po::value<std::string>(), "Write one JSON object per line to this file, "
+						"FIFO or Unix socket for each file uploaded, downloaded, moved or deleted." )
+		( "settle-time", po::value<unsigned>(), "Don't upload files changed less than this many "
+						"seconds ago, they are probably still being written." )
+		( "watch-address", po::value<std::string>(), "With --roots, keep running and sync a root when "
+						"Google Drive posts a change notification to this HTTPS address." )
+		( "watch-port", po::value<unsigned>(), "Local port receiving the notifications forwarded "
+						"from --watch-address. The default is 8080." )
+		( "watch-bind", po::value<std::string>(), "Local IPv4 address the notifications are received "
+						"on. The default is 127.0.0.1, for a proxy on the same host. Use 0.0.0.0 "
+						"for all interfaces." )
 	;
 	
 	po::variables_map vm;
@@ -208,7 +273,15 @@ int Main( int argc, char **argv )
 		return -1;
 	}
 	po::notify( vm );
-	
+
+	// the watch options only apply to the roots
+	if ( !vm.count( "roots" ) &&
+		( vm.count( "watch-address" ) || vm.count( "watch-port" ) || vm.count( "watch-bind" ) ) )
+	{
+		std::cerr << "Options are incorrect. Use -h for help\n";
+		return -1;
+	}
+
 	// simple commands that doesn't require log or config
 	if ( vm.count("help") )
 	{
@@ -229,6 +302,40 @@ int Main( int argc, char **argv )
 	
 	Log( "config file name %1%", config.Filename(), log::verbose );
 
+	// for all the threads started from here on
+	if ( vm.count( "polite-io" ) )
+		PageCache::Instance().Enable() ;
+	if ( vm.count( "idle-io" ) && !os::SetIdleIoPriority() )
+		Log( "idle I/O priority is not supported", log::warning ) ;
+
+	if ( vm.count( "status" ) )
+	{
+		State state( config.Get( "path" ).Str(), config.GetAll() ) ;
+		state.FromLocal( config.Get( "path" ).Str() ) ;
+		state.Status( &PrintStatus ) ;
+		return 0 ;
+	}
+
+	if ( vm.count( "events" ) )
+		EventStream::Instance().Open( vm["events"].as<std::string>() ) ;
+
+	if ( vm.count( "roots" ) )
+	{
+		MultiRoot roots( config, vm["roots"].as<std::string>() ) ;
+		unsigned threads = vm.count( "root-threads" ) ? vm["root-threads"].as<unsigned>() : 2 ;
+		Log( "syncing %1% roots in %2% threads", roots.Count(), threads, log::info ) ;
+
+		unsigned failed = 0 ;
+		if ( vm.count( "roots-interval" ) || vm.count( "watch-address" ) )
+			roots.Serve( threads, vm.count( "roots-interval" ) ? vm["roots-interval"].as<unsigned>() : 600 ) ;	// runs until killed
+		else
+			failed = roots.Run( threads ) ;
+		if ( failed > 0 )
+			Log( "%1% roots failed to sync", failed, log::warning ) ;
+		MemStats::Instance().Report() ;
+		return failed > 0 ? -1 : 0 ;
+	}
+
 	std::unique_ptr<http::Agent> http( new http::CurlAgent );
 	if ( vm.count( "log-http" ) )
 		http->SetLog( new http::ResponseLog( vm["log-http"].as<std::string>(), ".txt" ) );
@@ -298,30 +405,63 @@ int Main( int argc, char **argv )
 	
 	OAuth2 token( http.get(), refresh_token, id, secret, redirect_uri ) ;
 	AuthAgent agent( token, http.get() ) ;
-	v2::Syncer2 syncer( &agent );
 
+	// uploads and downloads get connections of their own
+	http::Lanes lanes( &agent, vm.count( "bulk-threads" ) > 0 ? vm["bulk-threads"].as<unsigned>() : 1 ) ;
+	if ( pb )
+		lanes.SetProgressReporter( pb.get() ) ;
+
+	std::unique_ptr<Syncer> syncer ;
+	std::string api = vm.count( "api" ) > 0 ? vm["api"].as<std::string>() : "v2" ;
+	if ( api == "v3" )
+		syncer.reset( new v3::Syncer3( &lanes ) ) ;
+	else if ( api == "v2" )
+		syncer.reset( new v2::Syncer2( &lanes ) ) ;
+	else
+	{
+		std::cerr << "Unknown API version " << api << ". Use v2 or v3\n" ;
+		return -1 ;
+	}
+
+	// shared by all the connections
 	if ( vm.count( "upload-speed" ) > 0 )
-		agent.SetUploadSpeed( vm["upload-speed"].as<unsigned>() * 1000 );
+		lanes.SetUploadSpeed( vm["upload-speed"].as<unsigned>() * 1000 );
 	if ( vm.count( "download-speed" ) > 0 )
-		agent.SetDownloadSpeed( vm["download-speed"].as<unsigned>() * 1000 );
-
-	Drive drive( &syncer, config.GetAll() ) ;
-	drive.DetectChanges() ;
+		lanes.SetDownloadSpeed( vm["download-speed"].as<unsigned>() * 1000 );
 
-	if ( vm.count( "dry-run" ) == 0 )
+	Drive drive( syncer.get(), config.GetAll() ) ;
+	if ( vm.count( "verify" ) > 0 )
+		drive.Verify( vm.count( "repair" ) > 0 ) ;
+	else if ( vm.count( "memory-limit" ) > 0 )
 	{
-		// The progress bar should just be enabled when actual file transfers take place
-		if ( pb )
+		// each part is written to its shard as soon as it is synced
+		if ( pb && vm.count( "dry-run" ) == 0 )
 			pb->setShowProgressBar( true ) ;
-		drive.Update() ;
+		drive.SyncPartitioned( vm.count( "dry-run" ) > 0 ) ;
 		if ( pb )
 			pb->setShowProgressBar( false ) ;
-
-		drive.SaveState() ;
 	}
 	else
-		drive.DryRun() ;
+	{
+		drive.DetectChanges() ;
+
+		if ( vm.count( "dry-run" ) == 0 )
+		{
+			// The progress bar should just be enabled when actual file transfers take place
+			if ( pb )
+				pb->setShowProgressBar( true ) ;
+			drive.Update() ;
+			if ( pb )
+				pb->setShowProgressBar( false ) ;
+
+			drive.SaveState() ;
+		}
+		else
+			drive.DryRun() ;
+	}
 		
+	lanes.Report() ;
+	MemStats::Instance().Report() ;
 	config.Save() ;
 	Log( "Finished!", log::info ) ;
 	return 0 ;
@@ -0,0 +1,281 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "ContentCache.hh"
+
+#include "Resource.hh"
+
+#include "http/Agent.hh"
+#include "http/Error.hh"
+#include "http/Header.hh"
+#include "http/StringResponse.hh"
+#include "util/Crypt.hh"
+#include "util/File.hh"
+#include "util/log/Log.hh"
+
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace gr {
+
+namespace
+{
+	std::string ChunkKey( const ContentCache::Source& src, u64_t index )
+	{
+		return ( boost::format( "%1%.%2%" ) % src.key % index ).str() ;
+	}
+
+	/// chunks are downloaded under this suffix and renamed when complete
+	const std::string partial = ".part" ;
+
+	bool OlderThan( const std::pair<std::time_t, fs::path>& a, const std::pair<std::time_t, fs::path>& b )
+	{
+		return a.first < b.first ;
+	}
+}
+
+/// Files with the same content share their chunks. Without a checksum,
+/// the chunks are only valid for one revision of the file.
+ContentCache::Source::Source( const Resource *res ) :
+	name	( res->Name() ),
+	url		( res->ContentSrc() ),
+	size	( res->Size() )
+{
+	Digest id = res->MD5() ;
+	if ( id.Empty() )
+	{
+		crypt::MD5 md5 ;
+		std::string rev = res->ResourceID() + res->ETag() ;
+		md5.Write( rev.c_str(), rev.size() ) ;
+		id = md5.Get() ;
+	}
+	key = id.Hex() ;
+}
+
+/// \param	limit		size of the cache in bytes
+/// \param	chunk_size	bytes fetched at once
+ContentCache::ContentCache( http::Agent *agent, const fs::path& dir, u64_t limit, std::size_t chunk_size ) :
+	m_agent		( agent ),
+	m_dir		( dir ),
+	m_limit		( limit ),
+	m_chunk		( chunk_size ),
+	m_used		( 0 ),
+	m_fetched	( 0 )
+{
+	m_idle.push_back( m_agent ) ;
+	fs::create_directories( m_dir ) ;
+
+	// keep the chunks of the last run, oldest first. the ones which were
+	// being downloaded or cannot be chunks of this size are dropped
+	std::vector<std::pair<std::time_t, fs::path> > old ;
+	for ( fs::directory_iterator i( m_dir ) ; i != fs::directory_iterator() ; ++i )
+	{
+		if ( !fs::is_regular_file( i->status() ) )
+			continue ;
+
+		u64_t size = fs::file_size( i->path() ) ;
+		if ( i->path().extension() == partial || size == 0 || size > m_chunk )
+		{
+			boost::system::error_code ec ;
+			fs::remove( i->path(), ec ) ;
+		}
+		else
+			old.push_back( std::make_pair( fs::last_write_time( i->path() ), i->path() ) ) ;
+	}
+	std::sort( old.begin(), old.end(), &OlderThan ) ;
+
+	for ( std::size_t i = 0 ; i < old.size() ; i++ )
+		Add( old[i].second.filename().string(), fs::file_size( old[i].second ) ) ;
+	Evict() ;
+}
+
+/// Read \a count bytes of the content of \a src from \a offset, downloading
+/// the chunks which are not in the cache.
+/// \return	bytes read, less than \a count at the end of the file
+std::size_t ContentCache::Read( const Source& src, u64_t offset, char *buf, std::size_t count )
+{
+	u64_t size = src.size ;
+	if ( offset >= size )
+		return 0 ;
+	count = static_cast<std::size_t>( std::min<u64_t>( count, size - offset ) ) ;
+
+	std::size_t done = 0 ;
+	while ( done < count )
+	{
+		u64_t pos	= offset + done ;
+		u64_t index	= pos / m_chunk ;
+		u64_t start	= pos % m_chunk ;
+		std::size_t n = static_cast<std::size_t>( std::min<u64_t>( count - done, m_chunk - start ) ) ;
+
+		File file ;
+		Open( src, index, file ) ;
+		file.Seek( start, SEEK_SET ) ;
+		std::size_t r = file.Read( buf + done, n ) ;
+		if ( r != n )
+			BOOST_THROW_EXCEPTION( Error() << boost::errinfo_file_name( ( m_dir / ChunkKey( src, index ) ).string() ) ) ;
+		done += n ;
+	}
+	return done ;
+}
+
+/// Open the chunk \a index of \a src in \a file, downloading it first if it
+/// is not in the cache. The chunk becomes the most recently used one. It is
+/// opened with the lock held, so that it stays readable if it is evicted
+/// before it is read.
+void ContentCache::Open( const Source& src, u64_t index, File& file )
+{
+	std::string key = ChunkKey( src, index ) ;
+
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+	while ( m_fetching.count( key ) > 0 )
+		m_fetch_done.wait( lock ) ;
+
+	// a chunk of another size was left by a run with other chunks
+	u64_t first = index * m_chunk ;
+	u64_t bytes = std::min<u64_t>( m_chunk, src.size - first ) ;
+	std::map<std::string, Chunk>::iterator i = m_chunks.find( key ) ;
+	if ( i != m_chunks.end() && i->second.size != bytes )
+	{
+		Drop( i ) ;
+		i = m_chunks.end() ;
+	}
+
+	if ( i != m_chunks.end() )
+		m_lru.splice( m_lru.begin(), m_lru, i->second.lru ) ;
+	else
+	{
+		m_fetching.insert( key ) ;
+		if ( m_idle.empty() )
+		{
+			m_clones.push_back( m_agent->Clone() ) ;
+			m_idle.push_back( m_clones.back().get() ) ;
+		}
+		http::Agent *agent = m_idle.back() ;
+		m_idle.pop_back() ;
+
+		lock.unlock() ;
+		try
+		{
+			bytes = Fetch( agent, src, index, key ) ;
+		}
+		catch ( ... )
+		{
+			lock.lock() ;
+			Fetched( agent, key ) ;
+			throw ;
+		}
+		lock.lock() ;
+		Fetched( agent, key ) ;
+
+		m_fetched++ ;
+		Add( key, bytes ) ;
+		Evict() ;
+	}
+	file.OpenForRead( m_dir / key ) ;
+}
+
+/// Download a chunk into the cache directory, without the lock.
+/// \return	the size of the chunk
+u64_t ContentCache::Fetch( http::Agent *agent, const Source& src, u64_t index, const std::string& key )
+{
+	u64_t first	= index * m_chunk ;
+	u64_t last	= std::min<u64_t>( first + m_chunk, src.size ) - 1 ;
+
+	Trace( "fetching bytes %1%-%2% of %3%", first, last, src.name ) ;
+
+	http::Header hdr ;
+	hdr.Add( ( boost::format( "Range: bytes=%1%-%2%" ) % first % last ).str() ) ;
+	http::StringResponse resp ;
+	long code = agent->Get( src.url, &resp, hdr, 0 ) ;
+
+	std::string data = resp.Response() ;
+	if ( code == 200 && data.size() == src.size )
+		data = data.substr( first, last - first + 1 ) ;
+	else if ( code != 206 || data.size() != last - first + 1 )
+	{
+		BOOST_THROW_EXCEPTION(
+			Error()
+				<< http::HttpResponseCode( code )
+				<< http::Url( src.url ) ) ;
+	}
+
+	// readers of the cache never see a chunk being written, even after a crash
+	fs::path part = m_dir / ( key + partial ) ;
+	File out ;
+	out.OpenForWrite( part ) ;
+	out.Write( data.c_str(), data.size() ) ;
+	out.Close() ;
+	fs::rename( part, m_dir / key ) ;
+	return data.size() ;
+}
+
+/// The download of \a key on \a agent is over, successful or not. Called
+/// with the lock held.
+void ContentCache::Fetched( http::Agent *agent, const std::string& key )
+{
+	m_idle.push_back( agent ) ;
+	m_fetching.erase( key ) ;
+	m_fetch_done.notify_all() ;
+}
+
+void ContentCache::Add( const std::string& key, u64_t size )
+{
+	m_lru.push_front( key ) ;
+	Chunk c = { m_lru.begin(), size } ;
+	m_chunks[key] = c ;
+	m_used += size ;
+}
+
+/// Remove the least recently used chunks until the cache fits. The most
+/// recent one is kept even if it is larger than the limit.
+void ContentCache::Evict()
+{
+	while ( m_used > m_limit && m_lru.size() > 1 )
+		Drop( m_chunks.find( m_lru.back() ) ) ;
+}
+
+/// Remove a chunk from the cache and the disk. Called with the lock held.
+void ContentCache::Drop( std::map<std::string, Chunk>::iterator i )
+{
+	boost::system::error_code ec ;
+	fs::remove( m_dir / i->first, ec ) ;
+	m_used -= i->second.size ;
+	m_lru.erase( i->second.lru ) ;
+	m_chunks.erase( i ) ;
+}
+
+/// bytes in the cache
+u64_t ContentCache::Used() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	return m_used ;
+}
+
+/// number of chunks downloaded since the cache was created
+std::size_t ContentCache::Fetched() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	return m_fetched ;
+}
+
+} // end of namespace gr
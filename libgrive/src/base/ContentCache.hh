@@ -0,0 +1,119 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "util/Exception.hh"
+#include "util/FileSystem.hh"
+#include "util/Types.hh"
+
+#include <condition_variable>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gr {
+
+namespace http
+{
+	class Agent ;
+}
+
+class File ;
+class Resource ;
+
+/*!	\brief	bounded on-disk cache of remote file content
+
+	File content is fetched in fixed-size chunks with ranged downloads, and
+	only the chunks that are read are downloaded. Chunks are stored as files
+	in the cache directory, named after the MD5 of the file content, and the
+	least recently used ones are removed when the cache grows over its limit.
+	Chunks left by a previous run are reused.
+
+	The readers only hold the lock to look up the chunks. Each download runs
+	on a connection of its own, and the readers of a chunk being downloaded
+	wait for it instead of downloading it again.
+*/
+class ContentCache
+{
+public :
+	struct Error : virtual Exception {} ;
+
+	/// what is read of a file, copied from its Resource so that the
+	/// downloads don't look at resources which may change meanwhile
+	struct Source
+	{
+		explicit Source( const Resource *res ) ;
+
+		std::string	name ;
+		std::string	url ;
+		std::string	key ;
+		u64_t		size ;
+	} ;
+
+public :
+	ContentCache( http::Agent *agent, const fs::path& dir, u64_t limit, std::size_t chunk_size = 4 << 20 ) ;
+
+	std::size_t Read( const Source& src, u64_t offset, char *buf, std::size_t count ) ;
+
+	u64_t Used() const ;
+	std::size_t Fetched() const ;
+
+private :
+	typedef std::list<std::string> Lru ;
+
+	struct Chunk
+	{
+		Lru::iterator	lru ;
+		u64_t			size ;
+	} ;
+
+	void Open( const Source& src, u64_t index, File& file ) ;
+	u64_t Fetch( http::Agent *agent, const Source& src, u64_t index, const std::string& key ) ;
+	void Fetched( http::Agent *agent, const std::string& key ) ;
+	void Add( const std::string& key, u64_t size ) ;
+	void Evict() ;
+	void Drop( std::map<std::string, Chunk>::iterator i ) ;
+
+private :
+	http::Agent		*m_agent ;
+	fs::path		m_dir ;
+	u64_t			m_limit ;
+	std::size_t		m_chunk ;
+
+	mutable std::mutex				m_mutex ;
+	Lru								m_lru ;
+	std::map<std::string, Chunk>	m_chunks ;
+	u64_t							m_used ;
+	std::size_t						m_fetched ;
+
+	// the chunks being downloaded, and the idle connections to download
+	// them. the clones of m_agent are made as needed and kept
+	std::set<std::string>						m_fetching ;
+	std::condition_variable						m_fetch_done ;
+	std::vector<http::Agent*>					m_idle ;
+	std::vector<std::unique_ptr<http::Agent> >	m_clones ;
+} ;
+
+} // end of namespace gr
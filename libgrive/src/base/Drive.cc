@@ -21,10 +21,18 @@
 
 #include "Entry.hh"
 #include "Feed.hh"
+#include "FeedReader.hh"
+#include "FolderLister.hh"
+#include "PartitionIndex.hh"
+#include "Resource.hh"
 #include "Syncer.hh"
+#include "Verifier.hh"
 
 #include "http/Agent.hh"
+#include "util/Crypt.hh"
 #include "util/Destroy.hh"
+#include "util/MemStats.hh"
+#include "util/OS.hh"
 #include "util/log/Log.hh"
 
 #include <boost/bind.hpp>
@@ -35,6 +43,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <map>
+#include <set>
 
 // for debugging only
 #include <iostream>
@@ -74,16 +83,30 @@ void Drive::DetectChanges()
 {
 	Log( "Reading local directories", log::info ) ;
 	m_state.FromLocal( m_root ) ;
+	m_state.SampleMemory( "reading local directories" ) ;
 
-	Log( "Reading remote server file list", log::info ) ;
-	std::unique_ptr<Feed> feed = m_syncer->GetAll() ;
+	ReadRemote() ;
+}
 
-	while ( feed->GetNext( m_syncer->Agent() ) )
+/// List the whole remote tree and merge it into the state. Like the local
+/// scan, this visits every file and folder, clean or not: only the changes
+/// feed, see ReadChanges(), could tell which ones changed without it.
+void Drive::ReadRemote()
+{
+	Log( "Reading remote server file list", log::info ) ;
+	unsigned threads = m_options.Has( "list-threads" ) ? m_options["list-threads"].U64() : 1 ;
+	if ( threads > 1 )
+	{
+		FolderLister lister( m_syncer, threads ) ;
+		lister.Run( boost::bind( &Drive::FromRemote, this, _1 ) ) ;
+	}
+	else
 	{
-		std::for_each(
-			feed->begin(), feed->end(),
-			boost::bind( &Drive::FromRemote, this, _1 ) ) ;
+		std::unique_ptr<Feed> feed = m_syncer->GetAll() ;
+		FeedReader reader( feed.get(), m_syncer->Agent() ) ;
+		reader.Run( boost::bind( &Drive::FromRemote, this, _1 ) ) ;
 	}
+	m_state.SampleMemory( "reading remote file list" ) ;
 	m_state.ResolveEntry() ;
 }
 
@@ -92,17 +115,21 @@ void Drive::DetectChanges()
 void Drive::ReadChanges()
 {
 	long prev_stamp = m_state.ChangeStamp() ;
-	if ( prev_stamp != -1 )
+	std::string token = m_state.PageToken() ;
+	if ( prev_stamp != -1 || !token.empty() )
 	{
-		Trace( "previous change stamp is %1%", prev_stamp ) ;
+		Trace( "previous change stamp is %1%, page token %2%", prev_stamp, token ) ;
 		Log( "Detecting changes from last sync", log::info ) ;
-		std::unique_ptr<Feed> feed = m_syncer->GetChanges( prev_stamp+1 ) ;
+		std::unique_ptr<Feed> feed = token.empty() ?
+			m_syncer->GetChanges( prev_stamp+1 ) : m_syncer->GetChangesFrom( token ) ;
 		while ( feed->GetNext( m_syncer->Agent() ) )
 		{
 			std::for_each(
 				feed->begin(), feed->end(),
 				boost::bind( &Drive::FromChange, this, _1 ) ) ;
 		}
+		if ( !feed->NextChanges().empty() )
+			m_state.PageToken( feed->NextChanges() ) ;
 	}
 }
 
@@ -110,6 +137,7 @@ void Drive::Update()
 {
 	Log( "Synchronizing files", log::info ) ;
 	m_state.Sync( m_syncer, m_options ) ;
+	m_state.SampleMemory( "synchronizing files" ) ;
 	
 	UpdateChangeStamp( ) ;
 }
@@ -120,11 +148,398 @@ void Drive::DryRun()
 	m_state.Sync( NULL, m_options ) ;
 }
 
+namespace
+{
+	// parent href and name of each remote folder
+	typedef std::map<std::string, std::pair<std::string, std::string> > FolderMap ;
+
+	/// Href of the top-level folder which contains the folder \a href, or
+	/// an empty string if it is the root or not reachable from it.
+	std::string TopFolder( const FolderMap& folders, std::string href )
+	{
+		std::string top ;
+		for ( std::size_t depth = 0 ; href != "root" && depth <= folders.size() ; depth++ )
+		{
+			FolderMap::const_iterator f = folders.find( href ) ;
+			if ( f == folders.end() )
+				return "" ;
+			top		= href ;
+			href	= f->second.first ;
+		}
+		return href == "root" ? top : "" ;
+	}
+}
+
+/// Files deleted in one top-level folder and added in another. Each part
+/// has its own state, so such moves are synced as a deletion and a new
+/// file. They are only found afterwards, to warn about them.
+class Drive::MoveCheck
+{
+public :
+	/// Note the new and deleted files of \a state, before it is synced.
+	void Add( State& state, const std::string& part )
+	{
+		for ( State::iterator i = state.begin() ; i != state.end() ; ++i )
+		{
+			Resource *res = *i ;
+			if ( res->IsFolder() )
+				continue ;
+
+			Resource::State st = res->GetState() ;
+			bool added = st == Resource::local_new || st == Resource::remote_new ;
+			if ( added || st == Resource::local_deleted || st == Resource::remote_deleted )
+			{
+				Change c = { part, res->Path(), res->Size(), res->MD5(),
+					st == Resource::local_new || st == Resource::local_deleted } ;
+				( added ? m_added : m_deleted ).insert( std::make_pair( c.size, c ) ) ;
+			}
+		}
+	}
+
+	/// Warn about the files which have the same content in two parts. The
+	/// checksums of new local files are only read for deleted files of the
+	/// same size.
+	void Report()
+	{
+		for ( Changes::iterator a = m_added.begin() ; a != m_added.end() ; ++a )
+		{
+			std::pair<Changes::iterator, Changes::iterator> same = m_deleted.equal_range( a->first ) ;
+			for ( Changes::iterator d = same.first ; d != same.second ; ++d )
+			{
+				Change& from = d->second ;
+				Change& to = a->second ;
+				if ( from.part == to.part || from.local != to.local || from.md5.Empty() )
+					continue ;
+				if ( to.md5.Empty() && to.local )
+					to.md5 = crypt::MD5::Get( to.path ) ;
+				if ( to.md5 == from.md5 )
+					Log( "%1% was moved to %2%, in another top-level folder. It was synced as a deletion "
+						"and a new file, because --memory-limit syncs one top-level folder at a time",
+						from.path, to.path, log::warning ) ;
+			}
+		}
+	}
+
+private :
+	struct Change
+	{
+		std::string	part ;
+		fs::path	path ;
+		u64_t		size ;
+		Digest		md5 ;
+		bool		local ;
+	} ;
+	typedef std::multimap<u64_t, Change> Changes ;
+
+	Changes	m_added ;
+	Changes	m_deleted ;
+} ;
+
+/// Synchronize one top-level folder at a time, so that the resource tree,
+/// the state and the remote entries of only one part of the tree are in
+/// memory at once. The remote file list is read once and spilled to disk by
+/// top-level folder. Files in the root folder and anything else go last.
+///
+/// "memory-limit" bounds the remote entries buffered before they are
+/// spilled, to a quarter of it. The tree and state of the largest top-level
+/// folder are in memory as a whole, whatever the limit. A warning tells
+/// when one of them takes more than the limit.
+///
+/// Moves between top-level folders are not detected, see MoveCheck.
+void Drive::SyncPartitioned( bool dry_run )
+{
+	std::size_t limit = static_cast<std::size_t>( m_options["memory-limit"].U64() ) * 1024 * 1024 ;
+
+	// the parts are keyed by the href of their top-level folder. folders
+	// with the same name go to the same local folder, so they are synced
+	// together, like the full sync does
+	Log( "Reading remote folder list", log::info ) ;
+	FolderMap folders ;
+	std::map<std::string, std::set<std::string> > parts ;
+	std::unique_ptr<Feed> feed = m_syncer->GetFolders() ;
+	while ( feed->GetNext( m_syncer->Agent() ) )
+	{
+		for ( Feed::iterator i = feed->begin() ; i != feed->end() ; ++i )
+		{
+			if ( i->ParentHrefs().size() != 1 )
+				continue ;
+			folders[i->SelfHref()] = std::make_pair( i->ParentHref(), i->Name() ) ;
+			if ( i->ParentHref() == "root" )
+				parts[i->Name()].insert( i->SelfHref() ) ;
+		}
+	}
+
+	Log( "Reading remote server file list", log::info ) ;
+	PartitionIndex index( limit / 4 ) ;
+	feed = m_syncer->GetAll() ;
+	while ( feed->GetNext( m_syncer->Agent() ) )
+	{
+		for ( Feed::iterator i = feed->begin() ; i != feed->end() ; ++i )
+		{
+			std::string part ;
+			if ( i->ParentHrefs().size() == 1 )
+				part = i->IsDir() && i->ParentHref() == "root" ? i->SelfHref() : TopFolder( folders, i->ParentHref() ) ;
+			index.Add( part, *i ) ;
+		}
+	}
+	feed.reset() ;
+	FolderMap().swap( folders ) ;
+
+	// folders which only exist locally
+	for ( fs::directory_iterator i( m_root ) ; i != fs::directory_iterator() ; ++i )
+	{
+		if ( fs::is_directory( i->status() ) )
+			parts[i->path().filename().string()] ;
+	}
+
+	// the state file is read once, into m_state. each part takes its
+	// folder out of it, and puts it back once written to its shard
+	std::set<std::string> names ;
+	for ( std::map<std::string, std::set<std::string> >::iterator p = parts.begin() ; p != parts.end() ; ++p )
+		names.insert( p->first ) ;
+	m_state.Skip( names ) ;
+
+	MoveCheck moves ;
+	for ( std::map<std::string, std::set<std::string> >::iterator p = parts.begin() ; p != parts.end() ; ++p )
+	{
+		Log( "Synchronizing folder %1%", p->first, log::info ) ;
+		if ( p->second.size() > 1 )
+			Log( "%1% remote folders are named %2%, they are synced into the same local folder",
+				p->second.size(), p->first, log::warning ) ;
+
+		State state( m_state, p->first, m_options ) ;
+		SyncPartition( state, index, p->second, p->first, limit, moves, dry_run ) ;
+		if ( !dry_run )
+			state.PutBack( m_state ) ;
+	}
+
+	Log( "Synchronizing files in the root folder", log::info ) ;
+	std::set<std::string> rest ;
+	rest.insert( "" ) ;
+	SyncPartition( m_state, index, rest, "", limit, moves, dry_run ) ;
+	moves.Report() ;
+
+	if ( !dry_run )
+	{
+		UpdateChangeStamp() ;
+		m_state.Write() ;
+	}
+}
+
+/// Sync \a state with the remote entries of the \a keys of \a index. The
+/// part is named \a name, the root folder if empty.
+void Drive::SyncPartition( State& state, PartitionIndex& index, const std::set<std::string>& keys,
+	const std::string& name, std::size_t limit, MoveCheck& moves, bool dry_run )
+{
+	state.FromLocal( m_root ) ;
+	for ( std::set<std::string>::const_iterator k = keys.begin() ; k != keys.end() ; ++k )
+		index.Replay( *k, boost::bind( &State::FromRemote, &state, _1 ) ) ;
+	state.ResolveEntry() ;
+	moves.Add( state, name ) ;
+
+	state.Sync( dry_run ? NULL : m_syncer, m_options ) ;
+	std::string folder = name.empty() ? std::string( "/" ) : name ;
+	state.SampleMemory( "synchronizing folder " + folder ) ;
+
+	MemStats& stats = MemStats::Instance() ;
+	std::size_t bytes = stats.Bytes( MemStats::resources ) + stats.Bytes( MemStats::state ) ;
+	if ( bytes > limit )
+		Log( "folder %1% alone takes %2% MB, more than the memory limit", folder,
+			bytes / ( 1024 * 1024 ), log::warning ) ;
+}
+
+namespace
+{
+	/// compares the local checksums from the Verifier with the remote ones
+	/// and the state, and downloads corrupted files again
+	class VerifyReport
+	{
+	public :
+		VerifyReport( State& state, Syncer *syncer, bool repair ) :
+			m_state		( state ),
+			m_syncer	( syncer ),
+			m_repair	( repair ),
+			m_ok		( 0 ),
+			m_changed	( 0 ),
+			m_bad		( 0 ),
+			m_fixed		( 0 ),
+			m_state_changed( false )
+		{
+		}
+
+		void operator()( Resource *res, const Digest& local )
+		{
+			fs::path path = res->Path() ;
+			StateRecord *rec = m_state.Record( res->RelPath() ) ;
+			Digest st_md5 = rec != NULL ? rec->md5 : Digest() ;
+
+			if ( local.Empty() )
+			{
+				Log( "%1% can't be read", path, log::warning ) ;
+				m_bad++ ;
+			}
+			else if ( local == res->MD5() )
+			{
+				m_ok++ ;
+				if ( !st_md5.Empty() && st_md5 != local )
+				{
+					Log( "%1% has a wrong checksum in the state", path, log::warning ) ;
+					m_bad++ ;
+					if ( m_repair )
+					{
+						rec->md5 = local ;
+						rec->Set( StateRecord::md5_field ) ;
+						rec->Del( StateRecord::fp_field ) ;
+						m_state_changed = true ;
+						m_fixed++ ;
+					}
+				}
+			}
+			else if ( rec == NULL || !rec->Has( StateRecord::ctime_field ) || ( st_md5 != local && st_md5 != res->MD5() ) )
+			{
+				Log( "%1% differs from Google Drive and was not synced", path, log::info ) ;
+				m_changed++ ;
+			}
+			else if ( st_md5 == local )
+			{
+				Log( "%1% is changed in Google Drive since the last sync", path, log::verbose ) ;
+				m_changed++ ;
+			}
+			else
+			{
+				DateTime ctime ;
+				os::Stat( path, &ctime, NULL, NULL ) ;
+				if ( (u64_t)ctime.Sec() > rec->ctime )
+				{
+					Log( "%1% is changed locally since the last sync", path, log::verbose ) ;
+					m_changed++ ;
+				}
+				else
+				{
+					Log( "%1% is corrupted: checksum %2%, expected %3%", path, local, res->MD5(), log::warning ) ;
+					m_bad++ ;
+					if ( m_repair )
+						Repair( res, rec ) ;
+				}
+			}
+		}
+
+		void Summary() const
+		{
+			Log( "%1% files verified, %2% changed, %3% mismatches, %4% repaired",
+				m_ok, m_changed, m_bad, m_fixed, log::info ) ;
+		}
+
+		bool StateChanged() const
+		{
+			return m_state_changed ;
+		}
+
+	private :
+		/// download the file next to the corrupted one and replace it
+		void Repair( Resource *res, StateRecord *rec )
+		{
+			fs::path path = res->Path() ;
+			fs::path tmp = path.parent_path() / ( "." + path.filename().string() + ".grive_verify" ) ;
+
+			Log( "downloading %1% again", path, log::info ) ;
+			crypt::Fingerprint fp ;
+			try
+			{
+				m_syncer->Download( res, tmp ) ;
+				if ( crypt::MD5::Get( tmp, &fp ) != res->MD5() )
+				{
+					fs::remove( tmp ) ;
+					Log( "the download of %1% has a wrong checksum too, not replaced", path, log::error ) ;
+					return ;
+				}
+				fs::rename( tmp, path ) ;
+			}
+			catch ( ... )
+			{
+				boost::system::error_code ec ;
+				fs::remove( tmp, ec ) ;
+				throw ;
+			}
+
+			DateTime ctime ;
+			os::Stat( path, &ctime, NULL, NULL ) ;
+			rec->ctime = ctime.Sec() ;
+			rec->Set( StateRecord::ctime_field ) ;
+			rec->fp = fp.Get() ;
+			rec->Set( StateRecord::fp_field ) ;
+			m_state_changed = true ;
+			m_fixed++ ;
+		}
+
+	private :
+		State&		m_state ;
+		Syncer		*m_syncer ;
+		bool		m_repair ;
+		unsigned	m_ok, m_changed, m_bad, m_fixed ;
+		bool		m_state_changed ;
+	} ;
+}
+
+/// Check that the local files have the content of the remote ones, without
+/// downloading them. Each file in both places is read and compared with the
+/// remote checksum, and with the one saved in the state by the last sync.
+/// With \a repair, corrupted files are downloaded again and wrong
+/// checksums in the state are fixed.
+void Drive::Verify( bool repair )
+{
+	ReadRemote() ;
+
+	unsigned threads = m_options.Has( "verify-threads" ) ? m_options["verify-threads"].U64() : 2 ;
+	u64_t rate = m_options.Has( "verify-rate" ) ? m_options["verify-rate"].U64() * 1024 * 1024 : 0 ;
+	Verifier verifier( m_root / ".grive_verify", threads, rate ) ;
+
+	std::size_t count = 0 ;
+	for ( State::iterator i = m_state.begin() ; i != m_state.end() ; ++i )
+	{
+		Resource *res = *i ;
+		if ( !res->IsFolder() && !res->MD5().Empty() && res->IsInRootTree() &&
+			fs::is_regular_file( res->Path() ) && verifier.Add( res ) )
+			count++ ;
+	}
+
+	Log( "Verifying %1% files", count, log::info ) ;
+	VerifyReport report( m_state, m_syncer, repair ) ;
+	try
+	{
+		verifier.Run( boost::ref( report ) ) ;
+	}
+	catch ( ... )
+	{
+		if ( report.StateChanged() )
+			m_state.Write() ;
+		throw ;
+	}
+
+	report.Summary() ;
+	if ( report.StateChanged() )
+		m_state.Write() ;
+}
+
+/// The change stamp of the remote tree as of the last sync.
+long Drive::ChangeStamp() const
+{
+	return m_state.ChangeStamp() ;
+}
+
+/// The page token of the changes after the last sync, for the APIs which
+/// have page tokens instead of change stamps.
+const std::string& Drive::PageToken() const
+{
+	return m_state.PageToken() ;
+}
+
 void Drive::UpdateChangeStamp( )
 {
 	// FIXME: we should go through the changes to see if it was really Grive to made that change
 	// maybe by recording the updated timestamp and compare it?
 	m_state.ChangeStamp( m_syncer->GetChangeStamp( m_state.ChangeStamp()+1 ) );
+	m_state.PageToken( m_syncer->GetPageToken() );
 }
 
 } // end of namespace gr
@@ -24,6 +24,7 @@
 #include "json/Val.hh"
 #include "util/Exception.hh"
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -35,6 +36,8 @@ class Entry ;
 
 class State ;
 
+class PartitionIndex ;
+
 class Drive
 {
 public :
@@ -44,14 +47,22 @@ public :
 	void Update() ;
 	void DryRun() ;
 	void SaveState() ;
+	void SyncPartitioned( bool dry_run ) ;
+	void Verify( bool repair ) ;
+	long ChangeStamp() const ;
+	const std::string& PageToken() const ;
 	
 	struct Error : virtual Exception {} ;
 	
 private :
 	void ReadChanges() ;
+	void ReadRemote() ;
 	void FromRemote( const Entry& entry ) ;
 	void FromChange( const Entry& entry ) ;
 	void UpdateChangeStamp( ) ;
+	class MoveCheck ;
+	void SyncPartition( State& state, PartitionIndex& index, const std::set<std::string>& keys,
+		const std::string& name, std::size_t limit, MoveCheck& moves, bool dry_run ) ;
 	
 private :
 	Syncer			*m_syncer ;
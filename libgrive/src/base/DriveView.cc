@@ -0,0 +1,477 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "DriveView.hh"
+
+#include "Entry.hh"
+#include "Feed.hh"
+#include "FeedReader.hh"
+#include "Resource.hh"
+#include "Syncer.hh"
+
+#include "http/Agent.hh"
+#include "json/Val.hh"
+#include "util/File.hh"
+#include "util/OS.hh"
+#include "util/log/Log.hh"
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/bind.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace gr {
+
+namespace
+{
+	Val StateOptions( const fs::path& stage )
+	{
+		Val options ;
+		options.Add( "path", Val( stage.string() ) ) ;
+		return options ;
+	}
+
+	/// split "/a/b" into its parent "/a" and the name "b"
+	std::pair<std::string, std::string> SplitPath( const std::string& path )
+	{
+		std::size_t slash = path.find_last_of( '/' ) ;
+		if ( slash == std::string::npos )
+			return std::make_pair( std::string( "/" ), path ) ;
+		return std::make_pair( slash == 0 ? std::string( "/" ) : path.substr( 0, slash ), path.substr( slash + 1 ) ) ;
+	}
+}
+
+/// \param	cache_dir	holds the content chunks and the staged files
+/// \param	cache_size	bytes of file content kept in the cache
+/// \param	chunk_size	bytes downloaded at once
+DriveView::DriveView( Syncer *syncer, const fs::path& cache_dir, u64_t cache_size, std::size_t chunk_size ) :
+	m_syncer	( syncer ),
+	m_reader	( syncer->Agent()->Clone() ),
+	m_stage		( cache_dir / "staged" ),
+	m_state		( m_stage, StateOptions( m_stage ) ),
+	m_cache		( m_reader.get(), cache_dir / "chunks", cache_size, chunk_size )
+{
+	// staged files are not kept between mounts
+	fs::remove_all( m_stage ) ;
+	fs::create_directories( m_stage ) ;
+}
+
+DriveView::~DriveView()
+{
+}
+
+/// Read the metadata of the remote tree.
+void DriveView::Load()
+{
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+
+	std::unique_ptr<Feed> feed = m_syncer->GetAll() ;
+	FeedReader reader( feed.get(), m_syncer->Agent() ) ;
+	reader.Run( boost::bind( &State::FromRemote, &m_state, _1 ) ) ;
+	m_state.ResolveEntry() ;
+
+	// nothing is downloaded until it is read
+	for ( State::iterator i = m_state.begin() ; i != m_state.end() ; ++i )
+		(*i)->AssumeSync() ;
+}
+
+Resource* DriveView::Child( Resource *folder, const std::string& name )
+{
+	for ( Resource::iterator i = folder->begin() ; i != folder->end() ; ++i )
+	{
+		if ( (*i)->Name() == name && m_removed.count( *i ) == 0 )
+			return *i ;
+	}
+	return 0 ;
+}
+
+Resource* DriveView::Find( const std::string& path )
+{
+	std::vector<std::string> names ;
+	boost::algorithm::split( names, path, boost::is_any_of( "/" ) ) ;
+
+	Resource *res = m_state.FindByHref( "root" ) ;
+	for ( std::size_t i = 0 ; i < names.size() && res != 0 ; i++ )
+	{
+		if ( names[i].empty() )
+			continue ;
+		res = res->IsFolder() ? Child( res, names[i] ) : 0 ;
+	}
+	return res ;
+}
+
+/// Marks a resource busy while it is transferred. The other calls which
+/// change it, or upload files into it, wait until it is idle again.
+class DriveView::Busy
+{
+public :
+	Busy( DriveView *view, std::unique_lock<std::mutex>& lock, Resource *res ) :
+		m_view( view ),
+		m_res( res )
+	{
+		// a file is uploaded into its folder once the folder is created
+		while ( view->m_busy.count( res ) > 0 || view->m_busy.count( res->Parent() ) > 0 )
+			view->m_idle.wait( lock ) ;
+
+		// fill the cached paths now, as the transfer reads them without the lock
+		res->Path() ;
+		view->m_busy.insert( res ) ;
+	}
+
+	// called with the lock held again
+	~Busy()
+	{
+		m_view->m_busy.erase( m_res ) ;
+		m_view->m_idle.notify_all() ;
+	}
+
+private :
+	DriveView	*m_view ;
+	Resource	*m_res ;
+} ;
+
+/// Lets go of the lock for a transfer on the connection of the Syncer.
+class DriveView::Transfer
+{
+public :
+	Transfer( DriveView *view, std::unique_lock<std::mutex>& lock ) :
+		m_lock( lock ),
+		m_turn( view->m_transfer, std::defer_lock )
+	{
+		m_lock.unlock() ;
+		m_turn.lock() ;
+	}
+
+	~Transfer()
+	{
+		m_turn.unlock() ;
+		m_lock.lock() ;
+	}
+
+private :
+	std::unique_lock<std::mutex>&	m_lock ;
+	std::unique_lock<std::mutex>	m_turn ;
+} ;
+
+/// Wait until \a res is not transferred any more.
+/// \return	false if it was removed meanwhile
+bool DriveView::WaitIdle( std::unique_lock<std::mutex>& lock, Resource *res )
+{
+	while ( m_busy.count( res ) > 0 )
+		m_idle.wait( lock ) ;
+	return m_removed.count( res ) == 0 ;
+}
+
+bool DriveView::GetAttr( const std::string& path, Attr& attr )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = Find( path ) ;
+	if ( res == 0 )
+		return false ;
+
+	// files being written have their size and time on disk, and are not
+	// looked at while they are uploaded
+	if ( m_staged.count( res ) > 0 )
+	{
+		off64_t size = 0 ;
+		os::Stat( res->Path(), &attr.mtime, &size, 0 ) ;
+		attr.is_dir		= false ;
+		attr.editable	= true ;
+		attr.size		= size ;
+		return true ;
+	}
+
+	if ( !WaitIdle( lock, res ) )
+		return false ;
+
+	attr.is_dir		= res->IsFolder() ;
+	attr.editable	= res->IsEditable() ;
+	attr.size		= res->Size() ;
+	attr.mtime		= res->ServerTime() ;
+	return true ;
+}
+
+bool DriveView::List( const std::string& path, std::vector<std::string>& names )
+{
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = Find( path ) ;
+	if ( res == 0 || !res->IsFolder() )
+		return false ;
+
+	for ( Resource::iterator i = res->begin() ; i != res->end() ; ++i )
+	{
+		if ( m_removed.count( *i ) == 0 )
+			names.push_back( (*i)->Name() ) ;
+	}
+	return true ;
+}
+
+std::size_t DriveView::Read( const std::string& path, u64_t offset, char *buf, std::size_t count )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = Find( path ) ;
+	if ( res == 0 || res->IsFolder() )
+		BOOST_THROW_EXCEPTION( Error() << boost::errinfo_file_name( path ) ) ;
+
+	if ( m_staged.count( res ) > 0 )
+	{
+		File file( res->Path() ) ;
+		file.Seek( offset, SEEK_SET ) ;
+		return file.Read( buf, count ) ;
+	}
+
+	if ( !WaitIdle( lock, res ) )
+		BOOST_THROW_EXCEPTION( Error() << boost::errinfo_file_name( path ) ) ;
+	ContentCache::Source src( res ) ;
+	lock.unlock() ;
+
+	// the cache downloads on its own connection, so that reads don't
+	// wait for uploads
+	return m_cache.Read( src, offset, buf, count ) ;
+}
+
+/// Copy the file to the staging directory for writing. Called with \a res
+/// marked busy.
+void DriveView::Stage( std::unique_lock<std::mutex>& lock, Resource *res, bool download )
+{
+	if ( m_staged.count( res ) > 0 )
+		return ;
+
+	fs::path file = res->Path() ;
+	fs::create_directories( file.parent_path() ) ;
+	if ( download )
+	{
+		Transfer t( this, lock ) ;
+		m_syncer->Download( res, file ) ;
+	}
+	else
+		File().OpenForWrite( file ) ;
+
+	Staged s = { !download, 0 } ;
+	m_staged[res] = s ;
+}
+
+bool DriveView::Open( const std::string& path, bool truncate )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = Find( path ) ;
+	if ( res == 0 || res->IsFolder() )
+		return false ;
+
+	Busy busy( this, lock, res ) ;
+	if ( m_removed.count( res ) > 0 )
+		return false ;
+
+	Stage( lock, res, !truncate && res->HasID() ) ;
+	Staged& s = m_staged[res] ;
+	s.open++ ;
+	if ( truncate )
+	{
+		File().OpenForWrite( res->Path() ) ;
+		s.dirty = true ;
+	}
+	return true ;
+}
+
+std::size_t DriveView::Write( const std::string& path, u64_t offset, const char *buf, std::size_t count )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	// changes made during an upload would be lost when it is over
+	Resource *res = Find( path ) ;
+	if ( res == 0 || !WaitIdle( lock, res ) || m_staged.count( res ) == 0 )
+		BOOST_THROW_EXCEPTION( Error() << boost::errinfo_file_name( path ) ) ;
+
+	File file ;
+	file.OpenForUpdate( res->Path() ) ;
+	file.Seek( offset, SEEK_SET ) ;
+	std::size_t w = file.Write( buf, count ) ;
+	m_staged[res].dirty = true ;
+	return w ;
+}
+
+bool DriveView::Truncate( const std::string& path, u64_t size )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = Find( path ) ;
+	if ( res == 0 || res->IsFolder() )
+		return false ;
+
+	Busy busy( this, lock, res ) ;
+	if ( m_removed.count( res ) > 0 )
+		return false ;
+
+	Stage( lock, res, size > 0 && res->HasID() ) ;
+	fs::resize_file( res->Path(), size ) ;
+	Staged& s = m_staged[res] ;
+	s.dirty = true ;
+
+	// truncate() without an open file is uploaded right away
+	if ( s.open == 0 )
+		Upload( lock, res, path ) ;
+	return true ;
+}
+
+/// Upload the file if it was changed and this was the last open handle.
+bool DriveView::Release( const std::string& path )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = Find( path ) ;
+	if ( res == 0 )
+		return false ;
+
+	Busy busy( this, lock, res ) ;
+	if ( m_removed.count( res ) > 0 || m_staged.count( res ) == 0 )
+		return false ;
+
+	Staged& s = m_staged[res] ;
+	if ( s.open > 0 )
+		s.open-- ;
+	if ( s.open > 0 || !s.dirty )
+		return true ;
+
+	Upload( lock, res, path ) ;
+	return true ;
+}
+
+/// Write back a staged file through the usual upload path. Called with
+/// \a res marked busy.
+void DriveView::Upload( std::unique_lock<std::mutex>& lock, Resource *res, const std::string& path )
+{
+	Log( "uploading %1%", path, log::info ) ;
+	bool ok = false ;
+	{
+		Transfer t( this, lock ) ;
+		ok = res->HasID() ? m_syncer->EditContent( res, false ) : m_syncer->Create( res ) ;
+	}
+	if ( !ok )
+		BOOST_THROW_EXCEPTION( Error() << boost::errinfo_file_name( path ) ) ;
+
+	m_staged[res].dirty = false ;
+}
+
+Resource* DriveView::NewChild( const std::string& path, const std::string& kind )
+{
+	std::pair<std::string, std::string> p = SplitPath( path ) ;
+	Resource *parent = Find( p.first ) ;
+	if ( parent == 0 || !parent->IsFolder() || Child( parent, p.second ) != 0 )
+		return 0 ;
+
+	m_new.push_back( std::unique_ptr<Resource>( new Resource( p.second, kind ) ) ) ;
+	Resource *res = m_new.back().get() ;
+	parent->AddChild( res ) ;
+	return res ;
+}
+
+/// Create an empty file. It is uploaded when it is released.
+bool DriveView::Create( const std::string& path )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = NewChild( path, "file" ) ;
+	if ( res == 0 )
+		return false ;
+
+	Stage( lock, res, false ) ;
+	m_staged[res].open++ ;
+	return true ;
+}
+
+bool DriveView::Mkdir( const std::string& path )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = NewChild( path, "folder" ) ;
+	if ( res == 0 )
+		return false ;
+
+	Busy busy( this, lock, res ) ;
+	bool ok = false ;
+	try
+	{
+		Transfer t( this, lock ) ;
+		ok = m_syncer->Create( res ) ;
+	}
+	catch ( ... )
+	{
+		m_removed.insert( res ) ;
+		throw ;
+	}
+	if ( !ok )
+	{
+		m_removed.insert( res ) ;
+		BOOST_THROW_EXCEPTION( Error() << boost::errinfo_file_name( path ) ) ;
+	}
+	res->AssumeSync() ;
+	return true ;
+}
+
+/// Move the file or folder to the trash. It is hidden from the other calls
+/// while it is deleted.
+bool DriveView::Remove( const std::string& path )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+
+	Resource *res = Find( path ) ;
+	if ( res == 0 || res->IsRoot() )
+		return false ;
+
+	Busy busy( this, lock, res ) ;
+	if ( m_removed.count( res ) > 0 )
+		return false ;
+
+	m_removed.insert( res ) ;
+	if ( res->HasID() )
+	{
+		try
+		{
+			Transfer t( this, lock ) ;
+			m_syncer->DeleteRemote( res ) ;
+		}
+		catch ( ... )
+		{
+			m_removed.erase( res ) ;
+			throw ;
+		}
+	}
+
+	if ( m_staged.count( res ) > 0 )
+	{
+		boost::system::error_code ec ;
+		fs::remove( res->Path(), ec ) ;
+		m_staged.erase( res ) ;
+	}
+	return true ;
+}
+
+ContentCache& DriveView::Cache()
+{
+	return m_cache ;
+}
+
+} // end of namespace gr
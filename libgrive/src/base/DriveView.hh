@@ -0,0 +1,141 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "ContentCache.hh"
+#include "State.hh"
+
+#include "util/DateTime.hh"
+#include "util/Exception.hh"
+#include "util/FileSystem.hh"
+#include "util/Types.hh"
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gr {
+
+namespace http
+{
+	class Agent ;
+}
+
+class Resource ;
+
+class Syncer ;
+
+class Val ;
+
+/*!	\brief	the remote tree as seen by grive-fuse
+
+	The metadata of the whole tree is read once from the remote file list, so
+	that sizes and modification times are known without downloading anything.
+	File content is read through a ContentCache. Files opened for writing are
+	copied to a staging directory and uploaded with the Syncer when they are
+	released.
+
+	The lock is not held during uploads and downloads: the resource being
+	transferred is marked busy instead, and the calls which change it wait
+	for the transfer. Files being written are looked up on disk, so that
+	they can be listed while they are uploaded.
+
+	Paths are absolute within the mount, e.g. "/folder/file".
+*/
+class DriveView
+{
+public :
+	struct Error : virtual Exception {} ;
+
+	struct Attr
+	{
+		bool		is_dir ;
+		bool		editable ;
+		u64_t		size ;
+		DateTime	mtime ;
+	} ;
+
+public :
+	DriveView( Syncer *syncer, const fs::path& cache_dir, u64_t cache_size, std::size_t chunk_size = 4 << 20 ) ;
+	~DriveView() ;
+
+	void Load() ;
+
+	bool GetAttr( const std::string& path, Attr& attr ) ;
+	bool List( const std::string& path, std::vector<std::string>& names ) ;
+	std::size_t Read( const std::string& path, u64_t offset, char *buf, std::size_t count ) ;
+
+	bool Open( const std::string& path, bool truncate ) ;
+	std::size_t Write( const std::string& path, u64_t offset, const char *buf, std::size_t count ) ;
+	bool Truncate( const std::string& path, u64_t size ) ;
+	bool Release( const std::string& path ) ;
+
+	bool Create( const std::string& path ) ;
+	bool Mkdir( const std::string& path ) ;
+	bool Remove( const std::string& path ) ;
+
+	ContentCache& Cache() ;
+
+private :
+	Resource* Find( const std::string& path ) ;
+	Resource* Child( Resource *folder, const std::string& name ) ;
+	Resource* NewChild( const std::string& path, const std::string& kind ) ;
+	void Stage( std::unique_lock<std::mutex>& lock, Resource *res, bool download ) ;
+	void Upload( std::unique_lock<std::mutex>& lock, Resource *res, const std::string& path ) ;
+	bool WaitIdle( std::unique_lock<std::mutex>& lock, Resource *res ) ;
+
+	class Busy ;
+	class Transfer ;
+
+private :
+	/// local copy of a file being written
+	struct Staged
+	{
+		bool		dirty ;
+		unsigned	open ;
+	} ;
+
+private :
+	Syncer							*m_syncer ;
+	std::unique_ptr<http::Agent>	m_reader ;
+	fs::path						m_stage ;
+	State							m_state ;
+	ContentCache					m_cache ;
+
+	std::mutex						m_mutex ;
+	std::map<Resource*, Staged>		m_staged ;
+	std::set<Resource*>				m_removed ;
+
+	// resources being transferred without m_mutex
+	std::set<Resource*>				m_busy ;
+	std::condition_variable			m_idle ;
+
+	// the Syncer has a single connection, which the transfers take in turns
+	std::mutex						m_transfer ;
+
+	// resources created in the mount, which are not in the State
+	std::vector<std::unique_ptr<Resource> >	m_new ;
+} ;
+
+} // end of namespace gr
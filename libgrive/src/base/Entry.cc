@@ -20,6 +20,7 @@
 #include "Entry.hh"
 
 #include "util/Crypt.hh"
+#include "util/MemStats.hh"
 #include "util/log/Log.hh"
 #include "util/OS.hh"
 #include "xml/Node.hh"
@@ -61,7 +62,7 @@ bool Entry::IsDir() const
 	return m_is_dir ;
 }
 
-std::string Entry::MD5() const
+Digest Entry::MD5() const
 {
 	return m_md5 ;
 }
@@ -121,6 +122,18 @@ bool Entry::IsRemoved() const
 	return m_is_removed ;
 }
 
+/// The heap taken by the strings of the entry, see MemStats
+std::size_t Entry::MemUsage() const
+{
+	std::size_t bytes = MemStats::Heap( m_title ) + MemStats::Heap( m_filename ) +
+		MemStats::Heap( m_etag ) + MemStats::Heap( m_resource_id ) +
+		MemStats::Heap( m_self_href ) + MemStats::Heap( m_content_src ) +
+		MemStats::Block( m_parent_hrefs.size() * sizeof(std::string) ) ;
+	for ( std::size_t i = 0 ; i < m_parent_hrefs.size() ; i++ )
+		bytes += MemStats::Heap( m_parent_hrefs[i] ) ;
+	return bytes ;
+}
+
 std::string Entry::Name() const
 {
 	return !m_filename.empty() ? m_filename : m_title ;
@@ -21,6 +21,7 @@
 
 #include "util/Types.hh"
 #include "util/DateTime.hh"
+#include "util/Digest.hh"
 #include "util/FileSystem.hh"
 
 #include <iosfwd>
@@ -43,7 +44,7 @@ public :
 	std::string Title() const ;
 	std::string Filename() const ;
 	bool IsDir() const ;
-	std::string MD5() const ;
+	Digest MD5() const ;
 	DateTime MTime() const ;
 	u64_t Size() const ;
 	
@@ -62,12 +63,14 @@ public :
 	bool IsRemoved() const ;
 	
 	const std::vector<std::string>& ParentHrefs() const ;
+
+	std::size_t MemUsage() const ;
 	
 protected :
 	std::string		m_title ;
 	std::string		m_filename ;
 	bool			m_is_dir ;
-	std::string		m_md5 ;
+	Digest			m_md5 ;
 	std::string		m_etag ;
 	std::string		m_resource_id ;
 
@@ -44,4 +44,11 @@ Feed::iterator Feed::end() const
 	return m_entries.end() ;
 }
 
+/// The page token to read the next changes from, once the last page of a
+/// changes feed is read. Empty for the feeds without page tokens.
+const std::string& Feed::NextChanges() const
+{
+	return m_next_changes ;
+}
+
 } // end of namespace gr::v1
@@ -44,10 +44,14 @@ public :
 	virtual ~Feed() = 0 ;
 	iterator begin() const ;
 	iterator end() const ;
+	const std::string& NextChanges() const ;
 
 protected :
 	Entries m_entries ;
 	std::string m_next ;
+
+	// the page token of the changes after these, given with the last page
+	std::string m_next_changes ;
 } ;
 
 } // end of namespace gr
@@ -0,0 +1,106 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "FeedReader.hh"
+
+#include "Entry.hh"
+
+#include "http/Agent.hh"
+#include "util/MemStats.hh"
+
+#include <thread>
+
+namespace gr {
+
+namespace
+{
+	// the entries read ahead are counted in MemStats::feed until applied
+	std::size_t PageUsage( const Feed::Entries& page )
+	{
+		std::size_t bytes = MemStats::Block( page.size() * sizeof(Entry) ) ;
+		for ( Feed::iterator i = page.begin() ; i != page.end() ; ++i )
+			bytes += i->MemUsage() ;
+		return bytes ;
+	}
+}
+
+/// \param	agent	used by the reading thread only, the calling thread must
+///					not send requests with it until Run() returns
+/// \param	ahead	the most pages read but not handed to the callback yet
+FeedReader::FeedReader( Feed *feed, http::Agent *agent, std::size_t ahead ) :
+	m_feed	( feed ),
+	m_agent	( agent ),
+	m_stop	( false ),
+	m_pages	( ahead > 0 ? ahead : 1 )
+{
+}
+
+void FeedReader::Run( const Callback& callback )
+{
+	std::thread reader( &FeedReader::Worker, this, &MemStats::Instance() ) ;
+
+	Feed::Entries page ;
+	std::size_t bytes = 0 ;
+	try
+	{
+		while ( m_pages.Pop( page ) )
+		{
+			bytes = PageUsage( page ) ;
+			for ( Feed::iterator i = page.begin() ; i != page.end() ; ++i )
+				callback( *i ) ;
+			MemStats::Instance().Remove( MemStats::feed, bytes ) ;
+			bytes = 0 ;
+		}
+	}
+	catch ( ... )
+	{
+		// unblock the reader, it stops after the page it is reading
+		m_stop = true ;
+		MemStats::Instance().Remove( MemStats::feed, bytes ) ;
+		while ( m_pages.Pop( page ) )
+			MemStats::Instance().Remove( MemStats::feed, PageUsage( page ) ) ;
+		reader.join() ;
+		throw ;
+	}
+	reader.join() ;
+
+	if ( m_error )
+		std::rethrow_exception( m_error ) ;
+}
+
+void FeedReader::Worker( MemStats *stats )
+{
+	MemStats::Scope scope( *stats ) ;
+	try
+	{
+		while ( !m_stop && m_feed->GetNext( m_agent ) )
+		{
+			Feed::Entries page( m_feed->begin(), m_feed->end() ) ;
+			stats->Add( MemStats::feed, PageUsage( page ) ) ;
+			m_pages.Push( page ) ;
+		}
+	}
+	catch ( ... )
+	{
+		m_error = std::current_exception() ;
+	}
+	m_pages.Close() ;
+}
+
+} // end of namespace gr
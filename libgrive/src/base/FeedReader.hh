@@ -0,0 +1,70 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "Feed.hh"
+
+#include "util/SyncQueue.hh"
+
+#include <boost/function.hpp>
+
+#include <atomic>
+#include <exception>
+
+namespace gr {
+
+namespace http
+{
+	class Agent ;
+}
+
+class Entry ;
+class MemStats ;
+
+/*!	\brief	reads the pages of a feed ahead in a thread of its own
+
+	The next pages are downloaded and decoded while the entries of the
+	previous ones are handed to the callback in the calling thread, so the
+	resource tree is still only changed by one thread.
+*/
+class FeedReader
+{
+public :
+	typedef boost::function<void ( const Entry& )> Callback ;
+
+public :
+	FeedReader( Feed *feed, http::Agent *agent, std::size_t ahead = 4 ) ;
+
+	void Run( const Callback& callback ) ;
+
+private :
+	void Worker( MemStats *stats ) ;
+
+private :
+	Feed					*m_feed ;
+	http::Agent				*m_agent ;
+
+	std::atomic<bool>		m_stop ;
+	std::exception_ptr		m_error ;
+
+	SyncQueue<Feed::Entries>	m_pages ;
+} ;
+
+} // end of namespace gr
@@ -0,0 +1,163 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "FolderLister.hh"
+
+#include "Entry.hh"
+#include "Syncer.hh"
+
+#include "http/Agent.hh"
+#include "util/MemStats.hh"
+#include "util/log/Log.hh"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace gr {
+
+FolderLister::FolderLister( Syncer *syncer, unsigned threads, std::size_t ahead ) :
+	m_syncer	( syncer ),
+	m_threads	( threads > 0 ? threads : 1 ),
+	m_busy		( 0 ),
+	m_running	( 0 ),
+	m_stop		( false ),
+	m_out		( ahead > 0 ? ahead : 1 )
+{
+}
+
+void FolderLister::Run( const Callback& callback )
+{
+	m_folders.push_back( "root" ) ;
+	m_seen.insert( "root" ) ;
+
+	// curl handles can't be shared between threads
+	std::vector<std::unique_ptr<http::Agent> > agents ;
+	for ( unsigned i = 0 ; i < m_threads ; i++ )
+		agents.push_back( m_syncer->Agent()->Clone() ) ;
+
+	m_running = m_threads ;
+	std::vector<std::thread> threads ;
+	for ( unsigned i = 0 ; i < m_threads ; i++ )
+		threads.push_back( std::thread( &FolderLister::Worker, this, agents[i].get(), &MemStats::Instance() ) ) ;
+
+	// an entry with several parents is listed once for each of them
+	std::set<std::string> multi ;
+	Feed::Entries batch ;
+	try
+	{
+		while ( m_out.Pop( batch ) )
+		{
+			for ( Feed::iterator i = batch.begin() ; i != batch.end() ; ++i )
+			{
+				if ( i->ParentHrefs().size() <= 1 || multi.insert( i->ResourceID() ).second )
+					callback( *i ) ;
+			}
+		}
+	}
+	catch ( ... )
+	{
+		// unblock the workers, they stop after the page they are reading
+		{
+			std::lock_guard<std::mutex> lock( m_mutex ) ;
+			m_stop = true ;
+			m_cond.notify_all() ;
+		}
+		while ( m_out.Pop( batch ) )
+			;
+		for ( unsigned i = 0 ; i < threads.size() ; i++ )
+			threads[i].join() ;
+		throw ;
+	}
+
+	for ( unsigned i = 0 ; i < threads.size() ; i++ )
+		threads[i].join() ;
+
+	if ( m_error )
+		std::rethrow_exception( m_error ) ;
+}
+
+/// Wait for a folder to list.
+/// \return	false if all folders are listed, or listing failed or was stopped
+bool FolderLister::NextFolder( std::string& id )
+{
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+	while ( m_folders.empty() && m_busy > 0 && !m_error && !m_stop )
+		m_cond.wait( lock ) ;
+	if ( m_folders.empty() || m_error || m_stop )
+	{
+		m_cond.notify_all() ;
+		return false ;
+	}
+	id = m_folders.front() ;
+	m_folders.pop_front() ;
+	m_busy++ ;
+	return true ;
+}
+
+void FolderLister::Worker( http::Agent *agent, MemStats *stats )
+{
+	MemStats::Scope scope( *stats ) ;
+	std::string id ;
+	while ( NextFolder( id ) )
+	{
+		try
+		{
+			// the syncer may need a request of its own to build the query
+			std::unique_ptr<Feed> feed ;
+			{
+				std::lock_guard<std::mutex> lock( m_mutex ) ;
+				feed = m_syncer->GetChildren( id ) ;
+			}
+			while ( !m_stop && feed->GetNext( agent ) )
+			{
+				Feed::Entries batch( feed->begin(), feed->end() ) ;
+				{
+					std::lock_guard<std::mutex> lock( m_mutex ) ;
+					for ( Feed::iterator i = batch.begin() ; i != batch.end() ; ++i )
+					{
+						if ( i->IsDir() && !i->IsRemoved() && m_seen.insert( i->ResourceID() ).second )
+							m_folders.push_back( i->ResourceID() ) ;
+					}
+					m_cond.notify_all() ;
+				}
+
+				// waits for room without the lock, the others go on listing
+				m_out.Push( batch ) ;
+			}
+		}
+		catch ( ... )
+		{
+			std::lock_guard<std::mutex> lock( m_mutex ) ;
+			if ( !m_error )
+				m_error = std::current_exception() ;
+		}
+
+		std::lock_guard<std::mutex> lock( m_mutex ) ;
+		m_busy-- ;
+		m_cond.notify_all() ;
+	}
+
+	// the last thread to finish ends the output
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	if ( --m_running == 0 )
+		m_out.Close() ;
+}
+
+} // end of namespace gr
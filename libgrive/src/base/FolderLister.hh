@@ -0,0 +1,86 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "Feed.hh"
+
+#include "util/SyncQueue.hh"
+
+#include <boost/function.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace gr {
+
+namespace http
+{
+	class Agent ;
+}
+
+class Entry ;
+class MemStats ;
+
+class Syncer ;
+
+/*!	\brief	lists the remote tree folder by folder over several connections
+
+	Starting from the root, the children of each folder are listed with their
+	own query. Sub-folders found on the way are queued for the other threads,
+	so the number of requests in flight grows with the breadth of the tree.
+	The entries are handed to the callback in the calling thread. At most
+	\a ahead pages wait for it, the listing threads wait for room after that.
+*/
+class FolderLister
+{
+public :
+	typedef boost::function<void ( const Entry& )> Callback ;
+
+public :
+	FolderLister( Syncer *syncer, unsigned threads, std::size_t ahead = 8 ) ;
+
+	void Run( const Callback& callback ) ;
+
+private :
+	void Worker( http::Agent *agent, MemStats *stats ) ;
+	bool NextFolder( std::string& id ) ;
+
+private :
+	Syncer					*m_syncer ;
+	unsigned				m_threads ;
+
+	std::mutex				m_mutex ;
+	std::condition_variable	m_cond ;
+	std::deque<std::string>	m_folders ;
+	std::set<std::string>	m_seen ;
+	unsigned				m_busy ;
+	unsigned				m_running ;
+	std::exception_ptr		m_error ;
+	std::atomic<bool>		m_stop ;
+
+	SyncQueue<Feed::Entries>	m_out ;
+} ;
+
+} // end of namespace gr
@@ -0,0 +1,510 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "MultiRoot.hh"
+
+#include "Drive.hh"
+#include "State.hh"
+#include "Syncer.hh"
+
+#include "drive2/Syncer2.hh"
+#include "drive3/Syncer3.hh"
+#include "http/CurlAgent.hh"
+#include "http/Lanes.hh"
+#include "http/Receiver.hh"
+#include "json/JsonParser.hh"
+#include "json/Val.hh"
+#include "protocol/AuthAgent.hh"
+#include "protocol/OAuth2.hh"
+#include "util/Config.hh"
+#include "util/DateTime.hh"
+#include "util/Destroy.hh"
+#include "util/File.hh"
+#include "util/MemStats.hh"
+#include "util/SyncQueue.hh"
+#include "util/log/Log.hh"
+
+#include <boost/bind.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <random>
+#include <thread>
+
+namespace gr {
+
+namespace
+{
+	// polling slows down to this many times the interval while nothing changes
+	const unsigned max_backoff = 16 ;
+
+	// seconds before it expires that a channel is renewed
+	const std::time_t renew_margin = 3600 ;
+
+	// seconds to wait before trying again to open a channel
+	const std::time_t watch_retry = 3600 ;
+
+	std::string RandomHex( std::size_t bytes )
+	{
+		static const char digits[] = "0123456789abcdef" ;
+		std::random_device random ;
+		std::string hex ;
+		for ( std::size_t i = 0 ; i < bytes ; i++ )
+		{
+			unsigned b = random() & 0xff ;
+			hex += digits[b >> 4] ;
+			hex += digits[b & 0xf] ;
+		}
+		return hex ;
+	}
+
+	void CountChange( unsigned *count, const std::string&, const Resource* )
+	{
+		++*count ;
+	}
+}
+
+struct MultiRoot::Root
+{
+	Root() : retry_watch( 0 ), notified( false ), busy( false ), stamp( -1 ), interval( 0 )
+	{
+	}
+
+	/// whether changes in Google Drive are pushed, rather than polled for
+	bool Watched() const
+	{
+		return channel.expiration > std::time( 0 ) + renew_margin ;
+	}
+
+	fs::path					path ;
+	std::unique_ptr<Config>		config ;
+
+	// only changed by the thread syncing the root
+	MemStats					stats ;
+
+	// the rest is only used by Serve(), and guarded by m_mutex
+	Channel						channel ;
+	std::time_t					retry_watch ;
+	bool						notified ;
+	bool						busy ;
+	long						stamp ;
+	std::string					page_token ;
+	unsigned					interval ;
+	std::chrono::steady_clock::time_point	due ;
+} ;
+
+/// the access token of an account, and the agent used to refresh it
+struct MultiRoot::Account
+{
+	std::unique_ptr<http::Agent>	http ;
+	std::unique_ptr<OAuth2>			token ;
+} ;
+
+MultiRoot::MultiRoot( const Config& cmd, const fs::path& roots, const http::Agent *http ) :
+	m_http		( http ),
+	m_first		( 0 ),
+	m_bind		( "127.0.0.1" ),
+	m_port		( 8080 ),
+	m_interval	( 0 ),
+	m_stop		( false )
+{
+	Val options = cmd.GetAll() ;
+	if ( options.Has( "watch-address" ) )
+		m_address = options["watch-address"].Str() ;
+	if ( options.Has( "watch-bind" ) )
+		m_bind = options["watch-bind"].Str() ;
+	if ( options.Has( "watch-port" ) )
+		m_port = options["watch-port"].U64() ;
+
+	File file( roots ) ;
+	Val list = ParseJson( file ) ;
+
+	const Val::Array& array = list.AsArray() ;
+	for ( Val::Array::const_iterator i = array.begin() ; i != array.end() ; ++i )
+	{
+		std::unique_ptr<Root> root( new Root ) ;
+		root->path = (*i)["path"].Str() ;
+		root->config.reset( new Config( cmd, root->path,
+			i->Has( "config" ) ? (*i)["config"].Str() : std::string() ) ) ;
+		m_roots.push_back( root.release() ) ;
+	}
+}
+
+MultiRoot::~MultiRoot()
+{
+	std::for_each( m_roots.begin(), m_roots.end(), Destroy() ) ;
+	for ( std::map<std::string, Account*>::iterator i = m_accounts.begin() ; i != m_accounts.end() ; ++i )
+		delete i->second ;
+}
+
+std::size_t MultiRoot::Count() const
+{
+	return m_roots.size() ;
+}
+
+/// The memory taken by the \a root th root, as of its last sync.
+const MemStats& MultiRoot::Stats( std::size_t root ) const
+{
+	return m_roots.at( root )->stats ;
+}
+
+/// Sync every root once, in \a threads threads. A root that fails is
+/// logged and doesn't stop the others.
+/// \return	the number of roots that failed
+unsigned MultiRoot::Run( unsigned threads )
+{
+	std::vector<Root*> roots ;
+	for ( std::size_t i = 0 ; i < m_roots.size() ; i++ )
+		roots.push_back( m_roots[(m_first + i) % m_roots.size()] ) ;
+
+	// the next pass starts with the next root, so that no root always
+	// waits for all the others
+	if ( !m_roots.empty() )
+		m_first = ( m_first + 1 ) % m_roots.size() ;
+
+	return Run( threads, roots ) ;
+}
+
+unsigned MultiRoot::Run( unsigned threads, const std::vector<Root*>& roots )
+{
+	SyncQueue<Root*> queue ;
+	for ( std::size_t i = 0 ; i < roots.size() ; i++ )
+		queue.Push( roots[i] ) ;
+	queue.Close() ;
+
+	unsigned failed = 0 ;
+	std::vector<std::thread> workers ;
+	for ( unsigned i = 0 ; i < std::max( threads, 1u ) ; i++ )
+		workers.push_back( std::thread( &MultiRoot::Worker, this, &queue, &failed ) ) ;
+	for ( std::size_t i = 0 ; i < workers.size() ; i++ )
+		workers[i].join() ;
+
+	return failed ;
+}
+
+/// Keep syncing the roots, each one when it may have changed, until Stop()
+/// is called. The syncs in progress are finished before it returns.
+/// \param	interval	seconds between two polls of a root which changes
+void MultiRoot::Serve( unsigned threads, unsigned interval )
+{
+	m_interval = std::max( interval, 1u ) ;
+
+	std::unique_ptr<http::Receiver> receiver ;
+	if ( !m_address.empty() )
+	{
+		receiver.reset( new http::Receiver( m_bind, m_port, boost::bind( &MultiRoot::Notify, this, _1 ) ) ) ;
+		Log( "receiving change notifications for %1% on %2%:%3%", m_address, m_bind, receiver->Port(), log::info ) ;
+	}
+
+	// the queue is never closed, the workers wait for the next due root
+	SyncQueue<Root*> queue ;
+	unsigned failed = 0 ;
+	std::vector<std::thread> workers ;
+	for ( unsigned i = 0 ; i < std::max( threads, 1u ) ; i++ )
+		workers.push_back( std::thread( &MultiRoot::Worker, this, &queue, &failed ) ) ;
+
+	std::unique_lock<std::mutex> lock( m_mutex ) ;
+	for ( std::size_t i = 0 ; i < m_roots.size() ; i++ )
+		m_roots[i]->due = std::chrono::steady_clock::now() ;
+
+	while ( !m_stop )
+	{
+		std::chrono::steady_clock::time_point next ;
+		std::vector<Root*> due = Due( next ) ;
+		for ( std::size_t i = 0 ; i < due.size() ; i++ )
+			queue.Push( due[i] ) ;
+		m_wake.wait_until( lock, next ) ;
+	}
+	lock.unlock() ;
+
+	queue.Close() ;
+	for ( std::size_t i = 0 ; i < workers.size() ; i++ )
+		workers[i].join() ;
+}
+
+/// Make Serve() return. Can be called from any thread.
+void MultiRoot::Stop()
+{
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	m_stop = true ;
+	m_wake.notify_all() ;
+}
+
+/// Take the roots to sync now, and find when the next one is due. Call with
+/// m_mutex held.
+std::vector<MultiRoot::Root*> MultiRoot::Due( std::chrono::steady_clock::time_point& next )
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now() ;
+	next = now + std::chrono::hours( 1 ) ;
+
+	std::vector<Root*> due ;
+	for ( std::size_t i = 0 ; i < m_roots.size() ; i++ )
+	{
+		Root *root = m_roots[i] ;
+		if ( root->busy )
+			continue ;
+		if ( root->notified || root->due <= now )
+		{
+			root->busy = true ;
+			due.push_back( root ) ;
+		}
+		else
+			next = std::min( next, root->due ) ;
+	}
+	return due ;
+}
+
+/// Handle a push notification, see http::Receiver.
+void MultiRoot::Notify( const std::map<std::string, std::string>& fields )
+{
+	std::map<std::string, std::string>::const_iterator
+		id		= fields.find( "x-goog-channel-id" ),
+		token	= fields.find( "x-goog-channel-token" ),
+		state	= fields.find( "x-goog-resource-state" ) ;
+
+	// the first message of a channel only confirms it
+	if ( id == fields.end() || token == fields.end() || state == fields.end() || state->second == "sync" )
+		return ;
+
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	for ( std::size_t i = 0 ; i < m_roots.size() ; i++ )
+	{
+		Root *root = m_roots[i] ;
+		if ( root->channel.id == id->second && root->channel.token == token->second )
+		{
+			Log( "change notification for %1%", root->path, log::verbose ) ;
+			root->notified = true ;
+			m_wake.notify_all() ;
+		}
+	}
+}
+
+void MultiRoot::Worker( SyncQueue<Root*> *queue, unsigned *failed )
+{
+	std::unique_ptr<http::Agent> http = Connect() ;
+
+	Root *root = 0 ;
+	while ( queue->Pop( root ) )
+	{
+		try
+		{
+			Poll( *root, http.get() ) ;
+			continue ;
+		}
+		catch ( Exception& e )
+		{
+			Log( "sync of %1% failed: %2%", root->path, boost::diagnostic_information( e ), log::error ) ;
+		}
+		catch ( std::exception& e )
+		{
+			Log( "sync of %1% failed: %2%", root->path, e.what(), log::error ) ;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( m_mutex ) ;
+			(*failed)++ ;
+		}
+		if ( m_interval > 0 )
+			Schedule( *root, true ) ;
+	}
+}
+
+/// Sync \a root if it may have changed. Outside of Serve(), it always is.
+void MultiRoot::Poll( Root& root, http::Agent *http )
+{
+	if ( m_interval == 0 )
+	{
+		Sync( root, http ) ;
+		return ;
+	}
+
+	bool full ;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex ) ;
+		full = root.notified || !root.Watched() ;
+		// notifications from now on may be for changes this sync misses
+		root.notified = false ;
+	}
+
+	bool changed = false ;
+	if ( full || LocalChanges( root ) )
+		changed = Sync( root, http ) ;
+	Schedule( root, changed ) ;
+}
+
+/// Whether any local file changed since the last sync, like with --status.
+bool MultiRoot::LocalChanges( Root& root )
+{
+	State state( root.path, root.config->GetAll() ) ;
+	state.FromLocal( root.path ) ;
+
+	unsigned count = 0 ;
+	state.Status( boost::bind( &CountChange, &count, _1, _2 ) ) ;
+	return count > 0 ;
+}
+
+/// Set when \a root is polled next: soon if it just changed, later every
+/// time it didn't. Roots with a channel only need their local files checked,
+/// which costs no requests, so they are not slowed down.
+void MultiRoot::Schedule( Root& root, bool changed )
+{
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	root.interval = changed || root.interval == 0 ?
+		m_interval : std::min( root.interval * 2, m_interval * max_backoff ) ;
+
+	std::time_t wait = root.interval ;
+	if ( root.Watched() )
+		wait = std::min<std::time_t>( m_interval, root.channel.expiration - renew_margin - std::time( 0 ) ) ;
+
+	root.due	= std::chrono::steady_clock::now() + std::chrono::seconds( wait ) ;
+	root.busy	= false ;
+	m_wake.notify_all() ;
+}
+
+/// Open a push channel for \a root, or a new one before it expires. Without
+/// one, the root is polled.
+void MultiRoot::Renew( Root& root, Syncer *syncer )
+{
+	std::time_t now = std::time( 0 ) ;
+	if ( root.Watched() || root.retry_watch > now )
+		return ;
+
+	Channel old = root.channel ;
+	try
+	{
+		Channel channel = syncer->Watch( "grive-" + RandomHex( 16 ), RandomHex( 16 ), m_address ) ;
+		Log( "watching %1% for changes until %2%", root.path, DateTime( channel.expiration ), log::verbose ) ;
+
+		std::lock_guard<std::mutex> lock( m_mutex ) ;
+		root.channel = channel ;
+	}
+	catch ( std::exception& e )
+	{
+		Log( "can't watch %1% for changes, polling instead: %2%", root.path, e.what(), log::warning ) ;
+		root.retry_watch = now + watch_retry ;
+		return ;
+	}
+
+	// it expires anyway if this fails
+	if ( !old.id.empty() && old.expiration > now )
+	{
+		try
+		{
+			syncer->StopWatch( old ) ;
+		}
+		catch ( std::exception& )
+		{
+		}
+	}
+}
+
+/// \return	whether the root changed since its previous sync
+bool MultiRoot::Sync( Root& root, http::Agent *http )
+{
+	MemStats::Scope scope( root.stats ) ;
+	Log( "syncing %1%", root.path, log::info ) ;
+
+	Val options = root.config->GetAll() ;
+	AuthAgent agent( Token( *root.config ), http ) ;
+	http::Lanes lanes( &agent, options.Has( "bulk-threads" ) ? options["bulk-threads"].U64() : 1 ) ;
+
+	std::unique_ptr<Syncer> syncer ;
+	std::string api = options.Has( "api" ) ? options["api"].Str() : "v2" ;
+	if ( api == "v3" )
+		syncer.reset( new v3::Syncer3( &lanes ) ) ;
+	else
+		syncer.reset( new v2::Syncer2( &lanes ) ) ;
+
+	// the partitioned sync keeps no change stamp, it always counts as changed
+	long stamp = -1 ;
+	std::string page_token ;
+	bool dry_run = options.Has( "dry-run" ) && options["dry-run"].Bool() ;
+	Drive drive( syncer.get(), options ) ;
+	if ( options.Has( "memory-limit" ) )
+		drive.SyncPartitioned( dry_run ) ;
+	else
+	{
+		drive.DetectChanges() ;
+		if ( dry_run )
+			drive.DryRun() ;
+		else
+		{
+			drive.Update() ;
+			drive.SaveState() ;
+			stamp = drive.ChangeStamp() ;
+			page_token = drive.PageToken() ;
+		}
+	}
+	if ( m_interval > 0 && !m_address.empty() && !dry_run )
+		Renew( root, syncer.get() ) ;
+	lanes.Report() ;
+	root.config->Save() ;
+	root.stats.Report( root.path.string() ) ;
+
+	Log( "finished syncing %1%", root.path, log::info ) ;
+
+	bool changed = ( stamp == -1 && page_token.empty() ) || stamp != root.stamp || page_token != root.page_token ;
+	root.stamp = stamp ;
+	root.page_token = page_token ;
+	return changed ;
+}
+
+/// The token of the account in \a config, shared by all its roots. It is
+/// only refreshed by the first root that needs it.
+OAuth2& MultiRoot::Token( const Config& config )
+{
+	std::string refresh_token	= config.Get( "refresh_token" ).Str() ;
+	std::string id				= config.Get( "id" ).Str() ;
+	std::string secret			= config.Get( "secret" ).Str() ;
+	std::string redirect_uri	= config.Get( "redirect-uri" ).Str() ;
+
+	std::string key = id + '\n' + refresh_token ;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex ) ;
+		std::map<std::string, Account*>::iterator i = m_accounts.find( key ) ;
+		if ( i != m_accounts.end() )
+			return *i->second->token ;
+	}
+
+	// the token is refreshed without the lock, so that the roots of other
+	// accounts don't wait for it
+	std::unique_ptr<Account> a( new Account ) ;
+	a->http = Connect() ;
+	a->token.reset( new OAuth2( a->http.get(), refresh_token, id, secret, redirect_uri ) ) ;
+
+	// another root of the same account may have been first
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	Account *& account = m_accounts[key] ;
+	if ( account == 0 )
+		account = a.release() ;
+	return *account->token ;
+}
+
+/// A connection for a worker or an account.
+std::unique_ptr<http::Agent> MultiRoot::Connect()
+{
+	if ( m_http != 0 )
+		return m_http->Clone() ;
+
+	// connections of all threads go to the same hosts, keep them in the share
+	return std::unique_ptr<http::Agent>( new http::CurlAgent( &m_share ) ) ;
+}
+
+} // end of namespace gr
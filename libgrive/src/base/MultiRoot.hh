@@ -0,0 +1,115 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "http/CurlShare.hh"
+#include "util/FileSystem.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gr {
+
+namespace http
+{
+	class Agent ;
+}
+
+class Config ;
+class MemStats ;
+class OAuth2 ;
+class Syncer ;
+
+template <typename T> class SyncQueue ;
+
+/*!	\brief	syncs many roots in one process
+
+	The roots are read from a JSON file like
+	[{"path":"/srv/a"},{"path":"/srv/b","config":"b.grive"}]. Each root
+	has its own config file, by default .grive in the root, but the roots
+	share the HTTP connections and one access token per account. A few
+	threads sync the roots, each root once per pass.
+
+	Serve() keeps syncing them. With a watch address, each root gets a
+	push channel and is synced when Google Drive notifies a change, and
+	otherwise only when its local files changed. Roots without a channel
+	are polled, less often while they don't change.
+
+	The connections are clones of the agent given to the constructor, or
+	CurlAgents if none is given. Each root counts its memory in MemStats of
+	its own, see Stats().
+*/
+class MultiRoot
+{
+public :
+	MultiRoot( const Config& cmd, const fs::path& roots, const http::Agent *http = 0 ) ;
+	~MultiRoot() ;
+
+	std::size_t Count() const ;
+	const MemStats& Stats( std::size_t root ) const ;
+	unsigned Run( unsigned threads ) ;
+	void Serve( unsigned threads, unsigned interval ) ;
+	void Stop() ;
+	void Notify( const std::map<std::string, std::string>& fields ) ;
+
+private :
+	struct Root ;
+	struct Account ;
+
+	unsigned Run( unsigned threads, const std::vector<Root*>& roots ) ;
+	void Worker( SyncQueue<Root*> *queue, unsigned *failed ) ;
+	void Poll( Root& root, http::Agent *http ) ;
+	bool Sync( Root& root, http::Agent *http ) ;
+	bool LocalChanges( Root& root ) ;
+	void Renew( Root& root, Syncer *syncer ) ;
+	void Schedule( Root& root, bool changed ) ;
+	std::vector<Root*> Due( std::chrono::steady_clock::time_point& next ) ;
+	OAuth2& Token( const Config& config ) ;
+	std::unique_ptr<http::Agent> Connect() ;
+
+private :
+	http::CurlShare				m_share ;
+	const http::Agent			*m_http ;
+	std::vector<Root*>			m_roots ;
+
+	std::mutex								m_mutex ;
+	std::map<std::string, Account*>			m_accounts ;
+
+	// roots are taken from the queue from this one, to take turns being first
+	std::size_t					m_first ;
+
+	// public address of the push notification receiver, and the local
+	// address and port it listens on
+	std::string					m_address ;
+	std::string					m_bind ;
+	unsigned					m_port ;
+
+	// the shortest polling interval in seconds, 0 unless serving
+	unsigned					m_interval ;
+	bool						m_stop ;
+	std::condition_variable		m_wake ;
+} ;
+
+} // end of namespace gr
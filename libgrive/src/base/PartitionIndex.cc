@@ -0,0 +1,189 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "PartitionIndex.hh"
+
+#include "Entry.hh"
+
+#include "json/JsonParser.hh"
+#include "json/JsonWriter.hh"
+#include "json/Val.hh"
+#include "util/File.hh"
+
+#include <boost/exception/errinfo_api_function.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/exception/info.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <fstream>
+#include <sstream>
+
+namespace gr {
+
+namespace
+{
+	/// an entry read back from the spill file
+	class SpilledEntry : public Entry
+	{
+	public :
+		explicit SpilledEntry( const Val& v )
+		{
+			m_title			= v["title"].Str() ;
+			m_filename		= v["filename"].Str() ;
+			m_is_dir		= v["is_dir"].Bool() ;
+			m_md5			= Digest::FromHex( v["md5"].Str() ) ;
+			m_etag			= v["etag"].Str() ;
+			m_resource_id	= v["id"].Str() ;
+			m_self_href		= v["self"].Str() ;
+			m_content_src	= v["src"].Str() ;
+			m_is_editable	= v["editable"].Bool() ;
+			m_change_stamp	= v["change_stamp"].Int() ;
+			m_mtime			= DateTime( v["mtime"].Int(), v["mtime_ns"].Int() ) ;
+			m_is_removed	= v["removed"].Bool() ;
+			m_size			= v["size"].U64() ;
+
+			const Val::Array& parents = v["parents"].AsArray() ;
+			for ( Val::Array::const_iterator i = parents.begin() ; i != parents.end() ; ++i )
+				m_parent_hrefs.push_back( i->Str() ) ;
+		}
+
+		static Val Dump( const Entry& e )
+		{
+			Val v ;
+			v.Add( "title",			Val( e.Title() ) ) ;
+			v.Add( "filename",		Val( e.Filename() ) ) ;
+			v.Add( "is_dir",		Val( e.IsDir() ) ) ;
+			v.Add( "md5",			Val( e.MD5().Hex() ) ) ;
+			v.Add( "etag",			Val( e.ETag() ) ) ;
+			v.Add( "id",			Val( e.ResourceID() ) ) ;
+			v.Add( "self",			Val( e.SelfHref() ) ) ;
+			v.Add( "src",			Val( e.ContentSrc() ) ) ;
+			v.Add( "editable",		Val( e.IsEditable() ) ) ;
+			v.Add( "change_stamp",	Val( e.ChangeStamp() ) ) ;
+			v.Add( "mtime",			Val( e.MTime().Sec() ) ) ;
+			v.Add( "mtime_ns",		Val( e.MTime().NanoSec() ) ) ;
+			v.Add( "removed",		Val( e.IsRemoved() ) ) ;
+			v.Add( "size",			Val( e.Size() ) ) ;
+
+			Val parents( Val::array_type ) ;
+			for ( std::size_t i = 0 ; i < e.ParentHrefs().size() ; i++ )
+				parents.Add( Val( e.ParentHrefs()[i] ) ) ;
+			v.Add( "parents", parents ) ;
+			return v ;
+		}
+	} ;
+}
+
+/// \param	buffer_limit	bytes of entries kept in memory before they are
+///							appended to the spill files
+PartitionIndex::PartitionIndex( std::size_t buffer_limit ) :
+	m_dir		( fs::temp_directory_path() / fs::unique_path( "grive-%%%%-%%%%-%%%%" ) ),
+	m_limit		( buffer_limit ),
+	m_buffered	( 0 ),
+	m_count		( 0 )
+{
+	fs::create_directories( m_dir ) ;
+}
+
+PartitionIndex::~PartitionIndex()
+{
+	boost::system::error_code ec ;
+	fs::remove_all( m_dir, ec ) ;
+}
+
+/// Store an entry, one JSON object per line.
+void PartitionIndex::Add( const std::string& partition, const Entry& e )
+{
+	std::string line = WriteJson( SpilledEntry::Dump( e ) ) + "\n" ;
+	m_buf[partition] += line ;
+	m_buffered += line.size() ;
+	if ( m_buffered > m_limit )
+		Flush() ;
+}
+
+void PartitionIndex::Flush()
+{
+	for ( std::map<std::string, std::string>::iterator i = m_buf.begin() ; i != m_buf.end() ; ++i )
+	{
+		if ( i->second.empty() )
+			continue ;
+
+		std::map<std::string, fs::path>::iterator f = m_files.find( i->first ) ;
+		if ( f == m_files.end() )
+		{
+			std::ostringstream name ;
+			name << m_count++ << ".json" ;
+			f = m_files.insert( std::make_pair( i->first, m_dir / name.str() ) ).first ;
+		}
+		// a lost entry would make its file look deleted remotely, so e.g. a
+		// full disk must fail the sync
+		std::ofstream out( f->second.string().c_str(), std::ios::app ) ;
+		out << i->second ;
+		out.close() ;
+		if ( !out )
+		{
+			BOOST_THROW_EXCEPTION(
+				File::Error()
+					<< boost::errinfo_api_function("write")
+					<< boost::errinfo_file_name(f->second.string())
+			) ;
+		}
+
+		std::string().swap( i->second ) ;
+	}
+	m_buffered = 0 ;
+}
+
+/// Pass the entries of \a partition to \a callback and drop them from the index.
+void PartitionIndex::Replay( const std::string& partition, const Callback& callback )
+{
+	std::map<std::string, std::string>::iterator b = m_buf.find( partition ) ;
+	std::map<std::string, fs::path>::iterator f = m_files.find( partition ) ;
+
+	if ( f != m_files.end() )
+	{
+		std::ifstream in( f->second.string().c_str() ) ;
+		std::string line ;
+		while ( std::getline( in, line ) )
+			callback( SpilledEntry( ParseJson( line ) ) ) ;
+		if ( in.bad() || !in.eof() )
+		{
+			BOOST_THROW_EXCEPTION(
+				File::Error()
+					<< boost::errinfo_api_function("read")
+					<< boost::errinfo_file_name(f->second.string())
+			) ;
+		}
+		in.close() ;
+		fs::remove( f->second ) ;
+		m_files.erase( f ) ;
+	}
+
+	if ( b != m_buf.end() )
+	{
+		std::istringstream in( b->second ) ;
+		std::string line ;
+		while ( std::getline( in, line ) )
+			callback( SpilledEntry( ParseJson( line ) ) ) ;
+		m_buffered -= b->second.size() ;
+		m_buf.erase( b ) ;
+	}
+}
+
+} // end of namespace gr
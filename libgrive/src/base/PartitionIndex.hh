@@ -0,0 +1,67 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "util/FileSystem.hh"
+
+#include <boost/function.hpp>
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace gr {
+
+class Entry ;
+
+/*!	\brief	temporary on-disk index of remote entries, grouped by partition
+
+	Used by the bounded-memory sync. The remote file list is read once and
+	the entries are spilled to one file per partition, so that only the
+	entries of the partition being synced are kept in memory.
+*/
+class PartitionIndex
+{
+public :
+	typedef boost::function<void ( const Entry& )> Callback ;
+
+public :
+	explicit PartitionIndex( std::size_t buffer_limit ) ;
+	~PartitionIndex() ;
+
+	void Add( const std::string& partition, const Entry& e ) ;
+	void Replay( const std::string& partition, const Callback& callback ) ;
+
+	/// bytes of entries in memory, at most the buffer limit
+	std::size_t Buffered() const { return m_buffered ; }
+
+private :
+	void Flush() ;
+
+private :
+	fs::path							m_dir ;
+	std::size_t							m_limit ;
+	std::size_t							m_buffered ;
+	unsigned							m_count ;
+	std::map<std::string, std::string>	m_buf ;
+	std::map<std::string, fs::path>		m_files ;
+} ;
+
+} // end of namespace gr
@@ -19,15 +19,19 @@
 
 #include "Resource.hh"
 #include "ResourceTree.hh"
+#include "StateRecord.hh"
 #include "Entry.hh"
 #include "Syncer.hh"
 
 #include "json/Val.hh"
 #include "util/CArray.hh"
 #include "util/Crypt.hh"
+#include "util/EventStream.hh"
+#include "util/MemStats.hh"
 #include "util/log/Log.hh"
 #include "util/OS.hh"
 #include "util/File.hh"
+#include "http/Agent.hh"
 #include "http/Error.hh"
 
 #include <boost/exception/all.hpp>
@@ -37,6 +41,8 @@
 #include <errno.h>
 
 #include <cassert>
+#include <map>
+#include <sstream>
 
 // for debugging
 #include <iostream>
@@ -48,13 +54,20 @@ Resource::Resource( const fs::path& root_folder ) :
 	m_name		( root_folder.string() ),
 	m_kind		( "folder" ),
 	m_size		( 0 ),
+	m_fp		( 0 ),
+	m_has_fp	( false ),
 	m_id		( "folder:root" ),
 	m_href		( "root" ),
 	m_is_editable( true ),
 	m_parent	( 0 ),
 	m_state		( sync ),
-	m_json		( NULL ),
-	m_local_exists( true )
+	m_rec		( NULL ),
+	m_local_exists( true ),
+	m_inode_md5	( NULL ),
+	m_paths_cached( false ),
+	m_settled	( false ),
+	m_unsettled	( 0 ),
+	m_deferred	( false )
 {
 }
 
@@ -62,11 +75,18 @@ Resource::Resource( const std::string& name, const std::string& kind ) :
 	m_name		( name ),
 	m_kind		( kind ),
 	m_size		( 0 ),
+	m_fp		( 0 ),
+	m_has_fp	( false ),
 	m_is_editable( true ),
 	m_parent	( 0 ),
 	m_state		( unknown ),
-	m_json		( NULL ),
-	m_local_exists( false )
+	m_rec		( NULL ),
+	m_local_exists( false ),
+	m_inode_md5	( NULL ),
+	m_paths_cached( false ),
+	m_settled	( false ),
+	m_unsettled	( 0 ),
+	m_deferred	( false )
 {
 }
 
@@ -79,6 +99,7 @@ void Resource::SetState( State new_state )
 	) ;
 	
 	m_state = new_state ;
+	Settle() ;
 	std::for_each( m_child.begin(), m_child.end(),
 		boost::bind( &Resource::SetState, _1, new_state ) ) ;
 }
@@ -139,6 +160,7 @@ void Resource::FromRemote( const Entry& remote )
 		m_md5 = remote.MD5() ;
 	
 	m_mtime = remote.MTime() ;
+	Settle() ;
 }
 
 void Resource::AssignIDs( const Entry& remote )
@@ -171,6 +193,8 @@ void Resource::FromRemoteFile( const Entry& remote )
 			m_parent->m_state, log::verbose ) ;
 		
 		m_state = m_parent->m_state ;
+		if ( m_state == remote_new )
+			m_size = remote.Size() ;
 	}
 
 	else if ( m_kind == "bad" )
@@ -198,7 +222,7 @@ void Resource::FromRemoteFile( const Entry& remote )
 	}
 
 	// remote checksum unknown, assume the file is not changed in remote
-	else if ( remote.MD5().empty() )
+	else if ( remote.MD5().Empty() )
 	{
 		Log( "file %1% has unknown checksum in remote. assumed in sync",
 			Path(), log::verbose ) ;
@@ -236,36 +260,65 @@ void Resource::FromRemoteFile( const Entry& remote )
 	}
 }
 
-void Resource::FromDeleted( Val& state )
+void Resource::FromDeleted( StateRecord& state )
 {
-	assert( !m_json );
-	m_json = &state;
-	if ( state.Has( "ctime" ) )
-		m_ctime.Assign( state["ctime"].U64(), 0 );
-	if ( state.Has( "md5" ) )
-		m_md5 = state["md5"];
-	if ( state.Has( "srv_time" ) )
-		m_mtime.Assign( state[ "srv_time" ].U64(), 0 ) ;
-	if ( state.Has( "size" ) )
-		m_size = state[ "size" ].U64();
+	assert( !m_rec );
+	m_rec = &state;
+	if ( state.Has( StateRecord::ctime_field ) )
+		m_ctime.Assign( state.ctime, 0 );
+	if ( state.Has( StateRecord::md5_field ) )
+		m_md5 = state.md5;
+	if ( state.Has( StateRecord::srv_time_field ) )
+		m_mtime.Assign( state.srv_time, 0 ) ;
+	if ( state.Has( StateRecord::size_field ) )
+		m_size = state.size;
 	m_state = both_deleted;
+	Settle() ;
+}
+
+/// Take the local file as unchanged since the last sync, without looking at
+/// it. This is what FromLocal() finds for a file whose change time is not
+/// newer than in \a state.
+void Resource::FromState( StateRecord& state )
+{
+	assert( !m_rec );
+	m_rec = &state;
+	if ( state.Has( StateRecord::ctime_field ) )
+		m_ctime.Assign( state.ctime, 0 );
+	if ( state.Has( StateRecord::md5_field ) )
+		m_md5 = state.md5;
+	if ( state.Has( StateRecord::srv_time_field ) )
+		m_mtime.Assign( state.srv_time, 0 ) ;
+	if ( state.Has( StateRecord::size_field ) )
+		m_size = state.size;
+	m_fp = state.fp ;
+	m_has_fp = state.Has( StateRecord::fp_field ) ;
+	m_local_exists = true;
+
+	// State will be updated to sync/remote_changed in FromRemote()
+	m_state = remote_deleted;
+	Settle() ;
 }
 
 /// Update the resource with the attributes of local file or directory. This
-/// function will propulate the fields in m_entry.
-void Resource::FromLocal( Val& state )
+/// function will propulate the fields in m_entry. If \a res_tree is given,
+/// hard links of the same inode share one checksum and are hashed only once.
+/// Without \a hash, a file with a newer ctime and the same size is taken
+/// as changed without comparing checksums.
+void Resource::FromLocal( StateRecord& state, ResourceTree *res_tree, bool hash )
 {
-	assert( !m_json );
-	m_json = &state;
+	assert( !m_rec );
+	m_rec = &state;
 
 	// root folder is always in sync
 	if ( !IsRoot() )
 	{
 		fs::path path = Path() ;
 		FileType ft ;
+		os::FileId id ;
 		try
 		{
-			os::Stat( path, &m_ctime, (off64_t*)&m_size, &ft ) ;
+			os::Stat( path, &m_ctime, (off64_t*)&m_size, &ft, &id ) ;
 		}
 		catch ( os::Error &e )
 		{
@@ -274,6 +327,7 @@ void Resource::FromLocal( Val& state )
 			Log( "Error accessing %1%: %2%; skipping file", path.string(), strerror( *eno ), log::warning );
 			m_state = sync;
 			m_kind = "bad";
+			Settle() ;
 			return;
 		}
 		if ( ft == FT_UNKNOWN )
@@ -282,19 +336,32 @@ void Resource::FromLocal( Val& state )
 			Log( "File %1% is not a regular file or directory; skipping file", path.string(), log::warning );
 			m_state = sync;
 			m_kind = "bad";
+			Settle() ;
 			return;
 		}
 
-		m_name = path.filename().string() ;
+		if ( m_name != path.filename().string() )
+		{
+			m_name = path.filename().string() ;
+			ForgetPaths() ;
+		}
 		m_kind = ft == FT_DIR ? "folder" : "file";
 		m_local_exists = true;
+		if ( res_tree && ft == FT_FILE && id.nlink > 1 )
+			m_inode_md5 = res_tree->InodeMD5( id.dev, id.ino ) ;
 
 		bool is_changed;
-		if ( state.Has( "ctime" ) && (u64_t) m_ctime.Sec() <= state["ctime"].U64() &&
-			( ft == FT_DIR || state.Has( "md5" ) ) )
+		if ( state.Has( StateRecord::ctime_field ) && (u64_t) m_ctime.Sec() <= state.ctime &&
+			( ft == FT_DIR || state.Has( StateRecord::md5_field ) ) )
 		{
 			if ( ft != FT_DIR )
-				m_md5 = state["md5"];
+			{
+				m_md5 = state.md5;
+				m_fp = state.fp ;
+				m_has_fp = state.Has( StateRecord::fp_field ) ;
+				if ( m_inode_md5 && m_inode_md5->Empty() )
+					*m_inode_md5 = m_md5 ;
+			}
 			is_changed = false;
 		}
 		else
@@ -302,14 +369,30 @@ void Resource::FromLocal( Val& state )
 			if ( ft != FT_DIR )
 			{
 				// File is changed locally. TODO: Detect conflicts
-				is_changed = ( state.Has( "size" ) && m_size != state["size"].U64() ) ||
-					!state.Has( "md5" ) || GetMD5() != state["md5"].Str();
+				if ( ( state.Has( StateRecord::size_field ) && m_size != state.size ) ||
+					!state.Has( StateRecord::md5_field ) || !hash )
+					is_changed = true ;
+
+				// the fingerprint tells much faster whether the content is the
+				// same. the checksum of new content is only computed if needed
+				else if ( state.Has( StateRecord::fp_field ) )
+				{
+					is_changed = !ReadFingerprint() || m_fp != state.fp ;
+					if ( !is_changed )
+					{
+						m_md5 = state.md5 ;
+						if ( m_inode_md5 && m_inode_md5->Empty() )
+							*m_inode_md5 = m_md5 ;
+					}
+				}
+				else
+					is_changed = GetMD5() != state.md5 ;
 			}
 			else
 				is_changed = true;
 		}
-		if ( state.Has( "srv_time" ) )
-			m_mtime.Assign( state[ "srv_time" ].U64(), 0 ) ;
+		if ( state.Has( StateRecord::srv_time_field ) )
+			m_mtime.Assign( state.srv_time, 0 ) ;
 
 		// Upload file if it is changed and remove if not.
 		// State will be updated to sync/remote_changed in FromRemote()
@@ -323,12 +406,14 @@ void Resource::FromLocal( Val& state )
 			while ( p && p->m_state == remote_deleted )
 			{
 				p->m_state = local_new;
+				p->Settle() ;
 				p = p->m_parent;
 			}
 		}
 	}
 	
 	assert( m_state != unknown ) ;
+	Settle() ;
 }
 
 std::string Resource::SelfHref() const
@@ -361,6 +446,12 @@ DateTime Resource::ServerTime() const
 	return m_mtime ;
 }
 
+/// The local change time, as of FromLocal()
+DateTime Resource::ChangeTime() const
+{
+	return m_ctime ;
+}
+
 std::string Resource::ResourceID() const
 {
 	return m_id ;
@@ -390,7 +481,10 @@ void Resource::AddChild( Resource *child )
 	assert( child != this ) ;
 
 	child->m_parent = this ;
+	child->ForgetPaths() ;
 	m_child.push_back( child ) ;
+	if ( !child->IsClean() )
+		ChildSettled( false ) ;
 }
 
 bool Resource::IsFolder() const
@@ -408,7 +502,10 @@ fs::path Resource::Path() const
 	assert( m_parent != this ) ;
 	assert( m_parent == 0 || m_parent->IsFolder() ) ;
 
-	return m_parent != 0 ? (m_parent->Path() / m_name) : m_name ;
+	if ( m_parent == 0 )
+		return m_name ;
+	m_parent->CachePaths() ;
+	return m_parent->m_path / m_name ;
 }
 
 // Path relative to the root directory
@@ -417,7 +514,41 @@ fs::path Resource::RelPath() const
 	assert( m_parent != this ) ;
 	assert( m_parent == 0 || m_parent->IsFolder() ) ;
 
-	return m_parent != 0 && !m_parent->IsRoot() ? (m_parent->RelPath() / m_name) : m_name ;
+	if ( m_parent == 0 || m_parent->IsRoot() )
+		return m_name ;
+	m_parent->CachePaths() ;
+	return m_parent->m_rel_path / m_name ;
+}
+
+/// Fill the paths of this folder and its parents that are not known yet.
+/// Not thread safe: paths of resources must not be built in several threads.
+void Resource::CachePaths() const
+{
+	if ( m_paths_cached )
+		return ;
+
+	if ( m_parent == 0 )
+		m_path = m_rel_path = m_name ;
+	else
+	{
+		m_parent->CachePaths() ;
+		m_path		= m_parent->m_path / m_name ;
+		m_rel_path	= m_parent->IsRoot() ? fs::path( m_name ) : m_parent->m_rel_path / m_name ;
+	}
+	m_paths_cached = true ;
+}
+
+/// Drop the paths of this resource and everything below it, after it was
+/// renamed or moved.
+void Resource::ForgetPaths()
+{
+	if ( !m_paths_cached )
+		return ;
+
+	m_paths_cached = false ;
+	fs::path().swap( m_path ) ;
+	fs::path().swap( m_rel_path ) ;
+	std::for_each( m_child.begin(), m_child.end(), boost::bind( &Resource::ForgetPaths, _1 ) ) ;
 }
 
 bool Resource::IsInRootTree() const
@@ -442,21 +573,43 @@ void Resource::Sync( Syncer *syncer, ResourceTree *res_tree, const Val& options
 {
 	assert( m_state != unknown ) ;
 	assert( !IsRoot() || m_state == sync ) ;	// root folder is already synced
+
+	// the folders that have not changed on either side are not visited
+	if ( IsClean() )
+	{
+		Log( "%1% is unchanged since the last sync, skipped", Path(), log::verbose ) ;
+		return ;
+	}
+	
+	if ( !Attempt( boost::bind( &Resource::SyncSelf, this, syncer, res_tree, boost::cref( options ) ) ) )
+		return ;
 	
+	// if myself is deleted, no need to do the childrens
+	if ( m_state != local_deleted && m_state != remote_deleted )
+	{
+		std::for_each( m_child.begin(), m_child.end(),
+			boost::bind( &Resource::Sync, _1, syncer, res_tree, options ) ) ;
+	}
+}
+
+/// Run \a action, which syncs this resource, and log its errors.
+/// \return	false if it failed
+bool Resource::Attempt( const boost::function<void ()>& action )
+{
 	try
 	{
-		SyncSelf( syncer, res_tree, options ) ;
+		action() ;
 	}
 	catch ( File::Error &e )
 	{
 		int *en = boost::get_error_info< boost::errinfo_errno > ( e ) ;
 		Log( "Error syncing %1%: %2%", Path(), en ? strerror( *en ) : "", log::error );
-		return;
+		return false;
 	}
 	catch ( boost::filesystem::filesystem_error &e )
 	{
 		Log( "Error syncing %1%: %2%", Path(), e.what(), log::error );
-		return;
+		return false;
 	}
 	catch ( http::Error &e )
 	{
@@ -482,15 +635,9 @@ void Resource::Sync( Syncer *syncer, ResourceTree *res_tree, const Val& options
 			Log( "Response headers: %1%", *resp_hdr, log::verbose );
 		if ( resp_txt )
 			Log( "Response text: %1%", *resp_txt, log::verbose );
-		return;
-	}
-	
-	// if myself is deleted, no need to do the childrens
-	if ( m_state != local_deleted && m_state != remote_deleted )
-	{
-		std::for_each( m_child.begin(), m_child.end(),
-			boost::bind( &Resource::Sync, _1, syncer, res_tree, options ) ) ;
+		return false;
 	}
+	return true ;
 }
 
 bool Resource::CheckRename( Syncer* syncer, ResourceTree *res_tree )
@@ -542,8 +689,10 @@ bool Resource::CheckRename( Syncer* syncer, ResourceTree *res_tree )
 						to->SetIndex( true );
 					}
 					to->m_mtime = from->m_mtime;
-					to->m_json->Set( "srv_time", Val( from->m_mtime.Sec() ) );
+					to->m_rec->srv_time = from->m_mtime.Sec();
+					to->m_rec->Set( StateRecord::srv_time_field );
 					from->DeleteIndex();
+					to->Emit( is_local ? "move_remote" : "move_local", from ) ;
 				}
 				from->m_state = both_deleted;
 				to->m_state = sync;
@@ -554,6 +703,77 @@ bool Resource::CheckRename( Syncer* syncer, ResourceTree *res_tree )
 	return false;
 }
 
+/// Find another file with the same content which is already in sync, i.e.
+/// present both locally and remotely. Used to avoid transferring the same
+/// bytes more than once.
+Resource* Resource::FindSyncedCopy( ResourceTree *res_tree, bool need_id )
+{
+	if ( IsFolder() || m_size == 0 )
+		return NULL ;
+
+	// compare sizes first to avoid hashing local files without a candidate
+	details::SizeRange same_size = res_tree->FindBySize( m_size ) ;
+	bool found = false ;
+	for ( details::SizeMap::iterator i = same_size.first ; i != same_size.second && !found ; i++ )
+		found = *i != this && (*i)->m_state == sync && (*i)->m_kind == "file" ;
+	if ( !found )
+		return NULL ;
+
+	details::MD5Range same = res_tree->FindByMD5( GetMD5() ) ;
+	for ( details::MD5Map::iterator i = same.first ; i != same.second ; i++ )
+	{
+		Resource *r = *i ;
+		if ( r != this && r->m_state == sync && r->m_kind == "file" && ( !need_id || r->HasID() ) )
+			return r ;
+	}
+	return NULL ;
+}
+
+/// Create a local file from an identical local copy instead of downloading it again.
+bool Resource::CopyLocal( ResourceTree *res_tree, const fs::path& path )
+{
+	Resource *from = FindSyncedCopy( res_tree, false ) ;
+	if ( !from )
+		return false ;
+
+	try
+	{
+		bool cloned = os::CloneFile( from->Path(), path ) ;
+		Log( "sync %1% has the same content as %2%. %3% it locally", path, from->Path(),
+			cloned ? "reflinking" : "copying", log::verbose ) ;
+	}
+	catch ( Exception& )
+	{
+		Log( "failed to copy %1% from %2%, downloading it", path, from->Path(), log::warning ) ;
+		return false ;
+	}
+	if ( m_mtime != DateTime() )
+		os::SetFileTime( path, m_mtime ) ;
+	return true ;
+}
+
+/// Create the remote file by copying an identical remote file instead of uploading it.
+bool Resource::CopyRemote( Syncer* syncer, ResourceTree *res_tree )
+{
+	Resource *from = FindSyncedCopy( res_tree, true ) ;
+	if ( !from )
+		return false ;
+
+	Log( "sync %1% has the same content as %2%. copying it remotely", Path(), from->Path(), log::verbose ) ;
+	try
+	{
+		return syncer->Copy( from, this ) ;
+	}
+	catch ( http::Error& e )
+	{
+		// e.g. the source can't be copied by this user. upload it instead
+		int *httpcode = boost::get_error_info< http::HttpResponseCode > ( e ) ;
+		Log( "failed to copy %1% from %2% (HTTP %3%), uploading it", Path(), from->Path(),
+			httpcode ? *httpcode : 0, log::warning ) ;
+		return false ;
+	}
+}
+
 void Resource::SyncSelf( Syncer* syncer, ResourceTree *res_tree, const Val& options )
 {
 	assert( !IsRoot() || m_state == sync ) ;	// root is always sync
@@ -567,15 +787,28 @@ void Resource::SyncSelf( Syncer* syncer, ResourceTree *res_tree, const Val& opti
 	if ( CheckRename( syncer, res_tree ) )
 		return;
 
+	if ( m_deferred )
+	{
+		Log( "sync %1% changed too recently, probably still being written. skipping", path, log::info ) ;
+		return ;
+	}
+
 	switch ( m_state )
 	{
 	case local_new :
 		Log( "sync %1% doesn't exist in server, uploading", path, log::info ) ;
-		
-		if ( syncer && syncer->Create( this ) )
+		if ( !syncer )
+			break ;
+		if ( !IsFolder() && !CopyRemote( syncer, res_tree ) )
+		{
+			Transfer( syncer, res_tree, options ) ;
+			return ;
+		}
+		if ( !IsFolder() || syncer->Create( this ) )
 		{
 			m_state = sync ;
 			SetIndex( false );
+			Emit( IsFolder() ? "mkdir_remote" : "upload" ) ;
 		}
 		break ;
 	
@@ -585,15 +818,16 @@ void Resource::SyncSelf( Syncer* syncer, ResourceTree *res_tree, const Val& opti
 		{
 			syncer->DeleteRemote( this ) ;
 			DeleteIndex() ;
+			Emit( "delete_remote" ) ;
 		}
 		break ;
 	
 	case local_changed :
 		Log( "sync %1% changed in local. uploading", path, log::info ) ;
-		if ( syncer && syncer->EditContent( this, options["new-rev"].Bool() ) )
+		if ( syncer )
 		{
-			m_state = sync ;
-			SetIndex( false );
+			Transfer( syncer, res_tree, options ) ;
+			return ;
 		}
 		break ;
 	
@@ -607,10 +841,14 @@ void Resource::SyncSelf( Syncer* syncer, ResourceTree *res_tree, const Val& opti
 			{
 				if ( IsFolder() )
 					fs::create_directories( path ) ;
-				else
-					syncer->Download( this, path ) ;
+				else if ( !CopyLocal( res_tree, path ) )
+				{
+					Transfer( syncer, res_tree, options ) ;
+					return ;
+				}
 				SetIndex( true ) ;
 				m_state = sync ;
+				Emit( IsFolder() ? "mkdir_local" : "download" ) ;
 			}
 		}
 		break ;
@@ -624,9 +862,14 @@ void Resource::SyncSelf( Syncer* syncer, ResourceTree *res_tree, const Val& opti
 			Log( "sync %1% changed in remote. downloading", path, log::info ) ;
 			if ( syncer )
 			{
-				syncer->Download( this, path ) ;
+				if ( !CopyLocal( res_tree, path ) )
+				{
+					Transfer( syncer, res_tree, options ) ;
+					return ;
+				}
 				SetIndex( true ) ;
 				m_state = sync ;
+				Emit( "download" ) ;
 			}
 		}
 		break ;
@@ -637,6 +880,7 @@ void Resource::SyncSelf( Syncer* syncer, ResourceTree *res_tree, const Val& opti
 		{
 			DeleteLocal() ;
 			DeleteIndex() ;
+			Emit( "delete_local" ) ;
 		}
 		break ;
 	
@@ -658,10 +902,157 @@ void Resource::SyncSelf( Syncer* syncer, ResourceTree *res_tree, const Val& opti
 		break ;
 	}
 	
-	if ( syncer && m_json )
+	if ( syncer )
+		StoreServerTime() ;
+}
+
+/// Upload or download the content of the file on the bulk lane of the agent,
+/// so that the requests for the resources after it don't wait for it.
+void Resource::Transfer( Syncer *syncer, ResourceTree *res_tree, const Val& options )
+{
+	// the same content is already on its way. the file is copied from it by
+	// SyncTwin() when the bulk lane is done, instead of transferring it again
+	if ( res_tree != 0 && !m_md5.Empty() )
 	{
-		// Update server time of this file
-		m_json->Set( "srv_time", Val( m_mtime.Sec() ) );
+		if ( m_state != local_changed && res_tree->FindTransfer( m_md5 ) != 0 )
+		{
+			Log( "sync %1% has the same content as %2%. copying it afterwards", Path(),
+				res_tree->FindTransfer( m_md5 )->Path(), log::verbose ) ;
+			res_tree->AddTwin( this ) ;
+			return ;
+		}
+		res_tree->AddTransfer( this ) ;
+	}
+
+	bool new_rev = m_state == local_changed && options["new-rev"].Bool() ;
+	boost::function<void ()> content = boost::bind( &Resource::SyncContent, this, syncer, new_rev ) ;
+	syncer->Agent()->Bulk( boost::bind( &Resource::Attempt, this, content ) ) ;
+}
+
+/// Sync a file that waited for the transfer of the same content, see
+/// Transfer(). Called once the bulk lane is done.
+void Resource::SyncTwin( Syncer *syncer, ResourceTree *res_tree, const Val& options )
+{
+	Attempt( boost::bind( &Resource::SyncCopy, this, syncer, res_tree, boost::cref( options ) ) ) ;
+}
+
+void Resource::SyncCopy( Syncer *syncer, ResourceTree *res_tree, const Val& options )
+{
+	bool local = m_state == local_new ;
+	if ( local ? !CopyRemote( syncer, res_tree ) : !CopyLocal( res_tree, Path() ) )
+	{
+		// e.g. the first transfer failed
+		Transfer( syncer, 0, options ) ;
+		return ;
+	}
+
+	SetIndex( !local ) ;
+	m_state = sync ;
+	Emit( local ? "upload" : "download" ) ;
+	StoreServerTime() ;
+}
+
+/// The part of SyncSelf() that transfers the file content.
+void Resource::SyncContent( Syncer *syncer, bool new_rev )
+{
+	switch ( m_state )
+	{
+	case local_new :
+	case local_changed :
+		if ( m_state == local_new ? syncer->Create( this ) : syncer->EditContent( this, new_rev ) )
+		{
+			m_state = sync ;
+			SetIndex( false );
+
+			// the content sent may not be the one of the checksum. without
+			// the change time and fingerprint, the next sync compares
+			// checksums again
+			if ( ChangedSince( m_ctime ) )
+			{
+				Log( "sync %1% changed while uploading. it will be uploaded again", Path(), log::warning ) ;
+				m_rec->Del( StateRecord::ctime_field ) ;
+				m_rec->Del( StateRecord::fp_field ) ;
+			}
+			Emit( "upload" ) ;
+		}
+		break ;
+
+	case remote_new :
+	case remote_changed :
+		syncer->Download( this, Path() ) ;
+		SetIndex( true ) ;
+		m_state = sync ;
+		Emit( "download" ) ;
+		break ;
+
+	default :
+		assert( false ) ;
+		break ;
+	}
+
+	StoreServerTime() ;
+}
+
+/// Write the event of an operation on the resource that has just completed,
+/// if "--events" asked for them. \a from is where it was moved from.
+void Resource::Emit( const std::string& action, const Resource *from ) const
+{
+	EventStream& events = EventStream::Instance() ;
+	if ( !events.Enabled() )
+		return ;
+
+	const Resource *root = this ;
+	while ( root->m_parent != 0 )
+		root = root->m_parent ;
+
+	Val event ;
+	event.Add( "action",	Val( action ) ) ;
+	event.Add( "root",		Val( root->m_name ) ) ;
+	event.Add( "path",		Val( RelPath().string() ) ) ;
+	event.Add( "type",		Val( m_kind ) ) ;
+	if ( from != 0 )
+		event.Add( "old_path", Val( from->RelPath().string() ) ) ;
+	if ( !IsFolder() )
+	{
+		event.Add( "size", Val( m_size ) ) ;
+		if ( !m_md5.Empty() )
+			event.Add( "md5", Val( m_md5.Hex() ) ) ;
+	}
+	std::string id = m_id.empty() && from != 0 ? from->m_id : m_id ;
+	if ( !id.empty() )
+		event.Add( "id", Val( id ) ) ;
+	events.Write( event ) ;
+}
+
+/// Whether the local file changed or disappeared after \a ctime.
+bool Resource::ChangedSince( const DateTime& ctime ) const
+{
+	try
+	{
+		DateTime now ;
+		os::Stat( Path(), &now, NULL, NULL ) ;
+		return now != ctime ;
+	}
+	catch ( os::Error& )
+	{
+		return true ;
+	}
+}
+
+/// Leave the local changes of the file for a later sync.
+void Resource::Defer()
+{
+	m_deferred = true ;
+	Settle() ;
+}
+
+/// Update server time of this file in the state
+void Resource::StoreServerTime()
+{
+	if ( m_rec )
+	{
+		m_rec->srv_time = m_mtime.Sec();
+		m_rec->Set( StateRecord::srv_time_field );
 	}
 }
 
@@ -670,6 +1061,78 @@ void Resource::SetServerTime( const DateTime& time )
 	m_mtime = time ;
 }
 
+/// Treat the resource as present on both sides without syncing it. Used by
+/// the mounted view, where the local copy is only fetched when it is read.
+void Resource::AssumeSync()
+{
+	m_state = sync ;
+	Settle() ;
+}
+
+/// Whether Sync() can skip the resource and everything below it, because
+/// all of it is in sync and already recorded in the state as it is now.
+/// No summary of the subtree is stored for this: it is worked out from the
+/// children by the local scan and the remote merge, which visit them all.
+/// With "-f" the server times were dropped from the state, so nothing is
+/// clean and the remote copies win everywhere.
+bool Resource::IsClean() const
+{
+	return m_settled && m_unsettled == 0 ;
+}
+
+/// Decide again whether the resource itself needs SyncSelf(), after its
+/// state was set, and tell the folders above it. Called by the local scan
+/// and the remote merge as they go, so that Sync() knows the clean folders
+/// without another pass over the tree.
+void Resource::Settle()
+{
+	bool was_clean = IsClean() ;
+	m_settled = IsRecorded() ;
+	if ( IsClean() != was_clean && m_parent != 0 )
+		m_parent->ChildSettled( !was_clean ) ;
+}
+
+/// A child became clean (\a clean) or not. Only the folders whose own
+/// cleanness changes are passed on, so each call is cheap.
+void Resource::ChildSettled( bool clean )
+{
+	bool was_clean = IsClean() ;
+	if ( clean )
+	{
+		assert( m_unsettled > 0 ) ;
+		m_unsettled-- ;
+	}
+	else
+		m_unsettled++ ;
+
+	if ( IsClean() != was_clean && m_parent != 0 )
+		m_parent->ChildSettled( !was_clean ) ;
+}
+
+/// true if the resource is in sync and SyncSelf() would not change its state
+/// record. With "-f", the server times are dropped from the records, so
+/// nothing is taken as recorded.
+bool Resource::IsRecorded() const
+{
+	if ( m_state != sync || m_deferred )
+		return false ;
+	if ( IsRoot() )
+		return true ;
+	if ( m_rec == NULL || ( m_kind != "file" && m_kind != "folder" ) || m_rec->IsFolder() != IsFolder() )
+		return false ;
+
+	// a record not older than the file is what FromLocal() takes as unchanged
+	const StateRecord& r = *m_rec ;
+	if ( !r.Has( StateRecord::ctime_field ) || r.ctime < static_cast<u64_t>( m_ctime.Sec() ) ||
+		!r.Has( StateRecord::srv_time_field ) || r.srv_time != static_cast<u64_t>( m_mtime.Sec() ) )
+		return false ;
+
+	return IsFolder() || (
+		r.Has( StateRecord::md5_field ) && r.md5 == m_md5 &&
+		r.Has( StateRecord::size_field ) && r.size == m_size &&
+		r.Has( StateRecord::fp_field ) == m_has_fp && ( !m_has_fp || r.fp == m_fp ) ) ;
+}
+
 /// this function doesn't really remove the local file. it renames it.
 void Resource::DeleteLocal()
 {
@@ -702,33 +1165,47 @@ void Resource::DeleteLocal()
 
 void Resource::DeleteIndex()
 {
-	(*m_parent->m_json)["tree"].Del( Name() );
-	m_json = NULL;
+	m_parent->m_rec->tree.erase( Name() );
+	m_rec = NULL;
 }
 
 void Resource::SetIndex( bool re_stat )
 {
-	assert( m_parent && m_parent->m_json != NULL );
-	if ( !m_json )
-		m_json = &((*m_parent->m_json)["tree"]).Item( Name() );
+	assert( m_parent && m_parent->m_rec != NULL );
+	if ( !m_rec )
+	{
+		m_parent->m_rec->Set( StateRecord::tree_field );
+		m_rec = &m_parent->m_rec->tree[Name()];
+	}
 	FileType ft;
 	if ( re_stat )
 		os::Stat( Path(), &m_ctime, NULL, &ft );
 	else
 		ft = IsFolder() ? FT_DIR : FT_FILE;
-	m_json->Set( "ctime", Val( m_ctime.Sec() ) );
+	m_rec->ctime = m_ctime.Sec();
+	m_rec->Set( StateRecord::ctime_field );
 	if ( ft != FT_DIR )
 	{
-		m_json->Set( "md5", Val( m_md5 ) );
-		m_json->Set( "size", Val( m_size ) );
-		m_json->Del( "tree" );
+		m_rec->md5 = m_md5;
+		m_rec->size = m_size;
+		m_rec->Set( StateRecord::md5_field );
+		m_rec->Set( StateRecord::size_field );
+		m_rec->Del( StateRecord::tree_field );
+		if ( m_has_fp )
+		{
+			m_rec->fp = m_fp ;
+			m_rec->Set( StateRecord::fp_field ) ;
+		}
+		else
+			m_rec->Del( StateRecord::fp_field ) ;
 	}
 	else
 	{
 		// add tree item if it does not exist
-		m_json->Item( "tree" );
-		m_json->Del( "md5" );
-		m_json->Del( "size" );
+		m_rec->Set( StateRecord::tree_field );
+		m_rec->Del( StateRecord::md5_field );
+		m_rec->Del( StateRecord::size_field );
+		m_rec->Del( StateRecord::fp_field ) ;
 	}
 }
 
@@ -765,28 +1242,73 @@ std::string Resource::StateStr() const
 	return ss.str() ;
 }
 
+/// The heap taken by the resource, see MemStats
+std::size_t Resource::MemUsage() const
+{
+	return MemStats::Block( sizeof(*this) ) +
+		MemStats::Heap( m_name ) + MemStats::Heap( m_kind ) + MemStats::Heap( m_id ) +
+		MemStats::Heap( m_href ) + MemStats::Heap( m_content ) + MemStats::Heap( m_etag ) +
+		MemStats::Heap( m_path.native() ) +
+		MemStats::Heap( m_rel_path.native() ) +
+		MemStats::Block( m_child.capacity() * sizeof(Resource*) ) ;
+}
+
 u64_t Resource::Size() const
 {
 	return m_size ;
 }
 
-std::string Resource::MD5() const
+Digest Resource::MD5() const
 {
 	return m_md5 ;
 }
 
-std::string Resource::GetMD5()
+Digest Resource::GetMD5()
 {
-	if ( m_md5.empty() && !IsFolder() && m_local_exists )
+	if ( m_md5.Empty() && !IsFolder() && m_local_exists )
 	{
 		// MD5 checksum is calculated lazily and only when really needed:
 		// 1) when a local rename is supposed (when there are a new file and a deleted file of the same size)
-		// 2) when local ctime is changed, but file size isn't
-		m_md5 = crypt::MD5::Get( Path() );
+		// 2) when local ctime is changed, but file size isn't, and there
+		//    is no fingerprint in the state
+		// 3) when the file is compared with the remote one
+		// hard links share the checksum, so each inode is only read once
+		if ( m_inode_md5 && !m_inode_md5->Empty() )
+			m_md5 = *m_inode_md5 ;
+		else
+		{
+			// the fingerprint costs little more in the same pass
+			crypt::Fingerprint fp ;
+			m_md5 = crypt::MD5::Get( Path(), &fp );
+			if ( !m_md5.Empty() )
+			{
+				m_fp = fp.Get() ;
+				m_has_fp = true ;
+			}
+			if ( m_inode_md5 )
+				*m_inode_md5 = m_md5 ;
+		}
 	}
 	return m_md5 ;
 }
 
+/// Compute the fingerprint of the local file, false if it can't be read.
+bool Resource::ReadFingerprint()
+{
+	try
+	{
+		File file( Path() ) ;
+		m_fp = crypt::Fingerprint::Get( file ) ;
+		m_has_fp = true ;
+		return true ;
+	}
+	catch ( File::Error& )
+	{
+		m_has_fp = false ;
+		return false ;
+	}
+}
+
 bool Resource::IsRoot() const
 {
 	// Root entry does not show up in file feeds, so we check for empty parent (and self-href)
@@ -798,4 +1320,10 @@ bool Resource::HasID() const
 	return !m_href.empty() && !m_id.empty() ;
 }
 
+/// true if the resource was recorded in the state file by a previous sync
+bool Resource::HasIndex() const
+{
+	return m_rec != NULL && m_rec->Has( StateRecord::ctime_field ) ;
+}
+
 } // end of namespace
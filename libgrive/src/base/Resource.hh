@@ -21,9 +21,12 @@
 
 #include "util/Types.hh"
 #include "util/DateTime.hh"
+#include "util/Digest.hh"
 #include "util/Exception.hh"
 #include "util/FileSystem.hh"
 
+#include <boost/function.hpp>
+
 #include <string>
 #include <vector>
 #include <iosfwd>
@@ -35,6 +38,7 @@ class ResourceTree ;
 class Syncer ;
 
 class Val ;
+struct StateRecord ;
 
 class Entry ;
 
@@ -93,6 +97,7 @@ public :
 	std::string Name() const ;
 	std::string Kind() const ;
 	DateTime ServerTime() const ;
+	DateTime ChangeTime() const ;
 	std::string SelfHref() const ;
 	std::string ContentSrc() const ;
 	std::string ETag() const ;
@@ -109,16 +114,24 @@ public :
 	bool IsInRootTree() const ;
 	bool IsRoot() const ;
 	bool HasID() const ;
+	bool HasIndex() const ;
 	u64_t Size() const;
-	std::string MD5() const ;
-	std::string GetMD5() ;
+	std::size_t MemUsage() const ;
+	Digest MD5() const ;
+	Digest GetMD5() ;
 
 	void FromRemote( const Entry& remote ) ;
-	void FromDeleted( Val& state ) ;
-	void FromLocal( Val& state ) ;
+	void FromDeleted( StateRecord& state ) ;
+	void FromState( StateRecord& state ) ;
+	void FromLocal( StateRecord& state, ResourceTree *res_tree = 0, bool hash = true ) ;
 	
 	void Sync( Syncer* syncer, ResourceTree *res_tree, const Val& options ) ;
+	void SyncTwin( Syncer* syncer, ResourceTree *res_tree, const Val& options ) ;
 	void SetServerTime( const DateTime& time ) ;
+	void AssumeSync() ;
+	void Defer() ;
+
+	bool IsClean() const ;
 
 	// children access
 	iterator begin() const ;
@@ -128,8 +141,12 @@ public :
 	std::string StateStr() const ;
 
 private :
-
 	void AssignIDs( const Entry& remote ) ;
+	void Settle() ;
+	void ChildSettled( bool clean ) ;
+	bool IsRecorded() const ;
+	void CachePaths() const ;
+	void ForgetPaths() ;
 
 	friend std::ostream& operator<<( std::ostream& os, State s ) ;
 	friend class Syncer ;
@@ -145,16 +162,31 @@ private :
 	void SetIndex( bool ) ;
 	
 	bool CheckRename( Syncer* syncer, ResourceTree *res_tree ) ;
+	Resource* FindSyncedCopy( ResourceTree *res_tree, bool need_id ) ;
+	bool CopyLocal( ResourceTree *res_tree, const fs::path& path ) ;
+	bool CopyRemote( Syncer* syncer, ResourceTree *res_tree ) ;
 	void SyncSelf( Syncer* syncer, ResourceTree *res_tree, const Val& options ) ;
+	void Transfer( Syncer *syncer, ResourceTree *res_tree, const Val& options ) ;
+	void SyncCopy( Syncer *syncer, ResourceTree *res_tree, const Val& options ) ;
+	void SyncContent( Syncer *syncer, bool new_rev ) ;
+	void StoreServerTime() ;
+	void Emit( const std::string& action, const Resource *from = 0 ) const ;
+	bool ChangedSince( const DateTime& ctime ) const ;
+	bool ReadFingerprint() ;
+	bool Attempt( const boost::function<void ()>& action ) ;
 
 private :
 	std::string				m_name ;
 	std::string				m_kind ;
-	std::string				m_md5 ;
+	Digest					m_md5 ;
 	DateTime				m_mtime ;
 	DateTime				m_ctime ;
 	u64_t					m_size ;
 
+	// fingerprint of the local content, if known. see crypt::Fingerprint
+	u64_t					m_fp ;
+	bool					m_has_fp ;
+
 	std::string				m_id ;
 	std::string				m_href ;
 	std::string				m_content ;
@@ -166,8 +198,25 @@ private :
 	std::vector<Resource*>	m_child ;
 
 	State					m_state ;
-	Val*					m_json ;
+	StateRecord*			m_rec ;
 	bool					m_local_exists ;
+
+	// shared with the other hard links of the same inode. not owned
+	Digest					*m_inode_md5 ;
+
+	// paths of a folder, kept so that the path of a child takes one
+	// concatenation instead of a walk up to the root
+	mutable fs::path		m_path ;
+	mutable fs::path		m_rel_path ;
+	mutable bool			m_paths_cached ;
+
+	// whether the resource itself needs no SyncSelf(), and the number of
+	// children that are not clean. see IsClean()
+	bool					m_settled ;
+	std::size_t				m_unsettled ;
+
+	// changed too recently to be synced, see State::DeferUnsettled()
+	bool					m_deferred ;
 } ;
 
 } // end of namespace gr::v1
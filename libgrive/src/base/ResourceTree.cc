@@ -20,6 +20,7 @@
 #include "ResourceTree.hh"
 
 #include "util/Destroy.hh"
+#include "util/MemStats.hh"
 #include "util/log/Log.hh"
 
 #include <algorithm>
@@ -63,6 +64,9 @@ void ResourceTree::Clear()
 	std::for_each( s.begin(), s.end(), Destroy() ) ;
 	
 	m_set.clear() ;
+	m_inodes.clear() ;
+	m_transfers.clear() ;
+	m_twins.clear() ;
 	m_root = 0 ;
 }
 
@@ -97,10 +101,10 @@ const Resource* ResourceTree::FindByHref( const std::string& href ) const
 	return i != map.end() ? *i : 0 ;
 }
 
-MD5Range ResourceTree::FindByMD5( const std::string& md5 )
+MD5Range ResourceTree::FindByMD5( const Digest& md5 )
 {
 	MD5Map& map = m_set.get<ByMD5>() ;
-	if ( !md5.empty() )
+	if ( !md5.Empty() )
 		return map.equal_range( md5 );
 	return MD5Range( map.end(), map.end() ) ;
 }
@@ -111,6 +115,41 @@ SizeRange ResourceTree::FindBySize( u64_t size )
 	return map.equal_range( size );
 }
 
+/// Returns the checksum slot shared by all hard links of one inode. It is
+/// empty until one of the links has been hashed.
+Digest* ResourceTree::InodeMD5( u64_t dev, u64_t ino )
+{
+	return &m_inodes[ std::make_pair( dev, ino ) ] ;
+}
+
+/// The file with the checksum \a md5 that is being uploaded or downloaded.
+Resource* ResourceTree::FindTransfer( const Digest& md5 )
+{
+	std::map<Digest, Resource*>::iterator i = m_transfers.find( md5 ) ;
+	return i != m_transfers.end() ? i->second : 0 ;
+}
+
+void ResourceTree::AddTransfer( Resource *res )
+{
+	m_transfers.insert( std::make_pair( res->MD5(), res ) ) ;
+}
+
+/// \a res has the same content as a file being transferred, it is copied
+/// from it afterwards instead of being transferred too.
+void ResourceTree::AddTwin( Resource *res )
+{
+	m_twins.push_back( res ) ;
+}
+
+/// The files added by AddTwin(), once the transfers are done.
+std::vector<Resource*> ResourceTree::TakeTwins()
+{
+	std::vector<Resource*> twins ;
+	twins.swap( m_twins ) ;
+	m_transfers.clear() ;
+	return twins ;
+}
+
 ///	Reinsert should be called when the ID/HREF/MD5 were updated
 bool ResourceTree::ReInsert( Resource *coll )
 {
@@ -145,6 +184,30 @@ void ResourceTree::Update( Resource *coll, const Entry& e )
 	ReInsert( coll ) ;
 }
 
+/// The heap taken by the resources, the nodes and buckets of the indexes and
+/// the checksums of hard links, see MemStats
+std::size_t ResourceTree::MemUsage() const
+{
+	// one node per resource with two links for each of the four indexes
+	const std::size_t node = MemStats::Block( sizeof(Resource*) * 9 ) ;
+
+	const Set& s = m_set.get<ByIdentity>() ;
+	std::size_t bytes = 0 ;
+	for ( Set::const_iterator i = s.begin() ; i != s.end() ; ++i )
+		bytes += node + (*i)->MemUsage() ;
+
+	bytes += MemStats::Block( sizeof(void*) * m_set.get<ByHref>().bucket_count() ) ;
+	bytes += MemStats::Block( sizeof(void*) * m_set.get<ByMD5>().bucket_count() ) ;
+	bytes += MemStats::Block( sizeof(void*) * m_set.get<BySize>().bucket_count() ) ;
+	bytes += MemStats::Block( sizeof(void*) * s.bucket_count() ) ;
+	return bytes + m_inodes.size() * MemStats::Block( 32 + sizeof(InodeMap::value_type) ) ;
+}
+
+std::size_t ResourceTree::Count() const
+{
+	return m_set.size() ;
+}
+
 ResourceTree::iterator ResourceTree::begin()
 {
 	return m_set.get<ByIdentity>().begin() ;
@@ -28,6 +28,10 @@
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 
+#include <map>
+#include <utility>
+#include <vector>
+
 namespace gr {
 
 namespace details
@@ -42,7 +46,7 @@ namespace details
 		Resource*,
 		indexed_by<
 			hashed_non_unique<tag<ByHref>,	const_mem_fun<Resource, std::string,	&Resource::SelfHref> >,
-			hashed_non_unique<tag<ByMD5>,	const_mem_fun<Resource, std::string,	&Resource::MD5> >,
+			hashed_non_unique<tag<ByMD5>,	const_mem_fun<Resource, Digest,		&Resource::MD5> >,
 			hashed_non_unique<tag<BySize>,	const_mem_fun<Resource, u64_t,			&Resource::Size> >,
 			hashed_unique<tag<ByIdentity>,	identity<Resource*> >
 		>
@@ -54,6 +58,9 @@ namespace details
 	typedef Folders::index<ByIdentity>::type	Set ;
 	typedef std::pair<SizeMap::iterator, SizeMap::iterator> SizeRange ;
 	typedef std::pair<MD5Map::iterator, MD5Map::iterator> MD5Range ;
+	
+	// local checksums of hard-linked files, keyed by (device, inode)
+	typedef std::map<std::pair<u64_t, u64_t>, Digest> InodeMap ;
 }
 
 /*!	\brief	A simple container for storing folders
@@ -73,8 +80,14 @@ public :
 	
 	Resource* FindByHref( const std::string& href ) ;
 	const Resource* FindByHref( const std::string& href ) const ;
-	details::MD5Range FindByMD5( const std::string& md5 ) ;
+	details::MD5Range FindByMD5( const Digest& md5 ) ;
 	details::SizeRange FindBySize( u64_t size ) ;
+	Digest* InodeMD5( u64_t dev, u64_t ino ) ;
+
+	Resource* FindTransfer( const Digest& md5 ) ;
+	void AddTransfer( Resource *res ) ;
+	void AddTwin( Resource *res ) ;
+	std::vector<Resource*> TakeTwins() ;
 
 	bool ReInsert( Resource *coll ) ;
 	
@@ -84,6 +97,9 @@ public :
 	
 	Resource* Root() ;
 	const Resource* Root() const ;
+
+	std::size_t MemUsage() const ;
+	std::size_t Count() const ;
 	
 	iterator begin() ;
 	iterator end() ;
@@ -93,7 +109,13 @@ private :
 
 private :
 	details::Folders	m_set ;
+	details::InodeMap	m_inodes ;
 	Resource*			m_root ;
+
+	// the files queued on the bulk lane by checksum, and the files with the
+	// same content which copy them when they are done
+	std::map<Digest, Resource*>	m_transfers ;
+	std::vector<Resource*>		m_twins ;
 } ;
 
 } // end of namespace gr
@@ -25,16 +25,30 @@
 
 #include "util/Crypt.hh"
 #include "util/File.hh"
+#include "util/IoUring.hh"
+#include "util/MemStats.hh"
+#include "util/StdStream.hh"
+#include "util/StringStream.hh"
 #include "util/log/Log.hh"
+#include "http/Agent.hh"
 #include "json/JsonParser.hh"
+#include "json/JsonWriter.hh"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/exception/errinfo_api_function.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/exception/info.hpp>
+#include <boost/throw_exception.hpp>
 
+#include <algorithm>
 #include <fstream>
 
 namespace gr {
 
 const std::string state_file = ".grive_state" ;
+const std::string shard_dir = ".grive_state.d" ;
+const int default_shard_depth = 0 ;
+const int partition_shard_depth = 1 ;
 const std::string ignore_file = ".griveignore" ;
 const int MAX_IGN = 65536 ;
 const char* regex_escape_chars = ".^$|()[]{}*+?\\";
@@ -45,15 +59,81 @@ inline std::string regex_escape( std::string s )
 	return regex_replace( s, regex_escape_re, "\\\\&", boost::format_sed );
 }
 
+/// The JSON of the "tree" of a folder, as written to its shard file
+static std::string TreeJson( const StateRecord::Tree& tree )
+{
+	StringStream ss ;
+	JsonWriter wr( &ss ) ;
+	StateRecord::VisitTree( tree, &wr ) ;
+	return ss.Str() ;
+}
+
+/// The state files are written next to their final name first, so that a
+/// failed write (e.g. a full disk) leaves the state of the last sync intact.
+static fs::path TempName( const fs::path& path )
+{
+	return path.parent_path() / ( path.filename().string() + ".tmp" ) ;
+}
+
+/// Replace \a path with the \a tmp file written in \a fs.
+static void Replace( std::ofstream& fs, const fs::path& tmp, const fs::path& path )
+{
+	fs.close() ;
+	if ( !fs )
+	{
+		boost::system::error_code ec ;
+		fs::remove( tmp, ec ) ;
+		BOOST_THROW_EXCEPTION(
+			File::Error()
+				<< boost::errinfo_api_function("write")
+				<< boost::errinfo_file_name(tmp.string())
+		) ;
+	}
+	fs::rename( tmp, path ) ;
+}
+
 State::State( const fs::path& root, const Val& options  ) :
 	m_root		( root ),
 	m_res		( options["path"].Str() ),
-	m_cstamp	( -1 )
+	m_cstamp	( -1 ),
+	m_shard_depth	( -1 )
 {
+	options.TryGet( "state-depth", m_shard_depth ) ;
 	Read() ;
+	Init( options ) ;
+}
+
+/// The state of the top-level folder \a partition alone, taken out of
+/// \a whole instead of reading the state file again. Used by the
+/// bounded-memory sync, see Skip() and PutBack().
+State::State( State& whole, const std::string& partition, const Val& options ) :
+	m_root		( whole.m_root ),
+	m_res		( options["path"].Str() ),
+	m_cstamp	( whole.m_cstamp ),
+	m_page_token( whole.m_page_token ),
+	m_ign		( whole.m_ign ),
+	m_shard_depth	( whole.m_shard_depth )
+{
+	StateRecord::Tree::iterator i = whole.m_st.tree.find( partition ) ;
+	if ( i != whole.m_st.tree.end() )
+	{
+		std::swap( m_st.tree[partition], i->second ) ;
+		whole.m_st.tree.erase( i ) ;
+	}
 
+	Init( options ) ;
+	m_ign_changed = whole.m_ign_changed ;
+	Restrict( "|^(?!" + regex_escape( partition ) + "(/|$))" ) ;
+}
+
+void State::Init( const Val& options )
+{
 	// the "-f" option will make grive always think remote is newer
-	m_force = options.Has( "force" ) ? options["force"].Bool() : false ;
+	m_force = false ;
+	options.TryGet( "force", m_force ) ;
+	bool no_hash = false ;
+	options.TryGet( "no-hash", no_hash ) ;
+	m_hash = !no_hash ;
 
 	std::string m_orig_ign = m_ign;
 	if ( options.Has( "ignore" ) && options["ignore"].Str() != m_ign )
@@ -78,19 +158,129 @@ State::State( const fs::path& root, const Val& options  ) :
 	}
 
 	m_ign_changed = m_orig_ign != "" && m_orig_ign != m_ign;
-	m_ign_re = boost::regex( m_ign.empty() ? "^\\.(grive$|grive_state$|trash)" : ( m_ign+"|^\\.(grive$|grive_state$|trash)" ) );
+
+	// "--paths-from" names the only local paths that may have changed
+	m_restrict = false ;
+	if ( options.Has( "paths" ) )
+	{
+		m_restrict = true ;
+		const Val::Array& paths = options["paths"].AsArray() ;
+		for ( Val::Array::const_iterator i = paths.begin() ; i != paths.end() ; ++i )
+			AddPath( i->Str() ) ;
+	}
+
+	ReadSettle( options ) ;
+	Restrict( "" ) ;
+}
+
+/// Build the ignore regex, with \a part_ign added to the ignore rules. The
+/// bounded-memory sync restricts each run to one part of the tree this way.
+/// Unlike "-s" this is not saved as ignore_regexp.
+void State::Restrict( const std::string& part_ign )
+{
+	if ( !part_ign.empty() && m_shard_depth == 0 )
+	{
+		// the state of the other parts must stay on disk
+		m_shard_depth = partition_shard_depth ;
+	}
+
+	// the files of grive, and the downloads of "--verify --repair" which
+	// are renamed over corrupted files
+	const std::string own = "^\\.(grive$|grive_state$|grive_state\\.d$|grive_verify$|trash)|(^|/)\\.[^/]*\\.grive_verify$" ;
+	m_ign_re = boost::regex( ( m_ign.empty() ? own : m_ign + "|" + own ) + part_ign );
+}
+
+/// Leave the top-level folders \a parts out of this state. Each of them is
+/// synced by a State of its own. Call before FromLocal().
+void State::Skip( const std::set<std::string>& parts )
+{
+	if ( parts.empty() )
+		return ;
+
+	std::string part_ign ;
+	for ( std::set<std::string>::const_iterator i = parts.begin() ; i != parts.end() ; ++i )
+		part_ign += ( part_ign.empty() ? "|^(" : "|" ) + regex_escape( *i ) ;
+	Restrict( part_ign + ")(/|$)" ) ;
+}
+
+/// Give the state of a partition back to the \a whole state it was taken
+/// from, after the partition was synced. Its subtree is written to its shard
+/// file and dropped from memory. This State is not to be used afterwards.
+void State::PutBack( State& whole )
+{
+	std::set<std::string> live ;
+	std::map<StateRecord*, StateRecord::Tree> split ;
+	fs::create_directories( m_root / shard_dir ) ;
+	SplitShards( m_st.tree, fs::path(), 1, live, split ) ;
+
+	for ( StateRecord::Tree::iterator i = m_st.tree.begin() ; i != m_st.tree.end() ; ++i )
+		std::swap( whole.m_st.tree[i->first], i->second ) ;
 }
 
 State::~State()
 {
 }
 
+/// Add \a path, relative to the root or absolute, to the paths that are
+/// looked at by FromLocal(), and its parent folders to the folders that are
+/// looked into. The root itself means the whole tree.
+void State::AddPath( const std::string& path )
+{
+	fs::path p( path ), rel ;
+	fs::path::iterator i = p.begin() ;
+	if ( p.is_absolute() )
+	{
+		fs::path root = fs::absolute( m_root ) ;
+		for ( fs::path::iterator r = root.begin() ; r != root.end() ; ++r )
+		{
+			if ( r->string() == "." )
+				continue ;
+			if ( i == p.end() || *i != *r )
+			{
+				Log( "%1% is not in the working copy, ignored", path, log::warning ) ;
+				return ;
+			}
+			++i ;
+		}
+	}
+	for ( ; i != p.end() ; ++i )
+	{
+		if ( i->string() == ".." )
+		{
+			Log( "%1% is not in the working copy, ignored", path, log::warning ) ;
+			return ;
+		}
+		if ( i->string() != "." && i->string() != "/" && !i->empty() )
+			rel /= *i ;
+	}
+
+	if ( rel.empty() )
+	{
+		m_restrict = false ;
+		return ;
+	}
+
+	m_paths.insert( rel.string() ) ;
+	for ( ; !rel.empty() ; rel = rel.parent_path() )
+		m_path_children[rel.parent_path().string()].insert( rel.filename().string() ) ;
+}
+
 /// Synchronize local directory. Build up the resource tree from files and folders
 /// of local directory.
+///
+/// Every file and folder is looked at, even below folders which turn out to
+/// be clean: a change deep down doesn't show in the change time of the
+/// folders above it. Only the hashing is skipped for unchanged files, and
+/// only Sync() skips the clean folders, see Resource::IsClean(). Use
+/// "--paths-from" to look at fewer files.
 void State::FromLocal( const fs::path& p )
 {
 	m_res.Root()->FromLocal( m_st ) ;
-	FromLocal( p, m_res.Root(), m_st.Item( "tree" ) ) ;
+	m_st.Set( StateRecord::tree_field ) ;
+	if ( m_restrict )
+		FromPaths( p, m_res.Root(), m_st.tree ) ;
+	else
+		FromLocal( p, m_res.Root(), m_st.tree ) ;
 }
 
 bool State::IsIgnore( const std::string& filename )
@@ -98,13 +288,14 @@ bool State::IsIgnore( const std::string& filename )
 	return regex_search( filename.c_str(), m_ign_re, boost::format_perl );
 }
 
-void State::FromLocal( const fs::path& p, Resource* folder, Val& tree )
+void State::FromLocal( const fs::path& p, Resource* folder, StateRecord::Tree& tree )
 {
 	assert( folder != 0 ) ;
 	assert( folder->IsFolder() ) ;
 
-	Val::Object leftover = tree.AsObject();
-
+	// list the directory first, so that its entries can be stat()ed in one batch
+	std::vector<fs::path> entries ;
+	std::vector<std::string> names ;
 	for ( fs::directory_iterator i( p ) ; i != fs::directory_iterator() ; ++i )
 	{
 		std::string fname = i->path().filename().string() ;
@@ -114,46 +305,285 @@ void State::FromLocal( const fs::path& p, Resource* folder, Val& tree )
 			Log( "file %1% is ignored by grive", path, log::verbose ) ;
 		else
 		{
-			// if the Resource object of the child already exists, it should
-			// have been so no need to do anything here
-			Resource *c = folder->FindChild( fname ), *c2 = c ;
-			if ( !c )
-			{
-				c2 = new Resource( fname, "" ) ;
-				folder->AddChild( c2 ) ;
-			}
-			leftover.erase( fname );
-			Val& rec = tree.Item( fname );
-			if ( m_force )
-				rec.Del( "srv_time" );
-			c2->FromLocal( rec ) ;
-			if ( !c )
-				m_res.Insert( c2 ) ;
-			if ( c2->IsFolder() )
-				FromLocal( *i, c2, rec.Item( "tree" ) ) ;
+			entries.push_back( i->path() ) ;
+			names.push_back( i->path().string() ) ;
+		}
+	}
+	IoUring::Instance().PrefetchStat( names ) ;
+
+	// the records without a local file are those of deleted files
+	std::vector<std::string> seen ;
+	seen.reserve( entries.size() ) ;
+
+	// the stats not taken must not outlive this listing, or a later
+	// os::Stat() in this thread would get them instead of the current ones
+	try
+	{
+		for ( std::vector<fs::path>::iterator i = entries.begin() ; i != entries.end() ; ++i )
+		{
+			std::string fname = i->filename().string() ;
+			seen.push_back( fname ) ;
+			StateRecord& rec = tree[fname] ;
+			Resource *c = AddLocal( folder, fname, rec ) ;
+			if ( c->IsFolder() )
+				FromLocal( *i, c, Subtree( rec ) ) ;
 		}
 	}
+	catch ( ... )
+	{
+		IoUring::Instance().DropStats( names ) ;
+		throw ;
+	}
+	IoUring::Instance().DropStats( names ) ;
 
-	for( Val::Object::iterator i = leftover.begin(); i != leftover.end(); i++ )
+	std::sort( seen.begin(), seen.end() ) ;
+	for ( StateRecord::Tree::iterator i = tree.begin() ; i != tree.end() ; ++i )
 	{
+		if ( std::binary_search( seen.begin(), seen.end(), i->first ) )
+			continue ;
+
 		std::string path = folder->IsRoot() ? i->first : ( folder->RelPath() / i->first ).string();
 		if ( IsIgnore( path ) )
 			Log( "file %1% is ignored by grive", path, log::verbose ) ;
 		else
+			AddDeleted( folder, i->first, i->second ) ;
+	}
+}
+
+/// Like FromLocal(), but only the paths given by "--paths-from" and the
+/// folders above them are looked at in the file system. Everything else is
+/// restored from the state as it was at the last sync.
+void State::FromPaths( const fs::path& p, Resource *folder, StateRecord::Tree& tree )
+{
+	std::string rel = folder->IsRoot() ? std::string() : folder->RelPath().string() ;
+	std::map<std::string, std::set<std::string> >::const_iterator wanted = m_path_children.find( rel ) ;
+	const std::set<std::string> *names = wanted != m_path_children.end() ? &wanted->second : NULL ;
+
+	for ( StateRecord::Tree::iterator i = tree.begin() ; i != tree.end() ; ++i )
+	{
+		if ( names == NULL || names->count( i->first ) == 0 )
+			FromRecord( folder, i->first, i->second ) ;
+	}
+	if ( names == NULL )
+		return ;
+
+	for ( std::set<std::string>::const_iterator i = names->begin() ; i != names->end() ; ++i )
+	{
+		std::string path = rel.empty() ? *i : rel + '/' + *i ;
+		if ( IsIgnore( path ) )
+		{
+			Log( "file %1% is ignored by grive", path, log::verbose ) ;
+			continue ;
+		}
+
+		bool named = m_paths.count( path ) > 0 ;
+		StateRecord::Tree::iterator r = tree.find( *i ) ;
+
+		// a folder above the named paths, which is known from the last sync
+		if ( !named && r != tree.end() && r->second.IsFolder() )
+		{
+			Resource *c = AddRecord( folder, *i, r->second ) ;
+			FromPaths( p / *i, c, Subtree( r->second ) ) ;
+			continue ;
+		}
+
+		boost::system::error_code ec ;
+		fs::symlink_status( p / *i, ec ) ;
+		if ( ec )
+		{
+			if ( r != tree.end() )
+				AddDeleted( folder, *i, r->second ) ;
+			continue ;
+		}
+
+		StateRecord& rec = tree[*i] ;
+		Resource *c = AddLocal( folder, *i, rec ) ;
+		if ( c->IsFolder() && named )
+			FromLocal( p / *i, c, Subtree( rec ) ) ;
+		else if ( c->IsFolder() )
+			FromPaths( p / *i, c, Subtree( rec ) ) ;
+	}
+}
+
+/// Restore \a rec and everything below it from the state, without looking
+/// at the file system.
+void State::FromRecord( Resource *folder, const std::string& name, StateRecord& rec )
+{
+	std::string path = folder->IsRoot() ? name : ( folder->RelPath() / name ).string() ;
+	if ( IsIgnore( path ) )
+	{
+		Log( "file %1% is ignored by grive", path, log::verbose ) ;
+		return ;
+	}
+
+	Resource *c = AddRecord( folder, name, rec ) ;
+	if ( c->IsFolder() )
+	{
+		StateRecord::Tree& tree = Subtree( rec ) ;
+		for ( StateRecord::Tree::iterator i = tree.begin() ; i != tree.end() ; ++i )
+			FromRecord( c, i->first, i->second ) ;
+	}
+}
+
+/// The child \a name of \a folder, from the local file.
+Resource* State::AddLocal( Resource *folder, const std::string& name, StateRecord& rec )
+{
+	// if the Resource object of the child already exists, it should
+	// have been so no need to do anything here
+	Resource *c = folder->FindChild( name ), *c2 = c ;
+	if ( !c )
+	{
+		c2 = new Resource( name, "" ) ;
+		folder->AddChild( c2 ) ;
+	}
+	if ( m_force )
+		rec.Del( StateRecord::srv_time_field ) ;
+	c2->FromLocal( rec, &m_res, m_hash ) ;
+	if ( !c )
+		m_res.Insert( c2 ) ;
+	return c2 ;
+}
+
+/// The child \a name of \a folder, as it was at the last sync.
+Resource* State::AddRecord( Resource *folder, const std::string& name, StateRecord& rec )
+{
+	Resource *c = folder->FindChild( name ), *c2 = c ;
+	if ( !c )
+	{
+		c2 = new Resource( name, rec.IsFolder() ? "folder" : "file" ) ;
+		folder->AddChild( c2 ) ;
+	}
+	if ( m_force )
+		rec.Del( StateRecord::srv_time_field ) ;
+	c2->FromState( rec ) ;
+	if ( !c )
+		m_res.Insert( c2 ) ;
+	return c2 ;
+}
+
+/// The child \a name of \a folder, which was deleted locally.
+void State::AddDeleted( Resource *folder, const std::string& name, StateRecord& rec )
+{
+	// Restore state of locally deleted files
+	Resource *c = folder->FindChild( name ), *c2 = c ;
+	if ( !c )
+	{
+		c2 = new Resource( name, rec.IsFolder() ? "folder" : "file" ) ;
+		folder->AddChild( c2 ) ;
+	}
+	if ( !rec.shard.empty() )
+		Subtree( rec ) ;
+	if ( m_force || m_ign_changed )
+		rec.Del( StateRecord::srv_time_field ) ;
+	c2->FromDeleted( rec );
+	if ( !c )
+		m_res.Insert( c2 ) ;
+}
+
+/// The state record of \a rel, relative to the root, as written by the last
+/// sync. NULL if the file was not synced.
+StateRecord* State::Record( const fs::path& rel )
+{
+	StateRecord *rec = &m_st ;
+	for ( fs::path::iterator i = rel.begin() ; i != rel.end() ; ++i )
+	{
+		if ( !rec->IsFolder() )
+			return NULL ;
+		StateRecord::Tree& tree = Subtree( *rec ) ;
+		StateRecord::Tree::iterator c = tree.find( i->string() ) ;
+		if ( c == tree.end() )
+			return NULL ;
+		rec = &c->second ;
+	}
+	return rec ;
+}
+
+/// Get the "tree" of a folder record, loading it from its shard file first
+/// if the folder has not been visited yet.
+StateRecord::Tree& State::Subtree( StateRecord& rec )
+{
+	if ( !rec.shard.empty() )
+	{
+		std::string id = rec.shard ;
+		rec.shard.clear() ;
+		rec.Set( StateRecord::tree_field ) ;
+		try
 		{
-			// Restore state of locally deleted files
-			Resource *c = folder->FindChild( i->first ), *c2 = c ;
-			if ( !c )
+			File sh_file( m_root / shard_dir / ( id + ".json" ) ) ;
+			StateLoader loader( &rec.tree ) ;
+			JsonParser parser( &loader ) ;
+			parser.Parse( sh_file ) ;
+			parser.Finish() ;
+		}
+		catch ( Exception& )
+		{
+			Log( "state shard %1% is missing, treating its files as new", id, log::warning ) ;
+			rec.tree.clear() ;
+		}
+
+		std::string json = TreeJson( rec.tree ) ;
+		crypt::MD5 sum ;
+		sum.Write( json.data(), json.size() ) ;
+		m_shards[id] = sum.Get() ;
+	}
+	return rec.tree ;
+}
+
+/// Load every shard under \a tree. Used when the shard depth changes.
+void State::LoadShards( StateRecord::Tree& tree )
+{
+	for ( StateRecord::Tree::iterator i = tree.begin() ; i != tree.end() ; ++i )
+	{
+		if ( i->second.IsFolder() )
+			LoadShards( Subtree( i->second ) ) ;
+	}
+}
+
+/// Move the folder subtrees at the shard depth out of \a tree into their own
+/// files. Only shards which were loaded and changed are written. The moved
+/// subtrees are collected in \a split so that they can be put back afterwards.
+void State::SplitShards( StateRecord::Tree& tree, const fs::path& rel, int depth,
+	std::set<std::string>& live, std::map<StateRecord*, StateRecord::Tree>& split )
+{
+	for ( StateRecord::Tree::iterator i = tree.begin() ; i != tree.end() ; ++i )
+	{
+		StateRecord& rec = i->second ;
+		if ( !rec.Has( StateRecord::tree_field ) )
+		{
+			// not a folder, or a shard that has not been loaded
+			if ( !rec.shard.empty() )
+				live.insert( rec.shard ) ;
+		}
+		else if ( depth < m_shard_depth )
+		{
+			rec.shard.clear() ;
+			SplitShards( rec.tree, rel / i->first, depth+1, live, split ) ;
+		}
+		else
+		{
+			std::string json = TreeJson( rec.tree ) ;
+			crypt::MD5 sum ;
+			sum.Write( json.data(), json.size() ) ;
+
+			std::string path = ( rel / i->first ).string() ;
+			crypt::MD5 name ;
+			name.Write( path.data(), path.size() ) ;
+			std::string id = name.Get().Hex() ;
+
+			fs::path filename = m_root / shard_dir / ( id + ".json" ) ;
+			std::map<std::string, Digest>::iterator old = m_shards.find( id ) ;
+			if ( old == m_shards.end() || old->second != sum.Get() || !fs::exists( filename ) )
 			{
-				c2 = new Resource( i->first, i->second.Has( "tree" ) ? "folder" : "file" ) ;
-				folder->AddChild( c2 ) ;
+				fs::path tmp = TempName( filename ) ;
+				std::ofstream fs( tmp.string().c_str() ) ;
+				fs << json ;
+				Replace( fs, tmp, filename ) ;
 			}
-			Val& rec = tree.Item( i->first );
-			if ( m_force || m_ign_changed )
-				rec.Del( "srv_time" );
-			c2->FromDeleted( rec );
-			if ( !c )
-				m_res.Insert( c2 ) ;
+			live.insert( id ) ;
+
+			split[&rec].swap( rec.tree ) ;
+			rec.Del( StateRecord::tree_field ) ;
+			rec.shard = id ;
 		}
 	}
 }
@@ -297,25 +727,50 @@ State::iterator State::end()
 
 void State::Read()
 {
-	try
-	{
-		File st_file( m_root / state_file ) ;
-		m_st = ParseJson( st_file );
-		m_cstamp = m_st["change_stamp"].Int() ;
-	}
-	catch ( Exception& )
+	// a missing state or ignore file is normal, don't pay for an exception
+	Val header ;
+	if ( fs::exists( m_root / state_file ) )
 	{
+		try
+		{
+			File st_file( m_root / state_file ) ;
+			StateLoader loader( &m_st ) ;
+			JsonParser parser( &loader ) ;
+			parser.Parse( st_file ) ;
+			parser.Finish() ;
+			header = loader.Header() ;
+			header.TryGet( "change_stamp", m_cstamp ) ;
+			header.TryGet( "page_token", m_page_token ) ;
+		}
+		catch ( Exception& )
+		{
+			m_st = StateRecord() ;
+		}
 	}
 
-	try
+	// state files written before sharding keep the whole tree inline
+	int depth = 0 ;
+	bool has_depth = header.TryGet( "shard_depth", depth ) ;
+	if ( m_shard_depth < 0 )
+		m_shard_depth = has_depth ? depth : default_shard_depth ;
+	else if ( depth > 0 && depth != m_shard_depth )
 	{
-		File ign_file( m_root / ignore_file ) ;
-		char ign[MAX_IGN] = { 0 };
-		int s = ign_file.Read( ign, MAX_IGN-1 ) ;
-		ParseIgnoreFile( ign, s );
+		Log( "state shard depth changed from %1% to %2%, loading all shards", depth, m_shard_depth, log::verbose ) ;
+		LoadShards( m_st.tree ) ;
 	}
-	catch ( Exception& e )
+
+	if ( fs::exists( m_root / ignore_file ) )
 	{
+		try
+		{
+			File ign_file( m_root / ignore_file ) ;
+			char ign[MAX_IGN] = { 0 };
+			int s = ign_file.Read( ign, MAX_IGN-1 ) ;
+			ParseIgnoreFile( ign, s );
+		}
+		catch ( Exception& e )
+		{
+		}
 	}
 }
 
@@ -331,12 +786,43 @@ std::vector<std::string> split( const boost::regex& re, const char* str, int len
 	return vec;
 }
 
+/// The path components of a .griveignore pattern, each converted to a regex
+std::vector<std::string> GlobParts( const std::string& glob )
+{
+	const boost::regex re4( "([^\\\\](\\\\\\\\)*|^)\\\\\\*" );
+	const boost::regex re5( "([^\\\\](\\\\\\\\)*|^)\\\\\\?" );
+	std::vector<std::string> parts = split( boost::regex( "/+" ), glob.c_str(), glob.size() );
+	for ( int j = 0; j < (int)parts.size(); j++ )
+	{
+		if ( parts[j] == "**" )
+		{
+			parts[j] = ".*";
+		}
+		else if ( parts[j] == "*" )
+		{
+			parts[j] = "[^/]*";
+		}
+		else
+		{
+			parts[j] = regex_escape( parts[j] );
+			std::string str1;
+			while (1)
+			{
+				str1 = regex_replace( parts[j], re5, "$1[^/]", boost::format_perl );
+				str1 = regex_replace( str1, re4, "$1[^/]*", boost::format_perl );
+				if ( str1.size() == parts[j].size() )
+					break;
+				parts[j] = str1;
+			}
+		}
+	}
+	return parts;
+}
+
 bool State::ParseIgnoreFile( const char* buffer, int size )
 {
 	const boost::regex re1( "([^\\\\]|^)[\\t\\r ]+$" );
 	const boost::regex re2( "^[\\t\\r ]+" );
-	const boost::regex re4( "([^\\\\](\\\\\\\\)*|^)\\\\\\*" );
-	const boost::regex re5( "([^\\\\](\\\\\\\\)*|^)\\\\\\?" );
 	std::string exclude_re, include_re;
 	std::vector<std::string> lines = split( boost::regex( "[\\n\\r]+" ), buffer, size );
 	for ( int i = 0; i < (int)lines.size(); i++ )
@@ -351,31 +837,7 @@ bool State::ParseIgnoreFile( const char* buffer, int size )
 		{
 			str = str.substr( 1 );
 		}
-		std::vector<std::string> parts = split( boost::regex( "/+" ), str.c_str(), str.size() );
-		for ( int j = 0; j < (int)parts.size(); j++ )
-		{
-			if ( parts[j] == "**" )
-			{
-				parts[j] = ".*";
-			}
-			else if ( parts[j] == "*" )
-			{
-				parts[j] = "[^/]*";
-			}
-			else
-			{
-				parts[j] = regex_escape( parts[j] );
-				std::string str1;
-				while (1)
-				{
-					str1 = regex_replace( parts[j], re5, "$1[^/]", boost::format_perl );
-					str1 = regex_replace( str1, re4, "$1[^/]*", boost::format_perl );
-					if ( str1.size() == parts[j].size() )
-						break;
-					parts[j] = str1;
-				}
-			}
-		}
+		std::vector<std::string> parts = GlobParts( str );
 		if ( !inc )
 		{
 			str = boost::algorithm::join( parts, "/" ) + "(/|$)";
@@ -401,20 +863,216 @@ bool State::ParseIgnoreFile( const char* buffer, int size )
 	return false;
 }
 
+static bool Longer( const std::string& a, const std::string& b )
+{
+	return a.size() > b.size() ;
+}
+
+/// The settle time of "settle-time", and the overrides in the "settle"
+/// object of the config, from .griveignore patterns to seconds.
+void State::ReadSettle( const Val& options )
+{
+	m_settle = 0 ;
+	if ( options.Has( "settle-time" ) )
+		m_settle = options["settle-time"].U64() ;
+
+	if ( !options.Has( "settle" ) )
+		return ;
+	const Val::Object& settle = options["settle"].AsObject() ;
+	std::vector<std::string> patterns ;
+	for ( Val::Object::const_iterator i = settle.begin() ; i != settle.end() ; ++i )
+		patterns.push_back( i->first ) ;
+
+	// the longest pattern is the most specific one, it is tried first
+	std::stable_sort( patterns.begin(), patterns.end(), &Longer ) ;
+	for ( std::size_t i = 0 ; i < patterns.size() ; i++ )
+	{
+		// "**/" also matches no folder at all
+		std::string re = boost::algorithm::join( GlobParts( patterns[i] ), "/" ) ;
+		boost::algorithm::replace_all( re, ".*/", "(.*/)?" ) ;
+		m_settle_re.push_back( std::make_pair( boost::regex( "^" + re + "$" ),
+			settle.find( patterns[i] )->second.U64() ) ) ;
+	}
+}
+
+/// How long after its last change the file at \a path, relative to the root,
+/// is left alone before it is uploaded.
+unsigned State::SettleTime( const std::string& path ) const
+{
+	for ( std::size_t i = 0 ; i < m_settle_re.size() ; i++ )
+	{
+		if ( boost::regex_match( path, m_settle_re[i].first ) )
+			return m_settle_re[i].second ;
+	}
+	return m_settle ;
+}
+
+/// Leave the files changed within their settle time for a later sync. They
+/// are probably still being written, and their record in the state is kept
+/// as of the last sync, so that they are found changed again.
+void State::DeferUnsettled()
+{
+	if ( m_settle == 0 && m_settle_re.empty() )
+		return ;
+
+	std::time_t now = DateTime::Now().Sec() ;
+	for ( iterator i = begin() ; i != end() ; ++i )
+	{
+		Resource *r = *i ;
+		if ( r->IsFolder() ||
+			( r->GetState() != Resource::local_new && r->GetState() != Resource::local_changed ) )
+			continue ;
+
+		unsigned settle = SettleTime( r->RelPath().string() ) ;
+		if ( settle > 0 && r->ChangeTime().Sec() + static_cast<std::time_t>( settle ) > now )
+			r->Defer() ;
+	}
+}
+
 void State::Write()
 {
-	m_st.Set( "change_stamp", Val( m_cstamp ) ) ;
-	m_st.Set( "ignore_regexp", Val( m_ign ) ) ;
-	
-	fs::path filename = m_root / state_file ;
-	std::ofstream fs( filename.string().c_str() ) ;
-	fs << m_st ;
+	std::set<std::string> live ;
+	std::map<StateRecord*, StateRecord::Tree> split ;
+	try
+	{
+		if ( m_shard_depth > 0 )
+		{
+			fs::create_directories( m_root / shard_dir ) ;
+			SplitShards( m_st.tree, fs::path(), 1, live, split ) ;
+		}
+
+		// the state file names the shards, so it is written after all of them
+		fs::path filename = m_root / state_file ;
+		fs::path tmp = TempName( filename ) ;
+		std::ofstream fs( tmp.string().c_str() ) ;
+		{
+			StdStream ss( fs.rdbuf() ) ;
+			JsonWriter wr( &ss ) ;
+			wr.StartObject() ;
+			wr.VisitKey( "change_stamp" ) ;
+			wr.Visit( static_cast<long long>( m_cstamp ) ) ;
+			if ( !m_page_token.empty() )
+			{
+				wr.VisitKey( "page_token" ) ;
+				wr.Visit( m_page_token ) ;
+			}
+			wr.VisitKey( "ignore_regexp" ) ;
+			wr.Visit( m_ign ) ;
+			wr.VisitKey( "shard_depth" ) ;
+			wr.Visit( static_cast<long long>( m_shard_depth ) ) ;
+			m_st.VisitFields( &wr ) ;
+			wr.EndObject() ;
+		}
+		Replace( fs, tmp, filename ) ;
+	}
+	catch ( ... )
+	{
+		JoinShards( split ) ;
+		throw ;
+	}
+	JoinShards( split ) ;
+
+	// remove the shards of deleted folders
+	if ( fs::exists( m_root / shard_dir ) )
+	{
+		for ( fs::directory_iterator i( m_root / shard_dir ) ; i != fs::directory_iterator() ; ++i )
+		{
+			if ( live.find( i->path().stem().string() ) == live.end() )
+				fs::remove( i->path() ) ;
+		}
+		if ( live.empty() )
+			fs::remove( m_root / shard_dir ) ;
+	}
+}
+
+/// Put the subtrees moved out by SplitShards() back, resources still point
+/// into them.
+void State::JoinShards( std::map<StateRecord*, StateRecord::Tree>& split )
+{
+	for ( std::map<StateRecord*, StateRecord::Tree>::iterator i = split.begin() ; i != split.end() ; ++i )
+	{
+		i->first->shard.clear() ;
+		i->first->Set( StateRecord::tree_field ) ;
+		i->first->tree.swap( i->second ) ;
+	}
 }
 
 void State::Sync( Syncer *syncer, const Val& options )
 {
-	// set the last sync time to the time on the client
-	m_res.Root()->Sync( syncer, &m_res, options ) ;
+	DeferUnsettled() ;
+
+	try
+	{
+		m_res.Root()->Sync( syncer, &m_res, options ) ;
+	}
+	catch ( ... )
+	{
+		// the jobs on the bulk lane refer to the resources
+		if ( syncer )
+			syncer->Agent()->WaitBulk() ;
+		throw ;
+	}
+
+	// the uploads and downloads may still be running on the bulk lane
+	if ( syncer )
+	{
+		syncer->Agent()->WaitBulk() ;
+
+		// the files with the same content as one of them copy it now
+		std::vector<Resource*> twins = m_res.TakeTwins() ;
+		for ( std::vector<Resource*>::iterator i = twins.begin() ; i != twins.end() ; ++i )
+			(*i)->SyncTwin( syncer, &m_res, options ) ;
+		syncer->Agent()->WaitBulk() ;
+	}
+}
+
+/// Report the local changes since the last sync after FromLocal(), without
+/// the remote file list. \a callback gets "new", "changed" or "deleted" and
+/// the resource, in tree order.
+void State::Status( const StatusCallback& callback )
+{
+	Status( m_res.Root(), callback ) ;
+}
+
+void State::Status( const Resource *folder, const StatusCallback& callback )
+{
+	for ( Resource::iterator i = folder->begin() ; i != folder->end() ; ++i )
+	{
+		const Resource *r = *i ;
+		if ( r->Kind() == "bad" )
+			continue ;
+
+		// folders are "changed" whenever their content is
+		if ( r->GetState() == Resource::local_new && !r->HasIndex() )
+			callback( "new", r ) ;
+		else if ( r->GetState() == Resource::local_new && !r->IsFolder() )
+			callback( "changed", r ) ;
+		else if ( r->GetState() == Resource::both_deleted && r->HasIndex() )
+			callback( "deleted", r ) ;
+
+		if ( r->IsFolder() )
+			Status( r, callback ) ;
+	}
+}
+
+/// Measure the resource tree, the state records and the unresolved entries
+/// and log the memory of each part at the end of \a phase.
+void State::SampleMemory( const std::string& phase )
+{
+	MemStats& stats = MemStats::Instance() ;
+	stats.Set( MemStats::resources, m_res.MemUsage(), m_res.Count() ) ;
+
+	std::size_t records = 1 ;
+	std::size_t bytes = m_st.MemUsage( &records ) ;
+	stats.Set( MemStats::state, bytes, records ) ;
+
+	// a list node has two links before the entry
+	bytes = 0 ;
+	for ( std::list<Entry>::const_iterator i = m_unresolved.begin() ; i != m_unresolved.end() ; ++i )
+		bytes += MemStats::Block( 2 * sizeof(void*) + sizeof(Entry) ) + i->MemUsage() ;
+	stats.Set( MemStats::unresolved, bytes, m_unresolved.size() ) ;
+
+	stats.Sample( phase ) ;
 }
 
 long State::ChangeStamp() const
@@ -428,4 +1086,17 @@ void State::ChangeStamp( long cstamp )
 	m_cstamp = cstamp ;
 }
 
+/// Where the changes of the APIs paged by token start, as of the last sync.
+/// Empty with the change stamps of v2.
+const std::string& State::PageToken() const
+{
+	return m_page_token ;
+}
+
+void State::PageToken( const std::string& token )
+{
+	Log( "page token is set to %1%", token, log::verbose ) ;
+	m_page_token = token ;
+}
+
 } // end of namespace gr
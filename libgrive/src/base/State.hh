@@ -20,12 +20,17 @@
 #pragma once
 
 #include "ResourceTree.hh"
+#include "StateRecord.hh"
 
 #include "util/DateTime.hh"
 #include "util/FileSystem.hh"
 #include "json/Val.hh"
 
+#include <map>
 #include <memory>
+#include <set>
+#include <vector>
+#include <boost/function.hpp>
 #include <boost/regex.hpp>
 
 namespace gr {
@@ -40,10 +45,15 @@ class State
 {
 public :
 	typedef ResourceTree::iterator iterator ;
+	typedef boost::function<void ( const std::string&, const Resource* )> StatusCallback ;
 
 public :
 	explicit State( const fs::path& root, const Val& options ) ;
+	State( State& whole, const std::string& partition, const Val& options ) ;
 	~State() ;
+
+	void Skip( const std::set<std::string>& parts ) ;
+	void PutBack( State& whole ) ;
 	
 	void FromLocal( const fs::path& p ) ;
 	void FromRemote( const Entry& e ) ;
@@ -54,33 +64,75 @@ public :
 
 	Resource* FindByHref( const std::string& href ) ;
 	Resource* FindByID( const std::string& id ) ;
+	StateRecord* Record( const fs::path& rel ) ;
 
 	void Sync( Syncer *syncer, const Val& options ) ;
+	void Status( const StatusCallback& callback ) ;
+	unsigned SettleTime( const std::string& path ) const ;
 	
 	iterator begin() ;
 	iterator end() ;
 	
 	long ChangeStamp() const ;
 	void ChangeStamp( long cstamp ) ;
+	const std::string& PageToken() const ;
+	void PageToken( const std::string& token ) ;
+
+	void SampleMemory( const std::string& phase ) ;
 
 private :
+	void Init( const Val& options ) ;
+	void Restrict( const std::string& part_ign ) ;
 	bool ParseIgnoreFile( const char* buffer, int size ) ;
-	void FromLocal( const fs::path& p, Resource *folder, Val& tree ) ;
+	void ReadSettle( const Val& options ) ;
+	void DeferUnsettled() ;
+	void FromLocal( const fs::path& p, Resource *folder, StateRecord::Tree& tree ) ;
+	void FromPaths( const fs::path& p, Resource *folder, StateRecord::Tree& tree ) ;
+	void FromRecord( Resource *folder, const std::string& name, StateRecord& rec ) ;
+	Resource* AddLocal( Resource *folder, const std::string& name, StateRecord& rec ) ;
+	Resource* AddRecord( Resource *folder, const std::string& name, StateRecord& rec ) ;
+	void AddDeleted( Resource *folder, const std::string& name, StateRecord& rec ) ;
+	void AddPath( const std::string& path ) ;
 	void FromChange( const Entry& e ) ;
 	bool Update( const Entry& e ) ;
 	std::size_t TryResolveEntry() ;
 
 	bool IsIgnore( const std::string& filename ) ;
+	void Status( const Resource *folder, const StatusCallback& callback ) ;
+
+	StateRecord::Tree& Subtree( StateRecord& rec ) ;
+	void LoadShards( StateRecord::Tree& tree ) ;
+	void SplitShards( StateRecord::Tree& tree, const fs::path& rel, int depth,
+		std::set<std::string>& live, std::map<StateRecord*, StateRecord::Tree>& split ) ;
+	void JoinShards( std::map<StateRecord*, StateRecord::Tree>& split ) ;
 	
 private :
 	fs::path			m_root ;
 	ResourceTree		m_res ;
 	int					m_cstamp ;
+	std::string			m_page_token ;
 	std::string			m_ign ;
 	boost::regex		m_ign_re ;
-	Val					m_st ;
+	StateRecord			m_st ;
 	bool				m_force ;
+	bool				m_hash ;
 	bool				m_ign_changed ;
+
+	// local changes younger than this many seconds are not synced yet, and
+	// the overrides for the paths matching each pattern
+	unsigned			m_settle ;
+	std::vector<std::pair<boost::regex, unsigned> >	m_settle_re ;
+
+	// only the paths given by "--paths-from" are looked at in FromLocal(),
+	// and the children to look at in each folder above them
+	bool				m_restrict ;
+	std::set<std::string>	m_paths ;
+	std::map<std::string, std::set<std::string> >	m_path_children ;
+
+	// subtrees below this depth are kept in separate files and loaded lazily
+	int					m_shard_depth ;
+	// checksums of the loaded shards, to skip rewriting unchanged ones
+	std::map<std::string, Digest>		m_shards ;
 	
 	std::list<Entry>	m_unresolved ;
 } ;
@@ -0,0 +1,289 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "StateRecord.hh"
+
+#include "util/Crypt.hh"
+#include "util/MemStats.hh"
+
+#include <cassert>
+
+namespace gr {
+
+StateRecord::StateRecord() :
+	fields		( 0 ),
+	ctime		( 0 ),
+	size		( 0 ),
+	srv_time	( 0 ),
+	fp			( 0 )
+{
+}
+
+bool StateRecord::Has( Field f ) const
+{
+	return ( fields & f ) != 0 ;
+}
+
+void StateRecord::Set( Field f )
+{
+	fields |= f ;
+}
+
+void StateRecord::Del( Field f )
+{
+	fields &= ~f ;
+	switch ( f )
+	{
+	case md5_field :
+		md5 = Digest() ;
+		break ;
+	case fp_field :
+		fp = 0 ;
+		break ;
+	case tree_field :
+		tree.clear() ;
+		break ;
+	default :
+		break ;
+	}
+}
+
+/// true if the record has children, loaded or not
+bool StateRecord::IsFolder() const
+{
+	return Has( tree_field ) || !shard.empty() ;
+}
+
+/// The heap taken by the record and the records below it, see MemStats.
+/// The number of records below it is added to \a records.
+std::size_t StateRecord::MemUsage( std::size_t *records ) const
+{
+	// a map node has three links and the color before the key and value
+	const std::size_t node = MemStats::Block( 32 + sizeof(Tree::value_type) ) ;
+
+	std::size_t bytes = MemStats::Heap( shard ) ;
+	for ( Tree::const_iterator i = tree.begin() ; i != tree.end() ; ++i )
+		bytes += node + MemStats::Heap( i->first ) + i->second.MemUsage( records ) ;
+	if ( records != 0 )
+		*records += tree.size() ;
+	return bytes ;
+}
+
+void StateRecord::Visit( ValVisitor *visitor ) const
+{
+	visitor->StartObject() ;
+	VisitFields( visitor ) ;
+	visitor->EndObject() ;
+}
+
+/// The fields without the braces, so that the state file can add its own
+/// top-level values to the root record. Written in the order of the keys,
+/// like a Val object.
+void StateRecord::VisitFields( ValVisitor *visitor ) const
+{
+	if ( Has( ctime_field ) )
+	{
+		visitor->VisitKey( "ctime" ) ;
+		visitor->Visit( static_cast<long long>( ctime ) ) ;
+	}
+	if ( Has( fp_field ) )
+	{
+		visitor->VisitKey( "fp" ) ;
+		visitor->Visit( crypt::Fingerprint::Hex( fp ) ) ;
+	}
+	if ( Has( md5_field ) )
+	{
+		visitor->VisitKey( "md5" ) ;
+		visitor->Visit( md5.Hex() ) ;
+	}
+	if ( !shard.empty() )
+	{
+		visitor->VisitKey( "shard" ) ;
+		visitor->Visit( shard ) ;
+	}
+	if ( Has( size_field ) )
+	{
+		visitor->VisitKey( "size" ) ;
+		visitor->Visit( static_cast<long long>( size ) ) ;
+	}
+	if ( Has( srv_time_field ) )
+	{
+		visitor->VisitKey( "srv_time" ) ;
+		visitor->Visit( static_cast<long long>( srv_time ) ) ;
+	}
+	if ( Has( tree_field ) )
+	{
+		visitor->VisitKey( "tree" ) ;
+		VisitTree( tree, visitor ) ;
+	}
+}
+
+void StateRecord::VisitTree( const Tree& tree, ValVisitor *visitor )
+{
+	visitor->StartObject() ;
+	for ( Tree::const_iterator i = tree.begin() ; i != tree.end() ; ++i )
+	{
+		visitor->VisitKey( i->first ) ;
+		i->second.Visit( visitor ) ;
+	}
+	visitor->EndObject() ;
+}
+
+/// Load a whole state file into \a root.
+StateLoader::StateLoader( StateRecord *root ) :
+	m_root	( root ),
+	m_tree	( 0 )
+{
+	assert( root != 0 ) ;
+}
+
+/// Load a shard file, i.e. only the "tree" of a folder, into \a tree.
+StateLoader::StateLoader( StateRecord::Tree *tree ) :
+	m_root	( 0 ),
+	m_tree	( tree )
+{
+	assert( tree != 0 ) ;
+}
+
+void StateLoader::Push( Kind kind, StateRecord *rec, StateRecord::Tree *tree )
+{
+	Level l = { kind, rec, tree } ;
+	m_ctx.push( l ) ;
+}
+
+/// true if the current value is a top-level one of a state file
+bool StateLoader::IsHeader() const
+{
+	return m_root != 0 && m_ctx.size() == 1 ;
+}
+
+void StateLoader::Visit( long long t )
+{
+	if ( m_ctx.empty() )
+		return ;
+
+	Level& l = m_ctx.top() ;
+	if ( l.kind == record && m_key == "ctime" )
+	{
+		l.rec->ctime = t ;
+		l.rec->Set( StateRecord::ctime_field ) ;
+	}
+	else if ( l.kind == record && m_key == "size" )
+	{
+		l.rec->size = t ;
+		l.rec->Set( StateRecord::size_field ) ;
+	}
+	else if ( l.kind == record && m_key == "srv_time" )
+	{
+		l.rec->srv_time = t ;
+		l.rec->Set( StateRecord::srv_time_field ) ;
+	}
+	else if ( IsHeader() )
+		m_header.Set( m_key, Val( t ) ) ;
+}
+
+void StateLoader::Visit( double t )
+{
+	if ( IsHeader() )
+		m_header.Set( m_key, Val( t ) ) ;
+}
+
+void StateLoader::Visit( const std::string& t )
+{
+	if ( m_ctx.empty() )
+		return ;
+
+	Level& l = m_ctx.top() ;
+	if ( l.kind == record && m_key == "md5" )
+	{
+		l.rec->md5 = Digest::FromHex( t ) ;
+		l.rec->Set( StateRecord::md5_field ) ;
+	}
+	else if ( l.kind == record && m_key == "fp" )
+	{
+		l.rec->fp = crypt::Fingerprint::FromHex( t ) ;
+		l.rec->Set( StateRecord::fp_field ) ;
+	}
+	else if ( l.kind == record && m_key == "shard" )
+		l.rec->shard = t ;
+	else if ( IsHeader() )
+		m_header.Set( m_key, Val( t ) ) ;
+}
+
+void StateLoader::Visit( bool t )
+{
+	if ( IsHeader() )
+		m_header.Set( m_key, Val( t ) ) ;
+}
+
+void StateLoader::VisitNull()
+{
+}
+
+void StateLoader::StartArray()
+{
+	// nothing in the state is an array
+	Push( skip, 0, 0 ) ;
+}
+
+void StateLoader::EndArray()
+{
+	m_ctx.pop() ;
+}
+
+void StateLoader::StartObject()
+{
+	if ( m_ctx.empty() )
+	{
+		if ( m_root != 0 )
+			Push( record, m_root, 0 ) ;
+		else
+			Push( tree, 0, m_tree ) ;
+		return ;
+	}
+
+	Level l = m_ctx.top() ;
+	if ( l.kind == tree )
+		Push( record, &(*l.tree)[m_key], 0 ) ;
+	else if ( l.kind == record && m_key == "tree" )
+	{
+		l.rec->Set( StateRecord::tree_field ) ;
+		Push( tree, 0, &l.rec->tree ) ;
+	}
+	// e.g. the folder summaries written by earlier versions, dropped
+	else
+		Push( skip, 0, 0 ) ;
+}
+
+void StateLoader::VisitKey( const std::string& t )
+{
+	m_key = t ;
+}
+
+void StateLoader::EndObject()
+{
+	m_ctx.pop() ;
+}
+
+const Val& StateLoader::Header() const
+{
+	return m_header ;
+}
+
+} // end of namespace
@@ -0,0 +1,118 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "json/Val.hh"
+#include "json/ValVisitor.hh"
+#include "util/Digest.hh"
+#include "util/Types.hh"
+
+#include <map>
+#include <stack>
+#include <string>
+
+namespace gr {
+
+/// The state of one file or folder as saved by the last sync. The fields
+/// are those of its object in .grive_state, only kept without a Val for
+/// each of them. The children of a folder are in "tree", unless they are in
+/// the shard file named by "shard" and have not been loaded yet.
+struct StateRecord
+{
+	typedef std::map<std::string, StateRecord> Tree ;
+
+	enum Field
+	{
+		ctime_field		= 1,
+		md5_field		= 2,
+		size_field		= 4,
+		srv_time_field	= 8,
+		tree_field		= 16,
+		fp_field		= 32
+	} ;
+
+	StateRecord() ;
+
+	bool Has( Field f ) const ;
+	void Set( Field f ) ;
+	void Del( Field f ) ;
+	bool IsFolder() const ;
+	std::size_t MemUsage( std::size_t *records = 0 ) const ;
+
+	void Visit( ValVisitor *visitor ) const ;
+	void VisitFields( ValVisitor *visitor ) const ;
+	static void VisitTree( const Tree& tree, ValVisitor *visitor ) ;
+
+	unsigned	fields ;
+	u64_t		ctime ;
+	u64_t		size ;
+	u64_t		srv_time ;
+	Digest		md5 ;
+	u64_t		fp ;		// see crypt::Fingerprint, only for local files
+	std::string	shard ;
+
+	Tree		tree ;
+} ;
+
+/// Builds StateRecords from the JSON parser, without a Val for every value.
+/// The top-level values which are not part of the root record, like
+/// "change_stamp", are collected in Header().
+class StateLoader : public ValVisitor
+{
+public :
+	explicit StateLoader( StateRecord *root ) ;
+	explicit StateLoader( StateRecord::Tree *tree ) ;
+
+	void Visit( long long t ) ;
+	void Visit( double t ) ;
+	void Visit( const std::string& t ) ;
+	void Visit( bool t ) ;
+	void VisitNull() ;
+
+	void StartArray() ;
+	void EndArray() ;
+	void StartObject() ;
+	void VisitKey( const std::string& t ) ;
+	void EndObject() ;
+
+	const Val& Header() const ;
+
+private :
+	enum Kind { record, tree, skip } ;
+
+	struct Level
+	{
+		Kind				kind ;
+		StateRecord			*rec ;
+		StateRecord::Tree	*tree ;
+	} ;
+
+	void Push( Kind kind, StateRecord *rec, StateRecord::Tree *tree ) ;
+	bool IsHeader() const ;
+
+private :
+	StateRecord			*m_root ;
+	StateRecord::Tree	*m_tree ;
+	std::stack<Level>	m_ctx ;
+	std::string			m_key ;
+	Val					m_header ;
+} ;
+
+} // end of namespace
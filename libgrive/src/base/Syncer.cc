@@ -20,12 +20,21 @@
 #include "Syncer.hh"
 #include "Resource.hh"
 #include "Entry.hh"
+#include "Feed.hh"
 #include "http/Agent.hh"
 #include "http/Header.hh"
 #include "http/Download.hh"
+#include "http/StringResponse.hh"
+#include "json/JsonWriter.hh"
+#include "json/Val.hh"
+#include "json/ValResponse.hh"
 #include "util/OS.hh"
 #include "util/log/Log.hh"
 
+#include <boost/bind.hpp>
+
+#include <cstdlib>
+
 namespace gr {
 
 Syncer::Syncer( http::Agent *http ):
@@ -38,10 +47,38 @@ http::Agent* Syncer::Agent() const
 	return m_http;
 }
 
+/// The changes from \a page_token on. The APIs with change stamps have no
+/// page tokens, and start from the change stamp in the token.
+std::unique_ptr<Feed> Syncer::GetChangesFrom( const std::string& page_token )
+{
+	return GetChanges( std::atol( page_token.c_str() ) );
+}
+
+/// The token of the changes from now on, for the APIs which page their
+/// changes by token. Empty for the ones with change stamps.
+std::string Syncer::GetPageToken()
+{
+	return std::string();
+}
+
+namespace
+{
+	void Fetch( http::Agent *http, const std::string& url, u64_t size, http::Download *dl, long *r )
+	{
+		*r = http->Get( url, dl, http::Header(), size ) ;
+		dl->Flush() ;
+	}
+}
+
 void Syncer::Download( Resource *res, const fs::path& file )
 {
+	// the other transfers go on while this one waits for the network and
+	// for its writes to reach the file
 	http::Download dl( file.string(), http::Download::NoChecksum() ) ;
-	long r = m_http->Get( res->ContentSrc(), &dl, http::Header(), res->Size() ) ;
+	long r = 0 ;
+	m_http->Apart( boost::bind( &Fetch, m_http, res->ContentSrc(), res->Size(), &dl, &r ) ) ;
+	res->m_has_fp = r <= 400 ;
+	res->m_fp = dl.FinishFingerprint() ;
 	if ( r <= 400 )
 	{
 		if ( res->ServerTime() != DateTime() )
@@ -56,4 +93,42 @@ void Syncer::AssignIDs( Resource *res, const Entry& remote )
 	res->AssignIDs( remote );
 }
 
+/// Ask for the changes to be posted to \a address until the channel expires,
+/// which is the latest Google Drive allows, usually in a week.
+Channel Syncer::OpenChannel( const std::string& url, const std::string& id,
+	const std::string& token, const std::string& address )
+{
+	Val meta ;
+	meta.Add( "id", Val( id ) ) ;
+	meta.Add( "type", Val( std::string( "web_hook" ) ) ) ;
+	meta.Add( "address", Val( address ) ) ;
+	meta.Add( "token", Val( token ) ) ;
+
+	http::Header hdr ;
+	hdr.Add( "Content-Type: application/json" ) ;
+	http::ValResponse vrsp ;
+	m_http->Post( url, WriteJson( meta ), &vrsp, hdr ) ;
+	Val valr = vrsp.Response() ;
+
+	Channel channel ;
+	channel.id			= id ;
+	channel.resource_id	= valr["resourceId"].Str() ;
+	channel.token		= token ;
+	// in milliseconds
+	channel.expiration	= std::strtoll( valr["expiration"].Str().c_str(), 0, 10 ) / 1000 ;
+	return channel ;
+}
+
+void Syncer::CloseChannel( const std::string& url, const Channel& channel )
+{
+	Val meta ;
+	meta.Add( "id", Val( channel.id ) ) ;
+	meta.Add( "resourceId", Val( channel.resource_id ) ) ;
+
+	http::Header hdr ;
+	hdr.Add( "Content-Type: application/json" ) ;
+	http::StringResponse str ;
+	m_http->Post( url, WriteJson( meta ), &str, hdr ) ;
+}
+
 } // end of namespace gr
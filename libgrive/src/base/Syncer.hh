@@ -21,6 +21,7 @@
 
 #include "util/FileSystem.hh"
 
+#include <ctime>
 #include <string>
 #include <vector>
 #include <iosfwd>
@@ -40,6 +41,18 @@ class Entry ;
 
 class Feed ;
 
+/// a channel which pushes a notification to an address on every change
+struct Channel
+{
+	Channel() : expiration( 0 ) {}
+
+	std::string		id ;
+	std::string		resource_id ;
+	// sent back with the notifications, to tell them from forged ones
+	std::string		token ;
+	std::time_t		expiration ;
+} ;
+
 /*!	\brief	A Syncer incapsulates all resource-related upload/download/edit methods */
 class Syncer
 {
@@ -53,18 +66,28 @@ public :
 	virtual void Download( Resource *res, const fs::path& file );
 	virtual bool EditContent( Resource *res, bool new_rev ) = 0;
 	virtual bool Create( Resource *res ) = 0;
+	virtual bool Copy( Resource *from, Resource *to ) = 0;
 	virtual bool Move( Resource* res, Resource* newParent, std::string newFilename ) = 0;
 
 	virtual std::unique_ptr<Feed> GetFolders() = 0;
 	virtual std::unique_ptr<Feed> GetAll() = 0;
+	virtual std::unique_ptr<Feed> GetChildren( const std::string& parent_id ) = 0;
 	virtual std::unique_ptr<Feed> GetChanges( long min_cstamp ) = 0;
 	virtual long GetChangeStamp( long min_cstamp ) = 0;
+	virtual std::unique_ptr<Feed> GetChangesFrom( const std::string& page_token );
+	virtual std::string GetPageToken();
+
+	virtual Channel Watch( const std::string& id, const std::string& token, const std::string& address ) = 0;
+	virtual void StopWatch( const Channel& channel ) = 0;
 
 protected:
 
 	http::Agent *m_http;
 
 	void AssignIDs( Resource *res, const Entry& remote );
+	Channel OpenChannel( const std::string& url, const std::string& id,
+		const std::string& token, const std::string& address );
+	void CloseChannel( const std::string& url, const Channel& channel );
 
 } ;
 
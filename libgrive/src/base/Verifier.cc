@@ -0,0 +1,171 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Verifier.hh"
+
+#include "Resource.hh"
+
+#include "util/Crypt.hh"
+#include "util/File.hh"
+#include "util/log/Log.hh"
+
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace gr {
+
+namespace
+{
+	const std::size_t read_size = 1 << 20 ;
+}
+
+/// \param	journal	file listing the files checked by an earlier, interrupted run
+/// \param	rate	bytes read per second by all threads, 0 for no limit
+Verifier::Verifier( const fs::path& journal, unsigned threads, u64_t rate ) :
+	m_journal	( journal ),
+	m_threads	( threads > 0 ? threads : 1 ),
+	m_running	( 0 ),
+	m_stop		( false ),
+	m_rate		( rate ),
+	m_read		( 0 )
+{
+	std::ifstream in( m_journal.string().c_str() ) ;
+	std::string line ;
+	while ( std::getline( in, line ) )
+		m_done.insert( line ) ;
+
+	if ( !m_done.empty() )
+		Log( "continuing verification, %1% files already checked", m_done.size(), log::info ) ;
+}
+
+/// Queue a file for checking.
+/// \return	false if the file was checked by an earlier run
+bool Verifier::Add( Resource *res )
+{
+	if ( m_done.count( res->RelPath().string() ) > 0 )
+		return false ;
+
+	// the paths are built here, the workers must not touch the tree
+	m_todo.Push( Job( res, res->Path() ) ) ;
+	return true ;
+}
+
+void Verifier::Run( const Callback& callback )
+{
+	m_todo.Close() ;
+	m_start = std::chrono::steady_clock::now() ;
+
+	std::ofstream journal( m_journal.string().c_str(), std::ios::app ) ;
+
+	m_running = m_threads ;
+	std::vector<std::thread> threads ;
+	for ( unsigned i = 0 ; i < m_threads ; i++ )
+		threads.push_back( std::thread( &Verifier::Worker, this ) ) ;
+
+	std::exception_ptr error ;
+	Result r ;
+	while ( m_out.Pop( r ) )
+	{
+		if ( error )
+			continue ;
+		try
+		{
+			callback( r.first, r.second ) ;
+			journal << r.first->RelPath().string() << std::endl ;
+		}
+		catch ( ... )
+		{
+			// let the threads finish what they are reading, then stop
+			error = std::current_exception() ;
+			std::lock_guard<std::mutex> lock( m_mutex ) ;
+			m_stop = true ;
+		}
+	}
+
+	for ( std::size_t i = 0 ; i < threads.size() ; i++ )
+		threads[i].join() ;
+
+	if ( error )
+		std::rethrow_exception( error ) ;
+
+	journal.close() ;
+	fs::remove( m_journal ) ;
+}
+
+void Verifier::Worker()
+{
+	Job job ;
+	while ( m_todo.Pop( job ) )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_mutex ) ;
+			if ( m_stop )
+				break ;
+		}
+
+		Digest md5 ;
+		try
+		{
+			md5 = Hash( job.second ) ;
+		}
+		catch ( Exception& )
+		{
+			// reported as unreadable
+		}
+		m_out.Push( Result( job.first, md5 ) ) ;
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	if ( --m_running == 0 )
+		m_out.Close() ;
+}
+
+Digest Verifier::Hash( const fs::path& path )
+{
+	File file( path ) ;
+	crypt::MD5 md5 ;
+
+	std::vector<char> buf( read_size ) ;
+	std::size_t count ;
+	while ( ( count = file.Read( &buf[0], buf.size() ) ) > 0 )
+	{
+		md5.Write( &buf[0], count ) ;
+		Throttle( count ) ;
+	}
+	return md5.Get() ;
+}
+
+/// Sleep until reading \a bytes more keeps all threads within the rate.
+void Verifier::Throttle( std::size_t bytes )
+{
+	if ( m_rate == 0 )
+		return ;
+
+	std::chrono::steady_clock::time_point due ;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex ) ;
+		m_read += bytes ;
+		due = m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>( static_cast<double>( m_read ) / m_rate ) ) ;
+	}
+	std::this_thread::sleep_until( due ) ;
+}
+
+} // end of namespace gr
@@ -0,0 +1,84 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "util/Digest.hh"
+#include "util/FileSystem.hh"
+#include "util/SyncQueue.hh"
+#include "util/Types.hh"
+
+#include <boost/function.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace gr {
+
+class Resource ;
+
+/*!	\brief	hashes local files in parallel for --verify
+
+	The files are read by a few threads at a bounded rate, and the
+	checksums are handed to the callback in the calling thread. Checked files
+	are appended to a journal, so that an interrupted run continues where it
+	stopped. The journal is removed when all files are checked.
+*/
+class Verifier
+{
+public :
+	/// the resource and its local MD5, empty if it can't be read
+	typedef boost::function<void ( Resource*, const Digest& )> Callback ;
+
+public :
+	Verifier( const fs::path& journal, unsigned threads, u64_t rate ) ;
+
+	bool Add( Resource *res ) ;
+	void Run( const Callback& callback ) ;
+
+private :
+	typedef std::pair<Resource*, fs::path> Job ;
+	typedef std::pair<Resource*, Digest> Result ;
+
+	void Worker() ;
+	Digest Hash( const fs::path& path ) ;
+	void Throttle( std::size_t bytes ) ;
+
+private :
+	fs::path				m_journal ;
+	unsigned				m_threads ;
+	std::set<std::string>	m_done ;
+
+	SyncQueue<Job>			m_todo ;
+	SyncQueue<Result>		m_out ;
+	std::mutex				m_mutex ;
+	unsigned				m_running ;
+	bool					m_stop ;
+
+	// bytes per second for all threads together, 0 for no limit
+	u64_t									m_rate ;
+	u64_t									m_read ;
+	std::chrono::steady_clock::time_point	m_start ;
+} ;
+
+} // end of namespace gr
@@ -28,8 +28,10 @@
 
 namespace gr {
 
+/// Only the addresses are saved. The symbols are loaded when the backtrace
+/// is printed, which most exceptions never are.
 Backtrace::Backtrace( std::size_t skip ) :
-	m_count( SymbolInfo::Instance()->Backtrace(m_stack, Count(m_stack) )),
+	m_count( SymbolInfo::Backtrace(m_stack, Count(m_stack) )),
 	m_skip( std::min( skip, m_count ) )
 {
 }
@@ -49,7 +49,8 @@ public :
     */
 	static SymbolInfo* Instance( ) ;
 
-	std::size_t Backtrace( addr_t *stack, std::size_t count ) ;
+	// only the raw addresses, doesn't need the symbols to be loaded
+	static std::size_t Backtrace( addr_t *stack, std::size_t count ) ;
 	void PrintTrace( addr_t addr, std::ostream& os, std::size_t idx = 0 ) ;
 	
 private :
@@ -29,6 +29,7 @@ namespace feeds
 {
 	const std::string files		= "https://www.googleapis.com/drive/v2/files" ;
 	const std::string changes	= "https://www.googleapis.com/drive/v2/changes" ;
+	const std::string channels	= "https://www.googleapis.com/drive/v2/channels" ;
 }
 
 namespace mime_types
@@ -56,8 +56,8 @@ void Entry2::Update( const Val& item )
 	{
 		m_title			= file["title"] ;
 		m_etag			= file["etag"] ;
-		Val fn;
-		m_filename		= file.Get( "title", fn ) ? fn.Str() : std::string();
+		m_filename.clear() ;
+		file.TryGet( "title", m_filename ) ;
 		m_self_href		= file["selfLink"] ;
 		m_mtime			= DateTime( file["modifiedDate"] ) ;
 
@@ -75,18 +75,16 @@ void Entry2::Update( const Val& item )
 			}
 			else
 			{
-				m_md5			= file["md5Checksum"] ;
+				m_md5			= Digest::FromHex( file["md5Checksum"].Str() ) ;
 				m_size			= file["fileSize"].U64() ;
 				m_content_src	= file["downloadUrl"] ;
-				// convert to lower case for easy comparison
-				std::transform( m_md5.begin(), m_md5.end(), m_md5.begin(), tolower ) ;
 			}
 		}
 
 		m_parent_hrefs.clear( ) ;
 
-		Val::Array parents = file["parents"].AsArray() ;
-		for ( Val::Array::iterator i = parents.begin() ; i != parents.end() ; ++i )
+		const Val::Array& parents = file["parents"].AsArray() ;
+		for ( Val::Array::const_iterator i = parents.begin() ; i != parents.end() ; ++i )
 		{
 			m_parent_hrefs.push_back( (*i)["isRoot"].Bool() ? std::string( "root" ) : (*i)["parentLink"] ) ;
 		}
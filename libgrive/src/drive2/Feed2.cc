@@ -25,6 +25,7 @@
 #include "http/Header.hh"
 #include "json/Val.hh"
 #include "json/ValResponse.hh"
+#include "util/MemStats.hh"
 
 #include <iostream>
 #include <boost/format.hpp>
@@ -48,6 +49,7 @@ bool Feed2::GetNext( http::Agent *http )
 	http::ValResponse out ;
 	http->Get( m_next, &out, http::Header(), 0 ) ;
 	Val m_content = out.Response() ;
+	MemStats::Hold page( MemStats::feed, m_content.MemUsage() ) ;
 	
 	Val::Array items = m_content["items"].AsArray() ;
 	m_entries.clear() ;
@@ -133,6 +133,41 @@ bool Syncer2::Move( Resource* res, Resource* newParentRes, std::string newFilena
 	return true;
 }
 
+/// Create \a to on the server as a copy of \a from, which has the same content,
+/// so that the file body does not have to be uploaded again.
+bool Syncer2::Copy( Resource *from, Resource *to )
+{
+	assert( to->Parent() ) ;
+	assert( to->ResourceID().empty() ) ;
+
+	if ( from->ResourceID().empty() || !to->Parent()->IsEditable() )
+		return false ;
+
+	Val meta;
+	meta.Add( "title", Val( to->Name() ) );
+
+	// without parents, the copy would go to the folder of the source
+	Val parent;
+	parent.Add( "id", Val( to->Parent()->IsRoot() ? std::string( "root" ) : to->Parent()->ResourceID() ) );
+	Val parents( Val::array_type );
+	parents.Add( parent );
+	meta.Add( "parents", parents );
+
+	http::Header hdr ;
+	hdr.Add( "Content-Type: application/json" );
+	http::ValResponse vrsp ;
+	m_http->Post( feeds::files + "/" + from->ResourceID() + "/copy", WriteJson( meta ), &vrsp, hdr ) ;
+	Val valr = vrsp.Response() ;
+	if ( !valr.Has( "id" ) )
+		return false ;
+
+	Entry2 responseEntry = Entry2( valr ) ;
+	AssignIDs( to, responseEntry ) ;
+	to->SetServerTime( responseEntry.MTime() );
+
+	return true;
+}
+
 std::string to_string( uint64_t n )
 {
 	std::ostringstream s;
@@ -221,6 +256,11 @@ std::unique_ptr<Feed> Syncer2::GetAll()
 	return std::unique_ptr<Feed>( new Feed2( feeds::files + "?maxResults=999999999&q=trashed%3dfalse" ) );
 }
 
+std::unique_ptr<Feed> Syncer2::GetChildren( const std::string& parent_id )
+{
+	return std::unique_ptr<Feed>( new Feed2( feeds::files + "?maxResults=1000&q=trashed%3dfalse+and+%27" + parent_id + "%27+in+parents" ) );
+}
+
 std::string ChangesFeed( long changestamp, int maxResults = 1000 )
 {
 	boost::format feed( feeds::changes + "?maxResults=%1%&includeSubscribed=false" + ( changestamp > 0 ? "&startChangeId=%2%" : "" ) ) ;
@@ -240,4 +280,14 @@ long Syncer2::GetChangeStamp( long min_cstamp )
 	return std::atoi( res.Response()["largestChangeId"].Str().c_str() );
 }
 
+Channel Syncer2::Watch( const std::string& id, const std::string& token, const std::string& address )
+{
+	return OpenChannel( feeds::changes + "/watch?includeSubscribed=false", id, token, address ) ;
+}
+
+void Syncer2::StopWatch( const Channel& channel )
+{
+	CloseChannel( feeds::channels + "/stop", channel ) ;
+}
+
 } } // end of namespace gr::v1
@@ -38,11 +38,15 @@ public :
 	bool EditContent( Resource *res, bool new_rev );
 	bool Create( Resource *res );
 	bool Move( Resource* res, Resource* newParent, std::string newFilename );
+	bool Copy( Resource *from, Resource *to );
 
 	std::unique_ptr<Feed> GetFolders();
 	std::unique_ptr<Feed> GetAll();
+	std::unique_ptr<Feed> GetChildren( const std::string& parent_id );
 	std::unique_ptr<Feed> GetChanges( long min_cstamp );
 	long GetChangeStamp( long min_cstamp );
+	Channel Watch( const std::string& id, const std::string& token, const std::string& address );
+	void StopWatch( const Channel& channel );
 
 private :
 
@@ -0,0 +1,52 @@
+/*
+	Common URIs for the Drive API v3
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <string>
+
+namespace gr { namespace v3 {
+
+const std::string upload_base = "https://www.googleapis.com/upload/drive/v3/files" ;
+
+namespace feeds
+{
+	const std::string files		= "https://www.googleapis.com/drive/v3/files" ;
+	const std::string changes	= "https://www.googleapis.com/drive/v3/changes" ;
+	const std::string channels	= "https://www.googleapis.com/drive/v3/channels" ;
+}
+
+namespace fields
+{
+	// only the file attributes grive uses are requested
+	const std::string file		= "id,name,mimeType,md5Checksum,size,modifiedTime,parents,trashed,version,capabilities/canEdit" ;
+	const std::string files		= "nextPageToken,files(" + file + ")" ;
+	const std::string changes	= "nextPageToken,newStartPageToken,changes(fileId,removed,file(" + file + "))" ;
+}
+
+namespace mime_types
+{
+	const std::string folder	= "application/vnd.google-apps.folder" ;
+}
+
+/// Resources are identified by v2-style hrefs in the ResourceTree, so that
+/// the two backends can be used on the same working copy.
+std::string SelfHref( const std::string& id ) ;
+
+} } // end of namespace gr::v3
@@ -0,0 +1,93 @@
+/*
+	Drive API v3 item class implementation
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Entry3.hh"
+#include "CommonUri.hh"
+
+#include "drive2/CommonUri.hh"
+#include "json/Val.hh"
+
+#include <algorithm>
+
+namespace gr { namespace v3 {
+
+std::string SelfHref( const std::string& id )
+{
+	return v2::feeds::files + "/" + id ;
+}
+
+/// construct an entry for remote, from "file" or "change" JSON object - Drive API v3.
+/// \a root_id is the ID of "My Drive", which is mapped to the "root" href.
+Entry3::Entry3( const Val& item, const std::string& root_id )
+{
+	Update( item, root_id ) ;
+}
+
+void Entry3::Update( const Val& item, const std::string& root_id )
+{
+	// the "kind" is not in the fields asked for, only the changes have a "fileId"
+	bool is_chg = item.Has( "fileId" ) ;
+
+	// v3 changes have no ID of their own, they are paged by token
+	m_change_stamp	= is_chg ? 0 : -1 ;
+	m_is_removed	= is_chg && item["removed"].Bool() ;
+	m_size			= 0 ;
+
+	if ( m_is_removed )
+	{
+		m_resource_id = item["fileId"];
+		return ;
+	}
+
+	const Val& file = is_chg ? item["file"] : item;
+
+	m_title			= file["name"] ;
+	m_filename		= m_title ;
+	m_etag			= file.Has( "version" ) ? file["version"].Str() : std::string() ;
+	m_resource_id	= file["id"] ;
+	m_self_href		= v3::SelfHref( m_resource_id ) ;
+	m_mtime			= DateTime( file["modifiedTime"] ) ;
+	m_is_dir		= file["mimeType"].Str() == mime_types::folder ;
+	m_is_editable	= file.Has( "capabilities" ) && file["capabilities"]["canEdit"].Bool() ;
+	m_is_removed	= file.Has( "trashed" ) && file["trashed"].Bool() ;
+	if ( !m_is_dir )
+	{
+		if ( !file.Has( "md5Checksum" ) )
+		{
+			// google docs have no content to download
+			m_is_removed = true;
+		}
+		else
+		{
+			m_md5			= Digest::FromHex( file["md5Checksum"].Str() ) ;
+			m_size			= file["size"].U64() ;
+			m_content_src	= feeds::files + "/" + m_resource_id + "?alt=media" ;
+		}
+	}
+
+	m_parent_hrefs.clear( ) ;
+	if ( file.Has( "parents" ) )
+	{
+		const Val::Array& parents = file["parents"].AsArray() ;
+		for ( Val::Array::const_iterator i = parents.begin() ; i != parents.end() ; ++i )
+			m_parent_hrefs.push_back( i->Str() == root_id ? std::string( "root" ) : v3::SelfHref( i->Str() ) ) ;
+	}
+}
+
+} } // end of namespace gr::v3
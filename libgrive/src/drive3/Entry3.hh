@@ -0,0 +1,40 @@
+/*
+	Drive API v3 item class implementation
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "base/Entry.hh"
+
+#include <string>
+
+namespace gr {
+
+class Val ;
+
+namespace v3 {
+
+class Entry3: public Entry
+{
+public :
+	Entry3( const Val& item, const std::string& root_id ) ;
+private :
+	void Update( const Val& item, const std::string& root_id ) ;
+} ;
+
+} } // end of namespace gr::v3
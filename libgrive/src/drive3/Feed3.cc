@@ -0,0 +1,66 @@
+/*
+	Drive API v3 item list ("Feed") implementation
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Feed3.hh"
+#include "Entry3.hh"
+
+#include "http/Agent.hh"
+#include "http/Header.hh"
+#include "json/Val.hh"
+#include "json/ValResponse.hh"
+#include "util/MemStats.hh"
+
+namespace gr { namespace v3 {
+
+/// \param	url			the list URL without a page token
+/// \param	page_token	page to start from, required for the changes list
+Feed3::Feed3( const std::string& url, const std::string& root_id, const std::string& page_token ):
+	Feed( page_token.empty() ? url : url + "&pageToken=" + page_token ),
+	m_base( url ),
+	m_root_id( root_id )
+{
+}
+
+Feed3::~Feed3()
+{
+}
+
+bool Feed3::GetNext( http::Agent *http )
+{
+	if ( m_next.empty() )
+		return false ;
+
+	http::ValResponse out ;
+	http->Get( m_next, &out, http::Header(), 0 ) ;
+	Val content = out.Response() ;
+	MemStats::Hold page( MemStats::feed, content.MemUsage() ) ;
+
+	m_entries.clear() ;
+	const Val::Array& items = content[ content.Has( "changes" ) ? "changes" : "files" ].AsArray() ;
+	for ( Val::Array::const_iterator i = items.begin() ; i != items.end() ; ++i )
+		m_entries.push_back( Entry3( *i, m_root_id ) );
+
+	Val token ;
+	m_next = content.Get( "nextPageToken", token ) ? m_base + "&pageToken=" + token.Str() : std::string() ;
+	if ( content.Get( "newStartPageToken", token ) )
+		m_next_changes = token.Str() ;
+	return true ;
+}
+
+} } // end of namespace gr::v3
@@ -0,0 +1,40 @@
+/*
+	Drive API v3 item list ("Feed") implementation
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "base/Feed.hh"
+
+#include <string>
+
+namespace gr { namespace v3 {
+
+class Feed3: public Feed
+{
+public :
+	Feed3( const std::string& url, const std::string& root_id, const std::string& page_token = "" ) ;
+	~Feed3() ;
+	bool GetNext( http::Agent *http ) ;
+
+private :
+	std::string		m_base ;
+	std::string		m_root_id ;
+} ;
+
+} } // end of namespace gr::v3
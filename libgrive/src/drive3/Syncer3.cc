@@ -0,0 +1,307 @@
+/*
+	Drive API v3 Syncer implementation
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "base/Resource.hh"
+#include "CommonUri.hh"
+#include "Entry3.hh"
+#include "Feed3.hh"
+#include "Syncer3.hh"
+
+#include "http/Agent.hh"
+#include "http/Header.hh"
+#include "json/ValResponse.hh"
+#include "json/JsonWriter.hh"
+
+#include "util/File.hh"
+#include "util/log/Log.hh"
+#include "util/StringStream.hh"
+#include "util/ConcatStream.hh"
+
+#include <cassert>
+#include <cstdlib>
+#include <sstream>
+
+namespace gr { namespace v3 {
+
+Syncer3::Syncer3( http::Agent *http ):
+	Syncer( http )
+{
+	assert( http != 0 ) ;
+}
+
+/// ID of "My Drive". v3 lists it like any other parent, while the
+/// ResourceTree expects the "root" href.
+std::string Syncer3::RootID()
+{
+	if ( m_root_id.empty() )
+	{
+		http::ValResponse res ;
+		m_http->Get( feeds::files + "/root?fields=id", &res, http::Header(), 0 ) ;
+		m_root_id = res.Response()["id"].Str() ;
+	}
+	return m_root_id ;
+}
+
+std::string Syncer3::ParentID( Resource *res )
+{
+	return res->Parent()->IsRoot() ? std::string( "root" ) : res->Parent()->ResourceID() ;
+}
+
+void Syncer3::Patch( const std::string& url, const Val& meta, Val *result )
+{
+	StringStream body( WriteJson( meta ) ) ;
+	http::Header hdr ;
+	hdr.Add( "Content-Type: application/json" ) ;
+	http::ValResponse vrsp ;
+	m_http->Request( "PATCH", url, &body, &vrsp, hdr ) ;
+	if ( result )
+		*result = vrsp.Response() ;
+}
+
+void Syncer3::DeleteRemote( Resource *res )
+{
+	Val meta ;
+	meta.Add( "trashed", Val( true ) ) ;
+	Patch( feeds::files + "/" + res->ResourceID() + "?fields=id", meta, NULL ) ;
+}
+
+bool Syncer3::EditContent( Resource *res, bool new_rev )
+{
+	assert( res->Parent() ) ;
+	assert( !res->ResourceID().empty() ) ;
+	assert( res->Parent()->GetState() == Resource::sync ) ;
+
+	if ( !res->IsEditable() )
+	{
+		Log( "Cannot upload %1%: file read-only. %2%", res->Name(), res->StateStr(), log::warning ) ;
+		return false ;
+	}
+
+	// v3 always adds a revision, the head one is just not kept forever
+	return Upload( res ) ;
+}
+
+bool Syncer3::Create( Resource *res )
+{
+	assert( res->Parent() ) ;
+	assert( res->Parent()->IsFolder() ) ;
+	assert( res->Parent()->GetState() == Resource::sync ) ;
+	assert( res->ResourceID().empty() ) ;
+
+	if ( !res->Parent()->IsEditable() )
+	{
+		Log( "Cannot upload %1%: parent directory read-only. %2%", res->Name(), res->StateStr(), log::warning ) ;
+		return false ;
+	}
+
+	return Upload( res ) ;
+}
+
+bool Syncer3::Copy( Resource *from, Resource *to )
+{
+	assert( to->Parent() ) ;
+	assert( to->ResourceID().empty() ) ;
+
+	if ( from->ResourceID().empty() || !to->Parent()->IsEditable() )
+		return false ;
+
+	Val meta ;
+	meta.Add( "name", Val( to->Name() ) ) ;
+	Val parents( Val::array_type ) ;
+	parents.Add( Val( ParentID( to ) ) ) ;
+	meta.Add( "parents", parents ) ;
+
+	http::Header hdr ;
+	hdr.Add( "Content-Type: application/json" ) ;
+	http::ValResponse vrsp ;
+	m_http->Post( feeds::files + "/" + from->ResourceID() + "/copy?fields=" + fields::file, WriteJson( meta ), &vrsp, hdr ) ;
+	Val valr = vrsp.Response() ;
+	if ( !valr.Has( "id" ) )
+		return false ;
+
+	Entry3 responseEntry( valr, RootID() ) ;
+	AssignIDs( to, responseEntry ) ;
+	to->SetServerTime( responseEntry.MTime() ) ;
+
+	return true ;
+}
+
+bool Syncer3::Move( Resource* res, Resource* newParentRes, std::string newFilename )
+{
+	if ( res->ResourceID().empty() )
+	{
+		Log("Can't rename file %1%, no server id found", res->Name());
+		return false;
+	}
+
+	Val meta ;
+	meta.Add( "name", Val( newFilename ) ) ;
+
+	// parents are not part of the metadata in v3, they are moved with parameters
+	std::string parents =
+		"&removeParents=" + ParentID( res ) +
+		"&addParents=" + ( newParentRes->IsRoot() ? std::string( "root" ) : newParentRes->ResourceID() ) ;
+
+	Val valr ;
+	Patch( feeds::files + "/" + res->ResourceID() + "?fields=id" + parents, meta, &valr ) ;
+	assert( valr.Has( "id" ) ) ;
+
+	return true ;
+}
+
+std::string to_string( uint64_t n )
+{
+	std::ostringstream s;
+	s << n;
+	return s.str();
+}
+
+bool Syncer3::Upload( Resource *res )
+{
+	Val meta ;
+	meta.Add( "name", Val( res->Name() ) ) ;
+	if ( res->IsFolder() )
+		meta.Add( "mimeType", Val( mime_types::folder ) ) ;
+	if ( res->ResourceID().empty() )
+	{
+		// parents can only be set on creation
+		Val parents( Val::array_type ) ;
+		parents.Add( Val( ParentID( res ) ) ) ;
+		meta.Add( "parents", parents ) ;
+	}
+	std::string json_meta = WriteJson( meta ) ;
+
+	Val valr ;
+
+	if ( res->IsFolder() )
+	{
+		// Only issue metadata update request
+		if ( res->ResourceID().empty() )
+		{
+			http::Header hdr ;
+			hdr.Add( "Content-Type: application/json" ) ;
+			http::ValResponse vrsp ;
+			m_http->Post( feeds::files + "?fields=" + fields::file, json_meta, &vrsp, hdr ) ;
+			valr = vrsp.Response() ;
+		}
+		else
+			Patch( feeds::files + "/" + res->ResourceID() + "?fields=" + fields::file, meta, &valr ) ;
+		assert( valr.Has( "id" ) ) ;
+	}
+	else
+	{
+		File file( res->Path() ) ;
+		uint64_t size = file.Size() ;
+		ConcatStream multipart ;
+		StringStream p1(
+			"--file_contents\r\nContent-Type: application/json; charset=utf-8\r\n\r\n" + json_meta +
+			"\r\n--file_contents\r\nContent-Type: application/octet-stream\r\nContent-Length: " + to_string( size ) +
+			"\r\n\r\n"
+		);
+		StringStream p2("\r\n--file_contents--\r\n");
+		multipart.Append( &p1 );
+		multipart.Append( &file );
+		multipart.Append( &p2 );
+
+		http::Header hdr ;
+		hdr.Add( "Content-Type: multipart/related; boundary=\"file_contents\"" );
+		hdr.Add( "Content-Length: " + to_string( multipart.Size() ) );
+
+		http::ValResponse vrsp;
+		m_http->Request(
+			res->ResourceID().empty() ? "POST" : "PATCH",
+			upload_base + ( res->ResourceID().empty() ? "" : "/" + res->ResourceID() ) +
+			"?uploadType=multipart&fields=" + fields::file,
+			&multipart, &vrsp, hdr
+		) ;
+		valr = vrsp.Response() ;
+		assert( valr.Has( "id" ) );
+	}
+
+	Entry3 responseEntry( valr, RootID() ) ;
+	AssignIDs( res, responseEntry ) ;
+	res->SetServerTime( responseEntry.MTime() );
+
+	return true ;
+}
+
+std::unique_ptr<Feed> Syncer3::GetFolders()
+{
+	return std::unique_ptr<Feed>( new Feed3(
+		feeds::files + "?pageSize=1000&fields=" + fields::files +
+		"&q=trashed%3dfalse+and+mimeType%3d%27" + mime_types::folder + "%27",
+		RootID() ) );
+}
+
+std::unique_ptr<Feed> Syncer3::GetAll()
+{
+	return std::unique_ptr<Feed>( new Feed3(
+		feeds::files + "?pageSize=1000&fields=" + fields::files + "&q=trashed%3dfalse",
+		RootID() ) );
+}
+
+std::unique_ptr<Feed> Syncer3::GetChildren( const std::string& parent_id )
+{
+	return std::unique_ptr<Feed>( new Feed3(
+		feeds::files + "?pageSize=1000&fields=" + fields::files +
+		"&q=trashed%3dfalse+and+%27" + parent_id + "%27+in+parents",
+		RootID() ) );
+}
+
+/// v3 has no change stamps: the changes from now on are listed.
+std::unique_ptr<Feed> Syncer3::GetChanges( long )
+{
+	return GetChangesFrom( GetPageToken() );
+}
+
+/// v3 has no change stamps, the state keeps a page token instead.
+long Syncer3::GetChangeStamp( long )
+{
+	return -1 ;
+}
+
+/// Changes are paged by token in v3. The tokens are opaque, the last page
+/// gives the one to start from next time.
+std::unique_ptr<Feed> Syncer3::GetChangesFrom( const std::string& page_token )
+{
+	return std::unique_ptr<Feed>( new Feed3(
+		feeds::changes + "?pageSize=1000&includeRemoved=true&fields=" + fields::changes,
+		RootID(), page_token ) );
+}
+
+std::string Syncer3::GetPageToken()
+{
+	http::ValResponse res ;
+	m_http->Get( feeds::changes + "/startPageToken", &res, http::Header(), 0 ) ;
+
+	return res.Response()["startPageToken"].Str() ;
+}
+
+/// The changes after the current ones are watched.
+Channel Syncer3::Watch( const std::string& id, const std::string& token, const std::string& address )
+{
+	return OpenChannel( feeds::changes + "/watch?pageToken=" + GetPageToken(), id, token, address ) ;
+}
+
+void Syncer3::StopWatch( const Channel& channel )
+{
+	CloseChannel( feeds::channels + "/stop", channel ) ;
+}
+
+} } // end of namespace gr::v3
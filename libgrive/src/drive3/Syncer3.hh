@@ -0,0 +1,68 @@
+/*
+	Drive API v3 Syncer implementation
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "base/Syncer.hh"
+
+namespace gr {
+
+class Feed;
+
+class Val;
+
+namespace v3 {
+
+class Syncer3: public Syncer
+{
+
+public :
+
+	Syncer3( http::Agent *http );
+
+	void DeleteRemote( Resource *res );
+	bool EditContent( Resource *res, bool new_rev );
+	bool Create( Resource *res );
+	bool Copy( Resource *from, Resource *to );
+	bool Move( Resource* res, Resource* newParent, std::string newFilename );
+
+	std::unique_ptr<Feed> GetFolders();
+	std::unique_ptr<Feed> GetAll();
+	std::unique_ptr<Feed> GetChildren( const std::string& parent_id );
+	std::unique_ptr<Feed> GetChanges( long min_cstamp );
+	long GetChangeStamp( long min_cstamp );
+	std::unique_ptr<Feed> GetChangesFrom( const std::string& page_token );
+	std::string GetPageToken();
+	Channel Watch( const std::string& id, const std::string& token, const std::string& address );
+	void StopWatch( const Channel& channel );
+
+private :
+
+	bool Upload( Resource *res );
+	std::string RootID();
+	std::string ParentID( Resource *res );
+	void Patch( const std::string& url, const Val& meta, Val *result );
+
+private :
+
+	std::string m_root_id;
+
+} ;
+
+} } // end of namespace gr::v3
@@ -70,6 +70,23 @@ long Agent::Post(
 	return Request( "POST", url, &s, dest, h );
 }
 
+/// Run \a job. Agents with a bulk lane run it there instead.
+void Agent::Bulk( const Job& job )
+{
+	job() ;
+}
+
+/// Wait until the jobs given to Bulk() are done.
+void Agent::WaitBulk()
+{
+}
+
+/// Run \a work. There are no other lanes to let go on.
+void Agent::Apart( const Job& work )
+{
+	work() ;
+}
+
 void Agent::SetUploadSpeed( unsigned kbytes )
 {
 	mMaxUpload = kbytes;
@@ -19,7 +19,9 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <boost/function.hpp>
 #include "ResponseLog.hh"
 #include "util/Types.hh"
 #include "util/Progress.hh"
@@ -89,6 +91,19 @@ public :
 	virtual std::string Unescape( const std::string& str ) = 0 ;
 
 	virtual void SetProgressReporter( Progress* ) = 0;
+
+	// a new agent with the same settings, for use in another thread
+	virtual std::unique_ptr<Agent> Clone() const = 0 ;
+
+	// a job that transfers file content, which may be run later on a lane
+	// of its own. see Lanes
+	typedef boost::function<void ()> Job ;
+	virtual void Bulk( const Job& job ) ;
+	virtual void WaitBulk() ;
+
+	// run work that touches neither the resources nor the state, e.g. the
+	// local file I/O of a transfer, while the other lanes go on. see Lanes
+	virtual void Apart( const Job& work ) ;
 } ;
 
 } } // end of namespace
@@ -18,6 +18,7 @@
 */
 
 #include "CurlAgent.hh"
+#include "CurlShare.hh"
 
 #include "Error.hh"
 #include "Header.hh"
@@ -25,6 +26,7 @@
 #include "util/log/Log.hh"
 #include "util/DataStream.hh"
 #include "util/File.hh"
+#include "util/MemStats.hh"
 
 #include <boost/throw_exception.hpp>
 
@@ -70,10 +72,15 @@ struct CurlAgent::Impl
 
 static struct curl_slist* SetHeader( CURL* handle, const Header& hdr );
 
-CurlAgent::CurlAgent() : Agent(),
-	m_pimpl( new Impl ), m_pb( 0 )
+// curl keeps a receive buffer and an upload buffer for each handle
+const std::size_t curl_buffers = CURL_MAX_WRITE_SIZE + 65536 ;
+
+/// \param	share	connections to reuse with other agents, or NULL
+CurlAgent::CurlAgent( CurlShare *share ) : Agent(),
+	m_pimpl( new Impl ), m_pb( 0 ), m_share( share ), m_stats( &MemStats::Instance() )
 {
 	m_pimpl->curl = ::curl_easy_init();
+	m_stats->Add( MemStats::http, curl_buffers ) ;
 }
 
 void CurlAgent::Init()
@@ -84,6 +91,8 @@ void CurlAgent::Init()
 	::curl_easy_setopt( m_pimpl->curl, CURLOPT_HEADERFUNCTION,	&CurlAgent::HeaderCallback ) ;
 	::curl_easy_setopt( m_pimpl->curl, CURLOPT_HEADERDATA,		this ) ;
 	::curl_easy_setopt( m_pimpl->curl, CURLOPT_HEADER,			0L ) ;
+	if ( m_share != 0 )
+		::curl_easy_setopt( m_pimpl->curl, CURLOPT_SHARE,		m_share->Handle() ) ;
 	if ( mMaxUpload > 0 )
 		::curl_easy_setopt( m_pimpl->curl, CURLOPT_MAX_SEND_SPEED_LARGE, mMaxUpload ) ;
 	if ( mMaxDownload > 0 )
@@ -98,6 +107,7 @@ void CurlAgent::Init()
 CurlAgent::~CurlAgent()
 {
 	::curl_easy_cleanup( m_pimpl->curl );
+	m_stats->Remove( MemStats::http, curl_buffers ) ;
 }
 
 ResponseLog* CurlAgent::GetLog() const
@@ -115,6 +125,16 @@ void CurlAgent::SetProgressReporter(Progress *progress)
 	m_pb = progress;
 }
 
+/// The clone has its own curl handle. Responses are not logged by it, as the
+/// response log belongs to this agent.
+std::unique_ptr<Agent> CurlAgent::Clone() const
+{
+	std::unique_ptr<Agent> agent( new CurlAgent( m_share ) ) ;
+	agent->SetUploadSpeed( mMaxUpload ) ;
+	agent->SetDownloadSpeed( mMaxDownload ) ;
+	return agent ;
+}
+
 std::size_t CurlAgent::HeaderCallback( void *ptr, size_t size, size_t nmemb, CurlAgent *pthis )
 {
 	char *str = static_cast<char*>(ptr) ;
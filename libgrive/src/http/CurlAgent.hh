@@ -29,9 +29,12 @@
 namespace gr {
 
 class DataStream ;
+class MemStats ;
 
 namespace http {
 
+class CurlShare ;
+
 /*!	\brief	agent to provide HTTP access
 	
 	This class provides functions to send HTTP request in many methods (e.g. get, post and put).
@@ -40,12 +43,13 @@ namespace http {
 class CurlAgent : public Agent
 {
 public :
-	CurlAgent() ;
+	explicit CurlAgent( CurlShare *share = 0 ) ;
 	~CurlAgent() ;
 
 	ResponseLog* GetLog() const ;
 	void SetLog( ResponseLog *log ) ;
 	void SetProgressReporter( Progress *progress ) ;
+	std::unique_ptr<Agent> Clone() const ;
 
 	long Request(
 		const std::string&	method,
@@ -81,6 +85,8 @@ private :
 	std::unique_ptr<Impl> m_pimpl ;
 	std::unique_ptr<ResponseLog> m_log ;
 	Progress* m_pb ;
+	CurlShare* m_share ;
+	MemStats* m_stats ;
 } ;
 
 } } // end of namespace
@@ -0,0 +1,58 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "CurlShare.hh"
+
+namespace gr { namespace http {
+
+CurlShare::CurlShare() :
+	m_share( ::curl_share_init() )
+{
+	::curl_share_setopt( m_share, CURLSHOPT_LOCKFUNC,	&CurlShare::Lock ) ;
+	::curl_share_setopt( m_share, CURLSHOPT_UNLOCKFUNC,	&CurlShare::Unlock ) ;
+	::curl_share_setopt( m_share, CURLSHOPT_USERDATA,	this ) ;
+	::curl_share_setopt( m_share, CURLSHOPT_SHARE,		CURL_LOCK_DATA_DNS ) ;
+	::curl_share_setopt( m_share, CURLSHOPT_SHARE,		CURL_LOCK_DATA_SSL_SESSION ) ;
+#if LIBCURL_VERSION_NUM >= 0x073900
+	// the connection pool can be shared since libcurl 7.57
+	::curl_share_setopt( m_share, CURLSHOPT_SHARE,		CURL_LOCK_DATA_CONNECT ) ;
+#endif
+}
+
+CurlShare::~CurlShare()
+{
+	::curl_share_cleanup( m_share ) ;
+}
+
+CURLSH* CurlShare::Handle() const
+{
+	return m_share ;
+}
+
+void CurlShare::Lock( CURL*, curl_lock_data data, curl_lock_access, void *pthis )
+{
+	static_cast<CurlShare*>( pthis )->m_mutex[data].lock() ;
+}
+
+void CurlShare::Unlock( CURL*, curl_lock_data data, void *pthis )
+{
+	static_cast<CurlShare*>( pthis )->m_mutex[data].unlock() ;
+}
+
+} } // end of namespace
@@ -0,0 +1,53 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <curl/curl.h>
+
+#include <mutex>
+
+namespace gr { namespace http {
+
+/*!	\brief	connections, DNS and TLS sessions shared by several CurlAgents
+
+	Agents given the same CurlShare reuse each other's connections, even
+	from different threads. The share must outlive the agents.
+*/
+class CurlShare
+{
+public :
+	CurlShare() ;
+	~CurlShare() ;
+
+	CURLSH* Handle() const ;
+
+private :
+	CurlShare( const CurlShare& ) ;
+	CurlShare& operator=( const CurlShare& ) ;
+
+	static void Lock( CURL *handle, curl_lock_data data, curl_lock_access access, void *pthis ) ;
+	static void Unlock( CURL *handle, curl_lock_data data, void *pthis ) ;
+
+private :
+	CURLSH		*m_share ;
+	std::mutex	m_mutex[CURL_LOCK_DATA_LAST] ;
+} ;
+
+} } // end of namespace
@@ -21,6 +21,8 @@
 // #include "util/SignalHandler.hh"
 
 #include "util/Crypt.hh"
+#include "util/IoUring.hh"
+#include "util/PageCache.hh"
 
 // boost headers
 #include <boost/throw_exception.hpp>
@@ -30,28 +32,70 @@
 #include <boost/exception/errinfo_file_handle.hpp>
 #include <boost/exception/errinfo_file_name.hpp>
 #include <boost/exception/errinfo_file_open_mode.hpp>
+#include <boost/exception/get_error_info.hpp>
 #include <boost/exception/info.hpp>
 
 #include <cassert>
+#include <cerrno>
 #include <new>
 
 #include <signal.h>
 
 namespace gr { namespace http {
 
+namespace
+{
+	/// The errors of the queued writes are errors of the file, like the ones
+	/// of File::Write(), so that only the transfer of this file fails.
+	void ThrowFileError( const IoUring::Error& e )
+	{
+		const int *en = boost::get_error_info< boost::errinfo_errno >( e ) ;
+		BOOST_THROW_EXCEPTION(
+			File::Error()
+				<< boost::errinfo_api_function("io_uring write")
+				<< boost::errinfo_errno( en != 0 ? *en : EIO )
+		) ;
+	}
+}
+
 Download::Download( const std::string& filename ) :
 	m_file( filename, 0600 ),
-	m_crypt( new crypt::MD5 )
+	m_crypt( new crypt::MD5 ),
+	m_fp( new crypt::Fingerprint ),
+	m_offset( 0 )
 {
 }
 
 Download::Download( const std::string& filename, NoChecksum ) :
-	m_file( filename, 0600 )
+	m_file( filename, 0600 ),
+	m_fp( new crypt::Fingerprint ),
+	m_offset( 0 )
 {
 }
 
 Download::~Download()
 {
+	// the queued writes must complete before the file is closed
+	try
+	{
+		Flush() ;
+	}
+	catch ( Exception& )
+	{
+	}
+}
+
+/// Wait until all data written so far is in the file.
+void Download::Flush()
+{
+	try
+	{
+		IoUring::Instance().Flush() ;
+	}
+	catch ( IoUring::Error& e )
+	{
+		ThrowFileError( e ) ;
+	}
 }
 
 void Download::Clear()
@@ -59,9 +103,15 @@ void Download::Clear()
 	// no need to do anything
 }
 
-std::string Download::Finish() const
+Digest Download::Finish() const
+{
+	return m_crypt.get() != 0 ? m_crypt->Get() : Digest() ;
+}
+
+/// The fingerprint of the data written, see crypt::Fingerprint
+u64_t Download::FinishFingerprint() const
 {
-	return m_crypt.get() != 0 ? m_crypt->Get() : "" ;
+	return m_fp->Get() ;
 }
 
 std::size_t Download::Write( const char *data, std::size_t count )
@@ -70,8 +120,30 @@ std::size_t Download::Write( const char *data, std::size_t count )
 	
 	if ( m_crypt.get() != 0 )
 		m_crypt->Write( data, count ) ;
+	m_fp->Write( data, count ) ;
 	
-	return m_file.Write( data, count ) ;
+	IoUring& ring = IoUring::Instance() ;
+	PageCache& cache = PageCache::Instance() ;
+	if ( ring.Available() && !cache.Enabled() )
+	{
+		// don't wait for the disk while curl has more data for us
+		try
+		{
+			ring.Write( m_file.Fd(), data, count, m_offset ) ;
+		}
+		catch ( IoUring::Error& e )
+		{
+			ThrowFileError( e ) ;
+		}
+		m_offset += count ;
+		return count ;
+	}
+
+	// the pages can only be dropped once they are written
+	std::size_t written = m_file.Write( data, count ) ;
+	cache.Written( m_file.Fd(), m_offset, m_offset + written ) ;
+	m_offset += written ;
+	return written ;
 }
 
 
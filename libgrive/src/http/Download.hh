@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "util/Digest.hh"
 #include "util/File.hh"
 
 #include <string>
@@ -28,6 +29,7 @@ namespace gr {
 namespace crypt
 {
 	class MD5 ;
+	class Fingerprint ;
 }
 
 namespace http {
@@ -40,7 +42,9 @@ public :
 	Download( const std::string& filename, NoChecksum ) ;
 	~Download() ;
 	
-	std::string Finish() const ;
+	Digest Finish() const ;
+	u64_t FinishFingerprint() const ;
+	void Flush() ;
 	
 	void Clear() ;
 	std::size_t Write( const char *data, std::size_t count ) ;
@@ -49,6 +53,8 @@ public :
 private :
 	File						m_file ;
 	std::unique_ptr<crypt::MD5>	m_crypt ;
+	std::unique_ptr<crypt::Fingerprint>	m_fp ;
+	u64_t						m_offset ;
 } ;
 
 } } // end of namespace
@@ -0,0 +1,338 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Lanes.hh"
+
+#include "util/MemStats.hh"
+#include "util/log/Log.hh"
+
+#include <algorithm>
+
+namespace gr { namespace http {
+
+namespace
+{
+	// the bulk lane of a thread, and its agent
+	thread_local const Lanes	*t_lanes = 0 ;
+	thread_local Agent			*t_agent = 0 ;
+
+	// the turn the thread has given up, if any
+	thread_local std::mutex		*t_off_turn = 0 ;
+
+	/// Gives up the turn for the lifetime of the object, unless the thread
+	/// has already given it up, e.g. a request in Apart().
+	class OffTurn
+	{
+	public :
+		explicit OffTurn( std::mutex& turn ) : m_turn( t_off_turn == &turn ? 0 : &turn )
+		{
+			if ( m_turn != 0 )
+			{
+				t_off_turn = m_turn ;
+				m_turn->unlock() ;
+			}
+		}
+
+		~OffTurn()
+		{
+			if ( m_turn != 0 )
+			{
+				m_turn->lock() ;
+				t_off_turn = 0 ;
+			}
+		}
+
+	private :
+		std::mutex	*m_turn ;
+	} ;
+}
+
+/// \param	bulk_threads	connections for the bulk lane. With 0, the jobs
+///							run right away on the metadata lane.
+Lanes::Lanes( Agent *agent, unsigned bulk_threads ) :
+	m_agent		( agent ),
+	m_threads	( bulk_threads ),
+	m_progress	( 0 ),
+	m_owner		( std::this_thread::get_id() ),
+	m_pending	( 0 ),
+	m_start		( std::chrono::steady_clock::now() )
+{
+	Usage none = { 0, 0, 1 } ;
+	m_usage[metadata_lane]	= none ;
+	m_usage[bulk_lane]		= none ;
+	m_usage[bulk_lane].connections = bulk_threads ;
+
+	m_turn.lock() ;
+}
+
+Lanes::~Lanes()
+{
+	// the workers need turns to finish
+	m_jobs.Close() ;
+	m_turn.unlock() ;
+	for ( std::size_t i = 0 ; i < m_workers.size() ; i++ )
+		m_workers[i].join() ;
+}
+
+/// Queue \a job on the bulk lane. Call from the metadata lane.
+void Lanes::Bulk( const Job& job )
+{
+	if ( m_threads == 0 )
+	{
+		job() ;
+		return ;
+	}
+
+	if ( m_workers.empty() )
+		Start() ;
+	m_pending++ ;
+	m_jobs.Push( job ) ;
+}
+
+/// Wait for the bulk jobs, and throw the first error of any of them. The
+/// other jobs still ran.
+void Lanes::WaitBulk()
+{
+	std::unique_lock<std::mutex> turn( m_turn, std::adopt_lock ) ;
+	while ( m_pending > 0 )
+		m_idle.wait( turn ) ;
+	turn.release() ;
+
+	if ( m_error )
+	{
+		std::exception_ptr error = m_error ;
+		m_error = std::exception_ptr() ;
+		std::rethrow_exception( error ) ;
+	}
+}
+
+void Lanes::Start()
+{
+	for ( unsigned i = 0 ; i < m_threads ; i++ )
+		m_bulk.push_back( m_agent->Clone() ) ;
+	m_bulk.front()->SetProgressReporter( m_progress ) ;
+	for ( unsigned i = 0 ; i < m_threads ; i++ )
+		m_workers.push_back( std::thread( &Lanes::Worker, this, m_bulk[i].get(), &MemStats::Instance() ) ) ;
+}
+
+void Lanes::Worker( Agent *agent, MemStats *stats )
+{
+	t_lanes = this ;
+	t_agent = agent ;
+	MemStats::Scope scope( *stats ) ;
+
+	Job job ;
+	while ( m_jobs.Pop( job ) )
+	{
+		std::lock_guard<std::mutex> turn( m_turn ) ;
+
+		// an error only ends its own job. the transfers of the other files
+		// go on, and WaitBulk() throws it when they are done
+		try
+		{
+			job() ;
+		}
+		catch ( ... )
+		{
+			if ( !m_error )
+				m_error = std::current_exception() ;
+		}
+		m_pending-- ;
+		m_idle.notify_all() ;
+	}
+}
+
+/// Run \a work without the turn, so that the other jobs and the metadata
+/// thread can go on meanwhile. Only for work that touches neither the
+/// resources nor the state.
+void Lanes::Apart( const Job& work )
+{
+	if ( t_lanes != this && std::this_thread::get_id() != m_owner )
+	{
+		// not on a lane, so it has no turn to give up
+		work() ;
+		return ;
+	}
+
+	OffTurn off( m_turn ) ;
+	work() ;
+}
+
+/// The agent of the lane of the calling thread.
+Agent* Lanes::Current() const
+{
+	return t_lanes == this ? t_agent : m_agent ;
+}
+
+long Lanes::Request(
+	const std::string&	method,
+	const std::string&	url,
+	SeekStream			*in,
+	DataStream			*dest,
+	const Header&		hdr,
+	u64_t				downloadFileBytes )
+{
+	Lane lane = t_lanes == this ? bulk_lane : metadata_lane ;
+	if ( lane == metadata_lane && std::this_thread::get_id() != m_owner )
+	{
+		// not on a lane. the agent is dropped if the request throws
+		std::unique_ptr<Agent> agent = TakeSpare() ;
+		long response = agent->Request( method, url, in, dest, hdr, downloadFileBytes ) ;
+		GiveBack( std::move( agent ) ) ;
+		return response ;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() ;
+	long response ;
+	{
+		OffTurn off( m_turn ) ;
+		response = Current()->Request( method, url, in, dest, hdr, downloadFileBytes ) ;
+	}
+
+	std::chrono::duration<double> busy = std::chrono::steady_clock::now() - start ;
+	m_usage[lane].requests++ ;
+	m_usage[lane].busy += busy.count() ;
+	return response ;
+}
+
+/// An agent for a thread that is on neither lane, with a connection of its own.
+std::unique_ptr<Agent> Lanes::TakeSpare()
+{
+	std::lock_guard<std::mutex> lock( m_spare_mutex ) ;
+	if ( m_spare.empty() )
+		return m_agent->Clone() ;
+
+	std::unique_ptr<Agent> agent = std::move( m_spare.back() ) ;
+	m_spare.pop_back() ;
+	return agent ;
+}
+
+void Lanes::GiveBack( std::unique_ptr<Agent> agent )
+{
+	std::lock_guard<std::mutex> lock( m_spare_mutex ) ;
+	m_spare.push_back( std::move( agent ) ) ;
+}
+
+Lanes::Usage Lanes::LaneUsage( Lane lane ) const
+{
+	return m_usage[lane] ;
+}
+
+/// Log the requests made on each lane, and how busy its connections were.
+void Lanes::Report() const
+{
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start ;
+	const char *names[lane_count] = { "metadata", "bulk" } ;
+	for ( int i = 0 ; i < lane_count ; i++ )
+	{
+		const Usage& u = m_usage[i] ;
+		if ( u.connections == 0 )
+			continue ;
+		Log( "%1% lane: %2% requests, %3% ms in requests, %4%%% busy", names[i], u.requests,
+			static_cast<u64_t>( u.busy * 1000 ),
+			static_cast<unsigned>( 100 * u.busy / ( elapsed.count() * u.connections ) ),
+			log::verbose ) ;
+	}
+}
+
+ResponseLog* Lanes::GetLog() const
+{
+	return m_agent->GetLog() ;
+}
+
+void Lanes::SetLog( ResponseLog *log )
+{
+	m_agent->SetLog( log ) ;
+}
+
+/// The progress is shown for the first connection of the bulk lane, if it
+/// has any, because the reporter is not shared between threads.
+void Lanes::SetProgressReporter( Progress *progress )
+{
+	m_progress = progress ;
+	m_agent->SetProgressReporter( m_threads == 0 ? progress : 0 ) ;
+	if ( !m_bulk.empty() )
+		m_bulk.front()->SetProgressReporter( progress ) ;
+}
+
+std::unique_ptr<Agent> Lanes::Clone() const
+{
+	return m_agent->Clone() ;
+}
+
+std::string Lanes::LastError() const
+{
+	return Current()->LastError() ;
+}
+
+std::string Lanes::LastErrorHeaders() const
+{
+	return Current()->LastErrorHeaders() ;
+}
+
+std::string Lanes::RedirLocation() const
+{
+	return Current()->RedirLocation() ;
+}
+
+std::string Lanes::Escape( const std::string& str )
+{
+	return Current()->Escape( str ) ;
+}
+
+std::string Lanes::Unescape( const std::string& str )
+{
+	return Current()->Unescape( str ) ;
+}
+
+/// The limits are for all connections together. The file content goes over
+/// the bulk lane, if it has any connections, so each of them gets an equal
+/// share. The other connections get as much, their requests are small.
+void Lanes::SetUploadSpeed( unsigned kbytes )
+{
+	unsigned share = Share( kbytes ) ;
+	m_agent->SetUploadSpeed( share ) ;
+	for ( std::size_t i = 0 ; i < m_bulk.size() ; i++ )
+		m_bulk[i]->SetUploadSpeed( share ) ;
+	std::lock_guard<std::mutex> lock( m_spare_mutex ) ;
+	for ( std::size_t i = 0 ; i < m_spare.size() ; i++ )
+		m_spare[i]->SetUploadSpeed( share ) ;
+}
+
+void Lanes::SetDownloadSpeed( unsigned kbytes )
+{
+	unsigned share = Share( kbytes ) ;
+	m_agent->SetDownloadSpeed( share ) ;
+	for ( std::size_t i = 0 ; i < m_bulk.size() ; i++ )
+		m_bulk[i]->SetDownloadSpeed( share ) ;
+	std::lock_guard<std::mutex> lock( m_spare_mutex ) ;
+	for ( std::size_t i = 0 ; i < m_spare.size() ; i++ )
+		m_spare[i]->SetDownloadSpeed( share ) ;
+}
+
+/// The limit of each connection for the limit \a kbytes of all of them. 0 is
+/// no limit, so it is never rounded down to that.
+unsigned Lanes::Share( unsigned kbytes ) const
+{
+	if ( kbytes == 0 )
+		return 0 ;
+	return std::max( kbytes / std::max( m_threads, 1u ), 1u ) ;
+}
+
+} } // end of namespace
@@ -0,0 +1,143 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "Agent.hh"
+#include "util/SyncQueue.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gr {
+
+class MemStats ;
+
+namespace http {
+
+/*!	\brief	separate lanes for metadata requests and file transfers
+
+	Lanes sends each request on the lane of the calling thread. The thread
+	that created it is on the metadata lane and uses the given agent. The jobs
+	given to Bulk() run in the threads of the bulk lane, each with a clone of
+	the agent and so a connection of its own. A long upload or download then
+	no longer holds up the folder creations, moves and listings behind it.
+
+	The jobs and the metadata thread take turns: only one of them runs at a
+	time, except while in a request or in Apart(). The code around them,
+	i.e. the resource tree and the state, needs no locking of its own. A
+	job that fails doesn't stop the others. Requests from
+	other threads, e.g. the read-ahead of FeedReader, are sent with spare
+	clones of the agent, as the connection of a lane can't be shared.
+
+	The speed limits set on Lanes are split between the bulk connections.
+	Set them on Lanes rather than on the agent, whose clones would each get
+	the whole limit.
+*/
+class Lanes : public Agent
+{
+public :
+	enum Lane { metadata_lane, bulk_lane, lane_count } ;
+
+	/// requests made on a lane and the time spent in them
+	struct Usage
+	{
+		u64_t		requests ;
+		double		busy ;			// seconds, all connections together
+		unsigned	connections ;
+	} ;
+
+public :
+	Lanes( Agent *agent, unsigned bulk_threads ) ;
+	~Lanes() ;
+
+	void Bulk( const Job& job ) ;
+	void WaitBulk() ;
+	void Apart( const Job& work ) ;
+
+	Usage LaneUsage( Lane lane ) const ;
+	void Report() const ;
+
+	ResponseLog* GetLog() const ;
+	void SetLog( ResponseLog *log ) ;
+	void SetProgressReporter( Progress *progress ) ;
+	std::unique_ptr<Agent> Clone() const ;
+
+	long Request(
+		const std::string&	method,
+		const std::string&	url,
+		SeekStream			*in,
+		DataStream			*dest,
+		const Header&		hdr,
+		u64_t			downloadFileBytes = 0 ) ;
+
+	std::string LastError() const ;
+	std::string LastErrorHeaders() const ;
+
+	std::string RedirLocation() const ;
+
+	std::string Escape( const std::string& str ) ;
+	std::string Unescape( const std::string& str ) ;
+
+	void SetUploadSpeed( unsigned kbytes ) ;
+	void SetDownloadSpeed( unsigned kbytes ) ;
+
+private :
+	Lanes( const Lanes& ) ;
+	Lanes& operator=( const Lanes& ) ;
+
+	Agent* Current() const ;
+	void Start() ;
+	void Worker( Agent *agent, MemStats *stats ) ;
+	std::unique_ptr<Agent> TakeSpare() ;
+	void GiveBack( std::unique_ptr<Agent> agent ) ;
+	unsigned Share( unsigned kbytes ) const ;
+
+private :
+	Agent			*m_agent ;
+	unsigned		m_threads ;
+	Progress		*m_progress ;
+
+	std::vector<std::unique_ptr<Agent> >	m_bulk ;
+	std::vector<std::thread>				m_workers ;
+	SyncQueue<Job>							m_jobs ;
+
+	// agents not in use by the other threads
+	std::mutex								m_spare_mutex ;
+	std::vector<std::unique_ptr<Agent> >	m_spare ;
+
+	// held by the thread whose turn it is, see above. the counters below
+	// are only touched during a turn
+	std::mutex				m_turn ;
+	std::condition_variable	m_idle ;
+	std::thread::id			m_owner ;
+	std::size_t				m_pending ;
+	std::exception_ptr		m_error ;
+
+	Usage									m_usage[lane_count] ;
+	std::chrono::steady_clock::time_point	m_start ;
+} ;
+
+} } // end of namespace
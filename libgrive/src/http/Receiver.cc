@@ -0,0 +1,235 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Receiver.hh"
+
+#include "Error.hh"
+
+#include "util/log/Log.hh"
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/exception/errinfo_api_function.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace gr { namespace http {
+
+namespace
+{
+	// requests are small, anything bigger is not a notification
+	const std::size_t max_header	= 16 * 1024 ;
+	const std::size_t max_body		= 64 * 1024 ;
+	const std::size_t max_clients	= 64 ;
+
+	// how often the thread checks whether to stop, and how long a client
+	// may take to send its whole request
+	const int poll_ms = 500 ;
+	const int client_ms = 5000 ;
+
+	void ThrowErrno( const char *api )
+	{
+		BOOST_THROW_EXCEPTION(
+			Error()
+				<< boost::errinfo_api_function( api )
+				<< boost::errinfo_errno( errno )
+		) ;
+	}
+
+	/// The header fields of the request in \a data, whose header ends at
+	/// \a end. The request line is skipped, only the fields are of interest.
+	Receiver::Fields ParseFields( const std::string& data, std::size_t end )
+	{
+		Receiver::Fields fields ;
+		std::size_t line = data.find( "\r\n" ) + 2 ;
+		while ( line < end )
+		{
+			std::size_t next = data.find( "\r\n", line ) ;
+			std::string field = data.substr( line, next - line ) ;
+			std::size_t colon = field.find( ':' ) ;
+			if ( colon != std::string::npos )
+			{
+				std::string name = boost::algorithm::to_lower_copy( field.substr( 0, colon ) ) ;
+				fields[name] = boost::algorithm::trim_copy( field.substr( colon + 1 ) ) ;
+			}
+			line = next + 2 ;
+		}
+		return fields ;
+	}
+}
+
+Receiver::Receiver( const std::string& address, unsigned port, const Callback& callback ) :
+	m_callback	( callback ),
+	m_socket	( ::socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0 ) ),
+	m_port		( port ),
+	m_stop		( false )
+{
+	if ( m_socket < 0 )
+		ThrowErrno( "socket" ) ;
+
+	int on = 1 ;
+	::setsockopt( m_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on) ) ;
+
+	sockaddr_in addr ;
+	std::memset( &addr, 0, sizeof(addr) ) ;
+	addr.sin_family			= AF_INET ;
+	addr.sin_port			= htons( static_cast<uint16_t>( port ) ) ;
+	if ( ::inet_pton( AF_INET, address.c_str(), &addr.sin_addr ) != 1 )
+	{
+		::close( m_socket ) ;
+		errno = EINVAL ;
+		ThrowErrno( "inet_pton" ) ;
+	}
+
+	socklen_t len = sizeof(addr) ;
+	if ( ::bind( m_socket, reinterpret_cast<sockaddr*>( &addr ), len ) != 0 ||
+		::listen( m_socket, 16 ) != 0 ||
+		::getsockname( m_socket, reinterpret_cast<sockaddr*>( &addr ), &len ) != 0 )
+	{
+		int error = errno ;
+		::close( m_socket ) ;
+		errno = error ;
+		ThrowErrno( "bind" ) ;
+	}
+	m_port = ntohs( addr.sin_port ) ;
+
+	m_thread = std::thread( &Receiver::Listen, this ) ;
+}
+
+Receiver::~Receiver()
+{
+	m_stop = true ;
+	m_thread.join() ;
+	for ( std::size_t i = 0 ; i < m_clients.size() ; i++ )
+		::close( m_clients[i].fd ) ;
+	::close( m_socket ) ;
+}
+
+unsigned Receiver::Port() const
+{
+	return m_port ;
+}
+
+void Receiver::Listen()
+{
+	while ( !m_stop )
+	{
+		std::vector<pollfd> fds ;
+		pollfd listen = { m_socket, POLLIN, 0 } ;
+		fds.push_back( listen ) ;
+		for ( std::size_t i = 0 ; i < m_clients.size() ; i++ )
+		{
+			pollfd client = { m_clients[i].fd, POLLIN, 0 } ;
+			fds.push_back( client ) ;
+		}
+
+		int ready = ::poll( &fds[0], fds.size(), poll_ms ) ;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now() ;
+
+		// keep the connections that are still sending their request in time
+		std::vector<Client> left ;
+		for ( std::size_t i = 0 ; i < m_clients.size() ; i++ )
+		{
+			bool keep = now < m_clients[i].deadline ;
+			if ( keep && ready > 0 && fds[i+1].revents != 0 )
+				keep = Receive( m_clients[i] ) ;
+
+			if ( keep )
+				left.push_back( m_clients[i] ) ;
+			else
+				::close( m_clients[i].fd ) ;
+		}
+		m_clients.swap( left ) ;
+
+		if ( ready > 0 && ( fds[0].revents & POLLIN ) != 0 )
+			Accept() ;
+	}
+}
+
+void Receiver::Accept()
+{
+	int fd = ::accept4( m_socket, 0, 0, SOCK_NONBLOCK ) ;
+	if ( fd < 0 )
+		return ;
+
+	if ( m_clients.size() >= max_clients )
+	{
+		Log( "too many connections for push notifications", log::warning ) ;
+		::close( fd ) ;
+		return ;
+	}
+
+	Client client ;
+	client.fd		= fd ;
+	client.deadline	= std::chrono::steady_clock::now() + std::chrono::milliseconds( client_ms ) ;
+	m_clients.push_back( client ) ;
+}
+
+/// Read what \a client has sent, and answer once its request is complete.
+/// \return	false when done with the connection
+bool Receiver::Receive( Client& client )
+{
+	char buf[4096] ;
+	ssize_t r = ::recv( client.fd, buf, sizeof(buf), 0 ) ;
+	if ( r < 0 )
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ;
+	if ( r == 0 )
+		return false ;
+	client.data.append( buf, r ) ;
+
+	std::size_t end = client.data.find( "\r\n\r\n" ) ;
+	if ( end == std::string::npos )
+		return client.data.size() <= max_header ;
+	if ( end > max_header )
+		return false ;
+
+	// wait for the whole body, so that the client sees the answer and not
+	// a reset
+	Fields fields = ParseFields( client.data, end ) ;
+	std::size_t body = fields.count( "content-length" ) ?
+		std::strtoul( fields["content-length"].c_str(), 0, 10 ) : 0 ;
+	if ( body > max_body )
+		return false ;
+	if ( client.data.size() - end - 4 < body )
+		return true ;
+
+	try
+	{
+		m_callback( fields ) ;
+	}
+	catch ( std::exception& e )
+	{
+		Log( "push notification failed: %1%", e.what(), log::warning ) ;
+	}
+
+	const char answer[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n" ;
+	::send( client.fd, answer, sizeof(answer) - 1, MSG_NOSIGNAL ) ;
+	return false ;
+}
+
+} } // end of namespace
@@ -0,0 +1,84 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <boost/function.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gr { namespace http {
+
+/*!	\brief	a minimal HTTP server for push notifications
+
+	Accepts requests on a local port in a thread of its own, hands the
+	headers of each to the callback and answers with an empty 200 response. The
+	body is read and dropped. It speaks plain HTTP, so a proxy terminating
+	TLS has to forward the notifications to it. That is why it only listens
+	on the loopback address unless told otherwise.
+
+	The connections are served side by side without blocking, and each is
+	closed if its request is not complete within a few seconds. A slow or idle
+	client doesn't hold up the notifications of the others.
+*/
+class Receiver
+{
+public :
+	/// header names in lower case, and their values
+	typedef std::map<std::string, std::string>		Fields ;
+	typedef boost::function<void ( const Fields& )>	Callback ;
+
+public :
+	/// \param	address	the IPv4 address to listen on, e.g. "0.0.0.0" for all
+	///					interfaces
+	/// \param	port	0 for any free port, see Port()
+	Receiver( const std::string& address, unsigned port, const Callback& callback ) ;
+	~Receiver() ;
+
+	unsigned Port() const ;
+
+private :
+	struct Client
+	{
+		int			fd ;
+		std::string	data ;
+		std::chrono::steady_clock::time_point	deadline ;
+	} ;
+
+	void Listen() ;
+	void Accept() ;
+	bool Receive( Client& client ) ;
+
+private :
+	Callback			m_callback ;
+	int					m_socket ;
+	unsigned			m_port ;
+	std::atomic<bool>	m_stop ;
+	std::thread			m_thread ;
+
+	// the connections whose request is not complete yet
+	std::vector<Client>	m_clients ;
+} ;
+
+} } // end of namespace
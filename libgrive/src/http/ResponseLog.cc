@@ -33,13 +33,22 @@ ResponseLog::ResponseLog(
 	Reset( prefix, suffix ) ;
 }
 
+/// The copy writes to the same file, so that an agent in another thread can
+/// log its responses there too. Each Write() goes in whole.
+ResponseLog::ResponseLog( const ResponseLog& log ) :
+	m_enabled( log.m_enabled ),
+	m_sink( log.m_sink )
+{
+}
+
 std::size_t ResponseLog::Write( const char *data, std::size_t count )
 {
 	if ( m_enabled )
 	{
-		assert( m_log.rdbuf() != 0 ) ;
-		m_log.rdbuf()->sputn( data, count ) ;
-		m_log.flush();
+		std::lock_guard<std::mutex> lock( m_sink->mutex ) ;
+		assert( m_sink->log.rdbuf() != 0 ) ;
+		m_sink->log.rdbuf()->sputn( data, count ) ;
+		m_sink->log.flush();
 	}
 	return count;
 }
@@ -56,18 +65,13 @@ std::string ResponseLog::Filename( const std::string& prefix, const std::string&
 
 void ResponseLog::Reset( const std::string& prefix, const std::string& suffix )
 {
-	if ( m_log.is_open() )
-		m_log.close() ;
+	// the copies keep writing to the old file
+	m_sink.reset( new Sink ) ;
 	
 	const std::string fname = Filename( prefix, suffix ) ;
 	
-	// reset previous stream state. don't care if file can be opened
-	// successfully previously
-	m_log.clear() ;
-	
-	// re-open the file
-	m_log.open( fname.c_str() ) ;
-	if ( m_log )
+	m_sink->log.open( fname.c_str() ) ;
+	if ( m_sink->log )
 	{
 		Trace( "logging HTTP response: %1%", fname ) ;
 		m_enabled = true ;
@@ -22,6 +22,8 @@
 #include "util/DataStream.hh"
 
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
 
 namespace gr { namespace http {
@@ -32,6 +34,7 @@ public :
 	ResponseLog(
 		const std::string&	prefix,
 		const std::string&	suffix ) ;
+	ResponseLog( const ResponseLog& log ) ;
 	
 	std::size_t Write( const char *data, std::size_t count ) ;
 	std::size_t Read( char *data, std::size_t count ) ;
@@ -42,8 +45,14 @@ private :
 	static std::string Filename( const std::string& prefix, const std::string& suffix ) ;
 	
 private :
-	bool	m_enabled ;
-	std::ofstream	m_log ;
+	struct Sink
+	{
+		std::mutex		mutex ;
+		std::ofstream	log ;
+	} ;
+
+	bool					m_enabled ;
+	std::shared_ptr<Sink>	m_sink ;
 } ;
 
 } } // end of namespace
@@ -0,0 +1,550 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "JsonIndexParser.hh"
+
+#include "JsonParser.hh"
+#include "ValVisitor.hh"
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define JSON_INDEX_X86
+#include <immintrin.h>
+#endif
+
+namespace gr {
+
+namespace
+{
+	/// one bit for each of the 64 bytes of a block
+	struct Masks
+	{
+		uint64_t	quote ;
+		uint64_t	backslash ;
+		uint64_t	op ;
+		uint64_t	space ;
+	} ;
+
+	typedef void (*Classifier)( const char *block, Masks& m ) ;
+
+	enum CharClass { other_char, quote_char, backslash_char, op_char, space_char } ;
+
+	struct CharTable
+	{
+		unsigned char cls[256] ;
+
+		CharTable()
+		{
+			std::memset( cls, other_char, sizeof(cls) ) ;
+			cls[(unsigned char)'"']		= quote_char ;
+			cls[(unsigned char)'\\']	= backslash_char ;
+			const char *ops = "{}[]:," ;
+			for ( const char *c = ops ; *c != '\0' ; ++c )
+				cls[(unsigned char)*c]	= op_char ;
+			const char *spaces = " \t\n\r" ;
+			for ( const char *c = spaces ; *c != '\0' ; ++c )
+				cls[(unsigned char)*c]	= space_char ;
+		}
+	} ;
+
+	const CharTable char_table ;
+
+	void ClassifyScalar( const char *block, Masks& m )
+	{
+		m.quote = m.backslash = m.op = m.space = 0 ;
+		for ( int i = 0 ; i < 64 ; i++ )
+		{
+			uint64_t bit = 1ULL << i ;
+			switch ( char_table.cls[(unsigned char)block[i]] )
+			{
+			case quote_char :		m.quote		|= bit ; break ;
+			case backslash_char :	m.backslash	|= bit ; break ;
+			case op_char :			m.op		|= bit ; break ;
+			case space_char :		m.space		|= bit ; break ;
+			default :				break ;
+			}
+		}
+	}
+
+#ifdef JSON_INDEX_X86
+	__attribute__((target("sse2")))
+	void ClassifySse2( const char *block, Masks& m )
+	{
+		m.quote = m.backslash = m.op = m.space = 0 ;
+		for ( int i = 0 ; i < 64 ; i += 16 )
+		{
+			__m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( block + i ) ) ;
+
+			// '[' and ']' differ from '{' and '}' only in bit 0x20
+			__m128i lower = _mm_or_si128( v, _mm_set1_epi8( 0x20 ) ) ;
+			__m128i op = _mm_or_si128(
+				_mm_or_si128( _mm_cmpeq_epi8( lower, _mm_set1_epi8( '{' ) ), _mm_cmpeq_epi8( lower, _mm_set1_epi8( '}' ) ) ),
+				_mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ':' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( ',' ) ) ) ) ;
+			__m128i space = _mm_or_si128(
+				_mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( '\t' ) ) ),
+				_mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\n' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( '\r' ) ) ) ) ;
+
+			m.quote		|= (uint64_t)(uint16_t)_mm_movemask_epi8( _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) ) ) << i ;
+			m.backslash	|= (uint64_t)(uint16_t)_mm_movemask_epi8( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) ) ) << i ;
+			m.op		|= (uint64_t)(uint16_t)_mm_movemask_epi8( op ) << i ;
+			m.space		|= (uint64_t)(uint16_t)_mm_movemask_epi8( space ) << i ;
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void ClassifyAvx2( const char *block, Masks& m )
+	{
+		m.quote = m.backslash = m.op = m.space = 0 ;
+		for ( int i = 0 ; i < 64 ; i += 32 )
+		{
+			__m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( block + i ) ) ;
+
+			__m256i lower = _mm256_or_si256( v, _mm256_set1_epi8( 0x20 ) ) ;
+			__m256i op = _mm256_or_si256(
+				_mm256_or_si256( _mm256_cmpeq_epi8( lower, _mm256_set1_epi8( '{' ) ), _mm256_cmpeq_epi8( lower, _mm256_set1_epi8( '}' ) ) ),
+				_mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ':' ) ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ',' ) ) ) ) ;
+			__m256i space = _mm256_or_si256(
+				_mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ' ' ) ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\t' ) ) ),
+				_mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\n' ) ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\r' ) ) ) ) ;
+
+			m.quote		|= (uint64_t)(uint32_t)_mm256_movemask_epi8( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '"' ) ) ) << i ;
+			m.backslash	|= (uint64_t)(uint32_t)_mm256_movemask_epi8( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) ) ) << i ;
+			m.op		|= (uint64_t)(uint32_t)_mm256_movemask_epi8( op ) << i ;
+			m.space		|= (uint64_t)(uint32_t)_mm256_movemask_epi8( space ) << i ;
+		}
+	}
+#endif
+
+	/// The characters escaped by a backslash. \a carry is set if the block
+	/// ends with a backslash that escapes the first character of the next one.
+	uint64_t Escaped( uint64_t backslash, uint64_t& carry )
+	{
+		uint64_t escaped = carry ;
+		uint64_t b = backslash & ~carry ;
+		carry = 0 ;
+
+		// backslashes are rare, only look at each of them when there are some
+		while ( b != 0 )
+		{
+			int i = __builtin_ctzll( b ) ;
+			if ( i == 63 )
+			{
+				carry = 1 ;
+				break ;
+			}
+			escaped	|= 2ULL << i ;
+			b		&= ~( 3ULL << i ) ;
+		}
+		return escaped ;
+	}
+
+	/// bit i is the parity of the bits 0 to i, i.e. set inside strings
+	uint64_t PrefixXor( uint64_t x )
+	{
+		x ^= x << 1 ;
+		x ^= x << 2 ;
+		x ^= x << 4 ;
+		x ^= x << 8 ;
+		x ^= x << 16 ;
+		x ^= x << 32 ;
+		return x ;
+	}
+
+	bool IsDigit( char c )
+	{
+		return c >= '0' && c <= '9' ;
+	}
+
+	int HexValue( char c )
+	{
+		if ( c >= '0' && c <= '9' )
+			return c - '0' ;
+		else if ( c >= 'a' && c <= 'f' )
+			return c - 'a' + 10 ;
+		else if ( c >= 'A' && c <= 'F' )
+			return c - 'A' + 10 ;
+		return -1 ;
+	}
+
+	void AppendUtf8( std::string& out, unsigned long cp )
+	{
+		if ( cp < 0x80 )
+			out += static_cast<char>( cp ) ;
+		else if ( cp < 0x800 )
+		{
+			out += static_cast<char>( 0xC0 | ( cp >> 6 ) ) ;
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) ) ;
+		}
+		else if ( cp < 0x10000 )
+		{
+			out += static_cast<char>( 0xE0 | ( cp >> 12 ) ) ;
+			out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) ) ;
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) ) ;
+		}
+		else
+		{
+			out += static_cast<char>( 0xF0 | ( cp >> 18 ) ) ;
+			out += static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3F ) ) ;
+			out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) ) ;
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) ) ;
+		}
+	}
+
+	enum Expect { value, value_or_end, key, key_or_end, colon, comma_or_end, done } ;
+}
+
+JsonIndexParser::JsonIndexParser( ValVisitor *callback, Isa isa ) :
+	m_callback	( callback ),
+	m_isa		( isa ),
+	m_str		( 0 ),
+	m_size		( 0 )
+{
+}
+
+/// The best instruction set of this CPU for BuildIndex()
+JsonIndexParser::Isa JsonIndexParser::BestIsa()
+{
+#ifdef JSON_INDEX_X86
+	if ( __builtin_cpu_supports( "avx2" ) )
+		return avx2_isa ;
+	if ( __builtin_cpu_supports( "sse2" ) )
+		return sse2_isa ;
+#endif
+	return scalar_isa ;
+}
+
+/// Append to \a index the offsets of the brackets, colons and commas outside
+/// strings, of the opening quote of each string, of the first character
+/// of the numbers and literals, and of the stray backslashes.
+void JsonIndexParser::BuildIndex( const char *str, std::size_t size,
+	std::vector<uint32_t>& index, Isa isa )
+{
+	Classifier classify = ClassifyScalar ;
+#ifdef JSON_INDEX_X86
+	if ( isa == avx2_isa )
+		classify = ClassifyAvx2 ;
+	else if ( isa == sse2_isa )
+		classify = ClassifySse2 ;
+#endif
+
+	index.reserve( index.size() + size / 8 ) ;
+
+	// carried over from the last block
+	uint64_t escaped_carry = 0, in_string_carry = 0, other_carry = 0 ;
+
+	for ( std::size_t pos = 0 ; pos < size ; pos += 64 )
+	{
+		const char *block = str + pos ;
+
+		// the last block is padded with spaces
+		char tail[64] ;
+		if ( size - pos < 64 )
+		{
+			std::memset( tail, ' ', sizeof(tail) ) ;
+			std::memcpy( tail, block, size - pos ) ;
+			block = tail ;
+		}
+
+		Masks m ;
+		classify( block, m ) ;
+
+		uint64_t quote		= m.quote & ~Escaped( m.backslash, escaped_carry ) ;
+		uint64_t in_string	= PrefixXor( quote ) ^ in_string_carry ;
+		in_string_carry		= in_string >> 63 ? ~0ULL : 0 ;
+
+		// the opening quote is in the string, the closing one is not
+		uint64_t other		= ~( m.op | m.space | quote | in_string ) ;
+		uint64_t start		= other & ~( ( other << 1 ) | other_carry ) ;
+		other_carry			= other >> 63 ;
+
+		// a backslash outside of the strings is indexed to be refused
+		uint64_t structural = ( m.op & ~in_string ) | ( quote & in_string ) | start |
+			( m.backslash & ~in_string ) ;
+		while ( structural != 0 )
+		{
+			index.push_back( static_cast<uint32_t>( pos + __builtin_ctzll( structural ) ) ) ;
+			structural &= structural - 1 ;
+		}
+	}
+}
+
+void JsonIndexParser::Parse( const char *str, std::size_t size )
+{
+	if ( size > UINT32_MAX )
+		Fail( "document too large", 0 ) ;
+
+	m_str	= str ;
+	m_size	= size ;
+	m_index.clear() ;
+	BuildIndex( str, size, m_index, m_isa ) ;
+
+	// '{' or '[' of each open object and array
+	std::string stack ;
+	Expect expect = value ;
+
+	for ( std::vector<uint32_t>::const_iterator i = m_index.begin() ; i != m_index.end() ; ++i )
+	{
+		std::size_t pos = *i ;
+		char c = str[pos] ;
+		switch ( c )
+		{
+		case '{' :
+		case '[' :
+			if ( expect != value && expect != value_or_end )
+				Fail( "unallowed token", pos ) ;
+			stack += c ;
+			if ( c == '{' )
+			{
+				m_callback->StartObject() ;
+				expect = key_or_end ;
+			}
+			else
+			{
+				m_callback->StartArray() ;
+				expect = value_or_end ;
+			}
+			break ;
+
+		case '}' :
+		case ']' :
+			if ( stack.empty() || stack[stack.size()-1] != ( c == '}' ? '{' : '[' ) ||
+				!( expect == comma_or_end || expect == ( c == '}' ? key_or_end : value_or_end ) ) )
+				Fail( "unallowed token", pos ) ;
+			stack.resize( stack.size() - 1 ) ;
+			if ( c == '}' )
+				m_callback->EndObject() ;
+			else
+				m_callback->EndArray() ;
+			expect = stack.empty() ? done : comma_or_end ;
+			break ;
+
+		case ':' :
+			if ( expect != colon )
+				Fail( "unallowed token", pos ) ;
+			expect = value ;
+			break ;
+
+		case ',' :
+			if ( expect != comma_or_end )
+				Fail( "unallowed token", pos ) ;
+			expect = stack[stack.size()-1] == '{' ? key : value ;
+			break ;
+
+		case '"' :
+			String( pos + 1 ) ;
+			if ( expect == key || expect == key_or_end )
+			{
+				m_callback->VisitKey( m_buf ) ;
+				expect = colon ;
+			}
+			else if ( expect == value || expect == value_or_end )
+			{
+				m_callback->Visit( m_buf ) ;
+				expect = stack.empty() ? done : comma_or_end ;
+			}
+			else
+				Fail( "unallowed token", pos ) ;
+			break ;
+
+		case '\\' :
+			Fail( "invalid token", pos ) ;
+			break ;
+
+		default :
+			if ( expect != value && expect != value_or_end )
+				Fail( "unallowed token", pos ) ;
+			Scalar( pos ) ;
+			expect = stack.empty() ? done : comma_or_end ;
+			break ;
+		}
+	}
+
+	if ( expect != done )
+		Fail( "premature EOF", size ) ;
+}
+
+/// Unescape the string starting at \a pos into m_buf. Returns the offset of
+/// the closing quote.
+std::size_t JsonIndexParser::String( std::size_t pos )
+{
+	m_buf.clear() ;
+	while ( true )
+	{
+		std::size_t run = pos ;
+		while ( pos < m_size && m_str[pos] != '"' && m_str[pos] != '\\' &&
+			static_cast<unsigned char>( m_str[pos] ) >= 0x20 )
+			pos++ ;
+		m_buf.append( m_str + run, pos - run ) ;
+
+		if ( pos >= m_size )
+			Fail( "premature EOF in string", pos ) ;
+		else if ( m_str[pos] == '"' )
+			return pos ;
+		else if ( m_str[pos] != '\\' )
+			Fail( "invalid char in string", pos ) ;
+
+		if ( ++pos >= m_size )
+			Fail( "premature EOF in string", pos ) ;
+		switch ( m_str[pos] )
+		{
+		case '"' :	m_buf += '"' ;	break ;
+		case '\\' :	m_buf += '\\' ;	break ;
+		case '/' :	m_buf += '/' ;	break ;
+		case 'b' :	m_buf += '\b' ;	break ;
+		case 'f' :	m_buf += '\f' ;	break ;
+		case 'n' :	m_buf += '\n' ;	break ;
+		case 'r' :	m_buf += '\r' ;	break ;
+		case 't' :	m_buf += '\t' ;	break ;
+		case 'u' :
+		{
+			unsigned long cp = 0 ;
+			for ( int d = 0 ; d < 4 ; d++ )
+			{
+				int h = ++pos < m_size ? HexValue( m_str[pos] ) : -1 ;
+				if ( h < 0 )
+					Fail( "invalid hex character in unicode escape", pos ) ;
+				cp = cp * 16 + h ;
+			}
+
+			// a high surrogate must be followed by a low one, yajl writes
+			// '?' for them otherwise
+			if ( ( cp & 0xFC00 ) == 0xD800 )
+			{
+				unsigned long low = 0 ;
+				bool ok = pos + 6 < m_size && m_str[pos+1] == '\\' && m_str[pos+2] == 'u' ;
+				for ( int d = 0 ; ok && d < 4 ; d++ )
+				{
+					int h = HexValue( m_str[pos+3+d] ) ;
+					ok = h >= 0 ;
+					low = low * 16 + h ;
+				}
+				if ( ok && ( low & 0xFC00 ) == 0xDC00 )
+				{
+					cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( low - 0xDC00 ) ;
+					pos += 6 ;
+				}
+				else
+					cp = '?' ;
+			}
+			else if ( ( cp & 0xFC00 ) == 0xDC00 )
+				cp = '?' ;
+			AppendUtf8( m_buf, cp ) ;
+			break ;
+		}
+		default :
+			Fail( "inside a string, '\\' occurs before a character which it may not", pos ) ;
+		}
+		pos++ ;
+	}
+}
+
+/// A number, true, false or null at \a pos
+void JsonIndexParser::Scalar( std::size_t pos )
+{
+	std::size_t end = pos ;
+	while ( end < m_size && char_table.cls[(unsigned char)m_str[end]] == other_char )
+		end++ ;
+
+	const char *s = m_str + pos ;
+	std::size_t len = end - pos ;
+	if ( len == 4 && std::memcmp( s, "true", 4 ) == 0 )
+		m_callback->Visit( true ) ;
+	else if ( len == 5 && std::memcmp( s, "false", 5 ) == 0 )
+		m_callback->Visit( false ) ;
+	else if ( len == 4 && std::memcmp( s, "null", 4 ) == 0 )
+		m_callback->VisitNull() ;
+	else
+	{
+		// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+		std::size_t i = 0 ;
+		bool neg = i < len && s[i] == '-' ;
+		if ( neg )
+			i++ ;
+		if ( i < len && s[i] == '0' )
+			i++ ;
+		else if ( i < len && IsDigit( s[i] ) )
+			while ( i < len && IsDigit( s[i] ) )
+				i++ ;
+		else
+			Fail( "invalid token", pos ) ;
+		std::size_t int_end = i ;
+
+		if ( i < len && s[i] == '.' )
+		{
+			if ( ++i >= len || !IsDigit( s[i] ) )
+				Fail( "malformed number, a digit is required after the decimal point", pos ) ;
+			while ( i < len && IsDigit( s[i] ) )
+				i++ ;
+		}
+		if ( i < len && ( s[i] == 'e' || s[i] == 'E' ) )
+		{
+			if ( ++i < len && ( s[i] == '+' || s[i] == '-' ) )
+				i++ ;
+			if ( i >= len || !IsDigit( s[i] ) )
+				Fail( "malformed number, a digit is required after the exponent", pos ) ;
+			while ( i < len && IsDigit( s[i] ) )
+				i++ ;
+		}
+		if ( i != len )
+			Fail( "invalid token", pos ) ;
+
+		if ( int_end == len )
+		{
+			unsigned long long v = 0 ;
+			unsigned long long max = neg ? static_cast<unsigned long long>( LLONG_MAX ) + 1 : LLONG_MAX ;
+			for ( i = neg ? 1 : 0 ; i < len ; i++ )
+			{
+				unsigned d = s[i] - '0' ;
+				if ( v > ( max - d ) / 10 )
+					Fail( "integer overflow", pos ) ;
+				v = v * 10 + d ;
+			}
+			m_callback->Visit( neg ? static_cast<long long>( 0 - v ) : static_cast<long long>( v ) ) ;
+		}
+		else
+		{
+			std::string num( s, len ) ;
+			errno = 0 ;
+			double d = std::strtod( num.c_str(), 0 ) ;
+			if ( errno == ERANGE )
+				Fail( "numeric (floating point) overflow", pos ) ;
+			m_callback->Visit( d ) ;
+		}
+	}
+}
+
+void JsonIndexParser::Fail( const std::string& msg, std::size_t pos ) const
+{
+	std::size_t len = std::min<std::size_t>( m_size - std::min( pos, m_size ), 32 ) ;
+	BOOST_THROW_EXCEPTION(
+		JsonParser::Error()
+			<< JsonParser::ParseErr_( "parse error: " + msg + " at offset " +
+				boost::lexical_cast<std::string>( pos ) )
+			<< JsonParser::JsonText_( std::string( m_str != 0 ? m_str + std::min( pos, m_size ) : "", len ) )
+	) ;
+}
+
+} // end of namespace
@@ -0,0 +1,68 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace gr {
+
+class ValVisitor ;
+
+/// JSON parser for whole documents, the alternative to yajl. A first pass
+/// finds the position of every bracket, colon, comma, string and other value,
+/// 64 bytes at a time with SSE2 or AVX2 where the CPU has them. The second
+/// pass only looks at these positions to call the ValVisitor, the same way
+/// as yajl does. Errors throw JsonParser::Error.
+class JsonIndexParser
+{
+public :
+	enum Isa { scalar_isa, sse2_isa, avx2_isa } ;
+
+	explicit JsonIndexParser( ValVisitor *callback, Isa isa = BestIsa() ) ;
+
+	void Parse( const char *str, std::size_t size ) ;
+
+	static Isa BestIsa() ;
+	static void BuildIndex( const char *str, std::size_t size,
+		std::vector<uint32_t>& index, Isa isa = BestIsa() ) ;
+
+private :
+	std::size_t String( std::size_t pos ) ;
+	void Scalar( std::size_t pos ) ;
+	void Fail( const std::string& msg, std::size_t pos ) const ;
+
+private :
+	ValVisitor				*m_callback ;
+	Isa						m_isa ;
+	std::vector<uint32_t>	m_index ;
+
+	// the document being parsed
+	const char				*m_str ;
+	std::size_t				m_size ;
+
+	// the last string without its escapes
+	std::string				m_buf ;
+} ;
+
+} // end of namespace
@@ -20,11 +20,16 @@
 
 #include "JsonParser.hh"
 
+#include "JsonIndexParser.hh"
 #include "Val.hh"
 #include "ValBuilder.hh"
 
 #include <yajl/yajl_parse.h>
 
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
 namespace gr {
 
 namespace
@@ -112,6 +117,21 @@ namespace
 		StartArray,  
 		EndArray,  
 	};  
+
+	JsonParser::Backend ReadBackend()
+	{
+#ifdef JSON_INDEX_PARSER
+		JsonParser::Backend b = JsonParser::index_backend ;
+#else
+		JsonParser::Backend b = JsonParser::yajl_backend ;
+#endif
+		const char *env = ::getenv( "GR_JSON_PARSER" ) ;
+		if ( env != 0 && std::strcmp( env, "yajl" ) == 0 )
+			b = JsonParser::yajl_backend ;
+		else if ( env != 0 && std::strcmp( env, "index" ) == 0 )
+			b = JsonParser::index_backend ;
+		return b ;
+	}
 }
 
 Val ParseJson( const std::string& json )
@@ -136,22 +156,40 @@ struct JsonParser::Impl
 {
 	ValVisitor	*callback ;
 	yajl_handle	hand ;
+
+	// the document so far for the index parser
+	std::string	doc ;
 } ;
 
-JsonParser::JsonParser( ValVisitor *callback ) :
+JsonParser::JsonParser( ValVisitor *callback, Backend backend ) :
 	m_impl( new Impl )
 {
 	m_impl->callback	= callback ;
-	m_impl->hand		= yajl_alloc( &callbacks, 0, m_impl->callback ) ;
+	m_impl->hand		= backend == yajl_backend ? yajl_alloc( &callbacks, 0, m_impl->callback ) : 0 ;
 }
 
 JsonParser::~JsonParser()
 {
-	yajl_free( m_impl->hand ) ;
+	if ( m_impl->hand != 0 )
+		yajl_free( m_impl->hand ) ;
+}
+
+/// yajl unless grive was built with JSON_INDEX_PARSER. The environment
+/// variable GR_JSON_PARSER chooses the parser at run time: "yajl" or "index".
+JsonParser::Backend JsonParser::DefaultBackend()
+{
+	static const Backend backend = ReadBackend() ;
+	return backend ;
 }
 
 void JsonParser::Parse( const char *str, std::size_t size )
 {
+	if ( m_impl->hand == 0 )
+	{
+		m_impl->doc.append( str, size ) ;
+		return ;
+	}
+
 	const unsigned char *ustr = reinterpret_cast<unsigned const char*>(str) ;
 	
 	yajl_status r = yajl_parse( m_impl->hand, ustr, size ) ;
@@ -172,17 +210,26 @@ void JsonParser::Parse( const char *str, std::size_t size )
 
 void JsonParser::Parse( DataStream &in )
 {
-	char buf[1024] ;
+	// big reads, state files can have many megabytes
+	std::vector<char> buf( 64 * 1024 ) ;
 	std::size_t count = 0 ;
 
-	while ( (count = in.Read( buf, sizeof(buf) ) ) > 0 )
+	while ( (count = in.Read( &buf[0], buf.size() ) ) > 0 )
 	{
-		Parse( buf, count );
+		Parse( &buf[0], count );
 	}
 }
 
 void JsonParser::Finish()
 {
+	if ( m_impl->hand == 0 )
+	{
+		JsonIndexParser parser( m_impl->callback ) ;
+		parser.Parse( m_impl->doc.data(), m_impl->doc.size() ) ;
+		std::string().swap( m_impl->doc ) ;
+		return ;
+	}
+
 	if ( yajl_complete_parse(m_impl->hand) != yajl_status_ok )
 	{
 		unsigned char *msg = yajl_get_error( m_impl->hand, false, 0, 0 ) ;
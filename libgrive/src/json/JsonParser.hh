@@ -41,8 +41,13 @@ public :
 	typedef boost::error_info<struct ParseErr,	std::string> ParseErr_ ;
 	typedef boost::error_info<struct JsonText,	std::string> JsonText_ ;
 
-	explicit JsonParser( ValVisitor *callback ) ;
+	/// yajl, or JsonIndexParser on the whole document in Finish()
+	enum Backend { yajl_backend, index_backend } ;
+
+	explicit JsonParser( ValVisitor *callback, Backend backend = DefaultBackend() ) ;
 	~JsonParser() ;
+
+	static Backend DefaultBackend() ;
 	
 	void Parse( const char *str, std::size_t size ) ;
 	void Parse( DataStream &in ) ;
@@ -21,6 +21,7 @@
 #include "Val.hh"
 #include "JsonWriter.hh"
 #include "ValVisitor.hh"
+#include "util/MemStats.hh"
 #include "util/StdStream.hh"
 
 #include <iostream>
@@ -79,6 +80,42 @@ Val::TypeEnum Val::Type() const
 	return m_base->Type() ;
 }
 
+/// The heap taken by the value and everything in it, see MemStats
+std::size_t Val::MemUsage() const
+{
+	if ( m_base.get() == 0 )
+		return 0 ;
+
+	switch ( Type() )
+	{
+	case string_type :
+		return MemStats::Block( sizeof(Impl<std::string>) ) + MemStats::Heap( As<std::string>() ) ;
+
+	case array_type :
+	{
+		const Array& a = As<Array>() ;
+		std::size_t bytes = MemStats::Block( sizeof(Impl<Array>) ) + MemStats::Block( a.size() * sizeof(Val) ) ;
+		for ( Array::const_iterator i = a.begin() ; i != a.end() ; ++i )
+			bytes += i->MemUsage() ;
+		return bytes ;
+	}
+
+	case object_type :
+	{
+		const Object& o = As<Object>() ;
+		const std::size_t node = MemStats::Block( 32 + sizeof(Object::value_type) ) ;
+		std::size_t bytes = MemStats::Block( sizeof(Impl<Object>) ) ;
+		for ( Object::const_iterator i = o.begin() ; i != o.end() ; ++i )
+			bytes += node + MemStats::Heap( i->first ) + i->second.MemUsage() ;
+		return bytes ;
+	}
+
+	default :
+		// the numbers, booleans and null are about the same size
+		return MemStats::Block( sizeof(Impl<long long>) ) ;
+	}
+}
+
 const Val& Val::operator[]( const std::string& key ) const
 {
 	const Object& obj = As<Object>() ;
@@ -202,6 +239,21 @@ bool Val::Get( const std::string& key, Val& val ) const
 		return false ;
 }
 
+const Val* Val::Find( const std::string& key ) const
+{
+	if ( Type() != object_type )
+		return 0 ;
+
+	const Object& obj = As<Object>() ;
+	Object::const_iterator i = obj.find(key) ;
+	return i != obj.end() ? &i->second : 0 ;
+}
+
+Val* Val::Find( const std::string& key )
+{
+	return const_cast<Val*>( static_cast<const Val*>( this )->Find( key ) ) ;
+}
+
 void Val::Add( const std::string& key, const Val& value )
 {
 	As<Object>().insert( std::make_pair(key, value) ) ;
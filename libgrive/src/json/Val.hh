@@ -111,6 +111,10 @@ public :
 	Val& Item( const std::string& key ) ; // insert if not exists and get
 	bool Has( const std::string& key ) const ; // check if exists
 	bool Get( const std::string& key, Val& val ) const ; // get or return false
+	const Val* Find( const std::string& key ) const ; // get pointer or NULL, never throws
+	Val* Find( const std::string& key ) ;
+	template <typename T>
+	bool TryGet( const std::string& key, T& t ) const ; // copy if exists with this type
 	void Add( const std::string& key, const Val& val ) ; // insert or do nothing
 	void Set( const std::string& key, const Val& val ) ; // insert or update
 	bool Del( const std::string& key ); // delete or do nothing
@@ -123,6 +127,7 @@ public :
 	
 	friend std::ostream& operator<<( std::ostream& os, const Val& val ) ;
 	void Visit( ValVisitor *visitor ) const ;
+	std::size_t MemUsage() const ;
 
 private :
 	struct Base ;
@@ -225,6 +230,18 @@ bool Val::Is() const
 	return Type() == Type2Enum<T>::type ;
 }
 
+template <typename T>
+bool Val::TryGet( const std::string& key, T& t ) const
+{
+	typedef typename SupportType<T>::Type Type ;
+	const Val *val = Find( key ) ;
+	if ( val == 0 || !val->Is<Type>() )
+		return false ;
+
+	t = static_cast<T>( val->As<Type>() ) ;
+	return true ;
+}
+
 } // end of namespace
 
 namespace std
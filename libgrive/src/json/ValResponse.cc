@@ -25,7 +25,8 @@
 namespace gr { namespace http {
 
 ValResponse::ValResponse( ) :
-	m_parser( &m_val )
+	m_parser	( &m_val ),
+	m_finished	( false )
 {
 }
 
@@ -42,12 +43,21 @@ std::size_t ValResponse::Read( char *data, std::size_t count )
 
 Val ValResponse::Response() const
 {
+	if ( !m_finished )
+	{
+		m_finished = true ;
+		m_parser.Finish() ;
+	}
 	return m_val.Result() ;
 }
 
 void ValResponse::Finish()
 {
-	m_parser.Finish() ;
+	if ( !m_finished )
+	{
+		m_finished = true ;
+		m_parser.Finish() ;
+	}
 }
 
 } } // end of namespace gr::http
@@ -44,8 +44,11 @@ public :
 	Val Response() const ;
 	
 private :
-	ValBuilder	m_val ;
-	JsonParser	m_parser ;
+	ValBuilder			m_val ;
+
+	// the index parser only calls m_val when the response is complete
+	mutable JsonParser	m_parser ;
+	mutable bool		m_finished ;
 } ;
 
 } } // end of namespace gr::http
@@ -53,6 +53,15 @@ void AuthAgent::SetProgressReporter( Progress *progress )
 	m_agent->SetProgressReporter( progress );
 }
 
+/// The clone shares the OAuth2 token with this agent, but not the connection.
+std::unique_ptr<http::Agent> AuthAgent::Clone() const
+{
+	std::unique_ptr<http::Agent> real = m_agent->Clone() ;
+	std::unique_ptr<AuthAgent> agent( new AuthAgent( m_auth, real.get() ) ) ;
+	agent->m_own = std::move( real ) ;
+	return std::unique_ptr<http::Agent>( std::move( agent ) ) ;
+}
+
 void AuthAgent::SetUploadSpeed( unsigned kbytes )
 {
 	m_agent->SetUploadSpeed( kbytes );
@@ -63,10 +72,11 @@ void AuthAgent::SetDownloadSpeed( unsigned kbytes )
 	m_agent->SetDownloadSpeed( kbytes );
 }
 
-http::Header AuthAgent::AppendHeader( const http::Header& hdr ) const
+http::Header AuthAgent::AppendHeader( const http::Header& hdr )
 {
+	m_token = m_auth.AccessToken() ;
 	http::Header h(hdr) ;
-	h.Add( "Authorization: Bearer " + m_auth.AccessToken() ) ;
+	h.Add( "Authorization: Bearer " + m_token ) ;
 	h.Add( "GData-Version: 3.0" ) ;
 	return h ;
 }
@@ -146,7 +156,7 @@ bool AuthAgent::CheckRetry( long response )
 			response, m_agent->LastError(), log::warning ) ;
 			
 		os::Sleep( 5 ) ;
-		m_auth.Refresh() ;
+		m_auth.Refresh( m_token ) ;
 		return true ;
 	}
 	else
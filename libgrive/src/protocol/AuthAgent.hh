@@ -59,9 +59,10 @@ public :
 	void SetDownloadSpeed( unsigned kbytes ) ;
 
 	void SetProgressReporter( Progress *progress ) ;
+	std::unique_ptr<http::Agent> Clone() const ;
 
 private :
-	http::Header AppendHeader( const http::Header& hdr ) const ;
+	http::Header AppendHeader( const http::Header& hdr ) ;
 	bool CheckRetry( long response ) ;
 	long CheckHttpResponse(
 		long 				response,
@@ -72,6 +73,12 @@ private :
 	OAuth2&		m_auth ;
 	http::Agent*	m_agent ;
 	int		m_interval ;
+
+	// the access token sent with the last request
+	std::string	m_token ;
+
+	// set if m_agent is a clone owned by this agent
+	std::unique_ptr<http::Agent>	m_own ;
 } ;
 
 } // end of namespace
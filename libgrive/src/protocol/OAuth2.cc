@@ -39,11 +39,17 @@ OAuth2::OAuth2(
 	const std::string& client_secret,
 	const std::string& redirect_uri ) :
 	m_refresh( refresh_code ),
-	m_agent( agent ),
+	m_own( agent->Clone() ),
 	m_client_id( client_id ),
 	m_client_secret( client_secret ),
 	m_redirect_uri ( redirect_uri )
 {
+	// the token is refreshed by whichever thread gets a 401, while the other
+	// threads may be in a request on \a agent. so it gets a connection of
+	// its own, which logs to the same file
+	m_agent = m_own.get() ;
+	if ( agent->GetLog() != 0 )
+		m_own->SetLog( new http::ResponseLog( *agent->GetLog() ) ) ;
 	Refresh( ) ;
 }
 
@@ -96,6 +102,18 @@ std::string OAuth2::MakeAuthURL()
 
 void OAuth2::Refresh( )
 {
+	Refresh( std::string() ) ;
+}
+
+/// Refresh the token after a request sent with the access token \a stale
+/// failed. Nothing is done if another thread has already refreshed it since,
+/// so that the workers which all get a 401 at once only refresh it once.
+void OAuth2::Refresh( const std::string& stale )
+{
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	if ( !stale.empty() && stale != m_access )
+		return ;
+
 	std::string post =
 		"refresh_token="	+ m_refresh +
 		"&client_id="		+ m_client_id +
@@ -123,11 +141,13 @@ std::string OAuth2::RefreshToken( ) const
 
 std::string OAuth2::AccessToken( ) const
 {
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
 	return m_access ;
 }
 
 std::string OAuth2::HttpHeader( ) const
 {
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
 	return "Authorization: Bearer " + m_access ;
 }
 
@@ -23,6 +23,7 @@
 #include "util/Exception.hh"
 #include <string>
 #include <memory>
+#include <mutex>
 
 namespace gr {
 
@@ -50,6 +51,7 @@ public :
 
 	void Auth( const std::string& auth_code ) ;
 	void Refresh( ) ;
+	void Refresh( const std::string& stale ) ;
 
 	std::string RefreshToken( ) const ;
 	std::string AccessToken( ) const ;
@@ -61,10 +63,16 @@ private :
 	std::string m_access ;
 	std::string m_refresh ;
 	http::Agent* m_agent ;
+
+	// the connection used to refresh the token, see OAuth2()
+	std::unique_ptr<http::Agent> m_own ;
 	
 	const std::string	m_client_id ;
 	const std::string	m_client_secret ;
 	const std::string	m_redirect_uri ;
+
+	// the token is shared by the agents of all threads
+	mutable std::mutex	m_mutex ;
 } ;
 
 } // end of namespace
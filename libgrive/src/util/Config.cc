@@ -37,6 +37,39 @@ const std::string default_filename     = ".grive";
 const std::string default_root_folder  = ".";
 const std::string default_redirect_uri = "http://localhost:9898" ;
 
+namespace
+{
+	/// The paths in \a filename, one per line, or in the standard input
+	/// if it is "-". Blank lines are skipped.
+	Val ReadPaths( const std::string& filename )
+	{
+		std::string text ;
+		if ( filename == "-" )
+			text.assign( std::istreambuf_iterator<char>( std::cin ), std::istreambuf_iterator<char>() ) ;
+		else
+		{
+			gr::File file( filename ) ;
+			char buf[4096] ;
+			std::size_t count ;
+			while ( ( count = file.Read( buf, sizeof(buf) ) ) > 0 )
+				text.append( buf, count ) ;
+		}
+
+		Val paths( Val::array_type ) ;
+		std::size_t start = 0 ;
+		while ( start < text.size() )
+		{
+			std::size_t end = text.find( '\n', start ) ;
+			if ( end == std::string::npos )
+				end = text.size() ;
+			if ( end > start )
+				paths.Add( Val( text.substr( start, end - start ) ) ) ;
+			start = end + 1 ;
+		}
+		return paths ;
+	}
+}
+
 Config::Config( const po::variables_map& vm )
 {
 	if ( vm.count( "id" ) > 0 )
@@ -56,6 +89,33 @@ Config::Config( const po::variables_map& vm )
 	m_cmd.Add( "no-remote-new", Val( vm.count( "no-remote-new" ) > 0 || vm.count( "upload-only" ) > 0 ) );
 	m_cmd.Add( "upload-only", Val( vm.count( "upload-only" ) > 0 ) );
 	m_cmd.Add( "no-delete-remote", Val( vm.count( "no-delete-remote" ) > 0 ) );
+	if ( vm.count( "memory-limit" ) > 0 )
+		m_cmd.Add( "memory-limit",	Val( vm["memory-limit"].as<unsigned>() ) );
+	if ( vm.count( "state-depth" ) > 0 )
+		m_cmd.Add( "state-depth",	Val( vm["state-depth"].as<unsigned>() ) );
+	if ( vm.count( "list-threads" ) > 0 )
+		m_cmd.Add( "list-threads",	Val( vm["list-threads"].as<unsigned>() ) );
+	if ( vm.count( "no-hash" ) > 0 )
+		m_cmd.Add( "no-hash",	Val( true ) );
+	if ( vm.count( "verify-threads" ) > 0 )
+		m_cmd.Add( "verify-threads",	Val( vm["verify-threads"].as<unsigned>() ) );
+	if ( vm.count( "verify-rate" ) > 0 )
+		m_cmd.Add( "verify-rate",	Val( vm["verify-rate"].as<unsigned>() ) );
+	if ( vm.count( "bulk-threads" ) > 0 )
+		m_cmd.Add( "bulk-threads",	Val( vm["bulk-threads"].as<unsigned>() ) );
+	if ( vm.count( "api" ) > 0 )
+		m_cmd.Add( "api",	Val( vm["api"].as<std::string>() ) );
+	m_cmd.Add( "dry-run",	Val( vm.count( "dry-run" ) > 0 ) );
+	if ( vm.count( "paths-from" ) > 0 )
+		m_cmd.Add( "paths",	ReadPaths( vm["paths-from"].as<std::string>() ) );
+	if ( vm.count( "settle-time" ) > 0 )
+		m_cmd.Add( "settle-time",	Val( vm["settle-time"].as<unsigned>() ) );
+	if ( vm.count( "watch-address" ) > 0 )
+		m_cmd.Add( "watch-address",	Val( vm["watch-address"].as<std::string>() ) );
+	if ( vm.count( "watch-bind" ) > 0 )
+		m_cmd.Add( "watch-bind",	Val( vm["watch-bind"].as<std::string>() ) );
+	if ( vm.count( "watch-port" ) > 0 )
+		m_cmd.Add( "watch-port",	Val( vm["watch-port"].as<unsigned>() ) );
 	
 	m_path	= GetPath( fs::path(m_cmd["path"].Str()) ) ;
 	m_file	= Read( ) ;
@@ -69,6 +129,17 @@ Config::Config( const po::variables_map& vm )
 	}
 }
 
+/// Config of one root of --roots. The command line options of \a cmd apply
+/// to all roots, but each root has its own path and config file.
+/// \param	file	config file, relative to \a root. Empty for the default.
+Config::Config( const Config& cmd, const fs::path& root, const fs::path& file ) :
+	m_path	( file.empty() ? GetPath( root ) : root / file ),
+	m_cmd	( cmd.m_cmd )
+{
+	m_cmd.Set( "path", Val( root.string() ) ) ;
+	m_file	= Read( ) ;
+}
+
 fs::path Config::GetPath( const fs::path& root_path )
 {
 	// config file will be (in order of preference)
@@ -98,7 +169,8 @@ void Config::Set( const std::string& key, const Val& value )
 
 Val Config::Get( const std::string& key ) const
 {
-	return m_cmd.Has(key) ? m_cmd[key] : m_file[key] ;
+	const Val *cmd = m_cmd.Find( key ) ;
+	return cmd != 0 ? *cmd : m_file[key] ;
 }
 
 Val Config::GetAll() const
@@ -114,6 +186,10 @@ Val Config::GetAll() const
 
 Val Config::Read()
 {
+	// no config file before the first "grive -a"
+	if ( !fs::exists( m_path ) )
+		return Val() ;
+
 	try
 	{
 		gr::File file(m_path) ;
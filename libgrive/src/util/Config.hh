@@ -40,6 +40,7 @@ public :
 	typedef boost::error_info<struct FileTag, std::string>	File ;
 
 	Config( const boost::program_options::variables_map& vm ) ;
+	Config( const Config& cmd, const fs::path& root, const fs::path& file ) ;
 
 	const fs::path Filename() const ;
 	
@@ -21,19 +21,103 @@
 
 #include "File.hh"
 #include "Exception.hh"
+#include "IoUring.hh"
 #include "MemMap.hh"
-
-#include <iomanip>
+#include "PageCache.hh"
 
 // dependent libraries
 #include <gcrypt.h>
+#include <boost/bind.hpp>
 #include <boost/throw_exception.hpp>
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
 namespace gr { namespace crypt {
 
 // map 4MB of data at a time
 const u64_t read_size = 1024 * 4096 ;
 
+// the primes of XXH64
+const u64_t prime1 = 0x9E3779B185EBCA87ULL ;
+const u64_t prime2 = 0xC2B2AE3D27D4EB4FULL ;
+const u64_t prime3 = 0x165667B19E3779F9ULL ;
+const u64_t prime4 = 0x85EBCA77C2B2AE63ULL ;
+const u64_t prime5 = 0x27D4EB2F165667C5ULL ;
+
+namespace
+{
+	inline u64_t Rotl( u64_t x, int r )
+	{
+		return ( x << r ) | ( x >> ( 64 - r ) ) ;
+	}
+
+	// little endian, whatever the host, so that the state can be moved
+	inline u64_t Load64( const unsigned char *p )
+	{
+		u64_t v ;
+		std::memcpy( &v, p, sizeof(v) ) ;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		v = __builtin_bswap64( v ) ;
+#endif
+		return v ;
+	}
+
+	inline u64_t Load32( const unsigned char *p )
+	{
+		return (u64_t)p[0] | (u64_t)p[1] << 8 | (u64_t)p[2] << 16 | (u64_t)p[3] << 24 ;
+	}
+
+	inline u64_t Round( u64_t acc, u64_t input )
+	{
+		return Rotl( acc + input * prime2, 31 ) * prime1 ;
+	}
+
+	inline u64_t Merge( u64_t acc, u64_t v )
+	{
+		return ( acc ^ Round( 0, v ) ) * prime1 + prime4 ;
+	}
+
+	void WriteBoth( MD5 *md5, Fingerprint *fp, const char *data, std::size_t size )
+	{
+		md5->Write( data, size ) ;
+		fp->Write( data, size ) ;
+	}
+}
+
+/// Pass the whole content of \a file to \a reader, in chunks of up to 4MB,
+/// in the fastest way this build and the options allow.
+void ReadAll( File& file, const Reader& reader )
+{
+	u64_t size = file.Size() ;
+	if ( PageCache::Instance().Enabled() )
+	{
+		PageCache::Instance().ReadAll( file.Fd(), size, reader ) ;
+		return ;
+	}
+
+	// read with all buffers in flight if io_uring is available. the chunks
+	// it has handed to reader before a failed read must not be passed again
+	u64_t done = IoUring::Instance().ReadAll( file.Fd(), size, reader ) ;
+	if ( done < size )
+		ReadFrom( file, done, reader ) ;
+}
+
+/// Pass the content of \a file after the first \a offset bytes to \a reader,
+/// with plain memory mapped reads.
+void ReadFrom( File& file, u64_t offset, const Reader& reader )
+{
+	// mappings must start on a page boundary
+	u64_t size = file.Size() ;
+	for ( u64_t i = offset - offset % read_size ; i < size ; i += read_size )
+	{
+		MemMap map( file, i, static_cast<std::size_t>(std::min(read_size, size-i)) ) ;
+		std::size_t skip = static_cast<std::size_t>( i < offset ? offset - i : 0 ) ;
+		reader( static_cast<const char*>( map.Addr() ) + skip, map.Length() - skip ) ;
+	}
+}
+
 struct MD5::Impl
 {
 	gcry_md_hd_t hd ;
@@ -61,44 +145,127 @@ void MD5::Write( const void *data, std::size_t size )
 	::gcry_md_write( m_impl->hd, data, size ) ;
 }
 
-std::string MD5::Get() const
+Digest MD5::Get() const
 {
-	unsigned char *md5 = ::gcry_md_read( m_impl->hd, GCRY_MD_MD5 ) ;
-	unsigned int  len  = ::gcry_md_get_algo_dlen(GCRY_MD_MD5) ;
-	
-	// format the MD5 string
-	std::ostringstream ss ;
-	for ( unsigned int i = 0 ; i < len ; i++ )
-		ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(md5[i]) ;
-
-	return ss.str() ;
+	return Digest( ::gcry_md_read( m_impl->hd, GCRY_MD_MD5 ) ) ;
 }
 
-std::string MD5::Get( const fs::path& file )
+/// The checksum of \a file, empty if it can't be read. The fingerprint of the
+/// same content is computed in the same pass if \a fp is given.
+Digest MD5::Get( const fs::path& file, Fingerprint *fp )
 {
 	try
 	{
 		File sfile( file ) ;
-		return Get( sfile ) ;
+		return Get( sfile, fp ) ;
 	}
 	catch ( File::Error& )
 	{
-		return "" ;
+		return Digest() ;
 	}
 }
 
-std::string MD5::Get( File& file )
+Digest MD5::Get( File& file, Fingerprint *fp )
 {
 	MD5 crypt ;
-	
-	u64_t size = file.Size() ;
-	for ( u64_t i = 0 ; i < size ; i += read_size )
+	if ( fp != 0 )
+		ReadAll( file, boost::bind( &WriteBoth, &crypt, fp, _1, _2 ) ) ;
+	else
+		ReadAll( file, boost::bind( &MD5::Write, &crypt, _1, _2 ) ) ;
+	return crypt.Get() ;
+}
+
+Fingerprint::Fingerprint() :
+	m_total	( 0 ),
+	m_len	( 0 )
+{
+	m_acc[0] = prime1 + prime2 ;
+	m_acc[1] = prime2 ;
+	m_acc[2] = 0 ;
+	m_acc[3] = 0 - prime1 ;
+}
+
+u64_t Fingerprint::Get( File& file )
+{
+	Fingerprint fp ;
+	ReadAll( file, boost::bind( &Fingerprint::Write, &fp, _1, _2 ) ) ;
+	return fp.Get() ;
+}
+
+void Fingerprint::Stripe( const unsigned char *p )
+{
+	for ( int i = 0 ; i < 4 ; i++ )
+		m_acc[i] = Round( m_acc[i], Load64( p + i * 8 ) ) ;
+}
+
+void Fingerprint::Write( const void *data, std::size_t size )
+{
+	const unsigned char *p = static_cast<const unsigned char*>( data ) ;
+	m_total += size ;
+
+	// complete the stripe left by the last write first
+	if ( m_len > 0 )
 	{
-		MemMap map( file, i, static_cast<std::size_t>(std::min(read_size, size-i)) ) ;
-		crypt.Write( map.Addr(), map.Length() ) ;
+		std::size_t n = std::min( size, sizeof(m_buf) - m_len ) ;
+		std::memcpy( m_buf + m_len, p, n ) ;
+		m_len	+= n ;
+		p		+= n ;
+		size	-= n ;
+		if ( m_len < sizeof(m_buf) )
+			return ;
+		Stripe( m_buf ) ;
+		m_len = 0 ;
 	}
 
-	return crypt.Get() ;
+	for ( ; size >= sizeof(m_buf) ; p += sizeof(m_buf), size -= sizeof(m_buf) )
+		Stripe( p ) ;
+
+	std::memcpy( m_buf, p, size ) ;
+	m_len = size ;
+}
+
+u64_t Fingerprint::Get() const
+{
+	u64_t h ;
+	if ( m_total >= sizeof(m_buf) )
+	{
+		h = Rotl( m_acc[0], 1 ) + Rotl( m_acc[1], 7 ) + Rotl( m_acc[2], 12 ) + Rotl( m_acc[3], 18 ) ;
+		for ( int i = 0 ; i < 4 ; i++ )
+			h = Merge( h, m_acc[i] ) ;
+	}
+	else
+		h = prime5 ;
+	h += m_total ;
+
+	const unsigned char *p = m_buf, *end = m_buf + m_len ;
+	for ( ; p + 8 <= end ; p += 8 )
+		h = Rotl( h ^ Round( 0, Load64( p ) ), 27 ) * prime1 + prime4 ;
+	if ( p + 4 <= end )
+	{
+		h = Rotl( h ^ ( Load32( p ) * prime1 ), 23 ) * prime2 + prime3 ;
+		p += 4 ;
+	}
+	for ( ; p < end ; p++ )
+		h = Rotl( h ^ ( *p * prime5 ), 11 ) * prime1 ;
+
+	h ^= h >> 33 ;
+	h *= prime2 ;
+	h ^= h >> 29 ;
+	h *= prime3 ;
+	h ^= h >> 32 ;
+	return h ;
+}
+
+std::string Fingerprint::Hex( u64_t fp )
+{
+	char hex[17] ;
+	std::snprintf( hex, sizeof(hex), "%016llx", static_cast<unsigned long long>( fp ) ) ;
+	return hex ;
+}
+
+u64_t Fingerprint::FromHex( const std::string& hex )
+{
+	return std::strtoull( hex.c_str(), 0, 16 ) ;
 }
 
 } } // end of namespaces
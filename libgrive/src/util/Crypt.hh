@@ -19,12 +19,15 @@
 
 #pragma once
 
+#include "util/Digest.hh"
 #include "util/Exception.hh"
+#include "util/Types.hh"
 
 #include <string>
 #include <memory>
 
 #include <boost/filesystem.hpp>
+#include <boost/function.hpp>
 
 namespace gr {
 
@@ -32,6 +35,12 @@ class File ;
 
 namespace crypt {
 
+class Fingerprint ;
+
+typedef boost::function<void ( const char*, std::size_t )> Reader ;
+void ReadAll( File& file, const Reader& reader ) ;
+void ReadFrom( File& file, u64_t offset, const Reader& reader ) ;
+
 class MD5
 {
 public :
@@ -42,15 +51,41 @@ public :
 	MD5() ;
 	~MD5() ;
 
-	static std::string Get( File& file ) ;
-	static std::string Get( const boost::filesystem::path& file ) ;
+	static Digest Get( File& file, Fingerprint *fp = 0 ) ;
+	static Digest Get( const boost::filesystem::path& file, Fingerprint *fp = 0 ) ;
 	
 	void Write( const void *data, std::size_t size ) ;
-	std::string Get() const ;
+	Digest Get() const ;
 
 private :
 	struct Impl ;
 	std::unique_ptr<Impl>	m_impl ;
 } ;
 
+/// A fast 64-bit checksum (XXH64) of the content of a local file. It tells
+/// whether a file changed since the last sync several times faster than its
+/// MD5, but unlike the MD5 it is never compared with Google Drive.
+class Fingerprint
+{
+public :
+	Fingerprint() ;
+
+	static u64_t Get( File& file ) ;
+
+	void Write( const void *data, std::size_t size ) ;
+	u64_t Get() const ;
+
+	static std::string Hex( u64_t fp ) ;
+	static u64_t FromHex( const std::string& hex ) ;
+
+private :
+	void Stripe( const unsigned char *p ) ;
+
+private :
+	u64_t			m_acc[4] ;
+	u64_t			m_total ;
+	unsigned char	m_buf[32] ;
+	std::size_t		m_len ;
+} ;
+
 } } // end of namespace gr
@@ -0,0 +1,180 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Digest.hh"
+
+#include <cstring>
+#include <ostream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace gr {
+
+#ifndef __SSE2__
+namespace
+{
+	const char hex_digits[] = "0123456789abcdef" ;
+
+	/// value of a hex digit, or -1
+	int HexValue( char c )
+	{
+		if ( c >= '0' && c <= '9' )
+			return c - '0' ;
+		c |= 0x20 ;
+		if ( c >= 'a' && c <= 'f' )
+			return c - 'a' + 10 ;
+		return -1 ;
+	}
+}
+#endif
+
+Digest::Digest( )
+{
+	std::memset( m_bytes, 0, size ) ;
+}
+
+Digest::Digest( const unsigned char *bytes )
+{
+	std::memcpy( m_bytes, bytes, size ) ;
+}
+
+/// Parse 32 hex digits, in either case. Anything else gives an empty Digest.
+Digest Digest::FromHex( const std::string& hex )
+{
+	Digest d ;
+	if ( hex.size() != 2 * size )
+		return d ;
+
+#ifdef __SSE2__
+	const __m128i *src = reinterpret_cast<const __m128i*>( hex.data() ) ;
+	__m128i out[2] ;
+	int bad = 0 ;
+	for ( int i = 0 ; i < 2 ; i++ )
+	{
+		__m128i c = _mm_loadu_si128( src + i ) ;
+
+		// digits are 0x30-0x39, letters 0x61-0x66 after setting the lower case
+		// bit. signed compares are fine, as all of them are below 0x80
+		__m128i lower	= _mm_or_si128( c, _mm_set1_epi8( 0x20 ) ) ;
+		__m128i digit	= _mm_and_si128( _mm_cmpgt_epi8( c, _mm_set1_epi8( '0' - 1 ) ),
+			_mm_cmplt_epi8( c, _mm_set1_epi8( '9' + 1 ) ) ) ;
+		__m128i letter	= _mm_and_si128( _mm_cmpgt_epi8( lower, _mm_set1_epi8( 'a' - 1 ) ),
+			_mm_cmplt_epi8( lower, _mm_set1_epi8( 'f' + 1 ) ) ) ;
+		bad |= _mm_movemask_epi8( _mm_or_si128( digit, letter ) ) ^ 0xFFFF ;
+
+		__m128i val = _mm_or_si128(
+			_mm_and_si128( digit, _mm_sub_epi8( c, _mm_set1_epi8( '0' ) ) ),
+			_mm_and_si128( letter, _mm_sub_epi8( lower, _mm_set1_epi8( 'a' - 10 ) ) ) ) ;
+
+		// two digits in each 16 bit lane, the first one in the low byte
+		out[i] = _mm_or_si128(
+			_mm_and_si128( _mm_slli_epi16( val, 4 ), _mm_set1_epi16( 0xF0 ) ),
+			_mm_srli_epi16( val, 8 ) ) ;
+	}
+	if ( bad != 0 )
+		return d ;
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( d.m_bytes ), _mm_packus_epi16( out[0], out[1] ) ) ;
+#else
+	for ( std::size_t i = 0 ; i < size ; i++ )
+	{
+		int hi = HexValue( hex[2*i] ), lo = HexValue( hex[2*i+1] ) ;
+		if ( hi < 0 || lo < 0 )
+			return Digest() ;
+		d.m_bytes[i] = static_cast<unsigned char>( hi << 4 | lo ) ;
+	}
+#endif
+	return d ;
+}
+
+/// 32 lower case hex digits, as Google Drive and the state file have them.
+/// Empty for an empty Digest.
+std::string Digest::Hex() const
+{
+	if ( Empty() )
+		return std::string() ;
+
+	char hex[2 * size] ;
+#ifdef __SSE2__
+	__m128i v	= _mm_loadu_si128( reinterpret_cast<const __m128i*>( m_bytes ) ) ;
+	__m128i mask = _mm_set1_epi8( 0x0F ) ;
+	__m128i hi	= _mm_and_si128( _mm_srli_epi16( v, 4 ), mask ) ;
+	__m128i lo	= _mm_and_si128( v, mask ) ;
+
+	// the high digit of each byte first
+	__m128i nib[2] = { _mm_unpacklo_epi8( hi, lo ), _mm_unpackhi_epi8( hi, lo ) } ;
+	for ( int i = 0 ; i < 2 ; i++ )
+	{
+		__m128i letter	= _mm_cmpgt_epi8( nib[i], _mm_set1_epi8( 9 ) ) ;
+		__m128i c		= _mm_add_epi8( _mm_add_epi8( nib[i], _mm_set1_epi8( '0' ) ),
+			_mm_and_si128( letter, _mm_set1_epi8( 'a' - '0' - 10 ) ) ) ;
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( hex + 16 * i ), c ) ;
+	}
+#else
+	for ( std::size_t i = 0 ; i < size ; i++ )
+	{
+		hex[2*i]	= hex_digits[m_bytes[i] >> 4] ;
+		hex[2*i+1]	= hex_digits[m_bytes[i] & 0x0F] ;
+	}
+#endif
+	return std::string( hex, sizeof(hex) ) ;
+}
+
+bool Digest::Empty() const
+{
+	static const unsigned char zero[size] = {} ;
+	return std::memcmp( m_bytes, zero, size ) == 0 ;
+}
+
+const unsigned char* Digest::Bytes() const
+{
+	return m_bytes ;
+}
+
+bool Digest::operator==( const Digest& d ) const
+{
+	return std::memcmp( m_bytes, d.m_bytes, size ) == 0 ;
+}
+
+bool Digest::operator!=( const Digest& d ) const
+{
+	return !( *this == d ) ;
+}
+
+bool Digest::operator<( const Digest& d ) const
+{
+	return std::memcmp( m_bytes, d.m_bytes, size ) < 0 ;
+}
+
+/// for the hashed indices of boost::multi_index. The bytes of an MD5 are
+/// already evenly distributed, so the first of them are hash enough.
+std::size_t hash_value( const Digest& d )
+{
+	std::size_t h ;
+	std::memcpy( &h, d.Bytes(), sizeof(h) ) ;
+	return h ;
+}
+
+std::ostream& operator<<( std::ostream& os, const Digest& d )
+{
+	return os << d.Hex() ;
+}
+
+} // end of namespace
@@ -0,0 +1,56 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+namespace gr {
+
+/// An MD5 checksum in its 16 bytes. The hex string is only made where the
+/// checksum is read or written as text, e.g. JSON. A default constructed
+/// Digest, all zeros, means no checksum.
+class Digest
+{
+public :
+	static const std::size_t size = 16 ;
+
+	Digest( ) ;
+	explicit Digest( const unsigned char *bytes ) ;
+
+	static Digest FromHex( const std::string& hex ) ;
+	std::string Hex() const ;
+
+	bool Empty() const ;
+	const unsigned char* Bytes() const ;
+
+	bool operator==( const Digest& d ) const ;
+	bool operator!=( const Digest& d ) const ;
+	bool operator<( const Digest& d ) const ;
+
+private :
+	unsigned char	m_bytes[size] ;
+} ;
+
+std::size_t hash_value( const Digest& d ) ;
+std::ostream& operator<<( std::ostream& os, const Digest& d ) ;
+
+} // end of namespace
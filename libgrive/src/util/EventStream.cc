@@ -0,0 +1,151 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "EventStream.hh"
+
+#include "json/JsonWriter.hh"
+#include "json/Val.hh"
+#include "log/Log.hh"
+
+#include <boost/exception/errinfo_api_function.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace gr {
+
+EventStream& EventStream::Instance()
+{
+	static EventStream inst ;
+	return inst ;
+}
+
+EventStream::EventStream() :
+	m_fd		( -1 ),
+	m_socket	( false )
+{
+}
+
+EventStream::~EventStream()
+{
+	Close() ;
+}
+
+/// Write the events to \a path from now on. Opening a FIFO waits for a
+/// reader.
+void EventStream::Open( const std::string& path )
+{
+	Close() ;
+
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	struct stat st ;
+	if ( ::stat( path.c_str(), &st ) == 0 && S_ISSOCK( st.st_mode ) )
+	{
+		struct sockaddr_un addr ;
+		std::memset( &addr, 0, sizeof(addr) ) ;
+		addr.sun_family = AF_UNIX ;
+		std::strncpy( addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1 ) ;
+
+		int fd = ::socket( AF_UNIX, SOCK_STREAM, 0 ) ;
+		if ( fd != -1 && ::connect( fd, reinterpret_cast<struct sockaddr*>( &addr ), sizeof(addr) ) != 0 )
+		{
+			int err = errno ;
+			::close( fd ) ;
+			fd = -1 ;
+			errno = err ;
+		}
+		if ( fd == -1 )
+		{
+			BOOST_THROW_EXCEPTION(
+				Error()
+					<< boost::errinfo_api_function( "connect" )
+					<< boost::errinfo_errno( errno )
+					<< boost::errinfo_file_name( path )
+			) ;
+		}
+		m_fd		= fd ;
+		m_socket	= true ;
+		return ;
+	}
+
+	m_fd = ::open( path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644 ) ;
+	if ( m_fd == -1 )
+	{
+		BOOST_THROW_EXCEPTION(
+			Error()
+				<< boost::errinfo_api_function( "open" )
+				<< boost::errinfo_errno( errno )
+				<< boost::errinfo_file_name( path )
+		) ;
+	}
+
+	// a reader of the FIFO that goes away must not kill grive
+	if ( ::fstat( m_fd, &st ) == 0 && S_ISFIFO( st.st_mode ) )
+		::signal( SIGPIPE, SIG_IGN ) ;
+	m_socket = false ;
+}
+
+void EventStream::Close()
+{
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	if ( m_fd != -1 )
+		::close( m_fd ) ;
+	m_fd = -1 ;
+}
+
+bool EventStream::Enabled() const
+{
+	return m_fd != -1 ;
+}
+
+/// Write \a event as one line. If the reader is gone, a warning is logged and
+/// no more events are written.
+void EventStream::Write( const Val& event )
+{
+	std::string line = WriteJson( event ) + "\n" ;
+
+	// one line at a time, so that the lines of different threads don't mix
+	std::lock_guard<std::mutex> lock( m_mutex ) ;
+	for ( std::size_t done = 0 ; m_fd != -1 && done < line.size() ; )
+	{
+		ssize_t r = m_socket ?
+			::send( m_fd, line.data() + done, line.size() - done, MSG_NOSIGNAL ) :
+			::write( m_fd, line.data() + done, line.size() - done ) ;
+		if ( r >= 0 )
+			done += r ;
+		else if ( errno != EINTR )
+		{
+			Log( "cannot write events: %1%. not writing any more", std::strerror( errno ), log::warning ) ;
+			::close( m_fd ) ;
+			m_fd = -1 ;
+		}
+	}
+}
+
+} // end of namespace
@@ -0,0 +1,66 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "Exception.hh"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace gr {
+
+class Val ;
+
+/*!	\brief	JSON lines for the changes made by a sync
+
+	Disabled by default. Once opened ("--events"), one JSON object is written
+	per line for each file or folder that was uploaded, downloaded, moved or
+	deleted, as soon as it is done, so that indexers and scanners can look at
+	only what changed. The destination may be a regular file, which is
+	appended to, a FIFO or a listening Unix socket.
+*/
+class EventStream
+{
+public :
+	/// boost::errinfo_api_function, boost::errinfo_errno and
+	/// boost::errinfo_file_name tell why the destination can't be opened
+	struct Error : virtual Exception {} ;
+
+public :
+	static EventStream& Instance() ;
+
+	void Open( const std::string& path ) ;
+	void Close() ;
+	bool Enabled() const ;
+
+	void Write( const Val& event ) ;
+
+private :
+	EventStream() ;
+	~EventStream() ;
+
+private :
+	std::mutex	m_mutex ;
+	std::atomic<int>	m_fd ;
+	bool		m_socket ;
+} ;
+
+} // end of namespace
@@ -18,6 +18,7 @@
 */
 
 #include "File.hh"
+#include "PageCache.hh"
 
 #include <cassert>
 
@@ -151,10 +152,21 @@ void File::OpenForWrite( const fs::path& path, int mode )
 	Open( path, flags, mode ) ;
 }
 
+/// Opens an existing file for writing, without truncating it.
+void File::OpenForUpdate( const fs::path& path )
+{
+	int flags = O_RDWR ;
+#ifdef WIN32
+	flags |= O_BINARY ;
+#endif
+	Open( path, flags, 0 ) ;
+}
+
 void File::Close()
 {
 	if ( IsOpened() )
 	{
+		PageCache::Instance().Forget( m_fd ) ;
 		close( m_fd ) ;
 		m_fd = -1 ;
 	}
@@ -180,6 +192,11 @@ std::size_t File::Read( char *ptr, std::size_t size )
 				<< boost::errinfo_errno(errno)
 		) ;
 	}
+	if ( PageCache::Instance().Enabled() )
+	{
+		u64_t end = LSeek( m_fd, 0, SEEK_CUR ) ;
+		PageCache::Instance().Read( m_fd, end - count, end ) ;
+	}
 	return count ;
 }
 
@@ -235,6 +252,11 @@ void File::Chmod( int mode )
 #endif
 }
 
+int File::Fd() const
+{
+	return m_fd ;
+}
+
 /// This function is not implemented in win32 yet.
 void* File::Map( off_t offset, std::size_t length )
 {
@@ -55,6 +55,7 @@ public :
 
 	void OpenForRead( const fs::path& path ) ;
 	void OpenForWrite( const fs::path& path, int mode = 0600 ) ;
+	void OpenForUpdate( const fs::path& path ) ;
 	void Close() ;
 	bool IsOpened() const ;
 	
@@ -66,6 +67,7 @@ public :
 	u64_t Size() const ;
 	
 	void Chmod( int mode ) ;
+	int Fd() const ;
 
 	void* Map( off_t offset, std::size_t length ) ;
 	static void UnMap( void *addr, std::size_t length ) ;
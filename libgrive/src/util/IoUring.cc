@@ -0,0 +1,497 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "IoUring.hh"
+
+#include "util/log/Log.hh"
+
+// boost headers
+#include <boost/throw_exception.hpp>
+#include <boost/exception/errinfo_api_function.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/exception/info.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <list>
+#include <map>
+
+// OS specific headers
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#include <stdlib.h>
+#include <sys/sysmacros.h>
+#include <sys/uio.h>
+#endif
+
+namespace gr {
+
+namespace
+{
+	// write synchronously, used when io_uring is not available and to
+	// finish short asynchronous writes
+	void WriteAt( int fd, const char *data, std::size_t count, u64_t offset )
+	{
+		while ( count > 0 )
+		{
+			ssize_t r = ::pwrite( fd, data, count, offset ) ;
+			if ( r < 0 )
+			{
+				if ( errno == EINTR )
+					continue ;
+				BOOST_THROW_EXCEPTION(
+					IoUring::Error()
+						<< boost::errinfo_api_function("pwrite")
+						<< boost::errinfo_errno(errno)
+				) ;
+			}
+			data	+= r ;
+			count	-= r ;
+			offset	+= r ;
+		}
+	}
+}
+
+#ifdef HAVE_LIBURING
+
+namespace
+{
+	// statx requests are submitted in batches of this size
+	const unsigned		queue_depth		= 64 ;
+
+	// number and size of the registered buffers used for reading. together
+	// they are as large as the 4MB window MD5::Get() maps at a time.
+	const unsigned		read_buffers	= 8 ;
+	const std::size_t	read_size		= 512 * 1024 ;
+
+	// maximum number of download writes in flight
+	const std::size_t	max_writes		= 16 ;
+
+	struct Op
+	{
+		Op() : res( 0 ), done( false ), busy( false ) {}
+		int		res ;
+		bool	done ;
+		bool	busy ;
+	} ;
+
+	struct StatOp : Op
+	{
+		struct statx	stx ;
+	} ;
+
+	struct ReadOp : Op
+	{
+		std::size_t		len ;
+	} ;
+
+	struct WriteOp : Op
+	{
+		int					fd ;
+		u64_t				offset ;
+		std::vector<char>	data ;
+	} ;
+}
+
+struct IoUring::Impl
+{
+	Impl() ;
+	~Impl() ;
+
+	io_uring_sqe* Sqe() ;
+	void WaitOne() ;
+	void SubmitRead( int fd, unsigned buf, u64_t offset, std::size_t len ) ;
+	void ReapWrites() ;
+
+	struct io_uring		ring ;
+	bool				ok ;
+	bool				fixed ;
+	std::vector<char*>	bufs ;
+	ReadOp				reads[read_buffers] ;
+
+	std::map<std::string, struct statx>	stats ;
+
+	// std::list so that the buffers do not move while the kernel uses them
+	std::list<WriteOp>	writes ;
+	int					write_err ;
+} ;
+
+IoUring::Impl::Impl() :
+	ok			( false ),
+	fixed		( false ),
+	write_err	( 0 )
+{
+	int r = ::io_uring_queue_init( queue_depth, &ring, 0 ) ;
+	if ( r < 0 )
+	{
+		Log( "io_uring is not available (%1%), using blocking I/O", std::strerror( -r ), log::verbose ) ;
+		return ;
+	}
+	ok = true ;
+
+	struct iovec iov[read_buffers] ;
+	for ( unsigned i = 0 ; i < read_buffers ; i++ )
+	{
+		void *p = NULL ;
+		if ( ::posix_memalign( &p, 4096, read_size ) != 0 )
+			throw std::bad_alloc() ;
+		bufs.push_back( static_cast<char*>( p ) ) ;
+		iov[i].iov_base	= p ;
+		iov[i].iov_len	= read_size ;
+	}
+
+	// registering needs locked memory. plain reads into the same buffers
+	// are used if RLIMIT_MEMLOCK is too low for it
+	fixed = ::io_uring_register_buffers( &ring, iov, read_buffers ) == 0 ;
+}
+
+IoUring::Impl::~Impl()
+{
+	if ( ok )
+		::io_uring_queue_exit( &ring ) ;
+	for ( std::size_t i = 0 ; i < bufs.size() ; i++ )
+		::free( bufs[i] ) ;
+}
+
+io_uring_sqe* IoUring::Impl::Sqe()
+{
+	io_uring_sqe *sqe = ::io_uring_get_sqe( &ring ) ;
+	if ( sqe == NULL )
+	{
+		// submission queue is full: hand it to the kernel and retry
+		::io_uring_submit( &ring ) ;
+		sqe = ::io_uring_get_sqe( &ring ) ;
+	}
+	assert( sqe != NULL ) ;
+	return sqe ;
+}
+
+/// Wait for one completion, whichever request it belongs to.
+void IoUring::Impl::WaitOne()
+{
+	io_uring_cqe *cqe = NULL ;
+	int r ;
+	while ( ( r = ::io_uring_wait_cqe( &ring, &cqe ) ) == -EINTR )
+		;
+	if ( r < 0 )
+		BOOST_THROW_EXCEPTION(
+			Error()
+				<< boost::errinfo_api_function("io_uring_wait_cqe")
+				<< boost::errinfo_errno(-r)
+		) ;
+
+	Op *op = static_cast<Op*>( ::io_uring_cqe_get_data( cqe ) ) ;
+	op->res		= cqe->res ;
+	op->done	= true ;
+	op->busy	= false ;
+	::io_uring_cqe_seen( &ring, cqe ) ;
+}
+
+void IoUring::Impl::SubmitRead( int fd, unsigned buf, u64_t offset, std::size_t len )
+{
+	ReadOp& op = reads[buf] ;
+	op.len	= len ;
+	op.done	= false ;
+	op.busy	= true ;
+
+	io_uring_sqe *sqe = Sqe() ;
+	if ( fixed )
+		::io_uring_prep_read_fixed( sqe, fd, bufs[buf], len, offset, buf ) ;
+	else
+		::io_uring_prep_read( sqe, fd, bufs[buf], len, offset ) ;
+	::io_uring_sqe_set_data( sqe, &op ) ;
+}
+
+/// Drop the finished writes at the front of the queue. Short writes are
+/// completed synchronously, errors are kept for Flush().
+void IoUring::Impl::ReapWrites()
+{
+	while ( !writes.empty() && writes.front().done )
+	{
+		WriteOp& w = writes.front() ;
+		if ( w.res < 0 )
+		{
+			if ( write_err == 0 )
+				write_err = -w.res ;
+		}
+		else if ( static_cast<std::size_t>( w.res ) < w.data.size() && write_err == 0 )
+		{
+			try
+			{
+				WriteAt( w.fd, &w.data[w.res], w.data.size() - w.res, w.offset + w.res ) ;
+			}
+			catch ( Error& )
+			{
+				write_err = EIO ;
+			}
+		}
+		writes.pop_front() ;
+	}
+}
+
+IoUring::IoUring() :
+	m_impl		( new Impl ),
+	m_enabled	( true )
+{
+}
+
+IoUring::~IoUring()
+{
+	try
+	{
+		Flush() ;
+	}
+	catch ( Error& )
+	{
+	}
+}
+
+bool IoUring::Available() const
+{
+	return m_impl->ok && m_enabled ;
+}
+
+/// Submit a statx for every path, queue_depth at a time, and keep the
+/// results for TakeStat(). Failed ones are simply left out, the caller
+/// will stat() them again and report the error.
+void IoUring::PrefetchStat( const std::vector<std::string>& paths )
+{
+	if ( !Available() )
+		return ;
+
+	std::vector<StatOp> ops( std::min<std::size_t>( paths.size(), queue_depth ) ) ;
+	for ( std::size_t start = 0 ; start < paths.size() ; start += queue_depth )
+	{
+		std::size_t count = std::min<std::size_t>( paths.size() - start, queue_depth ) ;
+		for ( std::size_t i = 0 ; i < count ; i++ )
+		{
+			ops[i].done = false ;
+			ops[i].busy = true ;
+			io_uring_sqe *sqe = m_impl->Sqe() ;
+			::io_uring_prep_statx( sqe, AT_FDCWD, paths[start+i].c_str(), 0, STATX_BASIC_STATS, &ops[i].stx ) ;
+			::io_uring_sqe_set_data( sqe, &ops[i] ) ;
+		}
+		::io_uring_submit( &m_impl->ring ) ;
+
+		for ( std::size_t i = 0 ; i < count ; i++ )
+		{
+			while ( !ops[i].done )
+				m_impl->WaitOne() ;
+			if ( ops[i].res == 0 )
+				m_impl->stats[paths[start+i]] = ops[i].stx ;
+		}
+		m_impl->ReapWrites() ;
+	}
+}
+
+bool IoUring::TakeStat( const std::string& path, struct stat& s )
+{
+	std::map<std::string, struct statx>::iterator i = m_impl->stats.find( path ) ;
+	if ( i == m_impl->stats.end() )
+		return false ;
+
+	const struct statx& stx = i->second ;
+	std::memset( &s, 0, sizeof(s) ) ;
+	s.st_dev			= makedev( stx.stx_dev_major, stx.stx_dev_minor ) ;
+	s.st_ino			= stx.stx_ino ;
+	s.st_nlink			= stx.stx_nlink ;
+	s.st_mode			= stx.stx_mode ;
+	s.st_size			= stx.stx_size ;
+	s.st_ctim.tv_sec	= stx.stx_ctime.tv_sec ;
+	s.st_ctim.tv_nsec	= stx.stx_ctime.tv_nsec ;
+
+	m_impl->stats.erase( i ) ;
+	return true ;
+}
+
+void IoUring::DropStats( const std::vector<std::string>& paths )
+{
+	for ( std::size_t i = 0 ; i < paths.size() && !m_impl->stats.empty() ; i++ )
+		m_impl->stats.erase( paths[i] ) ;
+}
+
+/// Read the file with all the buffers in flight at once. Chunks complete in
+/// any order but are handed to \a reader in file order.
+/// \return	the number of bytes handed to \a reader. Less than \a size on a
+///			read error or short read, the caller should then read the rest
+///			by other means.
+u64_t IoUring::ReadAll( int fd, u64_t size, const Reader& reader )
+{
+	if ( !Available() )
+		return 0 ;
+
+	u64_t chunks = ( size + read_size - 1 ) / read_size ;
+	u64_t next = 0 ;
+	for ( ; next < chunks && next < read_buffers ; next++ )
+		m_impl->SubmitRead( fd, next, next * read_size, std::min<u64_t>( read_size, size - next * read_size ) ) ;
+	::io_uring_submit( &m_impl->ring ) ;
+
+	bool ok = true ;
+	u64_t offset = 0 ;
+	for ( u64_t done = 0 ; done < chunks && ok ; done++ )
+	{
+		// chunk n always goes into buffer n % read_buffers
+		unsigned buf = done % read_buffers ;
+		ReadOp& op = m_impl->reads[buf] ;
+		while ( !op.done )
+			m_impl->WaitOne() ;
+
+		ok = op.res == static_cast<int>( op.len ) ;
+		if ( ok )
+		{
+			reader( m_impl->bufs[buf], op.len ) ;
+			offset += op.len ;
+			if ( next < chunks )
+			{
+				m_impl->SubmitRead( fd, buf, next * read_size, std::min<u64_t>( read_size, size - next * read_size ) ) ;
+				::io_uring_submit( &m_impl->ring ) ;
+				next++ ;
+			}
+		}
+	}
+
+	// the buffers can only be reused after the kernel is done with them
+	for ( unsigned i = 0 ; i < read_buffers ; i++ )
+	{
+		while ( m_impl->reads[i].busy )
+			m_impl->WaitOne() ;
+	}
+	m_impl->ReapWrites() ;
+	return offset ;
+}
+
+void IoUring::Write( int fd, const char *data, std::size_t count, u64_t offset )
+{
+	if ( !Available() || count == 0 )
+		return WriteAt( fd, data, count, offset ) ;
+
+	// keep the number of buffered writes bounded
+	while ( m_impl->writes.size() >= max_writes )
+	{
+		while ( !m_impl->writes.front().done )
+			m_impl->WaitOne() ;
+		m_impl->ReapWrites() ;
+	}
+
+	m_impl->writes.push_back( WriteOp() ) ;
+	WriteOp& w = m_impl->writes.back() ;
+	w.fd		= fd ;
+	w.offset	= offset ;
+	w.busy		= true ;
+	w.data.assign( data, data + count ) ;
+
+	io_uring_sqe *sqe = m_impl->Sqe() ;
+	::io_uring_prep_write( sqe, fd, &w.data[0], count, offset ) ;
+	::io_uring_sqe_set_data( sqe, &w ) ;
+	::io_uring_submit( &m_impl->ring ) ;
+}
+
+/// Wait for all queued writes and report the first error among them.
+void IoUring::Flush()
+{
+	while ( !m_impl->writes.empty() )
+	{
+		while ( !m_impl->writes.front().done )
+			m_impl->WaitOne() ;
+		m_impl->ReapWrites() ;
+	}
+
+	int err = m_impl->write_err ;
+	m_impl->write_err = 0 ;
+	if ( err != 0 )
+		BOOST_THROW_EXCEPTION(
+			Error()
+				<< boost::errinfo_api_function("io_uring write")
+				<< boost::errinfo_errno(err)
+		) ;
+}
+
+#else
+
+struct IoUring::Impl
+{
+} ;
+
+IoUring::IoUring() :
+	m_impl		( new Impl ),
+	m_enabled	( true )
+{
+}
+
+IoUring::~IoUring()
+{
+}
+
+bool IoUring::Available() const
+{
+	return false ;
+}
+
+void IoUring::PrefetchStat( const std::vector<std::string>& )
+{
+}
+
+bool IoUring::TakeStat( const std::string&, struct stat& )
+{
+	return false ;
+}
+
+void IoUring::DropStats( const std::vector<std::string>& )
+{
+}
+
+u64_t IoUring::ReadAll( int, u64_t, const Reader& )
+{
+	return 0 ;
+}
+
+void IoUring::Write( int fd, const char *data, std::size_t count, u64_t offset )
+{
+	WriteAt( fd, data, count, offset ) ;
+}
+
+void IoUring::Flush()
+{
+}
+
+#endif
+
+/// Turning the ring off makes this thread fall back to plain system calls,
+/// as if liburing was not there. Queued writes are still flushed.
+void IoUring::Enable( bool on )
+{
+	m_enabled = on ;
+}
+
+IoUring& IoUring::Instance()
+{
+	// one ring per thread, so that syncs in different threads don't mix
+	// their queued operations
+	static thread_local IoUring ring ;
+	return ring ;
+}
+
+} // end of namespace
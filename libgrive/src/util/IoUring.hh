@@ -0,0 +1,81 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "Exception.hh"
+#include "Types.hh"
+
+#include <boost/function.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct stat ;
+
+namespace gr {
+
+/*!	\brief	batched local file I/O on io_uring
+
+	Only functional when grive is built with liburing (HAVE_LIBURING) and the
+	kernel supports io_uring. Otherwise Available() returns false and callers
+	keep using plain system calls. Each thread has its own instance.
+*/
+class IoUring
+{
+public :
+	struct Error : virtual Exception {} ;
+
+	typedef boost::function<void ( const char*, std::size_t )> Reader ;
+
+public :
+	static IoUring& Instance() ;
+	~IoUring() ;
+
+	bool Available() const ;
+	void Enable( bool on ) ;
+
+	// stat a whole directory listing at once. results are kept until taken
+	// or dropped, so drop the batch once done with it
+	void PrefetchStat( const std::vector<std::string>& paths ) ;
+	bool TakeStat( const std::string& path, struct stat& s ) ;
+	void DropStats( const std::vector<std::string>& paths ) ;
+
+	// read the file from the beginning, handing the chunks to reader in order.
+	// returns how far it got
+	u64_t ReadAll( int fd, u64_t size, const Reader& reader ) ;
+
+	// queue a write of a copy of data. Flush() waits for all queued writes
+	void Write( int fd, const char *data, std::size_t count, u64_t offset ) ;
+	void Flush() ;
+
+private :
+	IoUring() ;
+	IoUring( const IoUring& ) ;
+	IoUring& operator=( const IoUring& ) ;
+
+private :
+	struct Impl ;
+	std::unique_ptr<Impl>	m_impl ;
+	bool					m_enabled ;
+} ;
+
+} // end of namespace
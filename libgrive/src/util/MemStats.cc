@@ -0,0 +1,204 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "MemStats.hh"
+
+#include "log/Log.hh"
+
+#include <boost/format.hpp>
+
+#include <cstdio>
+#include <sstream>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace gr {
+
+namespace
+{
+	// the stats of the calling thread, see MemStats::Scope
+	thread_local MemStats *t_stats = 0 ;
+}
+
+MemStats::Hold::Hold( Part part, std::size_t bytes ) :
+	m_stats	( &MemStats::Instance() ),
+	m_part	( part ),
+	m_bytes	( bytes )
+{
+	m_stats->Add( m_part, m_bytes ) ;
+}
+
+MemStats::Hold::~Hold()
+{
+	m_stats->Remove( m_part, m_bytes ) ;
+}
+
+MemStats::Scope::Scope( MemStats& stats ) :
+	m_prev	( t_stats )
+{
+	t_stats = &stats ;
+}
+
+MemStats::Scope::~Scope()
+{
+	t_stats = m_prev ;
+}
+
+MemStats& MemStats::Instance()
+{
+	static MemStats inst ;
+	return t_stats != 0 ? *t_stats : inst ;
+}
+
+MemStats::MemStats()
+{
+	for ( int i = 0 ; i < part_count ; i++ )
+	{
+		m_bytes[i]	= 0 ;
+		m_count[i]	= 0 ;
+		m_peak[i]	= 0 ;
+	}
+}
+
+/// The size of a structure as measured by walking it, and the number of
+/// entries in it.
+void MemStats::Set( Part part, std::size_t bytes, std::size_t count )
+{
+	m_bytes[part] = bytes ;
+	m_count[part] = count ;
+	Raise( part, bytes ) ;
+}
+
+void MemStats::Add( Part part, std::size_t bytes )
+{
+	Raise( part, m_bytes[part] += bytes ) ;
+}
+
+void MemStats::Remove( Part part, std::size_t bytes )
+{
+	m_bytes[part] -= bytes ;
+}
+
+void MemStats::Raise( Part part, std::size_t bytes )
+{
+	std::size_t peak = m_peak[part] ;
+	while ( bytes > peak && !m_peak[part].compare_exchange_weak( peak, bytes ) )
+		;
+}
+
+std::size_t MemStats::Bytes( Part part ) const
+{
+	return m_bytes[part] ;
+}
+
+/// The number of entries as of the last Set(), 0 for the transient parts
+std::size_t MemStats::Count( Part part ) const
+{
+	return m_count[part] ;
+}
+
+std::size_t MemStats::Peak( Part part ) const
+{
+	return m_peak[part] ;
+}
+
+const char* MemStats::Name( Part part )
+{
+	static const char *name[] = { "resources", "state", "feed", "unresolved", "http" } ;
+	return name[part] ;
+}
+
+/// The resident set size of the process, 0 if it is not known
+std::size_t MemStats::Resident()
+{
+	std::size_t size = 0, resident = 0 ;
+	std::FILE *f = std::fopen( "/proc/self/statm", "r" ) ;
+	if ( f == 0 )
+		return 0 ;
+	if ( std::fscanf( f, "%zu %zu", &size, &resident ) != 2 )
+		resident = 0 ;
+	std::fclose( f ) ;
+	return resident * ::sysconf( _SC_PAGESIZE ) ;
+}
+
+std::size_t MemStats::PeakResident()
+{
+	struct rusage usage ;
+	if ( ::getrusage( RUSAGE_SELF, &usage ) != 0 )
+		return 0 ;
+	// in kilobytes on Linux
+	return static_cast<std::size_t>( usage.ru_maxrss ) * 1024 ;
+}
+
+/// The heap block malloc takes for \a size bytes: an 8 byte header and a
+/// multiple of 16, at least 32 bytes.
+std::size_t MemStats::Block( std::size_t size )
+{
+	if ( size == 0 )
+		return 0 ;
+	std::size_t block = ( size + 8 + 15 ) & ~static_cast<std::size_t>( 15 ) ;
+	return block < 32 ? 32 : block ;
+}
+
+/// Short strings are kept in the string object itself.
+std::size_t MemStats::Heap( const std::string& s )
+{
+	return s.size() < 16 ? 0 : Block( s.size() + 1 ) ;
+}
+
+namespace
+{
+	std::string MB( std::size_t bytes )
+	{
+		return ( boost::format( "%.1f MB" ) % ( bytes / 1048576.0 ) ).str() ;
+	}
+}
+
+std::string MemStats::Line( bool peaks ) const
+{
+	std::ostringstream ss ;
+	for ( int i = 0 ; i < part_count ; i++ )
+	{
+		Part p = static_cast<Part>( i ) ;
+		ss << Name( p ) << ' ' << MB( peaks ? Peak( p ) : Bytes( p ) ) ;
+		if ( !peaks && Count( p ) > 0 )
+			ss << " (" << Bytes( p ) / Count( p ) << " bytes x " << Count( p ) << ")" ;
+		ss << ", " ;
+	}
+	ss << "resident " << MB( peaks ? PeakResident() : Resident() ) ;
+	return ss.str() ;
+}
+
+/// Log the memory of each part at the end of \a phase.
+void MemStats::Sample( const std::string& phase )
+{
+	Log( "memory after %1%: %2%", phase, Line( false ), log::debug ) ;
+}
+
+/// Log the peaks of the whole run, or those of \a what.
+void MemStats::Report( const std::string& what ) const
+{
+	if ( what.empty() )
+		Log( "peak memory: %1%", Line( true ), log::verbose ) ;
+	else
+		Log( "peak memory of %1%: %2%", what, Line( true ), log::verbose ) ;
+}
+
+} // end of namespace
@@ -0,0 +1,121 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace gr {
+
+/*!	\brief	memory held by each part of grive
+
+	Tells what a large resident size is made of. The long-lived structures
+	are measured by walking them at the end of each phase of a sync (Set()).
+	Transient buffers count their bytes while they hold them (Add() and
+	Remove(), or a Hold), so that their peak is known too. The sizes are
+	estimates of the heap blocks taken, including the malloc overhead.
+
+	Instance() is the stats of the whole process, unless a Scope gives the
+	calling thread stats of its own, like each root of a MultiRoot. The
+	threads a sync starts take the stats of the thread that started them.
+*/
+class MemStats
+{
+public :
+	enum Part
+	{
+		resources,		// the Resource tree and its indexes
+		state,			// the records of the last sync, see StateRecord
+		feed,			// remote list pages, parsed and read ahead
+		unresolved,		// remote entries whose parent is not known yet
+		http,			// the buffers of the HTTP connections
+		part_count
+	} ;
+
+	/// Counts \a bytes for a part for as long as it exists.
+	class Hold
+	{
+	public :
+		Hold( Part part, std::size_t bytes ) ;
+		~Hold() ;
+
+	private :
+		Hold( const Hold& ) ;
+		Hold& operator=( const Hold& ) ;
+
+	private :
+		MemStats	*m_stats ;
+		Part		m_part ;
+		std::size_t	m_bytes ;
+	} ;
+
+	/// Makes Instance() return \a stats in the calling thread, for as long
+	/// as it exists.
+	class Scope
+	{
+	public :
+		explicit Scope( MemStats& stats ) ;
+		~Scope() ;
+
+	private :
+		Scope( const Scope& ) ;
+		Scope& operator=( const Scope& ) ;
+
+	private :
+		MemStats	*m_prev ;
+	} ;
+
+public :
+	MemStats() ;
+	static MemStats& Instance() ;
+
+	void Set( Part part, std::size_t bytes, std::size_t count ) ;
+	void Add( Part part, std::size_t bytes ) ;
+	void Remove( Part part, std::size_t bytes ) ;
+
+	std::size_t Bytes( Part part ) const ;
+	std::size_t Count( Part part ) const ;
+	std::size_t Peak( Part part ) const ;
+
+	void Sample( const std::string& phase ) ;
+	void Report( const std::string& what = std::string() ) const ;
+
+	static const char* Name( Part part ) ;
+	static std::size_t Resident() ;
+	static std::size_t PeakResident() ;
+
+	// estimates of the heap taken by a block and by the characters of a string
+	static std::size_t Block( std::size_t size ) ;
+	static std::size_t Heap( const std::string& s ) ;
+
+private :
+	MemStats( const MemStats& ) ;
+	MemStats& operator=( const MemStats& ) ;
+	void Raise( Part part, std::size_t bytes ) ;
+	std::string Line( bool peaks ) const ;
+
+private :
+	std::atomic<std::size_t>	m_bytes[part_count] ;
+	std::atomic<std::size_t>	m_count[part_count] ;
+	std::atomic<std::size_t>	m_peak[part_count] ;
+} ;
+
+} // end of namespace
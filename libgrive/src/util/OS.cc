@@ -21,6 +21,8 @@
 
 #include "DateTime.hh"
 #include "Exception.hh"
+#include "File.hh"
+#include "IoUring.hh"
 
 // boost headers
 #include <boost/throw_exception.hpp>
@@ -36,18 +38,25 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#endif
 
 namespace gr { namespace os {
 
-void Stat( const fs::path& filename, DateTime *t, off_t *size, FileType *ft )
+void Stat( const fs::path& filename, DateTime *t, off_t *size, FileType *ft, FileId *id )
 {
-	Stat( filename.string(), t, size, ft ) ;
+	Stat( filename.string(), t, size, ft, id ) ;
 }
 
-void Stat( const std::string& filename, DateTime *t, off64_t *size, FileType *ft )
+void Stat( const std::string& filename, DateTime *t, off64_t *size, FileType *ft, FileId *id )
 {
 	struct stat s = {} ;
-	if ( ::stat( filename.c_str(), &s ) != 0 )
+	if ( !IoUring::Instance().TakeStat( filename, s ) && ::stat( filename.c_str(), &s ) != 0 )
 	{
 		BOOST_THROW_EXCEPTION(
 			Error()
@@ -69,6 +78,35 @@ void Stat( const std::string& filename, DateTime *t, off64_t *size, FileType *ft
 		*size = s.st_size;
 	if ( ft )
 		*ft = S_ISDIR( s.st_mode ) ? FT_DIR : ( S_ISREG( s.st_mode ) ? FT_FILE : FT_UNKNOWN ) ;
+	if ( id )
+	{
+		id->dev		= s.st_dev ;
+		id->ino		= s.st_ino ;
+		id->nlink	= s.st_nlink ;
+	}
+}
+
+/// Copy the content of \a src to \a dest. A reflink (FICLONE) is tried first,
+/// so on filesystems with shared extents (btrfs, XFS) no data is copied at all.
+/// \return	true if the file was reflinked, false if it was copied.
+bool CloneFile( const fs::path& src, const fs::path& dest )
+{
+	File in( src ) ;
+	File out( dest, 0600 ) ;
+
+#ifdef FICLONE
+	if ( ::ioctl( out.Fd(), FICLONE, in.Fd() ) == 0 )
+		return true ;
+#endif
+
+	char buf[64 * 1024] ;
+	std::size_t count ;
+	while ( ( count = in.Read( buf, sizeof(buf) ) ) > 0 )
+	{
+		for ( std::size_t done = 0 ; done < count ; )
+			done += out.Write( buf + done, count - done ) ;
+	}
+	return false ;
 }
 
 void SetFileTime( const fs::path& filename, const DateTime& t )
@@ -88,6 +126,21 @@ void SetFileTime( const std::string& filename, const DateTime& t )
 		) ;
 }
 
+/// Give the disk reads and writes of the calling thread, and the threads it
+/// starts afterwards, the idle I/O scheduling class: they are only served
+/// when no other program needs the disk.
+/// \return	false if not supported
+bool SetIdleIoPriority()
+{
+#if defined __linux__ && defined SYS_ioprio_set
+	// from linux/ioprio.h, which is not installed everywhere
+	const int who_process = 1, class_idle = 3, class_shift = 13 ;
+	return ::syscall( SYS_ioprio_set, who_process, 0, class_idle << class_shift ) == 0 ;
+#else
+	return false ;
+#endif
+}
+
 void Sleep( unsigned int sec )
 {
 	struct timespec ts = { sec, 0 } ;
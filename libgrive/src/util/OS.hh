@@ -21,6 +21,7 @@
 
 #include "Exception.hh"
 #include "FileSystem.hh"
+#include "Types.hh"
 
 #include <string>
 
@@ -39,13 +40,25 @@ namespace os
 {
 	struct Error : virtual Exception {} ;
 	
-	void Stat( const std::string& filename, DateTime *t, off64_t *size, FileType *ft ) ;
-	void Stat( const fs::path& filename, DateTime *t, off64_t *size, FileType *ft ) ;
+	/// identifies the inode behind a path, used to detect hard links
+	struct FileId
+	{
+		u64_t	dev ;
+		u64_t	ino ;
+		u64_t	nlink ;
+	} ;
+	
+	void Stat( const std::string& filename, DateTime *t, off64_t *size, FileType *ft, FileId *id = 0 ) ;
+	void Stat( const fs::path& filename, DateTime *t, off64_t *size, FileType *ft, FileId *id = 0 ) ;
+	
+	bool CloneFile( const fs::path& src, const fs::path& dest ) ;
 	
 	void SetFileTime( const std::string& filename, const DateTime& t ) ;
 	void SetFileTime( const fs::path& filename, const DateTime& t ) ;
 	
 	void Sleep( unsigned int sec ) ;
+	
+	bool SetIdleIoPriority() ;
 }
 
 } // end of namespaces
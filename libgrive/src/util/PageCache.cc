@@ -0,0 +1,207 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "PageCache.hh"
+
+#include "File.hh"
+
+#include <boost/exception/errinfo_api_function.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <cerrno>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gr {
+
+namespace
+{
+	// pages are dropped a window at a time, so that small reads and writes
+	// don't cost a system call each
+	const u64_t window = 1024 * 1024 ;
+
+	// the size of the direct reads, and the alignment they need
+	const std::size_t direct_size	= 4 * 1024 * 1024 ;
+	const std::size_t direct_align	= 4096 ;
+
+	void DontNeed( int fd, u64_t begin, u64_t end )
+	{
+#ifdef POSIX_FADV_DONTNEED
+		if ( end > begin )
+			::posix_fadvise( fd, begin, end - begin, POSIX_FADV_DONTNEED ) ;
+#endif
+	}
+
+	/// Write the dirty pages in the range back, and wait for them if \a wait.
+	/// Dirty pages are not dropped by POSIX_FADV_DONTNEED.
+	void WriteBack( int fd, u64_t begin, u64_t end, bool wait )
+	{
+#ifdef SYNC_FILE_RANGE_WRITE
+		if ( end > begin )
+			::sync_file_range( fd, begin, end - begin, wait ?
+				SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER :
+				SYNC_FILE_RANGE_WRITE ) ;
+#else
+		if ( wait && end > begin )
+			::fdatasync( fd ) ;
+#endif
+	}
+
+	/// Turn O_DIRECT on or off for \a fd.
+	/// \return	false if the file system doesn't support it
+	bool SetDirect( int fd, bool on )
+	{
+#ifdef O_DIRECT
+		int flags = ::fcntl( fd, F_GETFL ) ;
+		return flags != -1 && ::fcntl( fd, F_SETFL, on ? flags | O_DIRECT : flags & ~O_DIRECT ) == 0 ;
+#else
+		return false ;
+#endif
+	}
+
+	struct Free
+	{
+		void operator()( char *p ) const
+		{
+			std::free( p ) ;
+		}
+	} ;
+}
+
+PageCache& PageCache::Instance()
+{
+	static PageCache cache ;
+	return cache ;
+}
+
+PageCache::PageCache() : m_enabled( false )
+{
+}
+
+void PageCache::Enable()
+{
+	m_enabled = true ;
+}
+
+bool PageCache::Enabled() const
+{
+	return m_enabled ;
+}
+
+/// The bytes from \a begin to \a end of \a fd were read and are not needed
+/// again.
+void PageCache::Read( int fd, u64_t begin, u64_t end )
+{
+	if ( m_enabled && begin / window != end / window )
+		DontNeed( fd, begin / window * window, end / window * window ) ;
+}
+
+/// The bytes from \a begin to \a end were written to \a fd. The writeback of
+/// each window is started when it is full, and the window before it is
+/// dropped when it is on disk, so that the cache holds at most two windows of
+/// the file at a time.
+void PageCache::Written( int fd, u64_t begin, u64_t end )
+{
+	if ( !m_enabled || begin / window == end / window )
+		return ;
+
+	u64_t from = begin / window * window, to = end / window * window ;
+	WriteBack( fd, from, to, false ) ;
+	if ( to > window )
+	{
+		u64_t old = from >= window ? from - window : 0 ;
+		WriteBack( fd, old, to - window, true ) ;
+		DontNeed( fd, old, to - window ) ;
+	}
+}
+
+/// Drop the whole file before it is closed. Small files never fill a
+/// window, and their pages are only dropped here.
+void PageCache::Forget( int fd )
+{
+	if ( !m_enabled )
+		return ;
+
+	struct stat s ;
+	if ( ::fstat( fd, &s ) != 0 || !S_ISREG( s.st_mode ) )
+		return ;
+
+	int mode = ::fcntl( fd, F_GETFL ) ;
+	if ( mode != -1 && ( mode & O_ACCMODE ) != O_RDONLY )
+		WriteBack( fd, 0, s.st_size, true ) ;
+	DontNeed( fd, 0, s.st_size ) ;
+}
+
+/// Read the file from the beginning, handing the chunks to \a reader in
+/// order. The reads bypass the cache with O_DIRECT if possible, and are
+/// dropped from it after each chunk otherwise.
+void PageCache::ReadAll( int fd, u64_t size, const Reader& reader )
+{
+	void *p = 0 ;
+	if ( ::posix_memalign( &p, direct_align, direct_size ) != 0 )
+		throw std::bad_alloc() ;
+	std::unique_ptr<char, Free> buf( static_cast<char*>( p ) ) ;
+
+	bool direct = SetDirect( fd, true ) ;
+	u64_t offset = 0 ;
+	while ( offset < size )
+	{
+		// a direct read of the last chunk may be short, its length must
+		// still be aligned
+		ssize_t r = ::pread( fd, buf.get(), direct_size, offset ) ;
+		if ( r == -1 && errno == EINVAL && direct )
+		{
+			// the file system accepted the flag but not the reads
+			SetDirect( fd, false ) ;
+			direct = false ;
+			continue ;
+		}
+		if ( r == -1 )
+		{
+			int error = errno ;
+			if ( direct )
+				SetDirect( fd, false ) ;
+			BOOST_THROW_EXCEPTION(
+				File::Error()
+					<< boost::errinfo_api_function( "pread" )
+					<< boost::errinfo_errno( error )
+			) ;
+		}
+		if ( r == 0 )
+			break ;
+
+		std::size_t len = static_cast<std::size_t>( std::min<u64_t>( r, size - offset ) ) ;
+		reader( buf.get(), len ) ;
+		if ( !direct )
+			DontNeed( fd, offset, offset + r ) ;
+		offset += r ;
+	}
+
+	if ( direct )
+		SetDirect( fd, false ) ;
+}
+
+} // end of namespace
@@ -0,0 +1,63 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "Types.hh"
+
+#include <boost/function.hpp>
+
+#include <cstddef>
+
+namespace gr {
+
+/*!	\brief	keeps grive's file I/O out of the page cache
+
+	Disabled by default. Once enabled ("--polite-io"), files are hashed with
+	O_DIRECT reads where the file system allows it, and the pages read for
+	uploads or written by downloads are dropped from the cache as soon as
+	grive is done with them, so that syncing a large tree doesn't evict the
+	working set of the other programs on the host.
+*/
+class PageCache
+{
+public :
+	typedef boost::function<void ( const char*, std::size_t )> Reader ;
+
+public :
+	static PageCache& Instance() ;
+
+	// call before starting any thread
+	void Enable() ;
+	bool Enabled() const ;
+
+	void Read( int fd, u64_t begin, u64_t end ) ;
+	void Written( int fd, u64_t begin, u64_t end ) ;
+	void Forget( int fd ) ;
+
+	void ReadAll( int fd, u64_t size, const Reader& reader ) ;
+
+private :
+	PageCache() ;
+
+private :
+	bool	m_enabled ;
+} ;
+
+} // end of namespace
@@ -0,0 +1,85 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace gr {
+
+/*!	\brief	a queue to pass work between threads
+
+	Pop() blocks until an item is available or the queue is closed. With a
+	maximum size, Push() blocks while the queue is full.
+*/
+template <typename T>
+class SyncQueue
+{
+public :
+	/// \param	max		the most items queued at once, 0 for no limit
+	explicit SyncQueue( std::size_t max = 0 ) : m_max( max ), m_closed( false )
+	{
+	}
+
+	void Push( const T& item )
+	{
+		std::unique_lock<std::mutex> lock( m_mutex ) ;
+		while ( m_max > 0 && m_items.size() >= m_max && !m_closed )
+			m_full.wait( lock ) ;
+		m_items.push_back( item ) ;
+		m_cond.notify_one() ;
+	}
+
+	/// \return	false if the queue is closed and empty
+	bool Pop( T& item )
+	{
+		std::unique_lock<std::mutex> lock( m_mutex ) ;
+		while ( m_items.empty() && !m_closed )
+			m_cond.wait( lock ) ;
+		if ( m_items.empty() )
+			return false ;
+
+		item = m_items.front() ;
+		m_items.pop_front() ;
+		m_full.notify_one() ;
+		return true ;
+	}
+
+	/// no more items will be pushed
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock( m_mutex ) ;
+		m_closed = true ;
+		m_cond.notify_all() ;
+		m_full.notify_all() ;
+	}
+
+private :
+	std::mutex				m_mutex ;
+	std::condition_variable	m_cond ;
+	std::condition_variable	m_full ;
+	std::deque<T>			m_items ;
+	std::size_t				m_max ;
+	bool					m_closed ;
+} ;
+
+} // end of namespace
@@ -20,6 +20,7 @@
 #include "Log.hh"
 
 #include <cassert>
+#include <mutex>
 
 namespace gr {
 
@@ -40,17 +41,36 @@ public :
 	}
 } ;
 
+namespace
+{
+	// held while a message is written or the log is changed
+	std::mutex& LogMutex()
+	{
+		static std::mutex mutex ;
+		return mutex ;
+	}
+}
+
 LogBase* LogBase::Inst( LogBase *log )
 {
 	static std::unique_ptr<LogBase> inst( new MockLog ) ;
 	
 	if ( log != 0 )
+	{
+		std::lock_guard<std::mutex> lock( LogMutex() ) ;
 		inst.reset( log ) ;
+	}
 		
 	assert( inst.get() != 0 ) ;
 	return inst.get() ;
 }
 
+void LogBase::Write( const log::Fmt& msg, log::Serverity s )
+{
+	std::lock_guard<std::mutex> lock( LogMutex() ) ;
+	Inst()->Log( msg, s ) ;
+}
+
 LogBase::LogBase()
 {
 }
@@ -61,22 +81,24 @@ LogBase::~LogBase()
 
 void Log( const std::string& str, log::Serverity s )
 {
-	LogBase::Inst()->Log( log::Fmt(str), s ) ;
+	LogBase::Write( log::Fmt(str), s ) ;
 }
 
 void Trace( const std::string& str )
 {
-	LogBase::Inst()->Log( log::Fmt(str), log::debug ) ;
+	LogBase::Write( log::Fmt(str), log::debug ) ;
 }
 
 DisableLog::DisableLog( log::Serverity s ) :
-	m_sev( s ),
-	m_prev( LogBase::Inst()->Enable( s, false ) )
+	m_sev( s )
 {
+	std::lock_guard<std::mutex> lock( LogMutex() ) ;
+	m_prev = LogBase::Inst()->Enable( s, false ) ;
 }
 
 DisableLog::~DisableLog()
 {
+	std::lock_guard<std::mutex> lock( LogMutex() ) ;
 	LogBase::Inst()->Enable( m_sev, m_prev ) ;
 }
 
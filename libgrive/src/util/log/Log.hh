@@ -57,6 +57,10 @@ namespace log
 }
 
 /*!	\brief	Base class and singleton of log facilities
+
+	The Log() and Trace() functions pass their messages to the singleton
+	one thread at a time, with Write(), so that the lines of roots synced in
+	parallel don't interleave.
 */
 class LogBase
 {
@@ -66,6 +70,7 @@ public :
 	virtual bool IsEnabled( log::Serverity s ) const = 0 ;
 	
 	static LogBase* Inst( LogBase *log = 0 ) ;
+	static void Write( const log::Fmt& msg, log::Serverity s ) ;
 	virtual ~LogBase() ;
 
 protected :
@@ -88,19 +93,19 @@ void Log( const std::string& str, log::Serverity s = log::info ) ;
 template <typename P1>
 void Log( const std::string& fmt, const P1& p1, log::Serverity s = log::info )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1, s ) ;
+	LogBase::Write( log::Fmt(fmt) % p1, s ) ;
 }
 
 template <typename P1, typename P2>
 void Log( const std::string& fmt, const P1& p1, const P2& p2, log::Serverity s = log::info )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1 % p2, s ) ;
+	LogBase::Write( log::Fmt(fmt) % p1 % p2, s ) ;
 }
 
 template <typename P1, typename P2, typename P3>
 void Log( const std::string& fmt, const P1& p1, const P2& p2, const P3& p3, log::Serverity s = log::info )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1 % p2 % p3, s ) ;
+	LogBase::Write( log::Fmt(fmt) % p1 % p2 % p3, s ) ;
 }
 
 template <typename P1, typename P2, typename P3, typename P4>
@@ -112,13 +117,13 @@ void Log(
 	const P4& p4,
 	log::Serverity s = log::info )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1 % p2 % p3 % p4, s ) ;
+	LogBase::Write( log::Fmt(fmt) % p1 % p2 % p3 % p4, s ) ;
 }
 
 template <typename P1, typename P2, typename P3, typename P4, typename P5>
 void Log( const std::string& fmt, const P1& p1, const P2& p2, const P3& p3, const P4& p4, const P5& p5, log::Serverity s = log::info )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1 % p2 % p3 % p4 % p5, s ) ;
+	LogBase::Write( log::Fmt(fmt) % p1 % p2 % p3 % p4 % p5, s ) ;
 }
 
 void Trace( const std::string& str ) ;
@@ -126,25 +131,25 @@ void Trace( const std::string& str ) ;
 template <typename P1>
 void Trace( const std::string& fmt, const P1& p1 )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1, log::debug ) ;
+	LogBase::Write( log::Fmt(fmt) % p1, log::debug ) ;
 }
 
 template <typename P1, typename P2>
 void Trace( const std::string& fmt, const P1& p1, const P2& p2 )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1 % p2, log::debug ) ;
+	LogBase::Write( log::Fmt(fmt) % p1 % p2, log::debug ) ;
 }
 
 template <typename P1, typename P2, typename P3>
 void Trace( const std::string& fmt, const P1& p1, const P2& p2, const P3& p3 )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1 % p2 % p3, log::debug ) ;
+	LogBase::Write( log::Fmt(fmt) % p1 % p2 % p3, log::debug ) ;
 }
 
 template <typename P1, typename P2, typename P3, typename P4>
 void Trace( const std::string& fmt, const P1& p1, const P2& p2, const P3& p3, const P4& p4 )
 {
-	LogBase::Inst()->Log( log::Fmt(fmt) % p1 % p2 % p3 % p4, log::debug ) ;
+	LogBase::Write( log::Fmt(fmt) % p1 % p2 % p3 % p4, log::debug ) ;
 }
 
 } // end of namespace
@@ -22,6 +22,7 @@
 #include "Assert.hh"
 
 #include "base/Resource.hh"
+#include "base/StateRecord.hh"
 
 #include "drive2/Entry2.hh"
 #include "json/Val.hh"
@@ -54,18 +55,19 @@ void ResourceTest::TestNormal( )
 	GRUT_ASSERT_EQUAL( subject.IsRoot(), false ) ;
 	GRUT_ASSERT_EQUAL( subject.Path(), fs::path( TEST_DATA ) / "entry.xml" ) ;
 	
-	Val st;
-	st.Add( "srv_time", Val( DateTime( "2012-05-09T16:13:22.401Z" ).Sec() ) );
+	StateRecord st;
+	st.srv_time = DateTime( "2012-05-09T16:13:22.401Z" ).Sec();
+	st.Set( StateRecord::srv_time_field );
 	subject.FromLocal( st ) ;
-	GRUT_ASSERT_EQUAL( subject.MD5(), "c0742c0a32b2c909b6f176d17a6992d0" ) ;
+	GRUT_ASSERT_EQUAL( subject.MD5().Hex(), "c0742c0a32b2c909b6f176d17a6992d0" ) ;
 	GRUT_ASSERT_EQUAL( subject.StateStr(), "local_new" ) ;
 	
 	Val entry;
 	entry.Set( "modifiedDate", Val( std::string( "2012-05-09T16:13:22.401Z" ) ) );
-	entry.Set( "md5Checksum", Val( std::string( "DIFFERENT" ) ) );
+	entry.Set( "md5Checksum", Val( std::string( "0123456789ABCDEF0123456789ABCDEF" ) ) );
 	
 	Entry2 remote( entry ) ;
-	GRUT_ASSERT_EQUAL( "different", remote.MD5() ) ;
+	GRUT_ASSERT_EQUAL( "0123456789abcdef0123456789abcdef", remote.MD5().Hex() ) ;
 	subject.FromRemote( remote ) ;
 	GRUT_ASSERT_EQUAL( "local_changed", subject.StateStr() ) ;
 }
@@ -0,0 +1,69 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace gr { namespace test {
+
+/// Benchmarks are test cases that only run when GR_BENCH is set, e.g.
+/// GR_BENCH=1 btest --run_test=JsonBenchTest. They print their timings.
+inline bool Bench()
+{
+	return ::getenv( "GR_BENCH" ) != 0 ;
+}
+
+/// a size or count of a benchmark, from the environment variable \a name
+inline long BenchParam( const char *name, long def )
+{
+	const char *env = ::getenv( name ) ;
+	return env != 0 ? std::atol( env ) : def ;
+}
+
+class Stopwatch
+{
+public :
+	Stopwatch() : m_start( std::chrono::steady_clock::now() ) {}
+
+	double Seconds() const
+	{
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - m_start ;
+		return d.count() ;
+	}
+
+private :
+	std::chrono::steady_clock::time_point	m_start ;
+} ;
+
+/// print the time of \a runs runs, and the throughput if they went through \a bytes each
+inline void Report( const std::string& name, double seconds, long runs = 1, double bytes = 0 )
+{
+	std::cout << std::left << std::setw( 40 ) << name << std::right << std::fixed
+		<< std::setprecision( 3 ) << std::setw( 10 ) << seconds * 1000 / runs << " ms" ;
+	if ( bytes > 0 )
+		std::cout << std::setprecision( 1 ) << std::setw( 10 ) << bytes * runs / seconds / 1e6 << " MB/s" ;
+	std::cout << std::endl ;
+}
+
+} } // end of namespace gr::test
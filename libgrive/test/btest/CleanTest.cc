@@ -0,0 +1,189 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "SimAgent.hh"
+#include "TestDir.hh"
+
+#include "base/Entry.hh"
+#include "base/State.hh"
+#include "drive2/Syncer2.hh"
+#include "json/JsonParser.hh"
+#include "json/Val.hh"
+#include "util/File.hh"
+#include "util/FileSystem.hh"
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace gr ;
+using namespace gr::test ;
+
+namespace
+{
+	class TestEntry : public Entry
+	{
+	public :
+		TestEntry( const std::string& name, const std::string& parent, const std::string& content, long mtime )
+		{
+			m_title			= name ;
+			m_filename		= name ;
+			m_is_dir		= false ;
+			m_resource_id	= "id-" + name ;
+			m_self_href		= m_resource_id ;
+			m_content_src	= "content/" + name ;
+			m_parent_hrefs.push_back( parent ) ;
+			m_md5			= Md5( content ) ;
+			m_size			= content.size() ;
+			m_mtime			= DateTime( mtime, 0 ) ;
+		}
+
+		explicit TestEntry( const std::string& folder )
+		{
+			m_title			= folder ;
+			m_resource_id	= "id-" + folder ;
+			m_self_href		= m_resource_id ;
+			m_parent_hrefs.push_back( "root" ) ;
+			m_mtime			= DateTime( 1, 0 ) ;
+		}
+	} ;
+
+	struct Fixture : TestDir
+	{
+		Fixture() :
+			agent	( std::vector<test::Item>() ),
+			syncer	( &agent )
+		{
+			fs::create_directories( dir / "docs" ) ;
+			Write( "top.txt", "top" ) ;
+			Write( "docs/a.txt", "aaa" ) ;
+			Write( "docs/b.txt", "bbb" ) ;
+
+			options.Add( "path",		Val( dir.string() ) ) ;
+			options.Add( "state-depth",	Val( 0 ) ) ;
+
+			// everything was synced before, with the current content
+			WriteState( "\"top.txt\":" + Record( "top" ) + ","
+				"\"docs\":" + Folder(
+					"\"a.txt\":" + Record( "aaa" ) + ","
+					"\"b.txt\":" + Record( "bbb" ) ) ) ;
+		}
+
+		void Merge( State& state, long b_mtime )
+		{
+			state.FromLocal( dir ) ;
+			state.FromRemote( TestEntry( "docs" ) ) ;
+			state.FromRemote( TestEntry( "top.txt", "root", "top", 1 ) ) ;
+			state.FromRemote( TestEntry( "a.txt", "id-docs", "aaa", 1 ) ) ;
+			state.FromRemote( TestEntry( "b.txt", "id-docs", "bbb", b_mtime ) ) ;
+			state.ResolveEntry() ;
+		}
+
+		void Sync( long b_mtime )
+		{
+			State state( dir, options ) ;
+			Merge( state, b_mtime ) ;
+			state.Sync( &syncer, options ) ;
+			state.Write() ;
+		}
+
+		Val ReadState()
+		{
+			File file( dir / ".grive_state" ) ;
+			return ParseJson( file ) ;
+		}
+
+		// a value that the sync rewrites, unless it skips the folder
+		void MarkRecord()
+		{
+			Val st = ReadState() ;
+			st["tree"]["docs"]["tree"]["b.txt"].Set( "ctime", Val( future ) ) ;
+			std::ofstream f( ( dir / ".grive_state" ).string().c_str() ) ;
+			f << st ;
+		}
+
+		bool IsMarked()
+		{
+			return ReadState()["tree"]["docs"]["tree"]["b.txt"]["ctime"].U64() == (u64_t)future ;
+		}
+
+		Val					options ;
+		test::SimAgent		agent ;
+		v2::Syncer2			syncer ;
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( CleanTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestClean )
+{
+	// the state written by the fixture has no server times yet
+	{
+		State state( dir, options ) ;
+		Merge( state, 1 ) ;
+		BOOST_CHECK( !state.FindByHref( "id-docs" )->IsClean() ) ;
+	}
+	Sync( 1 ) ;
+	{
+		State state( dir, options ) ;
+		Merge( state, 1 ) ;
+		BOOST_CHECK( state.FindByHref( "id-docs" )->IsClean() ) ;
+		BOOST_CHECK( state.FindByHref( "root" )->IsClean() ) ;
+	}
+
+	// a new local file makes its folders unclean, and only them
+	Write( "new.txt", "new" ) ;
+	{
+		State state( dir, options ) ;
+		Merge( state, 1 ) ;
+		BOOST_CHECK( state.FindByHref( "id-docs" )->IsClean() ) ;
+		BOOST_CHECK( !state.FindByHref( "root" )->IsClean() ) ;
+	}
+	fs::remove( dir / "new.txt" ) ;
+
+	// so does a change in Google Drive
+	{
+		State state( dir, options ) ;
+		Merge( state, 2 ) ;
+		BOOST_CHECK( !state.FindByHref( "id-docs" )->IsClean() ) ;
+		BOOST_CHECK( !state.FindByHref( "root" )->IsClean() ) ;
+	}
+}
+
+BOOST_AUTO_TEST_CASE( TestSkipClean )
+{
+	Sync( 1 ) ;
+	MarkRecord() ;
+	Sync( 1 ) ;
+	BOOST_CHECK( IsMarked() ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestVisitChanged )
+{
+	Sync( 1 ) ;
+	MarkRecord() ;
+
+	// same content, but modified again in Google Drive
+	Sync( 2 ) ;
+	BOOST_CHECK( !IsMarked() ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,212 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "TestDir.hh"
+
+#include "base/Entry.hh"
+#include "base/State.hh"
+#include "drive2/Syncer2.hh"
+#include "http/Agent.hh"
+#include "http/Error.hh"
+#include "http/Lanes.hh"
+#include "json/Val.hh"
+#include "util/DataStream.hh"
+#include "util/FileSystem.hh"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace gr ;
+using namespace gr::test ;
+
+namespace
+{
+	const std::string files_url = "https://www.googleapis.com/drive/v2/files" ;
+
+	class TestEntry : public Entry
+	{
+	public :
+		TestEntry( const std::string& name, const std::string& content )
+		{
+			m_title			= name ;
+			m_filename		= name ;
+			m_is_dir		= false ;
+			m_resource_id	= "id-" + name ;
+			m_self_href		= m_resource_id ;
+			m_content_src	= files_url + "/" + m_resource_id + "?alt=media" ;
+			m_parent_hrefs.push_back( "root" ) ;
+			m_md5			= Md5( content ) ;
+			m_size			= content.size() ;
+			m_mtime			= DateTime( 1, 0 ) ;
+		}
+	} ;
+
+	/// answers the copy, upload and download requests, and can refuse the copies
+	class CopyAgent : public http::Agent
+	{
+	public :
+		explicit CopyAgent( bool refuse ) :
+			m_refuse	( refuse ),
+			m_downloads	( new std::atomic<unsigned>( 0 ) )
+		{
+		}
+
+		http::ResponseLog* GetLog() const { return 0 ; }
+		void SetLog( http::ResponseLog* ) {}
+
+		long Request(
+			const std::string&	method,
+			const std::string&	url,
+			SeekStream			*in,
+			DataStream			*dest,
+			const http::Header&	,
+			u64_t				)
+		{
+			if ( url.find( "?alt=media" ) != std::string::npos )
+			{
+				// on the bulk lane, i.e. a clone of this agent
+				++*m_downloads ;
+				dest->Write( "ccc", 3 ) ;
+				return 200 ;
+			}
+			requests.push_back( method + " " + url ) ;
+
+			std::string id = "id-upload" ;
+			if ( url.find( "/copy" ) != std::string::npos )
+			{
+				char buf[1024] ;
+				std::size_t n = in->Read( buf, sizeof(buf) ) ;
+				copy_meta.assign( buf, n ) ;
+				if ( m_refuse )
+					BOOST_THROW_EXCEPTION( http::Error() << http::HttpResponseCode( 403 ) ) ;
+				id = "id-copy" ;
+			}
+
+			std::string s = "{\"kind\":\"drive#file\",\"id\":\"" + id + "\",\"title\":\"b.txt\",\"etag\":\"e\""
+				",\"selfLink\":\"" + files_url + "/" + id + "\",\"modifiedDate\":\"2026-01-01T00:00:00.000Z\""
+				",\"editable\":true,\"labels\":{\"trashed\":false},\"mimeType\":\"text/plain\""
+				",\"md5Checksum\":\"" + Md5( "aaa" ).Hex() + "\",\"fileSize\":\"3\""
+				",\"downloadUrl\":\"" + files_url + "/" + id + "?alt=media\""
+				",\"parents\":[{\"isRoot\":true,\"parentLink\":\"" + files_url + "/root\"}]}" ;
+			dest->Write( s.c_str(), s.size() ) ;
+			return 200 ;
+		}
+
+		std::string LastError() const { return "" ; }
+		std::string LastErrorHeaders() const { return "" ; }
+		std::string RedirLocation() const { return "" ; }
+		std::string Escape( const std::string& str ) { return str ; }
+		std::string Unescape( const std::string& str ) { return str ; }
+		void SetProgressReporter( Progress* ) {}
+
+		std::unique_ptr<http::Agent> Clone() const
+		{
+			return std::unique_ptr<http::Agent>( new CopyAgent( *this ) ) ;
+		}
+
+		unsigned Downloads() const { return *m_downloads ; }
+
+		std::vector<std::string>	requests ;
+		std::string					copy_meta ;
+
+	private :
+		bool									m_refuse ;
+		std::shared_ptr<std::atomic<unsigned> >	m_downloads ;
+	} ;
+
+	struct Fixture : TestDir
+	{
+		Fixture()
+		{
+			Write( "a.txt", "aaa" ) ;
+			Write( "b.txt", "aaa" ) ;
+
+			options.Add( "path",		Val( dir.string() ) ) ;
+			options.Add( "state-depth",	Val( 0 ) ) ;
+
+			// a.txt is in sync, b.txt is a new local file with the same content
+			WriteState( "\"a.txt\":" + Record( "aaa", 1 ) ) ;
+		}
+
+		void Sync( CopyAgent *agent )
+		{
+			v2::Syncer2 syncer( agent ) ;
+			State state( dir, options ) ;
+			state.FromLocal( dir ) ;
+			state.FromRemote( TestEntry( "a.txt", "aaa" ) ) ;
+			state.ResolveEntry() ;
+			state.Sync( &syncer, options ) ;
+		}
+
+		Val	options ;
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( CopyTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestCopyToRoot )
+{
+	CopyAgent agent( false ) ;
+	Sync( &agent ) ;
+
+	BOOST_REQUIRE_EQUAL( agent.requests.size(), 1u ) ;
+	BOOST_CHECK_EQUAL( agent.requests[0], "POST " + files_url + "/id-a.txt/copy" ) ;
+
+	// without the parent, Google Drive puts the copy next to the source
+	BOOST_CHECK( agent.copy_meta.find( "\"parents\":[{\"id\":\"root\"}]" ) != std::string::npos ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestCopyRefused )
+{
+	// the copy fails, b.txt must be uploaded instead of failing the sync
+	CopyAgent agent( true ) ;
+	Sync( &agent ) ;
+
+	BOOST_REQUIRE_EQUAL( agent.requests.size(), 2u ) ;
+	BOOST_CHECK_EQUAL( agent.requests[0], "POST " + files_url + "/id-a.txt/copy" ) ;
+	BOOST_CHECK( agent.requests[1].find( "uploadType=multipart" ) != std::string::npos ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestDownloadOnce )
+{
+	// c.txt and d.txt are new remote files with the same content
+	options.Add( "no-remote-new",	Val( false ) ) ;
+	CopyAgent agent( false ) ;
+	http::Lanes lanes( &agent, 1 ) ;
+	v2::Syncer2 syncer( &lanes ) ;
+	State state( dir, options ) ;
+	state.FromLocal( dir ) ;
+	state.FromRemote( TestEntry( "a.txt", "aaa" ) ) ;
+	state.FromRemote( TestEntry( "b.txt", "aaa" ) ) ;
+	state.FromRemote( TestEntry( "c.txt", "ccc" ) ) ;
+	state.FromRemote( TestEntry( "d.txt", "ccc" ) ) ;
+	state.ResolveEntry() ;
+	state.Sync( &syncer, options ) ;
+
+	// the second one is copied from the first when its download is done
+	BOOST_CHECK_EQUAL( agent.Downloads(), 1u ) ;
+	BOOST_CHECK( fs::exists( dir / "c.txt" ) ) ;
+	BOOST_CHECK( fs::exists( dir / "d.txt" ) ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
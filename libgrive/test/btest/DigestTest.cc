@@ -0,0 +1,129 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "util/Crypt.hh"
+#include "util/Digest.hh"
+#include "util/File.hh"
+#include "util/FileSystem.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+using namespace gr ;
+
+BOOST_AUTO_TEST_SUITE( DigestTest )
+
+BOOST_AUTO_TEST_CASE( TestHex )
+{
+	const std::string hex = "900150983cd24fb0d6963f7d28e17f72" ;
+	Digest d = Digest::FromHex( hex ) ;
+	BOOST_CHECK( !d.Empty() ) ;
+	BOOST_CHECK_EQUAL( d.Hex(), hex ) ;
+	BOOST_CHECK_EQUAL( d.Bytes()[0], 0x90 ) ;
+	BOOST_CHECK_EQUAL( d.Bytes()[15], 0x72 ) ;
+
+	// Google Drive may send upper case
+	BOOST_CHECK( Digest::FromHex( "900150983CD24FB0D6963F7D28E17F72" ) == d ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestInvalid )
+{
+	BOOST_CHECK( Digest().Empty() ) ;
+	BOOST_CHECK_EQUAL( Digest().Hex(), "" ) ;
+	BOOST_CHECK( Digest::FromHex( "" ).Empty() ) ;
+	BOOST_CHECK( Digest::FromHex( "abc" ).Empty() ) ;
+	BOOST_CHECK( Digest::FromHex( "900150983cd24fb0d6963f7d28e17fxx" ).Empty() ) ;
+	BOOST_CHECK( Digest::FromHex( "900150983cd24fb0d6963f7d28e17f7200" ).Empty() ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestCompare )
+{
+	Digest a = Digest::FromHex( "d41d8cd98f00b204e9800998ecf8427e" ) ;
+	Digest b = Digest::FromHex( "f96b697d7cb7938d525a2f31aaf161d0" ) ;
+	BOOST_CHECK( a != b ) ;
+	BOOST_CHECK( a < b && !( b < a ) ) ;
+	BOOST_CHECK( a == Digest::FromHex( a.Hex() ) ) ;
+	BOOST_CHECK_EQUAL( hash_value( a ), hash_value( Digest( a.Bytes() ) ) ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestFingerprint )
+{
+	// the reference values of XXH64 with seed 0
+	BOOST_CHECK_EQUAL( crypt::Fingerprint().Get(), 0xef46db3751d8e999ULL ) ;
+
+	std::string data ;
+	for ( int i = 0 ; i < 1280 ; i++ )
+		data += static_cast<char>( i % 256 ) ;
+	data += "xyz" ;
+
+	// the result must not depend on how the data is split
+	crypt::Fingerprint whole, parts ;
+	whole.Write( data.data(), data.size() ) ;
+	for ( std::size_t i = 0, n = 1 ; i < data.size() ; i += n, n = n * 2 + 1 )
+		parts.Write( data.data() + i, std::min( n, data.size() - i ) ) ;
+	BOOST_CHECK_EQUAL( whole.Get(), 0xafd18a3957d3670aULL ) ;
+	BOOST_CHECK_EQUAL( parts.Get(), whole.Get() ) ;
+
+	crypt::Fingerprint abc ;
+	abc.Write( "abc", 3 ) ;
+	BOOST_CHECK_EQUAL( crypt::Fingerprint::Hex( abc.Get() ), "44bc2cf5ad770999" ) ;
+	BOOST_CHECK_EQUAL( crypt::Fingerprint::FromHex( "44bc2cf5ad770999" ), abc.Get() ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestReadFrom )
+{
+	// a failed io_uring read leaves the first chunks already hashed, the
+	// plain reads must go on after them without passing them again
+	fs::path path = fs::temp_directory_path() / fs::unique_path( "grive-test-%%%%-%%%%" ) ;
+	std::string data ;
+	for ( std::size_t i = 0 ; i < 9 * 1024 * 1024 + 123 ; i++ )
+		data += static_cast<char>( ( i * 7919 ) >> 5 ) ;
+	std::ofstream( path.string().c_str() ).write( data.data(), data.size() ) ;
+
+	crypt::MD5 whole ;
+	whole.Write( data.data(), data.size() ) ;
+	crypt::Fingerprint whole_fp ;
+	whole_fp.Write( data.data(), data.size() ) ;
+
+	// the io_uring chunks are 512KB, not aligned on the mapped chunks
+	const std::size_t offsets[] = { 0, 512 * 1024, 4608 * 1024, data.size() } ;
+	for ( std::size_t i = 0 ; i < sizeof(offsets) / sizeof(offsets[0]) ; i++ )
+	{
+		crypt::MD5 md5 ;
+		md5.Write( data.data(), offsets[i] ) ;
+		crypt::Fingerprint fp ;
+		fp.Write( data.data(), offsets[i] ) ;
+
+		File file( path ) ;
+		crypt::ReadFrom( file, offsets[i], boost::bind( &crypt::MD5::Write, &md5, _1, _2 ) ) ;
+		crypt::ReadFrom( file, offsets[i], boost::bind( &crypt::Fingerprint::Write, &fp, _1, _2 ) ) ;
+		BOOST_CHECK_EQUAL( md5.Get(), whole.Get() ) ;
+		BOOST_CHECK_EQUAL( fp.Get(), whole_fp.Get() ) ;
+	}
+
+	File file( path ) ;
+	BOOST_CHECK_EQUAL( crypt::MD5::Get( file ), whole.Get() ) ;
+	fs::remove( path ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
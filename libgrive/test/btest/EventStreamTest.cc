@@ -0,0 +1,155 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "SimAgent.hh"
+#include "TestDir.hh"
+
+#include "base/Entry.hh"
+#include "base/State.hh"
+#include "drive2/Syncer2.hh"
+#include "json/JsonParser.hh"
+#include "json/Val.hh"
+#include "util/EventStream.hh"
+#include "util/FileSystem.hh"
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace gr ;
+using namespace gr::test ;
+
+namespace
+{
+	class TestEntry : public Entry
+	{
+	public :
+		TestEntry( const std::string& name, const std::string& parent, const std::string& content, long mtime )
+		{
+			m_title			= name ;
+			m_filename		= name ;
+			m_is_dir		= false ;
+			m_resource_id	= "id-" + name ;
+			m_self_href		= m_resource_id ;
+			m_content_src	= test::files_url + "/" + m_resource_id + "?alt=media" ;
+			m_parent_hrefs.push_back( parent ) ;
+			m_md5			= Md5( content ) ;
+			m_size			= content.size() ;
+			m_mtime			= DateTime( mtime, 0 ) ;
+		}
+
+		explicit TestEntry( const std::string& folder )
+		{
+			m_title			= folder ;
+			m_resource_id	= "id-" + folder ;
+			m_self_href		= m_resource_id ;
+			m_parent_hrefs.push_back( "root" ) ;
+			m_mtime			= DateTime( 1, 0 ) ;
+		}
+	} ;
+
+	std::vector<test::Item> Remote()
+	{
+		test::Item a = { "id-a.txt", false, std::vector<std::string>( 1, "id-docs" ), "aaaa" } ;
+		return std::vector<test::Item>( 1, a ) ;
+	}
+
+	struct Fixture : TestDir
+	{
+		Fixture() :
+			events	( dir.string() + ".events" ),
+			agent	( Remote() ),
+			syncer	( &agent )
+		{
+			fs::create_directories( dir / "docs" ) ;
+			Write( "docs/a.txt", "aaa" ) ;
+			Write( "old.txt", "old" ) ;
+
+			options.Add( "path",		Val( dir.string() ) ) ;
+			options.Add( "state-depth",	Val( 0 ) ) ;
+			options.Add( "upload-only",	Val( false ) ) ;
+			options.Add( "no-remote-new",	Val( false ) ) ;
+
+			WriteState( "\"old.txt\":" + Record( "old", 1 ) + ","
+				"\"docs\":" + Folder( "\"a.txt\":" + Record( "aaa", 1 ) ) ) ;
+
+			EventStream::Instance().Open( events.string() ) ;
+		}
+
+		~Fixture()
+		{
+			EventStream::Instance().Close() ;
+			fs::remove( events ) ;
+		}
+
+		/// the events written, by path
+		std::map<std::string, Val> Read()
+		{
+			std::map<std::string, Val> result ;
+			std::ifstream f( events.string().c_str() ) ;
+			std::string line ;
+			while ( std::getline( f, line ) )
+			{
+				Val event = ParseJson( line ) ;
+				result[event["path"].Str()] = event ;
+			}
+			return result ;
+		}
+
+		fs::path			events ;
+		Val					options ;
+		test::SimAgent		agent ;
+		v2::Syncer2			syncer ;
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( EventStreamTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestSyncEvents )
+{
+	// a.txt changed in Google Drive, and old.txt was deleted there
+	State state( dir, options ) ;
+	state.FromLocal( dir ) ;
+	state.FromRemote( TestEntry( "docs" ) ) ;
+	state.FromRemote( TestEntry( "a.txt", "id-docs", "aaaa", 2 ) ) ;
+	state.ResolveEntry() ;
+	state.Sync( &syncer, options ) ;
+
+	std::map<std::string, Val> written = Read() ;
+	BOOST_CHECK_EQUAL( written.size(), 2u ) ;
+
+	const Val& a = written["docs/a.txt"] ;
+	BOOST_CHECK_EQUAL( a["action"].Str(), "download" ) ;
+	BOOST_CHECK_EQUAL( a["type"].Str(), "file" ) ;
+	BOOST_CHECK_EQUAL( a["size"].U64(), 4u ) ;
+	BOOST_CHECK_EQUAL( a["md5"].Str(), Md5( "aaaa" ).Hex() ) ;
+	BOOST_CHECK_EQUAL( a["id"].Str(), "id-a.txt" ) ;
+	BOOST_CHECK_EQUAL( a["root"].Str(), dir.string() ) ;
+
+	const Val& old = written["old.txt"] ;
+	BOOST_CHECK_EQUAL( old["action"].Str(), "delete_local" ) ;
+	BOOST_CHECK_EQUAL( old["size"].U64(), 3u ) ;
+	BOOST_CHECK( !old.Has( "old_path" ) ) ;
+	BOOST_CHECK( !fs::exists( dir / "old.txt" ) ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "base/Entry.hh"
+#include "base/FeedReader.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+using namespace gr ;
+
+namespace
+{
+	/// a feed of \a pages pages of two entries, which fails after \a fail_after
+	class CountFeed : public Feed
+	{
+	public :
+		CountFeed( unsigned pages, unsigned fail_after ) :
+			Feed( "" ), m_pages( pages ), m_fail_after( fail_after ), m_read( 0 )
+		{
+		}
+
+		bool GetNext( http::Agent* )
+		{
+			if ( m_read == m_fail_after )
+				throw std::runtime_error( "failed" ) ;
+			if ( m_read == m_pages )
+				return false ;
+			m_read++ ;
+			m_entries.assign( 2, Entry() ) ;
+			return true ;
+		}
+
+	private :
+		unsigned	m_pages ;
+		unsigned	m_fail_after ;
+		unsigned	m_read ;
+	} ;
+
+	void Count( unsigned *count, const Entry& )
+	{
+		++*count ;
+	}
+
+	void Fail( const Entry& )
+	{
+		throw std::runtime_error( "apply failed" ) ;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( FeedReaderTest )
+
+BOOST_AUTO_TEST_CASE( TestAllEntries )
+{
+	CountFeed feed( 100, 1000 ) ;
+	unsigned count = 0 ;
+	FeedReader( &feed, 0, 2 ).Run( boost::bind( &Count, &count, _1 ) ) ;
+	BOOST_CHECK_EQUAL( count, 200u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestReadError )
+{
+	CountFeed feed( 100, 3 ) ;
+	unsigned count = 0 ;
+	BOOST_CHECK_THROW( FeedReader( &feed, 0 ).Run( boost::bind( &Count, &count, _1 ) ), std::runtime_error ) ;
+	BOOST_CHECK_EQUAL( count, 6u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestCallbackError )
+{
+	// the reader must not stay blocked on the full queue
+	CountFeed feed( 100, 1000 ) ;
+	BOOST_CHECK_THROW( FeedReader( &feed, 0, 1 ).Run( &Fail ), std::runtime_error ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
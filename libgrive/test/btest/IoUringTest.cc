@@ -0,0 +1,233 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "SimAgent.hh"
+#include "TestDir.hh"
+
+#include "base/Drive.hh"
+#include "base/State.hh"
+#include "drive2/Syncer2.hh"
+#include "http/Lanes.hh"
+#include "json/Val.hh"
+#include "util/Crypt.hh"
+#include "util/DateTime.hh"
+#include "util/File.hh"
+#include "util/FileSystem.hh"
+#include "util/IoUring.hh"
+#include "util/OS.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <signal.h>
+#include <sys/resource.h>
+
+using namespace gr ;
+
+namespace
+{
+	struct Fixture : test::TestDir
+	{
+		Fixture()
+		{
+			fs::create_directories( dir / "sub" ) ;
+
+			// several read buffers worth, with a short last chunk
+			big.resize( 9 * 1024 * 1024 + 123 ) ;
+			for ( std::size_t i = 0 ; i < big.size() ; i++ )
+				big[i] = static_cast<char>( i * 7 + i / 4096 ) ;
+			Write( "big.bin", big ) ;
+			Write( "a.txt", "aaa" ) ;
+			Write( "sub/b.txt", "bbbbb" ) ;
+			Write( "empty", "" ) ;
+		}
+
+		~Fixture()
+		{
+			IoUring::Instance().Enable( true ) ;
+		}
+
+		std::string	big ;
+	} ;
+
+	/// Files larger than \a bytes can't be written while it is in scope.
+	/// The writes past the limit fail with EFBIG.
+	class SizeLimit
+	{
+	public :
+		explicit SizeLimit( rlim_t bytes ) : m_sig( ::signal( SIGXFSZ, SIG_IGN ) )
+		{
+			::getrlimit( RLIMIT_FSIZE, &m_old ) ;
+			rlimit limit = m_old ;
+			limit.rlim_cur = bytes ;
+			::setrlimit( RLIMIT_FSIZE, &limit ) ;
+		}
+
+		~SizeLimit()
+		{
+			::setrlimit( RLIMIT_FSIZE, &m_old ) ;
+			::signal( SIGXFSZ, m_sig ) ;
+		}
+
+	private :
+		rlimit		m_old ;
+		sighandler_t	m_sig ;
+	} ;
+
+	void Append( std::string *out, const char *data, std::size_t size )
+	{
+		out->append( data, size ) ;
+	}
+
+	std::string ReadAll( const fs::path& path )
+	{
+		std::string out ;
+		File file( path ) ;
+		crypt::ReadAll( file, boost::bind( &Append, &out, _1, _2 ) ) ;
+		return out ;
+	}
+
+	struct StatResult
+	{
+		DateTime	mtime ;
+		off64_t		size ;
+		FileType	type ;
+		os::FileId	id ;
+	} ;
+
+	StatResult Stat( const fs::path& path )
+	{
+		StatResult r ;
+		os::Stat( path, &r.mtime, &r.size, &r.type, &r.id ) ;
+		return r ;
+	}
+
+	void CheckSame( const StatResult& a, const StatResult& b )
+	{
+		BOOST_CHECK( a.mtime == b.mtime ) ;
+		BOOST_CHECK_EQUAL( a.size, b.size ) ;
+		BOOST_CHECK_EQUAL( a.type, b.type ) ;
+		BOOST_CHECK_EQUAL( a.id.dev, b.id.dev ) ;
+		BOOST_CHECK_EQUAL( a.id.ino, b.id.ino ) ;
+		BOOST_CHECK_EQUAL( a.id.nlink, b.id.nlink ) ;
+	}
+
+	void ScanLocal( const fs::path& dir )
+	{
+		Val options ;
+		options.Add( "path", Val( dir.string() ) ) ;
+		State state( dir, options ) ;
+		state.FromLocal( dir ) ;
+	}
+}
+
+BOOST_FIXTURE_TEST_SUITE( IoUringTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestReadAll )
+{
+	// on the ring if this build and kernel have one
+	BOOST_CHECK( ReadAll( dir / "big.bin" ) == big ) ;
+	BOOST_CHECK_EQUAL( ReadAll( dir / "a.txt" ), "aaa" ) ;
+	BOOST_CHECK_EQUAL( ReadAll( dir / "empty" ), "" ) ;
+	Digest on_md5 = crypt::MD5::Get( dir / "big.bin" ) ;
+
+	IoUring::Instance().Enable( false ) ;
+	BOOST_CHECK( !IoUring::Instance().Available() ) ;
+	BOOST_CHECK( ReadAll( dir / "big.bin" ) == big ) ;
+	BOOST_CHECK_EQUAL( ReadAll( dir / "a.txt" ), "aaa" ) ;
+	BOOST_CHECK_EQUAL( ReadAll( dir / "empty" ), "" ) ;
+	BOOST_CHECK( crypt::MD5::Get( dir / "big.bin" ) == on_md5 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestStat )
+{
+	const char *names[] = { "big.bin", "a.txt", "sub", "sub/b.txt", "empty" } ;
+
+	// with the stats of the listing prefetched
+	std::vector<std::string> paths ;
+	for ( std::size_t i = 0 ; i < sizeof(names)/sizeof(names[0]) ; i++ )
+		paths.push_back( ( dir / names[i] ).string() ) ;
+	IoUring::Instance().PrefetchStat( paths ) ;
+	std::vector<StatResult> on ;
+	for ( std::size_t i = 0 ; i < paths.size() ; i++ )
+		on.push_back( Stat( paths[i] ) ) ;
+
+	IoUring::Instance().Enable( false ) ;
+	IoUring::Instance().PrefetchStat( paths ) ;
+	for ( std::size_t i = 0 ; i < paths.size() ; i++ )
+		CheckSame( on[i], Stat( paths[i] ) ) ;
+
+	BOOST_CHECK_EQUAL( on[0].size, static_cast<off64_t>( big.size() ) ) ;
+	BOOST_CHECK_EQUAL( on[2].type, FT_DIR ) ;
+	BOOST_CHECK_EQUAL( on[3].size, 5 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestNoStaleStat )
+{
+	// the stats prefetched for a listing must not be handed out after it
+	ScanLocal( dir ) ;
+	Write( "a.txt", "aaaaaaa" ) ;
+	BOOST_CHECK_EQUAL( Stat( dir / "a.txt" ).size, 7 ) ;
+
+	std::vector<std::string> paths( 1, ( dir / "a.txt" ).string() ) ;
+	IoUring::Instance().PrefetchStat( paths ) ;
+	IoUring::Instance().DropStats( paths ) ;
+	Write( "a.txt", "a" ) ;
+	BOOST_CHECK_EQUAL( Stat( dir / "a.txt" ).size, 1 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestFailedWrite )
+{
+	// f2 can't be written, e.g. the disk is full. its download fails, but
+	// the ones queued with it on the bulk lane must still finish
+	std::vector<test::Item> items ;
+	const char *names[] = { "f1", "f2", "f3", "f4" } ;
+	for ( std::size_t i = 0 ; i < 4 ; i++ )
+	{
+		test::Item item = { names[i], false, std::vector<std::string>( 1, "root" ),
+			i == 1 ? big : std::string( names[i] ) } ;
+		items.push_back( item ) ;
+	}
+	test::SimAgent agent( items ) ;
+	http::Lanes lanes( &agent, 2 ) ;
+	v2::Syncer2 syncer( &lanes ) ;
+
+	Val options ;
+	options.Add( "path",				Val( ( dir / "sync" ).string() ) ) ;
+	options.Add( "no-remote-new",		Val( false ) ) ;
+	options.Add( "upload-only",			Val( false ) ) ;
+	options.Add( "no-delete-remote",	Val( false ) ) ;
+	options.Add( "new-rev",				Val( false ) ) ;
+	fs::create_directories( dir / "sync" ) ;
+
+	Drive drive( &syncer, options ) ;
+	drive.DetectChanges() ;
+	{
+		SizeLimit limit( 1024 * 1024 ) ;
+		BOOST_CHECK_NO_THROW( drive.Update() ) ;
+	}
+
+	BOOST_CHECK( ReadAll( dir / "sync/f2" ).size() < big.size() ) ;
+	BOOST_CHECK_EQUAL( ReadAll( dir / "sync/f1" ), "f1" ) ;
+	BOOST_CHECK_EQUAL( ReadAll( dir / "sync/f3" ), "f3" ) ;
+	BOOST_CHECK_EQUAL( ReadAll( dir / "sync/f4" ), "f4" ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, 4u ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
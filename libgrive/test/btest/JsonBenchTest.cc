@@ -0,0 +1,203 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Bench.hh"
+#include "TestDir.hh"
+
+#include "json/JsonIndexParser.hh"
+#include "json/JsonParser.hh"
+#include "json/ValBuilder.hh"
+#include "json/ValVisitor.hh"
+#include "util/File.hh"
+
+#include <boost/format.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using namespace gr ;
+
+namespace
+{
+	/// counts the values, the least a visitor can do
+	struct Count : ValVisitor
+	{
+		Count() : n( 0 ) {}
+
+		void Visit( long long )				{ n++ ; }
+		void Visit( double )				{ n++ ; }
+		void Visit( const std::string& )	{ n++ ; }
+		void Visit( bool )					{ n++ ; }
+		void VisitNull()					{ n++ ; }
+		void StartArray()					{ n++ ; }
+		void EndArray()						{}
+		void StartObject()					{ n++ ; }
+		void VisitKey( const std::string& )	{ n++ ; }
+		void EndObject()					{}
+
+		long	n ;
+	} ;
+
+	const char *Name( JsonParser::Backend backend )
+	{
+		return backend == JsonParser::yajl_backend ? "yajl" : "index" ;
+	}
+
+	const char *Name( JsonIndexParser::Isa isa )
+	{
+		static const char *names[] = { "scalar", "sse2", "avx2" } ;
+		return names[isa] ;
+	}
+
+	struct Fixture : test::TestDir
+	{
+		/// a files.list page of Google Drive API v2 with \a items files, as
+		/// returned with maxResults=1000
+		static std::string Page( int items )
+		{
+			std::ostringstream ss ;
+			ss << "{\n \"kind\": \"drive#fileList\",\n \"etag\": \"\\\"Xyz-9AbCdEf/GhIjKlMnOpQrStUv\\\"\",\n"
+				" \"nextPageToken\": \"EAIa8wELEgBS6gEKsQEKlwEI4tP0lI7d0gISiwEKhgEKBGZpbGUS\",\n \"items\": [\n" ;
+			for ( int n = 0 ; n < items ; n++ )
+			{
+				std::string id = ( boost::format( "0B1x2y3z4w5v6u7t8s9r%08d" ) % n ).str() ;
+				ss << ( n > 0 ? ",\n" : "" ) << "  {\n"
+					"   \"kind\": \"drive#file\",\n"
+					"   \"id\": \"" << id << "\",\n"
+					"   \"etag\": \"\\\"Xyz-9AbCdEf/MTQ4NjA5NDcwNjAwMA\\\"\",\n"
+					"   \"selfLink\": \"https://www.googleapis.com/drive/v2/files/" << id << "\",\n"
+					"   \"webContentLink\": \"https://docs.google.com/uc?id=" << id << "&export=download\",\n"
+					"   \"alternateLink\": \"https://drive.google.com/file/d/" << id << "/view?usp=drivesdk\",\n"
+					"   \"title\": \"" << ( boost::format( "report-%04d-final-version.txt" ) % n ) << "\",\n"
+					"   \"mimeType\": \"text/plain\",\n"
+					"   \"labels\": {\n    \"starred\": false,\n    \"hidden\": false,\n    \"trashed\": false,\n"
+					"    \"restricted\": false,\n    \"viewed\": true\n   },\n"
+					"   \"createdDate\": \"2017-02-03T04:05:06.000Z\",\n"
+					"   \"modifiedDate\": \"2017-02-03T04:05:06.789Z\",\n"
+					"   \"parents\": [\n    {\n     \"kind\": \"drive#parentReference\",\n"
+					"     \"id\": \"0B1x2y3z4w5v6u7t8s9rAAAA\",\n"
+					"     \"parentLink\": \"https://www.googleapis.com/drive/v2/files/0B1x2y3z4w5v6u7t8s9rAAAA\",\n"
+					"     \"isRoot\": false\n    }\n   ],\n"
+					"   \"downloadUrl\": \"https://doc-0s-8k-docs.googleusercontent.com/docs/securesc/" << id << "?e=download\",\n"
+					"   \"originalFilename\": \"report.txt\",\n"
+					"   \"fileExtension\": \"txt\",\n"
+					"   \"md5Checksum\": \"900150983cd24fb0d6963f7d28e17f72\",\n"
+					"   \"fileSize\": \"" << n * 37 << "\",\n"
+					"   \"quotaBytesUsed\": \"" << n * 37 << "\",\n"
+					"   \"version\": \"" << 1000 + n << "\",\n"
+					"   \"editable\": true,\n   \"copyable\": true,\n   \"shared\": false\n  }" ;
+			}
+			ss << "\n ]\n}\n" ;
+			return ss.str() ;
+		}
+
+		/// write a state file of at least \a mb MB, folders of 100 files each
+		fs::path State( long mb ) const
+		{
+			fs::path path = dir / "state.json" ;
+			std::ofstream out( path.string().c_str(), std::ios::binary ) ;
+			out << "{\"change_stamp\":1,\"shard_depth\":0,\"tree\":{" ;
+			for ( int d = 0 ; out.tellp() < mb * 1000000 ; d++ )
+			{
+				std::string folder = ( boost::format( "folder-%06d" ) % d ).str() ;
+				out << ( d > 0 ? "," : "" ) << '"' << folder << "\":{\"ctime\":1486094706,\"tree\":{" ;
+				for ( int f = 0 ; f < 100 ; f++ )
+					out << ( f > 0 ? "," : "" ) << '"' << ( boost::format( "report-%04d-final-version.txt" ) % f )
+						<< "\":{\"ctime\":1486094706,\"fp\":\"44bc2cf5ad770999\","
+						"\"md5\":\"900150983cd24fb0d6963f7d28e17f72\",\"size\":" << f * 37
+						<< ",\"srv_time\":1486094706}" ;
+				out << "}}" ;
+			}
+			out << "}}" ;
+			return path ;
+		}
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( JsonBenchTest, Fixture )
+
+/// A page of the changes or files feed, parsed into a Val as FeedReader does.
+/// GR_BENCH_RUNS sets the number of pages.
+BOOST_AUTO_TEST_CASE( TestFeedPage )
+{
+	if ( !test::Bench() )
+		return ;
+
+	std::string page = Page( 1000 ) ;
+	long runs = test::BenchParam( "GR_BENCH_RUNS", 50 ) ;
+	std::cout << "feed page of 1000 files, " << page.size() << " bytes, " << runs << " runs" << std::endl ;
+
+	for ( int b = JsonParser::yajl_backend ; b <= JsonParser::index_backend ; b++ )
+	{
+		JsonParser::Backend backend = static_cast<JsonParser::Backend>( b ) ;
+		test::Stopwatch sw ;
+		for ( long i = 0 ; i < runs ; i++ )
+		{
+			ValBuilder vb ;
+			JsonParser parser( &vb, backend ) ;
+			parser.Parse( page.data(), page.size() ) ;
+			parser.Finish() ;
+			BOOST_REQUIRE_EQUAL( vb.Result()["items"].AsArray().size(), 1000u ) ;
+		}
+		test::Report( std::string( "page to Val, " ) + Name( backend ), sw.Seconds(), runs, page.size() ) ;
+	}
+
+	for ( int i = JsonIndexParser::scalar_isa ; i <= JsonIndexParser::BestIsa() ; i++ )
+	{
+		JsonIndexParser::Isa isa = static_cast<JsonIndexParser::Isa>( i ) ;
+		std::vector<uint32_t> index ;
+		test::Stopwatch sw ;
+		for ( long r = 0 ; r < runs ; r++ )
+		{
+			index.clear() ;
+			JsonIndexParser::BuildIndex( page.data(), page.size(), index, isa ) ;
+		}
+		test::Report( std::string( "page index only, " ) + Name( isa ), sw.Seconds(), runs, page.size() ) ;
+	}
+}
+
+/// The state file read from disk in the way State does, with GR_BENCH_MB
+/// (100 by default) MB of folders and files.
+BOOST_AUTO_TEST_CASE( TestStateFile )
+{
+	if ( !test::Bench() )
+		return ;
+
+	long mb = test::BenchParam( "GR_BENCH_MB", 100 ) ;
+	fs::path path = State( mb ) ;
+	std::cout << "state file, " << fs::file_size( path ) << " bytes" << std::endl ;
+
+	long values[2] = {} ;
+	for ( int b = JsonParser::yajl_backend ; b <= JsonParser::index_backend ; b++ )
+	{
+		JsonParser::Backend backend = static_cast<JsonParser::Backend>( b ) ;
+		Count count ;
+		test::Stopwatch sw ;
+		File file( path ) ;
+		JsonParser parser( &count, backend ) ;
+		parser.Parse( file ) ;
+		parser.Finish() ;
+		test::Report( std::string( "state file, " ) + Name( backend ), sw.Seconds(), 1, fs::file_size( path ) ) ;
+		values[b] = count.n ;
+	}
+	BOOST_CHECK_EQUAL( values[0], values[1] ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
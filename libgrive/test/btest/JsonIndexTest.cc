@@ -0,0 +1,105 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "json/JsonIndexParser.hh"
+#include "json/JsonParser.hh"
+#include "json/JsonWriter.hh"
+#include "json/ValBuilder.hh"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace gr ;
+
+namespace
+{
+	struct Fixture
+	{
+		static std::string Parse( const std::string& json, JsonParser::Backend backend )
+		{
+			ValBuilder b ;
+			JsonParser parser( &b, backend ) ;
+			parser.Parse( json.data(), json.size() ) ;
+			parser.Finish() ;
+			return WriteJson( b.Result() ) ;
+		}
+
+		/// strings with escapes and runs of backslashes across the 64 byte blocks
+		static std::string Document()
+		{
+			std::string json = "{\"list\" : [" ;
+			for ( int i = 0 ; i < 70 ; i++ )
+			{
+				json += "\"" + std::string( i, 'x' ) + std::string( 2 * ( i % 5 ), '\\' ) + "\\\"q\\u00e9\\n\", " ;
+				json += "{\"k\\\\\":" + std::string( i % 7, ' ' ) + "-12.5e3, \"t\":true,\"n\":null,\"f\":false}, " ;
+			}
+			json += "9223372036854775807, -9223372036854775808, 0, \"{[,:]}\"]}" ;
+			return json ;
+		}
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( JsonIndexTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestIsa )
+{
+	std::string json = Document() ;
+	std::vector<uint32_t> scalar, simd ;
+	JsonIndexParser::BuildIndex( json.data(), json.size(), scalar, JsonIndexParser::scalar_isa ) ;
+	BOOST_CHECK_EQUAL( json[scalar.front()], '{' ) ;
+	BOOST_CHECK_EQUAL( json[scalar.back()], '}' ) ;
+
+	for ( int isa = JsonIndexParser::sse2_isa ; isa <= JsonIndexParser::BestIsa() ; isa++ )
+	{
+		simd.clear() ;
+		JsonIndexParser::BuildIndex( json.data(), json.size(), simd, static_cast<JsonIndexParser::Isa>( isa ) ) ;
+		BOOST_CHECK( scalar == simd ) ;
+	}
+}
+
+BOOST_AUTO_TEST_CASE( TestSameAsYajl )
+{
+	const std::string docs[] =
+	{
+		Document(),
+		"{}", "[]", " [ 1 , [ ] , { } ] ", "\"\"", "0", "-1.5",
+		"{\"a\":{\"b\":[1,2,{\"c\":\"\\\\\"}]}}",
+	} ;
+	for ( std::size_t i = 0 ; i < sizeof(docs) / sizeof(docs[0]) ; i++ )
+		BOOST_CHECK_EQUAL( Parse( docs[i], JsonParser::index_backend ), Parse( docs[i], JsonParser::yajl_backend ) ) ;
+
+	// surrogate pairs are one character, lone surrogates are '?'
+	BOOST_CHECK_EQUAL( Parse( "\"\\ud83d\\ude00\\udc00\"", JsonParser::index_backend ), "\"\xf0\x9f\x98\x80?\"" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestErrors )
+{
+	const char *docs[] =
+	{
+		"", "{", "[1,]", "{\"a\" 1}", "{\"a\":1,}", "[1 2]", "tru", "\"abc",
+		"[01]", "{}{}", "[\"a\\x\"]", "[1.]", "99999999999999999999", "[\"a\nb\"]",
+		"{1:2}", "[}", "]", "{\"a\":1\\}", "[1\\,2]",
+	} ;
+	for ( std::size_t i = 0 ; i < sizeof(docs) / sizeof(docs[0]) ; i++ )
+		BOOST_CHECK_THROW( Parse( docs[i], JsonParser::index_backend ), JsonParser::Error ) ;
+
+	// in the second block of 64 bytes
+	BOOST_CHECK_THROW( Parse( "[" + std::string( 70, ' ' ) + "1\\]", JsonParser::index_backend ), JsonParser::Error ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,238 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "http/Header.hh"
+#include "http/Lanes.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace gr ;
+
+namespace
+{
+	// set when two threads are in a request of the same agent
+	std::atomic<bool> shared_use( false ) ;
+
+	// the download limit of the agent of the last request to "limit"
+	std::atomic<unsigned> seen_limit( 0 ) ;
+
+	/// an agent whose requests to "slow" take a while
+	class DelayAgent : public http::Agent
+	{
+	public :
+		DelayAgent() : m_busy( 0 )
+		{
+		}
+
+		http::ResponseLog* GetLog() const { return 0 ; }
+		void SetLog( http::ResponseLog* ) {}
+
+		long Request( const std::string&, const std::string& url, SeekStream*, DataStream*,
+			const http::Header&, u64_t )
+		{
+			if ( ++m_busy > 1 )
+				shared_use = true ;
+			if ( url == "slow" )
+				std::this_thread::sleep_for( std::chrono::milliseconds( 300 ) ) ;
+			if ( url == "limit" )
+				seen_limit = mMaxDownload ;
+			m_busy-- ;
+			return 200 ;
+		}
+
+		std::string LastError() const { return "" ; }
+		std::string LastErrorHeaders() const { return "" ; }
+		std::string RedirLocation() const { return "" ; }
+		std::string Escape( const std::string& str ) { return str ; }
+		std::string Unescape( const std::string& str ) { return str ; }
+		void SetProgressReporter( Progress* ) {}
+
+		std::unique_ptr<http::Agent> Clone() const
+		{
+			// like CurlAgent, the clones keep the limits
+			std::unique_ptr<http::Agent> agent( new DelayAgent ) ;
+			agent->SetUploadSpeed( mMaxUpload ) ;
+			agent->SetDownloadSpeed( mMaxDownload ) ;
+			return agent ;
+		}
+
+	private :
+		std::atomic<int>	m_busy ;
+	} ;
+
+	void Transfer( http::Agent *agent, bool *done )
+	{
+		agent->Get( "slow", 0, http::Header() ) ;
+		*done = true ;
+	}
+
+	void Slow( http::Agent *agent )
+	{
+		agent->Get( "slow", 0, http::Header() ) ;
+	}
+
+	void Limit( http::Agent *agent )
+	{
+		agent->Get( "limit", 0, http::Header() ) ;
+	}
+
+	void Fail()
+	{
+		throw std::runtime_error( "failed" ) ;
+	}
+
+	void Sleep()
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( 300 ) ) ;
+	}
+
+	/// e.g. a download waiting for its writes to reach the file
+	void Local( http::Agent *agent )
+	{
+		agent->Apart( &Sleep ) ;
+		agent->Get( "fast", 0, http::Header() ) ;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( LanesTest )
+
+BOOST_AUTO_TEST_CASE( TestNoHeadOfLineBlocking )
+{
+	DelayAgent agent ;
+	http::Lanes lanes( &agent, 1 ) ;
+
+	bool done = false ;
+	lanes.Bulk( boost::bind( &Transfer, &lanes, &done ) ) ;
+
+	// the metadata request doesn't wait for the transfer queued before it
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() ;
+	lanes.Get( "fast", 0, http::Header() ) ;
+	BOOST_CHECK( std::chrono::steady_clock::now() - start < std::chrono::milliseconds( 200 ) ) ;
+	BOOST_CHECK( !done ) ;
+
+	lanes.WaitBulk() ;
+	BOOST_CHECK( done ) ;
+	BOOST_CHECK_EQUAL( lanes.LaneUsage( http::Lanes::metadata_lane ).requests, 1u ) ;
+	BOOST_CHECK_EQUAL( lanes.LaneUsage( http::Lanes::bulk_lane ).requests, 1u ) ;
+	BOOST_CHECK( lanes.LaneUsage( http::Lanes::bulk_lane ).busy >= 0.3 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestNoBulkThreads )
+{
+	DelayAgent agent ;
+	http::Lanes lanes( &agent, 0 ) ;
+
+	// the job runs right away
+	bool done = false ;
+	lanes.Bulk( boost::bind( &Transfer, &lanes, &done ) ) ;
+	BOOST_CHECK( done ) ;
+	BOOST_CHECK_EQUAL( lanes.LaneUsage( http::Lanes::metadata_lane ).requests, 1u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestError )
+{
+	DelayAgent agent ;
+	http::Lanes lanes( &agent, 1 ) ;
+
+	// the job after the failed one still runs
+	bool done = false ;
+	lanes.Bulk( &Fail ) ;
+	lanes.Bulk( boost::bind( &Transfer, &lanes, &done ) ) ;
+	BOOST_CHECK_THROW( lanes.WaitBulk(), std::runtime_error ) ;
+	BOOST_CHECK( done ) ;
+
+	// the lanes can be used again afterwards
+	done = false ;
+	lanes.Bulk( boost::bind( &Transfer, &lanes, &done ) ) ;
+	lanes.WaitBulk() ;
+	BOOST_CHECK( done ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestApart )
+{
+	DelayAgent agent ;
+	http::Lanes lanes( &agent, 3 ) ;
+
+	// the local work of the jobs runs side by side, and beside the
+	// metadata lane
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() ;
+	for ( int i = 0 ; i < 3 ; i++ )
+		lanes.Bulk( boost::bind( &Local, &lanes ) ) ;
+	lanes.Apart( &Sleep ) ;
+	lanes.WaitBulk() ;
+	BOOST_CHECK( std::chrono::steady_clock::now() - start < std::chrono::milliseconds( 600 ) ) ;
+	BOOST_CHECK_EQUAL( lanes.LaneUsage( http::Lanes::bulk_lane ).requests, 3u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestOtherThread )
+{
+	DelayAgent agent ;
+	http::Lanes lanes( &agent, 1 ) ;
+	shared_use = false ;
+
+	// e.g. the read-ahead of the remote listing, while the metadata lane is
+	// busy. each must have a connection of its own
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() ;
+	std::thread other( &Slow, &lanes ) ;
+	lanes.Get( "slow", 0, http::Header() ) ;
+	other.join() ;
+
+	BOOST_CHECK( !shared_use ) ;
+	BOOST_CHECK( std::chrono::steady_clock::now() - start < std::chrono::milliseconds( 500 ) ) ;
+	BOOST_CHECK_EQUAL( lanes.LaneUsage( http::Lanes::metadata_lane ).requests, 1u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestSpeedSplit )
+{
+	// the limit is for the bulk connections together
+	DelayAgent agent ;
+	http::Lanes lanes( &agent, 4 ) ;
+	lanes.SetDownloadSpeed( 1000 ) ;
+	lanes.Bulk( boost::bind( &Limit, &lanes ) ) ;
+	lanes.WaitBulk() ;
+	BOOST_CHECK_EQUAL( seen_limit, 250u ) ;
+
+	// also when they are already there, and for the spare ones
+	lanes.SetDownloadSpeed( 2000 ) ;
+	lanes.Bulk( boost::bind( &Limit, &lanes ) ) ;
+	lanes.WaitBulk() ;
+	BOOST_CHECK_EQUAL( seen_limit, 500u ) ;
+	std::thread other( &Limit, &lanes ) ;
+	other.join() ;
+	BOOST_CHECK_EQUAL( seen_limit, 500u ) ;
+
+	// all of it for a single connection, and never rounded down to no limit
+	DelayAgent single ;
+	http::Lanes one( &single, 0 ) ;
+	one.SetDownloadSpeed( 1000 ) ;
+	one.Bulk( boost::bind( &Limit, &one ) ) ;
+	BOOST_CHECK_EQUAL( seen_limit, 1000u ) ;
+	lanes.SetDownloadSpeed( 3 ) ;
+	lanes.Bulk( boost::bind( &Limit, &lanes ) ) ;
+	lanes.WaitBulk() ;
+	BOOST_CHECK_EQUAL( seen_limit, 1u ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
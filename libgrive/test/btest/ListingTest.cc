@@ -0,0 +1,128 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "base/Entry.hh"
+#include "base/Feed.hh"
+#include "base/FolderLister.hh"
+#include "drive2/Syncer2.hh"
+
+#include "SimAgent.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace gr ;
+using namespace gr::test ;
+
+namespace
+{
+	struct Fixture
+	{
+		Fixture()
+		{
+			Add( "a",		true,	"root" ) ;
+			Add( "b",		true,	"root" ) ;
+			Add( "c",		true,	"a" ) ;
+			Add( "d",		true,	"c" ) ;
+			Add( "f1",		false,	"root" ) ;
+			Add( "f2",		false,	"a" ) ;
+			Add( "f3",		false,	"a" ) ;
+			Add( "f4",		false,	"a" ) ;
+			Add( "f5",		false,	"b" ) ;
+			Add( "f6",		false,	"c" ) ;
+			Add( "f7",		false,	"d" ) ;
+			Add( "shared",	false,	"" ) ;
+
+			// in two folders at once
+			items.back().parents.clear() ;
+			Add( "multi",	false,	"b" ) ;
+			items.back().parents.push_back( "d" ) ;
+		}
+
+		void Add( const std::string& id, bool is_dir, const std::string& parent )
+		{
+			Item item = { id, is_dir, std::vector<std::string>(), is_dir ? "" : id } ;
+			if ( !parent.empty() )
+				item.parents.push_back( parent ) ;
+			items.push_back( item ) ;
+		}
+
+		static void Collect( std::multiset<std::string> *out, const Entry& e )
+		{
+			out->insert( e.SelfHref() ) ;
+		}
+
+		std::vector<Item>	items ;
+	} ;
+
+	void Fail( const Entry& )
+	{
+		throw std::runtime_error( "apply failed" ) ;
+	}
+}
+
+BOOST_FIXTURE_TEST_SUITE( ListingTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestSameAsSingleListing )
+{
+	SimAgent agent( items ) ;
+	v2::Syncer2 syncer( &agent ) ;
+
+	std::multiset<std::string> all ;
+	std::unique_ptr<Feed> feed = syncer.GetAll() ;
+	while ( feed->GetNext( &agent ) )
+	{
+		for ( Feed::iterator i = feed->begin() ; i != feed->end() ; ++i )
+			Collect( &all, *i ) ;
+	}
+
+	// files outside of the tree are only in the full listing
+	all.erase( files_url + "/shared" ) ;
+	BOOST_CHECK_EQUAL( all.size(), items.size() - 1 ) ;
+
+	for ( unsigned threads = 1 ; threads <= 4 ; threads++ )
+	{
+		std::multiset<std::string> tree ;
+		FolderLister lister( &syncer, threads ) ;
+		lister.Run( boost::bind( &Fixture::Collect, &tree, _1 ) ) ;
+
+		BOOST_CHECK( tree == all ) ;
+	}
+}
+
+BOOST_AUTO_TEST_CASE( TestCallbackError )
+{
+	SimAgent agent( items ) ;
+	v2::Syncer2 syncer( &agent ) ;
+
+	// one page at a time is waiting for the callback
+	std::multiset<std::string> tree ;
+	FolderLister( &syncer, 3, 1 ).Run( boost::bind( &Fixture::Collect, &tree, _1 ) ) ;
+	BOOST_CHECK_EQUAL( tree.size(), items.size() - 1 ) ;
+
+	// the workers must not stay blocked on the full queue
+	BOOST_CHECK_THROW( FolderLister( &syncer, 3, 1 ).Run( &Fail ), std::runtime_error ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,168 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "TestDir.hh"
+
+#include "base/Entry.hh"
+#include "base/FeedReader.hh"
+#include "base/State.hh"
+#include "drive2/Entry2.hh"
+#include "json/Val.hh"
+#include "util/FileSystem.hh"
+#include "util/MemStats.hh"
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using namespace gr ;
+
+namespace
+{
+	/// a folder of 10 folders of 100 files each, with names of 30 characters
+	struct Fixture : test::TestDir
+	{
+		Fixture()
+		{
+			// as left by the last sync
+			std::ostringstream st ;
+			for ( int d = 0 ; d < 10 ; d++ )
+			{
+				std::string folder = ( boost::format( "folder-%02d" ) % d ).str() ;
+				fs::create_directories( dir / folder ) ;
+				st << ( d > 0 ? "," : "" ) << '"' << folder << "\":{\"ctime\":1,\"tree\":{" ;
+				for ( int f = 0 ; f < 100 ; f++ )
+				{
+					std::string file = ( boost::format( "report-%04d-final-version.txt" ) % f ).str() ;
+					std::ofstream( ( dir / folder / file ).string().c_str() ) << f ;
+					st << ( f > 0 ? "," : "" ) << '"' << file << "\":{\"ctime\":9999999999,"
+						"\"fp\":\"44bc2cf5ad770999\",\"md5\":\"900150983cd24fb0d6963f7d28e17f72\","
+						"\"size\":3,\"srv_time\":1486094706}" ;
+				}
+				st << "}}" ;
+			}
+			WriteState( st.str() ) ;
+		}
+	} ;
+
+	Val Str( const std::string& s )
+	{
+		return Val( s ) ;
+	}
+
+	/// an item of a files.list page of Google Drive API v2
+	Val Item( int n )
+	{
+		std::string id = ( boost::format( "0B1x2y3z4w5v6u7t8s9r%08d" ) % n ).str() ;
+		Val parent ;
+		parent.Add( "isRoot", Val( false ) ) ;
+		parent.Add( "parentLink", Str( "https://www.googleapis.com/drive/v2/files/0B1x2y3z4w5v6u7t8s9rAAAA" ) ) ;
+		Val parents( Val::array_type ) ;
+		parents.Add( parent ) ;
+		Val labels ;
+		labels.Add( "trashed", Val( false ) ) ;
+
+		Val item ;
+		item.Add( "kind", Str( "drive#file" ) ) ;
+		item.Add( "id", Str( id ) ) ;
+		item.Add( "etag", Str( "\"MTQ4NjA4OTk2NzAwMA\"" ) ) ;
+		item.Add( "title", Str( ( boost::format( "report-%04d-final-version.txt" ) % n ).str() ) ) ;
+		item.Add( "selfLink", Str( "https://www.googleapis.com/drive/v2/files/" + id ) ) ;
+		item.Add( "downloadUrl", Str( "https://doc-04-2c-docs.googleusercontent.com/docs/securesc/" + id + "?e=download" ) ) ;
+		item.Add( "mimeType", Str( "text/plain" ) ) ;
+		item.Add( "modifiedDate", Str( "2017-02-03T04:05:06.789Z" ) ) ;
+		item.Add( "md5Checksum", Str( "900150983cd24fb0d6963f7d28e17f72" ) ) ;
+		item.Add( "fileSize", Str( "3" ) ) ;
+		item.Add( "editable", Val( true ) ) ;
+		item.Add( "labels", labels ) ;
+		item.Add( "parents", parents ) ;
+		return item ;
+	}
+
+	class PageFeed : public Feed
+	{
+	public :
+		PageFeed() : Feed( "" ), m_read( 0 )
+		{
+		}
+
+		bool GetNext( http::Agent* )
+		{
+			if ( m_read++ == 5 )
+				return false ;
+			m_entries.clear() ;
+			for ( int i = 0 ; i < 100 ; i++ )
+				m_entries.push_back( v2::Entry2( Item( i ) ) ) ;
+			return true ;
+		}
+
+	private :
+		int		m_read ;
+	} ;
+
+	void Ignore( const Entry& )
+	{
+	}
+}
+
+BOOST_FIXTURE_TEST_SUITE( MemStatsTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestTreeBudget )
+{
+	Val options ;
+	options.Add( "path", Val( dir.string() ) ) ;
+	State state( dir, options ) ;
+	state.FromLocal( dir ) ;
+	state.SampleMemory( "test" ) ;
+
+	// the root, the folders and the files
+	MemStats& stats = MemStats::Instance() ;
+	BOOST_CHECK_EQUAL( stats.Count( MemStats::resources ), 1011u ) ;
+	BOOST_CHECK_EQUAL( stats.Count( MemStats::state ), 1011u ) ;
+
+	// bytes per entry, about 650 and 300 at the time of writing
+	BOOST_CHECK_LE( stats.Bytes( MemStats::resources ) / 1011, 768u ) ;
+	BOOST_CHECK_LE( stats.Bytes( MemStats::state ) / 1011, 384u ) ;
+	BOOST_CHECK_EQUAL( stats.Count( MemStats::unresolved ), 0u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestFeedBudget )
+{
+	Val page( Val::array_type ) ;
+	for ( int i = 0 ; i < 100 ; i++ )
+		page.Add( Item( i ) ) ;
+	v2::Entry2 entry( Item( 0 ) ) ;
+
+	// the parsed JSON of a page takes much more than the entries made of it,
+	// about 2700 and 800 bytes per file at the time of writing
+	BOOST_CHECK_LE( page.MemUsage() / 100, 3072u ) ;
+	BOOST_CHECK_LE( sizeof(Entry) + entry.MemUsage(), 1024u ) ;
+
+	// the pages read ahead are released once they are applied
+	std::size_t before = MemStats::Instance().Bytes( MemStats::feed ) ;
+	PageFeed feed ;
+	FeedReader( &feed, 0, 2 ).Run( &Ignore ) ;
+	BOOST_CHECK_EQUAL( MemStats::Instance().Bytes( MemStats::feed ), before ) ;
+	BOOST_CHECK( MemStats::Instance().Peak( MemStats::feed ) > before ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
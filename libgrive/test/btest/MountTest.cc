@@ -0,0 +1,392 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "base/DriveView.hh"
+#include "drive2/Syncer2.hh"
+#include "drive3/Syncer3.hh"
+#include "util/DateTime.hh"
+
+#include "SimAgent.hh"
+#include "TestDir.hh"
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/bind.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gr ;
+using namespace gr::test ;
+
+namespace
+{
+	struct Fixture : TestDir
+	{
+		Fixture()
+		{
+			Add( "docs",	true,	"root",	"" ) ;
+			Add( "small",	false,	"docs",	"hello" ) ;
+
+			std::string big ;
+			for ( int i = 0 ; i < 1000 ; i++ )
+				big += "0123456789" ;
+			Add( "big",		false,	"root",	big ) ;
+		}
+
+		void Add( const std::string& id, bool is_dir, const std::string& parent, const std::string& content )
+		{
+			Item item = { id, is_dir, std::vector<std::string>( 1, parent ), content } ;
+			items.push_back( item ) ;
+		}
+
+		std::string Read( DriveView& view, const std::string& path, u64_t offset, std::size_t count )
+		{
+			std::vector<char> buf( count ) ;
+			return std::string( &buf[0], view.Read( path, offset, &buf[0], count ) ) ;
+		}
+
+		void ReadInto( DriveView *view, const std::string& path, u64_t offset, std::size_t count, std::string *out )
+		{
+			*out = Read( *view, path, offset, count ) ;
+		}
+
+		/// look at the files other than the one being uploaded
+		bool LookAround( DriveView *view )
+		{
+			DriveView::Attr attr ;
+			std::vector<std::string> names ;
+			return view->GetAttr( "/big", attr ) && view->GetAttr( "/docs/new", attr ) &&
+				view->List( "/docs", names ) && Read( *view, "/docs/small", 0, 5 ) == "hello" ;
+		}
+
+		std::vector<Item>	items ;
+	} ;
+
+	/// whether the change \a i was a \a method request with \a text in its
+	/// URL or body
+	bool Changed( SimAgent& agent, std::size_t i, const std::string& method, const std::string& text )
+	{
+		const std::vector<std::string>& changes = agent.Stats().changes ;
+		return i < changes.size() && changes[i].compare( 0, method.size() + 1, method + " " ) == 0 &&
+			changes[i].find( text ) != std::string::npos ;
+	}
+
+	/// holds back the uploads while it is closed
+	class GateAgent : public SimAgent
+	{
+	public :
+		explicit GateAgent( const std::vector<Item>& items ) :
+			SimAgent	( items ),
+			m_closed	( false ),
+			m_held		( 0 )
+		{
+		}
+
+		long Request(
+			const std::string&	method,
+			const std::string&	url,
+			SeekStream			*in,
+			DataStream			*dest,
+			const http::Header&	hdr,
+			u64_t				limit )
+		{
+			if ( method != "GET" )
+			{
+				std::unique_lock<std::mutex> lock( m_mutex ) ;
+				m_held++ ;
+				m_cond.notify_all() ;
+				while ( m_closed )
+					m_cond.wait( lock ) ;
+			}
+			return SimAgent::Request( method, url, in, dest, hdr, limit ) ;
+		}
+
+		void Close()
+		{
+			std::lock_guard<std::mutex> lock( m_mutex ) ;
+			m_closed = true ;
+		}
+
+		void Open()
+		{
+			std::lock_guard<std::mutex> lock( m_mutex ) ;
+			m_closed = false ;
+			m_cond.notify_all() ;
+		}
+
+		/// wait for an upload to reach the gate
+		bool Held()
+		{
+			std::unique_lock<std::mutex> lock( m_mutex ) ;
+			return m_cond.wait_for( lock, std::chrono::seconds( 10 ),
+				boost::bind( std::greater<unsigned>(), boost::cref( m_held ), 0u ) ) ;
+		}
+
+	private :
+		std::mutex				m_mutex ;
+		std::condition_variable	m_cond ;
+		bool					m_closed ;
+		unsigned				m_held ;
+	} ;
+
+	double Millisec( std::chrono::steady_clock::time_point start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() ;
+	}
+}
+
+BOOST_FIXTURE_TEST_SUITE( MountTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestMetadataWithoutContent )
+{
+	SimAgent agent( items ) ;
+	v2::Syncer2 syncer( &agent ) ;
+	DriveView view( &syncer, dir, 1 << 20, 1024 ) ;
+	view.Load() ;
+
+	DriveView::Attr attr ;
+	BOOST_REQUIRE( view.GetAttr( "/docs/small", attr ) ) ;
+	BOOST_CHECK( !attr.is_dir ) ;
+	BOOST_CHECK_EQUAL( attr.size, 5 ) ;
+	BOOST_CHECK_EQUAL( attr.mtime.Sec(), DateTime( "2026-01-01T00:00:00.000Z" ).Sec() ) ;
+
+	BOOST_REQUIRE( view.GetAttr( "/big", attr ) ) ;
+	BOOST_CHECK_EQUAL( attr.size, 10000 ) ;
+	BOOST_CHECK( !view.GetAttr( "/docs/none", attr ) ) ;
+
+	std::vector<std::string> names ;
+	BOOST_REQUIRE( view.List( "/", names ) ) ;
+	BOOST_CHECK_EQUAL( names.size(), 2 ) ;
+
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, 0 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestRangedRead )
+{
+	SimAgent agent( items ) ;
+	v2::Syncer2 syncer( &agent ) ;
+	DriveView view( &syncer, dir, 1 << 20, 1024 ) ;
+	view.Load() ;
+
+	// spans three chunks
+	BOOST_CHECK_EQUAL( Read( view, "/big", 3000, 2000 ), items[2].content.substr( 3000, 2000 ) ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, 3 ) ;
+
+	// cached
+	BOOST_CHECK_EQUAL( Read( view, "/big", 3500, 100 ), items[2].content.substr( 3500, 100 ) ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, 3 ) ;
+
+	// short read at the end of the file
+	BOOST_CHECK_EQUAL( Read( view, "/big", 9990, 100 ), items[2].content.substr( 9990 ) ) ;
+	BOOST_CHECK_EQUAL( Read( view, "/docs/small", 0, 100 ), "hello" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestEviction )
+{
+	SimAgent agent( items ) ;
+	v2::Syncer2 syncer( &agent ) ;
+	DriveView view( &syncer, dir, 4096, 1024 ) ;
+	view.Load() ;
+
+	BOOST_CHECK_EQUAL( Read( view, "/big", 0, 10000 ), items[2].content ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, 10 ) ;
+	BOOST_CHECK( view.Cache().Used() <= 4096 ) ;
+
+	// the first chunks were dropped, the last ones are kept
+	Read( view, "/big", 9000, 1000 ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, 10 ) ;
+	Read( view, "/big", 0, 1000 ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, 11 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestChunksOfLastRun )
+{
+	SimAgent agent( items ) ;
+	v2::Syncer2 syncer( &agent ) ;
+	{
+		DriveView view( &syncer, dir, 1 << 20, 1024 ) ;
+		view.Load() ;
+		Read( view, "/big", 0, 1000 ) ;
+	}
+	Write( "chunks/interrupted.0.part", "0123" ) ;
+	Write( "chunks/empty.0", "" ) ;
+
+	// the chunk of 1024 bytes is not one of 2048 bytes
+	DriveView view( &syncer, dir, 1 << 20, 2048 ) ;
+	BOOST_CHECK( !fs::exists( dir / "chunks/interrupted.0.part" ) ) ;
+	BOOST_CHECK( !fs::exists( dir / "chunks/empty.0" ) ) ;
+	view.Load() ;
+	BOOST_CHECK_EQUAL( Read( view, "/big", 0, 2000 ), items[2].content.substr( 0, 2000 ) ) ;
+	BOOST_CHECK_EQUAL( view.Cache().Used(), 2048 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestConcurrentReads )
+{
+	SimAgent agent( items, 300 ) ;
+	v2::Syncer2 syncer( &agent ) ;
+	DriveView view( &syncer, dir, 1 << 20, 1024 ) ;
+	view.Load() ;
+	unsigned downloads = agent.Stats().downloads ;
+
+	// the reads of two files download at the same time
+	std::string big, small ;
+	std::thread other( boost::bind( &Fixture::ReadInto, this, &view, "/big", 0, 100, &big ) ) ;
+	small = Read( view, "/docs/small", 0, 100 ) ;
+	other.join() ;
+	BOOST_CHECK_EQUAL( big, items[2].content.substr( 0, 100 ) ) ;
+	BOOST_CHECK_EQUAL( small, "hello" ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, downloads + 2 ) ;
+
+	// two readers of the same chunk download it once
+	std::string first, second ;
+	std::thread t1( boost::bind( &Fixture::ReadInto, this, &view, "/big", 5000, 10, &first ) ) ;
+	std::thread t2( boost::bind( &Fixture::ReadInto, this, &view, "/big", 5010, 10, &second ) ) ;
+	t1.join() ;
+	t2.join() ;
+	BOOST_CHECK_EQUAL( first + second, items[2].content.substr( 5000, 20 ) ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, downloads + 3 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestWriteBack )
+{
+	SimAgent agent( items ) ;
+	v3::Syncer3 syncer( &agent ) ;
+	DriveView view( &syncer, dir, 1 << 20, 1024 ) ;
+	view.Load() ;
+	std::vector<std::string>& changes = agent.Stats().changes ;
+	unsigned downloads = agent.Stats().downloads ;
+
+	// a new file is uploaded when it is released
+	BOOST_REQUIRE( view.Create( "/docs/new" ) ) ;
+	BOOST_CHECK_EQUAL( view.Write( "/docs/new", 0, "abc", 3 ), 3 ) ;
+	BOOST_CHECK( changes.empty() ) ;
+	BOOST_REQUIRE( view.Release( "/docs/new" ) ) ;
+	BOOST_REQUIRE_EQUAL( changes.size(), 1 ) ;
+	BOOST_CHECK( Changed( agent, 0, "POST", "abc" ) ) ;
+
+	// an existing file is downloaded, changed and uploaded again
+	BOOST_REQUIRE( view.Open( "/docs/small", false ) ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, downloads + 1 ) ;
+	BOOST_CHECK_EQUAL( view.Write( "/docs/small", 5, " world", 6 ), 6 ) ;
+	DriveView::Attr attr ;
+	BOOST_REQUIRE( view.GetAttr( "/docs/small", attr ) ) ;
+	BOOST_CHECK_EQUAL( attr.size, 11 ) ;
+	BOOST_CHECK_EQUAL( Read( view, "/docs/small", 0, 100 ), "hello world" ) ;
+	BOOST_REQUIRE( view.Release( "/docs/small" ) ) ;
+	BOOST_REQUIRE_EQUAL( changes.size(), 2 ) ;
+	BOOST_CHECK( Changed( agent, 1, "PATCH", "hello world" ) ) ;
+
+	// released again without changes
+	BOOST_REQUIRE( view.Open( "/docs/small", false ) ) ;
+	BOOST_REQUIRE( view.Release( "/docs/small" ) ) ;
+	BOOST_CHECK_EQUAL( changes.size(), 2 ) ;
+
+	// truncate() without an open file is uploaded at once
+	BOOST_REQUIRE( view.Truncate( "/big", 3 ) ) ;
+	BOOST_REQUIRE_EQUAL( changes.size(), 3 ) ;
+	BOOST_CHECK( Changed( agent, 2, "PATCH", "/big?" ) ) ;
+	BOOST_REQUIRE( view.GetAttr( "/big", attr ) ) ;
+	BOOST_CHECK_EQUAL( attr.size, 3 ) ;
+
+	BOOST_REQUIRE( view.Mkdir( "/folder" ) ) ;
+	BOOST_REQUIRE_EQUAL( changes.size(), 4 ) ;
+	BOOST_CHECK( Changed( agent, 3, "POST", "application/vnd.google-apps.folder" ) ) ;
+	BOOST_REQUIRE( view.GetAttr( "/folder", attr ) ) ;
+	BOOST_CHECK( attr.is_dir ) ;
+	BOOST_CHECK( !view.Mkdir( "/folder" ) ) ;
+
+	// removed files go to the trash
+	BOOST_REQUIRE( view.Remove( "/docs/small" ) ) ;
+	BOOST_REQUIRE_EQUAL( changes.size(), 5 ) ;
+	BOOST_CHECK( Changed( agent, 4, "PATCH", "\"trashed\":true" ) ) ;
+	BOOST_CHECK( !view.GetAttr( "/docs/small", attr ) ) ;
+	std::vector<std::string> names ;
+	BOOST_REQUIRE( view.List( "/docs", names ) ) ;
+	BOOST_CHECK_EQUAL( names.size(), 1 ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestLookupDuringUpload )
+{
+	GateAgent agent( items ) ;
+	v3::Syncer3 syncer( &agent ) ;
+	DriveView view( &syncer, dir, 1 << 20, 1024 ) ;
+	view.Load() ;
+
+	BOOST_REQUIRE( view.Create( "/docs/new" ) ) ;
+	view.Write( "/docs/new", 0, "abc", 3 ) ;
+
+	agent.Close() ;
+	std::thread upload( boost::bind( &DriveView::Release, &view, std::string( "/docs/new" ) ) ) ;
+	BOOST_CHECK( agent.Held() ) ;
+
+	// the upload holds the connection, but not the view
+	std::future<bool> looked = std::async( std::launch::async, boost::bind( &Fixture::LookAround, this, &view ) ) ;
+	BOOST_CHECK( looked.wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready ) ;
+
+	agent.Open() ;
+	upload.join() ;
+	BOOST_CHECK( looked.get() ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().changes.size(), 1 ) ;
+}
+
+// startup and first access latency against a stand-in with 2ms per request
+BOOST_AUTO_TEST_CASE( TestLatency )
+{
+	for ( int f = 0 ; f < 20 ; f++ )
+	{
+		std::ostringstream folder ;
+		folder << "folder" << f ;
+		Add( folder.str(), true, "root", "" ) ;
+		for ( int i = 0 ; i < 10 ; i++ )
+		{
+			std::ostringstream file ;
+			file << folder.str() << "-file" << i ;
+			Add( file.str(), false, folder.str(), std::string( 100000, 'x' ) ) ;
+		}
+	}
+
+	SimAgent agent( items, 2 ) ;
+	v2::Syncer2 syncer( &agent ) ;
+	DriveView view( &syncer, dir, 1 << 20, 64 << 10 ) ;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() ;
+	view.Load() ;
+	BOOST_TEST_MESSAGE( "mount: " << Millisec( start ) << " ms for " << items.size() << " entries in "
+		<< agent.Stats().lists << " requests" ) ;
+
+	start = std::chrono::steady_clock::now() ;
+	BOOST_CHECK_EQUAL( Read( view, "/folder7/folder7-file3", 0, 4096 ).size(), 4096 ) ;
+	BOOST_TEST_MESSAGE( "first read: " << Millisec( start ) << " ms" ) ;
+
+	start = std::chrono::steady_clock::now() ;
+	BOOST_CHECK_EQUAL( Read( view, "/folder7/folder7-file3", 4096, 4096 ).size(), 4096 ) ;
+	BOOST_TEST_MESSAGE( "cached read: " << Millisec( start ) << " ms" ) ;
+
+	BOOST_CHECK_EQUAL( agent.Stats().downloads, 1 ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
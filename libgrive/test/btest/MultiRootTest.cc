@@ -0,0 +1,296 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "SimAgent.hh"
+#include "TestDir.hh"
+
+#include "base/MultiRoot.hh"
+#include "json/JsonParser.hh"
+#include "json/Val.hh"
+#include "util/Config.hh"
+#include "util/FileSystem.hh"
+#include "util/MemStats.hh"
+#include "util/log/Log.hh"
+
+#include <boost/program_options.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gr ;
+using namespace gr::test ;
+
+namespace po = boost::program_options ;
+
+namespace
+{
+	/// roots in a temp dir, and an empty Google Drive for them
+	struct Fixture : TestDir
+	{
+		Fixture() :
+			agent	( std::vector<Item>() )
+		{
+		}
+
+		/// a root of the account of \a refresh_token
+		void AddRoot( const std::string& name, const std::string& refresh_token )
+		{
+			fs::create_directories( dir / name ) ;
+			Write( name + "/.grive", "{\"refresh_token\":\"" + refresh_token + "\"}" ) ;
+			roots.push_back( name ) ;
+		}
+
+		/// the command line options, with the roots file written for them
+		Config Cmd( const std::vector<std::string>& extra = std::vector<std::string>() )
+		{
+			std::ofstream list( ( dir / "roots.json" ).string().c_str() ) ;
+			list << "[" ;
+			for ( std::size_t i = 0 ; i < roots.size() ; i++ )
+				list << ( i > 0 ? "," : "" ) << "{\"path\":\"" << ( dir / roots[i] ).string() << "\"}" ;
+			list << "]" ;
+
+			po::options_description desc ;
+			desc.add_options()
+				( "api",			po::value<std::string>() )
+				( "id",				po::value<std::string>() )
+				( "secret",			po::value<std::string>() )
+				( "path",			po::value<std::string>() )
+				( "state-depth",	po::value<unsigned>() )
+				( "watch-address",	po::value<std::string>() )
+				( "watch-bind",		po::value<std::string>() )
+				( "watch-port",		po::value<unsigned>() ) ;
+
+			std::vector<std::string> args ;
+			args.push_back( "--id=client" ) ;
+			args.push_back( "--secret=secret" ) ;
+			args.push_back( "--path=" + dir.string() ) ;
+			args.push_back( "--state-depth=0" ) ;
+			args.insert( args.end(), extra.begin(), extra.end() ) ;
+
+			po::variables_map vm ;
+			po::store( po::command_line_parser( args ).options( desc ).run(), vm ) ;
+			po::notify( vm ) ;
+			return Config( vm ) ;
+		}
+
+		/// how many times the token of \a refresh_token was asked for
+		unsigned Refreshes( const std::string& refresh_token )
+		{
+			SimStats& stats = agent.Stats() ;
+			std::lock_guard<std::mutex> lock( stats.mutex ) ;
+			unsigned count = 0 ;
+			for ( std::size_t i = 0 ; i < stats.changes.size() ; i++ )
+			{
+				if ( stats.changes[i].find( "refresh_token=" + refresh_token + "&" ) != std::string::npos )
+					count++ ;
+			}
+			return count ;
+		}
+
+		/// the body of the request which opened the push channel
+		Val Watch()
+		{
+			SimStats& stats = agent.Stats() ;
+			std::lock_guard<std::mutex> lock( stats.mutex ) ;
+			for ( std::size_t i = 0 ; i < stats.changes.size() ; i++ )
+			{
+				const std::string& c = stats.changes[i] ;
+				if ( c.find( "/watch?" ) != std::string::npos )
+					return ParseJson( c.substr( c.find( '{' ) ) ) ;
+			}
+			BOOST_FAIL( "no channel was opened" ) ;
+			return Val() ;
+		}
+
+		SimAgent					agent ;
+		std::vector<std::string>	roots ;
+	} ;
+
+	class QuietLog : public LogBase
+	{
+	public :
+		void Log( const log::Fmt&, log::Serverity ) {}
+		bool Enable( log::Serverity, bool enable ) { return enable ; }
+		bool IsEnabled( log::Serverity ) const { return true ; }
+	} ;
+
+	/// counts the lines, and the ones written while another thread was
+	/// writing one
+	class CheckLog : public QuietLog
+	{
+	public :
+		CheckLog( std::atomic<unsigned> *lines, std::atomic<unsigned> *overlaps ) :
+			m_lines( lines ), m_overlaps( overlaps ), m_inside( 0 )
+		{
+		}
+
+		void Log( const log::Fmt&, log::Serverity )
+		{
+			if ( m_inside++ > 0 )
+				(*m_overlaps)++ ;
+			std::this_thread::sleep_for( std::chrono::microseconds( 100 ) ) ;
+			m_inside-- ;
+			(*m_lines)++ ;
+		}
+
+	private :
+		std::atomic<unsigned>	*m_lines ;
+		std::atomic<unsigned>	*m_overlaps ;
+		std::atomic<unsigned>	m_inside ;
+	} ;
+
+	void Wait( unsigned ms )
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( ms ) ) ;
+	}
+
+	std::map<std::string, std::string> Notification( const std::string& id, const std::string& token,
+		const std::string& state )
+	{
+		std::map<std::string, std::string> fields ;
+		fields["x-goog-channel-id"]		= id ;
+		fields["x-goog-channel-token"]	= token ;
+		fields["x-goog-resource-state"]	= state ;
+		return fields ;
+	}
+}
+
+BOOST_FIXTURE_TEST_SUITE( MultiRootTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestTokenPerAccount )
+{
+	AddRoot( "a", "one" ) ;
+	AddRoot( "b", "one" ) ;
+	AddRoot( "c", "two" ) ;
+	MultiRoot multi( Cmd(), dir / "roots.json", &agent ) ;
+	BOOST_CHECK_EQUAL( multi.Count(), 3u ) ;
+
+	// the roots of an account share its token, for all the passes
+	BOOST_CHECK_EQUAL( multi.Run( 3 ), 0u ) ;
+	BOOST_CHECK_EQUAL( multi.Run( 3 ), 0u ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().stamps, 6u ) ;
+	BOOST_CHECK_EQUAL( Refreshes( "one" ), 1u ) ;
+	BOOST_CHECK_EQUAL( Refreshes( "two" ), 1u ) ;
+	BOOST_CHECK( fs::exists( dir / "c" / ".grive_state" ) ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestFailure )
+{
+	AddRoot( "a", "bad" ) ;
+	AddRoot( "b", "one" ) ;
+	MultiRoot multi( Cmd(), dir / "roots.json", &agent ) ;
+
+	// the other roots are still synced
+	BOOST_CHECK_EQUAL( multi.Run( 1 ), 1u ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().stamps, 1u ) ;
+	BOOST_CHECK( fs::exists( dir / "b" / ".grive_state" ) ) ;
+
+	// and the failed one tried again in the next pass
+	BOOST_CHECK_EQUAL( multi.Run( 1 ), 1u ) ;
+	BOOST_CHECK_EQUAL( Refreshes( "bad" ), 2u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestConcurrentRoots )
+{
+	AddRoot( "a", "one" ) ;
+	AddRoot( "b", "two" ) ;
+	for ( int i = 0 ; i < 20 ; i++ )
+	{
+		std::string n( 1, 'a' + i ) ;
+		if ( i < 2 )
+			Write( "a/" + n, n ) ;
+		Write( "b/" + n, n ) ;
+	}
+	// the uploads are answered in the v3 format
+	MultiRoot multi( Cmd( std::vector<std::string>( 1, "--api=v3" ) ), dir / "roots.json", &agent ) ;
+
+	std::atomic<unsigned> lines( 0 ), overlaps( 0 ) ;
+	LogBase::Inst( new CheckLog( &lines, &overlaps ) ) ;
+	std::size_t before = MemStats::Instance().Count( MemStats::resources ) ;
+	unsigned failed = multi.Run( 2 ) ;
+	LogBase::Inst( new QuietLog ) ;
+	BOOST_CHECK_EQUAL( failed, 0u ) ;
+
+	// the roots log one line at a time
+	BOOST_CHECK( lines > 10 ) ;
+	BOOST_CHECK_EQUAL( overlaps, 0u ) ;
+
+	// and count their memory apart: the root folder and its files
+	BOOST_CHECK_EQUAL( multi.Stats( 0 ).Count( MemStats::resources ), 3u ) ;
+	BOOST_CHECK_EQUAL( multi.Stats( 1 ).Count( MemStats::resources ), 21u ) ;
+	BOOST_CHECK( multi.Stats( 1 ).Peak( MemStats::resources ) > multi.Stats( 0 ).Peak( MemStats::resources ) ) ;
+	BOOST_CHECK_EQUAL( MemStats::Instance().Count( MemStats::resources ), before ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestPollBackoff )
+{
+	AddRoot( "a", "one" ) ;
+	AddRoot( "b", "bad" ) ;
+	MultiRoot multi( Cmd(), dir / "roots.json", &agent ) ;
+
+	std::thread serve( &MultiRoot::Serve, &multi, 2, 1 ) ;
+	Wait( 3500 ) ;
+	multi.Stop() ;
+	serve.join() ;
+
+	// the root which doesn't change is polled after 1, 2 then 4 seconds,
+	// the failing one is tried again every second
+	BOOST_CHECK_EQUAL( agent.Stats().stamps, 3u ) ;
+	BOOST_CHECK_EQUAL( Refreshes( "bad" ), 4u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestNotify )
+{
+	AddRoot( "a", "one" ) ;
+	std::vector<std::string> watch ;
+	watch.push_back( "--watch-address=https://grive.example.com/notify" ) ;
+	watch.push_back( "--watch-port=0" ) ;
+	MultiRoot multi( Cmd( watch ), dir / "roots.json", &agent ) ;
+
+	std::thread serve( &MultiRoot::Serve, &multi, 1, 1 ) ;
+	Wait( 500 ) ;
+	Val channel = Watch() ;
+	std::string id = channel["id"].Str(), token = channel["token"].Str() ;
+	BOOST_CHECK_EQUAL( channel["address"].Str(), "https://grive.example.com/notify" ) ;
+
+	// with a channel, Google Drive is not polled, the local files are
+	Wait( 1500 ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().stamps, 1u ) ;
+
+	// only a change on the channel of the root makes it sync
+	multi.Notify( Notification( id, "other", "change" ) ) ;
+	multi.Notify( Notification( "grive-other", token, "change" ) ) ;
+	multi.Notify( Notification( id, token, "sync" ) ) ;
+	Wait( 500 ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().stamps, 1u ) ;
+
+	multi.Notify( Notification( id, token, "change" ) ) ;
+	Wait( 500 ) ;
+	BOOST_CHECK_EQUAL( agent.Stats().stamps, 2u ) ;
+
+	multi.Stop() ;
+	serve.join() ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
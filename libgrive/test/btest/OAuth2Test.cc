@@ -0,0 +1,126 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "TestDir.hh"
+
+#include "http/ResponseLog.hh"
+#include "protocol/OAuth2.hh"
+#include "util/DataStream.hh"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace gr ;
+
+namespace
+{
+	/// hands out a new access token for each refresh, counted over clones
+	class TokenAgent : public http::Agent
+	{
+	public :
+		TokenAgent() : m_posts( new std::atomic<unsigned>( 0 ) ), m_clone( false )
+		{
+		}
+
+		http::ResponseLog* GetLog() const { return m_log.get() ; }
+		void SetLog( http::ResponseLog *log ) { m_log.reset( log ) ; }
+
+		long Request( const std::string& method, const std::string&, SeekStream*, DataStream *dest,
+			const http::Header&, u64_t )
+		{
+			BOOST_CHECK_EQUAL( method, "POST" ) ;
+			BOOST_CHECK( m_clone ) ;
+
+			std::ostringstream ss ;
+			ss << "{\"access_token\":\"t" << ++*m_posts << "\"}" ;
+			std::string s = ss.str() ;
+			dest->Write( s.c_str(), s.size() ) ;
+			if ( m_log )
+				m_log->Write( s.c_str(), s.size() ) ;
+			return 200 ;
+		}
+
+		std::string LastError() const { return "" ; }
+		std::string LastErrorHeaders() const { return "" ; }
+		std::string RedirLocation() const { return "" ; }
+		std::string Escape( const std::string& str ) { return str ; }
+		std::string Unescape( const std::string& str ) { return str ; }
+		void SetProgressReporter( Progress* ) {}
+
+		std::unique_ptr<http::Agent> Clone() const
+		{
+			std::unique_ptr<TokenAgent> agent( new TokenAgent( *this ) ) ;
+			agent->m_clone = true ;
+			agent->m_log.reset() ;		// as CurlAgent, the clone does not log
+			return std::unique_ptr<http::Agent>( std::move( agent ) ) ;
+		}
+
+		unsigned Posts() const { return *m_posts ; }
+
+	private :
+		std::shared_ptr<std::atomic<unsigned> >	m_posts ;
+		bool									m_clone ;
+		std::shared_ptr<http::ResponseLog>		m_log ;
+	} ;
+}
+
+BOOST_AUTO_TEST_SUITE( OAuth2Test )
+
+BOOST_AUTO_TEST_CASE( TestRefreshOnce )
+{
+	// the token is refreshed on a connection of its own
+	TokenAgent agent ;
+	OAuth2 token( &agent, "refresh", "id", "secret", "uri" ) ;
+	BOOST_CHECK_EQUAL( agent.Posts(), 1u ) ;
+	BOOST_CHECK_EQUAL( token.AccessToken(), "t1" ) ;
+
+	// two requests sent with "t1" fail, only the first one refreshes it
+	token.Refresh( "t1" ) ;
+	token.Refresh( "t1" ) ;
+	BOOST_CHECK_EQUAL( agent.Posts(), 2u ) ;
+	BOOST_CHECK_EQUAL( token.AccessToken(), "t2" ) ;
+
+	token.Refresh() ;
+	BOOST_CHECK_EQUAL( token.AccessToken(), "t3" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestRefreshLogged )
+{
+	// --log-http records the token refreshes too
+	test::TestDir tmp ;
+	TokenAgent agent ;
+	agent.SetLog( new http::ResponseLog( ( tmp.dir / "http-" ).string(), ".txt" ) ) ;
+	OAuth2 token( &agent, "refresh", "id", "secret", "uri" ) ;
+	token.Refresh() ;
+
+	fs::directory_iterator i( tmp.dir ) ;
+	BOOST_REQUIRE( i != fs::directory_iterator() ) ;
+	std::ifstream f( i->path().string().c_str() ) ;
+	std::string log( ( std::istreambuf_iterator<char>( f ) ), std::istreambuf_iterator<char>() ) ;
+	BOOST_CHECK_EQUAL( log, "{\"access_token\":\"t1\"}{\"access_token\":\"t2\"}" ) ;
+	BOOST_CHECK( ++i == fs::directory_iterator() ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,189 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Bench.hh"
+#include "TestDir.hh"
+
+#include "http/Download.hh"
+#include "util/Crypt.hh"
+#include "util/File.hh"
+#include "util/FileSystem.hh"
+#include "util/PageCache.hh"
+
+#include <boost/format.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace gr ;
+
+namespace
+{
+	const std::size_t chunk = 1024 * 1024 ;
+
+	// the pages of the file in the page cache, and their number. the files
+	// of the benchmark itself are opened without File, which PageCache
+	// would drop from the cache
+	void Count( const fs::path& path, std::size_t& resident, std::size_t& pages )
+	{
+		int fd = ::open( path.string().c_str(), O_RDONLY ) ;
+		BOOST_REQUIRE( fd != -1 ) ;
+		std::size_t size = fs::file_size( path ), page = ::sysconf( _SC_PAGESIZE ) ;
+		void *map = size > 0 ? ::mmap( 0, size, PROT_READ, MAP_SHARED, fd, 0 ) : MAP_FAILED ;
+		if ( map != MAP_FAILED )
+		{
+			std::vector<unsigned char> vec( ( size + page - 1 ) / page ) ;
+			BOOST_REQUIRE_EQUAL( ::mincore( map, size, &vec[0] ), 0 ) ;
+			for ( std::size_t i = 0 ; i < vec.size() ; i++ )
+				resident += vec[i] & 1 ;
+			pages += vec.size() ;
+			::munmap( map, size ) ;
+		}
+		::close( fd ) ;
+	}
+
+	/// the part of \a files in the page cache, in percent
+	double Resident( const std::vector<fs::path>& files )
+	{
+		std::size_t resident = 0, pages = 0 ;
+		for ( std::size_t i = 0 ; i < files.size() ; i++ )
+			Count( files[i], resident, pages ) ;
+		return pages > 0 ? 100.0 * resident / pages : 0 ;
+	}
+
+	/// a working set of another program and the files grive syncs, of
+	/// GR_BENCH_MB (256 by default) MB each
+	struct Fixture : test::TestDir
+	{
+		Fixture() :
+			mb	( test::BenchParam( "GR_BENCH_MB", 256 ) ),
+			buf	( chunk )
+		{
+			if ( !test::Bench() )
+				return ;
+
+			work.push_back( dir / "work" ) ;
+			Make( work.front() ) ;
+			for ( int i = 0 ; i < 4 ; i++ )
+			{
+				files.push_back( dir / ( "file" + std::to_string( i ) ) ) ;
+				Make( files.back() ) ;
+				copies.push_back( dir / ( "copy" + std::to_string( i ) ) ) ;
+			}
+		}
+
+		void Make( const fs::path& path )
+		{
+			std::ofstream out( path.string().c_str(), std::ios::binary ) ;
+			for ( long i = 0 ; i < mb ; i++ )
+			{
+				for ( std::size_t j = 0 ; j < chunk ; j++ )
+					buf[j] = static_cast<char>( i * 31 + j * 7 ) ;
+				out.write( &buf[0], chunk ) ;
+			}
+		}
+
+		/// grive's files out of the cache, and the working set in it
+		void Start()
+		{
+			for ( std::size_t i = 0 ; i < files.size() ; i++ )
+			{
+				int fd = ::open( files[i].string().c_str(), O_RDONLY ) ;
+				::posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED ) ;
+				::close( fd ) ;
+				fs::remove( copies[i] ) ;
+			}
+			int fd = ::open( work.front().string().c_str(), O_RDONLY ) ;
+			while ( ::read( fd, &buf[0], chunk ) > 0 )
+				;
+			::close( fd ) ;
+		}
+
+		void Finish( const std::string& name, const test::Stopwatch& sw, const std::vector<fs::path>& used )
+		{
+			test::Report( name, sw.Seconds(), 1, static_cast<double>( mb ) * chunk * files.size() ) ;
+			std::cout << boost::format( "  resident after: working set %.0f%%, grive's files %.0f%%" )
+				% Resident( work ) % Resident( used ) << std::endl ;
+		}
+
+		long					mb ;
+		std::vector<char>		buf ;
+		std::vector<fs::path>	work, files, copies ;
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( PageCacheBenchTest, Fixture )
+
+/// The throughput of hashing, upload reads and download writes, and how
+/// much of a working set warmed before each of them stays in the page cache,
+/// without and with "--polite-io". The writes are timed without their
+/// writeback, unless polite. PageCache stays enabled for the later tests.
+BOOST_AUTO_TEST_CASE( TestResidency )
+{
+	if ( !test::Bench() )
+		return ;
+
+	std::cout << files.size() << " files and a working set of " << mb << " MB" << std::endl ;
+	for ( int polite = 0 ; polite < 2 ; polite++ )
+	{
+		std::string mode = polite ? "polite" : "normal" ;
+		if ( polite )
+			PageCache::Instance().Enable() ;
+
+		Start() ;
+		test::Stopwatch hash ;
+		for ( std::size_t i = 0 ; i < files.size() ; i++ )
+			crypt::MD5::Get( files[i] ) ;
+		Finish( mode + " hash", hash, files ) ;
+
+		Start() ;
+		test::Stopwatch read ;
+		for ( std::size_t i = 0 ; i < files.size() ; i++ )
+		{
+			File file( files[i] ) ;
+			while ( file.Read( &buf[0], chunk ) > 0 )
+				;
+		}
+		Finish( mode + " upload read", read, files ) ;
+
+		// in the pieces curl hands them over
+		Start() ;
+		test::Stopwatch write ;
+		for ( std::size_t i = 0 ; i < copies.size() ; i++ )
+		{
+			http::Download dl( copies[i].string(), http::Download::NoChecksum() ) ;
+			for ( long m = 0 ; m < mb ; m++ )
+			{
+				for ( std::size_t j = 0 ; j < chunk ; j += 16384 )
+					dl.Write( &buf[j], 16384 ) ;
+			}
+			dl.Flush() ;
+		}
+		Finish( mode + " download write", write, copies ) ;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
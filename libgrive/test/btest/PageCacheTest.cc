@@ -0,0 +1,52 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "util/Crypt.hh"
+#include "util/File.hh"
+#include "util/FileSystem.hh"
+#include "util/PageCache.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+
+using namespace gr ;
+
+BOOST_AUTO_TEST_SUITE( PageCacheTest )
+
+// direct reads need aligned lengths, the last chunk of the file is not
+BOOST_AUTO_TEST_CASE( TestReadAllUnaligned )
+{
+	fs::path path = fs::temp_directory_path() / fs::unique_path( "grive-test-%%%%-%%%%" ) ;
+	{
+		std::ofstream out( path.string().c_str(), std::ios::binary ) ;
+		for ( unsigned i = 0 ; i < 5 * 1024 * 1024 + 123 ; i++ )
+			out.put( static_cast<char>( i * 7 ) ) ;
+	}
+
+	File file( path ) ;
+	crypt::MD5 md5 ;
+	PageCache::Instance().ReadAll( file.Fd(), file.Size(), boost::bind( &crypt::MD5::Write, &md5, _1, _2 ) ) ;
+	BOOST_CHECK_EQUAL( md5.Get().Hex(), crypt::MD5::Get( path ).Hex() ) ;
+
+	fs::remove( path ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,294 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "SimAgent.hh"
+#include "TestDir.hh"
+
+#include "base/Drive.hh"
+#include "base/Entry.hh"
+#include "base/PartitionIndex.hh"
+#include "base/State.hh"
+#include "drive2/Syncer2.hh"
+#include "drive3/Syncer3.hh"
+#include "json/JsonParser.hh"
+#include "json/JsonWriter.hh"
+#include "json/Val.hh"
+#include "util/File.hh"
+#include "util/FileSystem.hh"
+#include "util/log/Log.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace gr ;
+using namespace gr::test ;
+
+namespace
+{
+	class TestEntry : public Entry
+	{
+	public :
+		TestEntry( const std::string& name, const std::string& parent )
+		{
+			m_title			= name ;
+			m_filename		= name ;
+			m_resource_id	= "id-" + name ;
+			m_self_href		= m_resource_id ;
+			m_parent_hrefs.push_back( parent ) ;
+			m_size			= name.size() ;
+			m_mtime			= DateTime( 1234, 5 ) ;
+		}
+	} ;
+
+	void Collect( std::vector<std::string> *out, const Entry& e )
+	{
+		BOOST_CHECK_EQUAL( e.Size(), e.Title().size() ) ;
+		BOOST_CHECK( e.MTime() == DateTime( 1234, 5 ) ) ;
+		out->push_back( e.ParentHref() + "/" + e.Title() ) ;
+	}
+
+	void DropCtime( Val& v )
+	{
+		if ( v.Type() != Val::object_type )
+			return ;
+		v.Del( "ctime" ) ;
+		if ( v.Has( "tree" ) )
+		{
+			Val::Object& tree = v["tree"].AsObject() ;
+			for ( Val::Object::iterator i = tree.begin() ; i != tree.end() ; ++i )
+				DropCtime( i->second ) ;
+		}
+	}
+
+	/// the state files of \a dir as one object, without the local change
+	/// times which differ from one copy to the other
+	Val ReadState( const fs::path& dir )
+	{
+		Val options ;
+		options.Add( "path",		Val( dir.string() ) ) ;
+		options.Add( "state-depth",	Val( 0 ) ) ;
+		State( dir, options ).Write() ;
+
+		File file( dir / ".grive_state" ) ;
+		std::string json( file.Size(), '\0' ) ;
+		file.Read( &json[0], json.size() ) ;
+		Val st = ParseJson( json ) ;
+		DropCtime( st ) ;
+		return st ;
+	}
+
+	class QuietLog : public LogBase
+	{
+	public :
+		void Log( const log::Fmt&, log::Serverity ) {}
+		bool Enable( log::Serverity, bool enable ) { return enable ; }
+		bool IsEnabled( log::Serverity ) const { return true ; }
+	} ;
+
+	/// keeps the warnings
+	class WarningLog : public QuietLog
+	{
+	public :
+		explicit WarningLog( std::vector<std::string> *lines ) : m_lines( lines )
+		{
+		}
+
+		void Log( const log::Fmt& msg, log::Serverity s )
+		{
+			if ( s == log::warning )
+				m_lines->push_back( msg.str() ) ;
+		}
+
+	private :
+		std::vector<std::string>	*m_lines ;
+	} ;
+
+	struct Fixture : TestDir
+	{
+		Fixture()
+		{
+			Add( "a",		true,	"root" ) ;
+			Add( "b",		true,	"root" ) ;
+			Add( "c",		true,	"a" ) ;
+			Add( "f1",		false,	"root" ) ;
+			Add( "f2",		false,	"a" ) ;
+			Add( "f3",		false,	"b" ) ;
+			Add( "f4",		false,	"c" ) ;
+		}
+
+		void Add( const std::string& id, bool is_dir, const std::string& parent,
+			const std::string& name = "" )
+		{
+			Item item = { id, is_dir, std::vector<std::string>( 1, parent ), is_dir ? "" : id, name } ;
+			items.push_back( item ) ;
+		}
+
+		Val Options( const fs::path& path )
+		{
+			fs::create_directories( path ) ;
+			Val options ;
+			options.Add( "path",				Val( path.string() ) ) ;
+			options.Add( "no-remote-new",		Val( false ) ) ;
+			options.Add( "upload-only",			Val( false ) ) ;
+			options.Add( "no-delete-remote",	Val( false ) ) ;
+			options.Add( "new-rev",				Val( false ) ) ;
+			return options ;
+		}
+
+		std::vector<Item>	items ;
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( PartitionTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestSpillAndReplay )
+{
+	// a small buffer, so that each partition is partly spilled to disk
+	std::vector<std::string> a, b, root ;
+	{
+		PartitionIndex index( 200 ) ;
+		for ( int i = 0 ; i < 10 ; i++ )
+		{
+			std::string n( 1, 'a' + i ) ;
+			index.Add( "a", TestEntry( "a" + n, "pa" ) ) ;
+			index.Add( "b", TestEntry( "bb" + n, "pb" ) ) ;
+			if ( i % 3 == 0 )
+				index.Add( "", TestEntry( n, "root" ) ) ;
+		}
+		index.Replay( "b", boost::bind( &Collect, &b, _1 ) ) ;
+		index.Replay( "a", boost::bind( &Collect, &a, _1 ) ) ;
+		index.Replay( "", boost::bind( &Collect, &root, _1 ) ) ;
+
+		// each entry is replayed once
+		std::vector<std::string> again ;
+		index.Replay( "a", boost::bind( &Collect, &again, _1 ) ) ;
+		BOOST_CHECK( again.empty() ) ;
+	}
+
+	// in the order they were added
+	BOOST_REQUIRE_EQUAL( a.size(), 10u ) ;
+	BOOST_REQUIRE_EQUAL( b.size(), 10u ) ;
+	BOOST_REQUIRE_EQUAL( root.size(), 4u ) ;
+	for ( int i = 0 ; i < 10 ; i++ )
+	{
+		std::string n( 1, 'a' + i ) ;
+		BOOST_CHECK_EQUAL( a[i], "pa/a" + n ) ;
+		BOOST_CHECK_EQUAL( b[i], "pb/bb" + n ) ;
+	}
+	BOOST_CHECK_EQUAL( root[3], "root/j" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestBufferLimit )
+{
+	// the entries in memory never take more than the limit, however many
+	// there are in a partition
+	PartitionIndex index( 200 ) ;
+	for ( int i = 0 ; i < 100 ; i++ )
+	{
+		index.Add( i % 2 ? "a" : "", TestEntry( "entry" + std::string( 1, 'a' + i % 26 ), "pa" ) ) ;
+		BOOST_CHECK_LE( index.Buffered(), 200u ) ;
+	}
+
+	std::vector<std::string> a ;
+	index.Replay( "a", boost::bind( &Collect, &a, _1 ) ) ;
+	BOOST_CHECK_EQUAL( a.size(), 50u ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestSameAsFullSync )
+{
+	SimAgent agent( items ) ;
+	v2::Syncer2 syncer( &agent ) ;
+
+	Val full = Options( dir / "full" ) ;
+	{
+		Drive drive( &syncer, full ) ;
+		drive.DetectChanges() ;
+		drive.Update() ;
+		drive.SaveState() ;
+	}
+
+	// one part for each of "a" and "b", then the files in the root folder
+	Val parts = Options( dir / "parts" ) ;
+	parts.Add( "memory-limit", Val( 1 ) ) ;
+	Drive( &syncer, parts ).SyncPartitioned( false ) ;
+
+	BOOST_CHECK( fs::exists( dir / "parts/a/c/f4" ) ) ;
+	BOOST_CHECK( fs::exists( dir / "parts/f1" ) ) ;
+	BOOST_CHECK_EQUAL( WriteJson( ReadState( dir / "parts" ) ), WriteJson( ReadState( dir / "full" ) ) ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestSameName )
+{
+	// two remote top-level folders named "a" are one part, keyed by their
+	// ids, so that both are handled the way the full sync handles them
+	Add( "a2",	true,	"root",	"a" ) ;
+	Add( "f5",	false,	"a2" ) ;
+	SimAgent agent( items ) ;
+	v2::Syncer2 syncer( &agent ) ;
+
+	Val full = Options( dir / "full" ) ;
+	{
+		Drive drive( &syncer, full ) ;
+		drive.DetectChanges() ;
+		drive.Update() ;
+		drive.SaveState() ;
+	}
+	std::vector<std::string> full_changes = agent.Stats().changes ;
+
+	Val parts = Options( dir / "parts" ) ;
+	parts.Add( "memory-limit", Val( 1 ) ) ;
+	Drive( &syncer, parts ).SyncPartitioned( false ) ;
+
+	const char *files[] = { "a/f2", "a/f5", "a/c/f4", "f1" } ;
+	for ( std::size_t i = 0 ; i < sizeof( files ) / sizeof( files[0] ) ; i++ )
+		BOOST_CHECK_EQUAL( fs::exists( dir / "parts" / files[i] ), fs::exists( dir / "full" / files[i] ) ) ;
+	BOOST_CHECK_EQUAL( WriteJson( ReadState( dir / "parts" ) ), WriteJson( ReadState( dir / "full" ) ) ) ;
+
+	// and the same requests are sent to the server
+	std::vector<std::string> part_changes( agent.Stats().changes.begin() + full_changes.size(),
+		agent.Stats().changes.end() ) ;
+	BOOST_CHECK( part_changes == full_changes ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestMoveBetweenParts )
+{
+	// with the checksums of the v3 format
+	SimAgent agent( items ) ;
+	v3::Syncer3 syncer( &agent ) ;
+
+	Val parts = Options( dir / "parts" ) ;
+	parts.Add( "memory-limit", Val( 1 ) ) ;
+	Drive( &syncer, parts ).SyncPartitioned( false ) ;
+
+	// each part has its own state, so the move is not seen as one, but it
+	// is told about
+	fs::rename( dir / "parts/b/f3", dir / "parts/a/f3" ) ;
+	std::vector<std::string> warnings ;
+	LogBase::Inst( new WarningLog( &warnings ) ) ;
+	Drive( &syncer, parts ).SyncPartitioned( true ) ;
+	LogBase::Inst( new QuietLog ) ;
+
+	BOOST_REQUIRE_EQUAL( warnings.size(), 1u ) ;
+	BOOST_CHECK( warnings[0].find( "another top-level folder" ) != std::string::npos ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Bench.hh"
+
+#include "base/Resource.hh"
+
+#include <boost/format.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace gr ;
+
+namespace
+{
+	/// the paths as they were built before folders cached theirs: by
+	/// walking up to the root on every call
+	fs::path WalkPath( const Resource *r )
+	{
+		return r->Parent() != 0 ? WalkPath( r->Parent() ) / r->Name() : fs::path( r->Name() ) ;
+	}
+
+	fs::path WalkRelPath( const Resource *r )
+	{
+		return r->Parent() != 0 && !r->Parent()->IsRoot() ? WalkRelPath( r->Parent() ) / r->Name() : fs::path( r->Name() ) ;
+	}
+
+	/// the size of all the paths, so that building them isn't optimised away
+	std::size_t Paths( const std::vector<Resource*>& nodes, bool walk )
+	{
+		std::size_t size = 0 ;
+		for ( std::size_t i = 0 ; i < nodes.size() ; i++ )
+		{
+			if ( walk )
+				size += WalkPath( nodes[i] ).native().size() + WalkRelPath( nodes[i] ).native().size() ;
+			else
+				size += nodes[i]->Path().native().size() + nodes[i]->RelPath().native().size() ;
+		}
+		return size ;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( PathBenchTest )
+
+/// Path() and RelPath() of every node of a tree of 50 chains of 20 nested
+/// folders, with files in every folder. GR_BENCH_NODES (1M by default)
+/// sets the number of nodes, GR_BENCH_RUNS the passes over them.
+BOOST_AUTO_TEST_CASE( TestLargeTree )
+{
+	if ( !test::Bench() )
+		return ;
+
+	const long chains = 50, depth = 20 ;
+	long nodes = test::BenchParam( "GR_BENCH_NODES", 1000000 ) ;
+	long runs = test::BenchParam( "GR_BENCH_RUNS", 3 ) ;
+	long files = std::max( nodes / ( chains * depth ) - 1, 0L ) ;
+
+	Resource root( fs::path( "/home/user/drive" ) ) ;
+	std::vector<Resource*> all ;
+	for ( long c = 0 ; c < chains ; c++ )
+	{
+		Resource *folder = &root ;
+		for ( long d = 0 ; d < depth ; d++ )
+		{
+			Resource *sub = new Resource( ( boost::format( "folder-%02d-%02d" ) % c % d ).str(), "folder" ) ;
+			folder->AddChild( sub ) ;
+			all.push_back( sub ) ;
+			folder = sub ;
+
+			for ( long f = 0 ; f < files ; f++ )
+			{
+				Resource *file = new Resource( ( boost::format( "report-%04d-final-version.txt" ) % f ).str(), "file" ) ;
+				folder->AddChild( file ) ;
+				all.push_back( file ) ;
+			}
+		}
+	}
+	std::cout << "tree of " << all.size() << " nodes, " << depth << " levels deep, " << runs << " runs" << std::endl ;
+
+	test::Stopwatch walk ;
+	std::size_t walked = 0 ;
+	for ( long r = 0 ; r < runs ; r++ )
+		walked = Paths( all, true ) ;
+	test::Report( "paths walked up to the root", walk.Seconds(), runs ) ;
+
+	test::Stopwatch first ;
+	std::size_t cached = Paths( all, false ) ;
+	test::Report( "cached paths, first pass", first.Seconds() ) ;
+
+	test::Stopwatch next ;
+	for ( long r = 0 ; r < runs ; r++ )
+		cached = Paths( all, false ) ;
+	test::Report( "cached paths, next passes", next.Seconds(), runs ) ;
+
+	BOOST_CHECK_EQUAL( cached, walked ) ;
+	BOOST_CHECK_EQUAL( all.back()->Path(), WalkPath( all.back() ) ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
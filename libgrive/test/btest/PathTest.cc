@@ -0,0 +1,63 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "base/Resource.hh"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace gr ;
+
+BOOST_AUTO_TEST_SUITE( PathTest )
+
+BOOST_AUTO_TEST_CASE( TestDeepPaths )
+{
+	Resource root( fs::path( "/drive" ) ) ;
+	Resource *folder = &root ;
+	fs::path rel ;
+	for ( int i = 0 ; i < 20 ; i++ )
+	{
+		Resource *sub = new Resource( "d" + std::to_string( i ), "folder" ) ;
+		folder->AddChild( sub ) ;
+		folder = sub ;
+		rel /= sub->Name() ;
+	}
+	Resource *file = new Resource( "file.txt", "file" ) ;
+	folder->AddChild( file ) ;
+
+	BOOST_CHECK_EQUAL( file->RelPath(), rel / "file.txt" ) ;
+	BOOST_CHECK_EQUAL( file->Path(), "/drive" / rel / "file.txt" ) ;
+	BOOST_CHECK_EQUAL( folder->RelPath(), rel ) ;
+	BOOST_CHECK_EQUAL( root.RelPath(), "/drive" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestMovedSubtree )
+{
+	// paths built before the folder is attached must not stay
+	Resource *folder = new Resource( "docs", "folder" ) ;
+	Resource *file = new Resource( "a.txt", "file" ) ;
+	folder->AddChild( file ) ;
+	BOOST_CHECK_EQUAL( file->Path(), "docs/a.txt" ) ;
+
+	Resource root( fs::path( "/drive" ) ) ;
+	root.AddChild( folder ) ;
+	BOOST_CHECK_EQUAL( file->Path(), "/drive/docs/a.txt" ) ;
+	BOOST_CHECK_EQUAL( file->RelPath(), "docs/a.txt" ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "http/CurlAgent.hh"
+#include "http/Error.hh"
+#include "http/Header.hh"
+#include "http/Receiver.hh"
+#include "http/StringResponse.hh"
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace gr ;
+
+namespace
+{
+	void Store( std::vector<http::Receiver::Fields> *out, const http::Receiver::Fields& fields )
+	{
+		out->push_back( fields ) ;
+	}
+
+	long Notify( unsigned port )
+	{
+		http::Header hdr ;
+		hdr.Add( "X-Goog-Resource-State: change" ) ;
+
+		http::CurlAgent agent ;
+		http::StringResponse str ;
+		return agent.Post( "http://127.0.0.1:" + boost::lexical_cast<std::string>( port ) + "/notify",
+			"{}", &str, hdr ) ;
+	}
+
+	/// a client that connects and sends part of a request, then nothing
+	class Idle
+	{
+	public :
+		explicit Idle( unsigned port ) : m_fd( ::socket( AF_INET, SOCK_STREAM, 0 ) )
+		{
+			sockaddr_in addr ;
+			std::memset( &addr, 0, sizeof(addr) ) ;
+			addr.sin_family			= AF_INET ;
+			addr.sin_addr.s_addr	= htonl( INADDR_LOOPBACK ) ;
+			addr.sin_port			= htons( static_cast<uint16_t>( port ) ) ;
+			BOOST_REQUIRE( ::connect( m_fd, reinterpret_cast<sockaddr*>( &addr ), sizeof(addr) ) == 0 ) ;
+
+			const char part[] = "POST /notify HTTP/1.1\r\nX-Goog" ;
+			::send( m_fd, part, sizeof(part) - 1, MSG_NOSIGNAL ) ;
+		}
+
+		~Idle()
+		{
+			::close( m_fd ) ;
+		}
+
+	private :
+		int	m_fd ;
+	} ;
+}
+
+BOOST_AUTO_TEST_SUITE( ReceiverTest )
+
+// posts like Google Drive does for a change
+BOOST_AUTO_TEST_CASE( TestNotification )
+{
+	std::vector<http::Receiver::Fields> received ;
+	http::Receiver receiver( "127.0.0.1", 0, boost::bind( &Store, &received, _1 ) ) ;
+	BOOST_REQUIRE( receiver.Port() > 0 ) ;
+
+	http::Header hdr ;
+	hdr.Add( "X-Goog-Channel-ID: grive-1" ) ;
+	hdr.Add( "X-Goog-Channel-Token: secret" ) ;
+	hdr.Add( "X-Goog-Resource-State: change" ) ;
+
+	http::CurlAgent agent ;
+	http::StringResponse str ;
+	long code = agent.Post( "http://127.0.0.1:" + boost::lexical_cast<std::string>( receiver.Port() ) + "/notify",
+		"{}", &str, hdr ) ;
+	BOOST_CHECK_EQUAL( code, 200 ) ;
+
+	BOOST_REQUIRE_EQUAL( received.size(), 1u ) ;
+	BOOST_CHECK_EQUAL( received[0]["x-goog-channel-id"], "grive-1" ) ;
+	BOOST_CHECK_EQUAL( received[0]["x-goog-channel-token"], "secret" ) ;
+	BOOST_CHECK_EQUAL( received[0]["x-goog-resource-state"], "change" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestIdleClient )
+{
+	// the notification doesn't wait for the clients that connected before
+	std::vector<http::Receiver::Fields> received ;
+	http::Receiver receiver( "127.0.0.1", 0, boost::bind( &Store, &received, _1 ) ) ;
+	Idle first( receiver.Port() ), second( receiver.Port() ) ;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() ;
+	BOOST_CHECK_EQUAL( Notify( receiver.Port() ), 200 ) ;
+	BOOST_CHECK( std::chrono::steady_clock::now() - start < std::chrono::seconds( 2 ) ) ;
+	BOOST_REQUIRE_EQUAL( received.size(), 1u ) ;
+	BOOST_CHECK_EQUAL( received[0]["x-goog-resource-state"], "change" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestBadAddress )
+{
+	std::vector<http::Receiver::Fields> received ;
+	BOOST_CHECK_THROW( http::Receiver( "localhost", 0, boost::bind( &Store, &received, _1 ) ), http::Error ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
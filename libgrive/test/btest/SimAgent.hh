@@ -0,0 +1,299 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "http/Agent.hh"
+#include "http/Header.hh"
+#include "util/Crypt.hh"
+#include "util/DataStream.hh"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gr { namespace test {
+
+const std::string files_url = "https://www.googleapis.com/drive/v2/files" ;
+const std::string files3_url = "https://www.googleapis.com/drive/v3/files" ;
+
+// the ID of "My Drive" in the v3 format
+const std::string root_id = "0Aroot" ;
+
+struct Item
+{
+	std::string					id ;
+	bool						is_dir ;
+	std::vector<std::string>	parents ;
+	std::string					content ;
+
+	// the title, if not the id
+	std::string					name ;
+} ;
+
+/// counters shared by an agent and its clones
+struct SimStats
+{
+	SimStats() : lists( 0 ), downloads( 0 ), stamps( 0 ) {}
+
+	std::atomic<unsigned>	lists ;
+	std::atomic<unsigned>	downloads ;
+
+	// the v2 requests for the latest change, one per sync
+	std::atomic<unsigned>	stamps ;
+
+	// the requests other than GET, as "<method> <url> <body>"
+	std::vector<std::string>	changes ;
+	std::mutex					mutex ;
+} ;
+
+/*!	\brief	a local stand-in for Google Drive
+
+	Serves a fixed tree of files in the Drive v2 or v3 format, two items per
+	page, and the file content with support for ranged downloads. Each request
+	can be delayed to simulate the network latency. The other requests are
+	only recorded, and answered with a new file, a push channel or an access
+	token. Tokens are granted for any refresh token but "bad".
+*/
+class SimAgent : public http::Agent
+{
+public :
+	explicit SimAgent( const std::vector<Item>& items, unsigned delay_ms = 0 ) :
+		m_items	( items ),
+		m_delay	( delay_ms ),
+		m_stats	( new SimStats )
+	{
+	}
+
+	http::ResponseLog* GetLog() const { return 0 ; }
+	void SetLog( http::ResponseLog* ) {}
+
+	long Request(
+		const std::string&	method,
+		const std::string&	url,
+		SeekStream			*in,
+		DataStream			*dest,
+		const http::Header&	hdr,
+		u64_t				)
+	{
+		if ( m_delay > 0 )
+			std::this_thread::sleep_for( std::chrono::milliseconds( m_delay ) ) ;
+
+		bool v3 = url.find( "/drive/v3/" ) != std::string::npos ;
+		if ( method != "GET" )
+			return Change( method, url, in, dest ) ;
+		if ( v3 && url.find( "/root?" ) != std::string::npos )
+			return Reply( "{\"id\":\"" + root_id + "\"}", dest ) ;
+		if ( v3 && url.find( "/startPageToken" ) != std::string::npos )
+			return Reply( "{\"startPageToken\":\"8\"}", dest ) ;
+		if ( v3 && url.find( "/changes?" ) != std::string::npos )
+			return Reply( "{\"newStartPageToken\":\"9\",\"changes\":[]}", dest ) ;
+
+		std::size_t media = url.find( "?alt=media" ) ;
+		if ( media != std::string::npos )
+			return Content( url.substr( files_url.size() + 1, media - files_url.size() - 1 ), dest, hdr ) ;
+
+		// only asked for the latest change
+		if ( url.find( "/changes?" ) != std::string::npos )
+		{
+			if ( url.find( "maxResults=1&" ) != std::string::npos )
+				m_stats->stamps++ ;
+			std::string s = "{\"largestChangeId\":\"7\",\"items\":[]}" ;
+			dest->Write( s.c_str(), s.size() ) ;
+			return 200 ;
+		}
+
+		m_stats->lists++ ;
+
+		// "'<id>' in parents", only the folders or everything
+		std::string parent ;
+		bool folders = url.find( "mimeType%3d" ) != std::string::npos ;
+		std::size_t q = url.find( "%27" ) ;
+		if ( q != std::string::npos && !folders )
+			parent = url.substr( q + 3, url.find( "%27", q + 3 ) - q - 3 ) ;
+		if ( parent == root_id )
+			parent = "root" ;
+
+		std::size_t page = 0 ;
+		std::size_t p = url.find( "&pageToken=" ) ;
+		if ( p != std::string::npos )
+			page = std::atoi( url.c_str() + p + 11 ) ;
+
+		std::vector<const Item*> match ;
+		for ( std::size_t i = 0 ; i < m_items.size() ; i++ )
+		{
+			const std::vector<std::string>& ps = m_items[i].parents ;
+			if ( folders ? m_items[i].is_dir : parent.empty() || std::find( ps.begin(), ps.end(), parent ) != ps.end() )
+				match.push_back( &m_items[i] ) ;
+		}
+
+		std::ostringstream out ;
+		out << ( v3 ? "{\"files\":[" : "{\"items\":[" ) ;
+		for ( std::size_t i = page * 2 ; i < match.size() && i < page * 2 + 2 ; i++ )
+			out << ( i > page * 2 ? "," : "" ) << ( v3 ? Json3( *match[i] ) : Json( *match[i] ) ) ;
+		out << "]" ;
+		if ( match.size() > page * 2 + 2 && v3 )
+			out << ",\"nextPageToken\":\"" << page + 1 << "\"" ;
+		else if ( match.size() > page * 2 + 2 )
+			out << ",\"nextLink\":\"" << url.substr( 0, p ) << "&pageToken=" << page + 1 << "\"" ;
+		out << "}" ;
+		return Reply( out.str(), dest ) ;
+	}
+
+	std::string LastError() const { return "" ; }
+	std::string LastErrorHeaders() const { return "" ; }
+	std::string RedirLocation() const { return "" ; }
+	std::string Escape( const std::string& str ) { return str ; }
+	std::string Unescape( const std::string& str ) { return str ; }
+	void SetProgressReporter( Progress* ) {}
+
+	std::unique_ptr<http::Agent> Clone() const
+	{
+		return std::unique_ptr<http::Agent>( new SimAgent( *this ) ) ;
+	}
+
+	SimStats& Stats() const { return *m_stats ; }
+
+private :
+	static long Reply( const std::string& s, DataStream *dest )
+	{
+		dest->Write( s.c_str(), s.size() ) ;
+		return 200 ;
+	}
+
+	/// record the request and answer with a new file, in the v3 format
+	long Change( const std::string& method, const std::string& url, SeekStream *in, DataStream *dest )
+	{
+		std::string body ;
+		char buf[4096] ;
+		std::size_t n ;
+		while ( in != 0 && ( n = in->Read( buf, sizeof(buf) ) ) > 0 )
+			body.append( buf, n ) ;
+		{
+			std::lock_guard<std::mutex> lock( m_stats->mutex ) ;
+			m_stats->changes.push_back( method + " " + url + " " + body ) ;
+		}
+
+		if ( url.find( "/oauth2/token" ) != std::string::npos )
+			return body.find( "refresh_token=bad&" ) != std::string::npos ?
+				400 : Reply( "{\"access_token\":\"token\"}", dest ) ;
+		// expires in 2100
+		if ( url.find( "/watch?" ) != std::string::npos )
+			return Reply( "{\"resourceId\":\"resource\",\"expiration\":\"4102444800000\"}", dest ) ;
+
+		Item item = { "new", false, std::vector<std::string>( 1, "root" ), "" } ;
+		return Reply( Json3( item ), dest ) ;
+	}
+
+	long Content( const std::string& id, DataStream *dest, const http::Header& hdr )
+	{
+		m_stats->downloads++ ;
+
+		const Item *item = 0 ;
+		for ( std::size_t i = 0 ; i < m_items.size() ; i++ )
+		{
+			if ( m_items[i].id == id )
+				item = &m_items[i] ;
+		}
+		BOOST_REQUIRE( item != 0 ) ;
+
+		std::string body = item->content ;
+		long code = 200 ;
+		for ( http::Header::iterator i = hdr.begin() ; i != hdr.end() ; ++i )
+		{
+			if ( i->compare( 0, 13, "Range: bytes=" ) == 0 )
+			{
+				std::size_t first = std::atoi( i->c_str() + 13 ) ;
+				std::size_t last = std::atoi( i->c_str() + i->find( '-' ) + 1 ) ;
+				body = body.substr( first, last - first + 1 ) ;
+				code = 206 ;
+			}
+		}
+		dest->Write( body.c_str(), body.size() ) ;
+		return code ;
+	}
+
+	static std::string Title( const Item& item )
+	{
+		return item.name.empty() ? item.id : item.name ;
+	}
+
+	static std::string Json( const Item& item )
+	{
+		std::ostringstream out ;
+		out << "{\"kind\":\"drive#file\",\"id\":\"" << item.id << "\""
+			<< ",\"title\":\"" << Title( item ) << "\",\"etag\":\"e\""
+			<< ",\"selfLink\":\"" << files_url << "/" << item.id << "\""
+			<< ",\"modifiedDate\":\"2026-01-01T00:00:00.000Z\",\"editable\":true"
+			<< ",\"labels\":{\"trashed\":false}" ;
+		if ( item.is_dir )
+			out << ",\"mimeType\":\"application/vnd.google-apps.folder\"" ;
+		else
+			out << ",\"mimeType\":\"text/plain\",\"md5Checksum\":\"md5" << item.id << "\""
+				<< ",\"fileSize\":\"" << item.content.size() << "\""
+				<< ",\"downloadUrl\":\"" << files_url << "/" << item.id << "?alt=media\"" ;
+		out << ",\"parents\":[" ;
+		for ( std::size_t i = 0 ; i < item.parents.size() ; i++ )
+		{
+			const std::string& p = item.parents[i] ;
+			out << ( i > 0 ? "," : "" ) << "{\"isRoot\":" << ( p == "root" ? "true" : "false" )
+				<< ",\"parentLink\":\"" << files_url << "/" << p << "\"}" ;
+		}
+		out << "]}" ;
+		return out.str() ;
+	}
+
+	static std::string Json3( const Item& item )
+	{
+		std::ostringstream out ;
+		out << "{\"id\":\"" << item.id << "\",\"name\":\"" << Title( item ) << "\""
+			<< ",\"version\":\"1\",\"modifiedTime\":\"2026-01-01T00:00:00.000Z\""
+			<< ",\"trashed\":false,\"capabilities\":{\"canEdit\":true}" ;
+		if ( item.is_dir )
+			out << ",\"mimeType\":\"application/vnd.google-apps.folder\"" ;
+		else
+		{
+			crypt::MD5 md5 ;
+			md5.Write( item.content.data(), item.content.size() ) ;
+			out << ",\"mimeType\":\"text/plain\",\"md5Checksum\":\"" << md5.Get().Hex() << "\""
+				<< ",\"size\":\"" << item.content.size() << "\"" ;
+		}
+		out << ",\"parents\":[" ;
+		for ( std::size_t i = 0 ; i < item.parents.size() ; i++ )
+			out << ( i > 0 ? "," : "" ) << "\"" << ( item.parents[i] == "root" ? root_id : item.parents[i] ) << "\"" ;
+		out << "]}" ;
+		return out.str() ;
+	}
+
+private :
+	std::vector<Item>			m_items ;
+	unsigned					m_delay ;
+	std::shared_ptr<SimStats>	m_stats ;
+} ;
+
+} } // end of namespace gr::test
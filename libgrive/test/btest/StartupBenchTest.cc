@@ -0,0 +1,135 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "Bench.hh"
+#include "TestDir.hh"
+
+#include "base/State.hh"
+#include "json/Val.hh"
+
+#ifdef HAVE_BFD
+#include "bfd/Backtrace.hh"
+#endif
+
+#include <boost/format.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+
+using namespace gr ;
+
+namespace
+{
+	/// options like those of the config file, looked up by key
+	Val Options()
+	{
+		Val options ;
+		for ( int i = 0 ; i < 20 ; i++ )
+			options.Add( ( boost::format( "option-%02d" ) % i ).str(), Val( i ) ) ;
+		return options ;
+	}
+
+	struct Fixture : test::TestDir
+	{
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( StartupBenchTest, Fixture )
+
+/// A State on a root with no state file and no .griveignore, as the first
+/// sync of a root and every MultiRoot poll build. GR_BENCH_RUNS sets the
+/// number of States.
+BOOST_AUTO_TEST_CASE( TestState )
+{
+	if ( !test::Bench() )
+		return ;
+
+	long runs = test::BenchParam( "GR_BENCH_RUNS", 5000 ) ;
+	Val options ;
+	options.Add( "path", Val( dir.string() ) ) ;
+
+	test::Stopwatch sw ;
+	for ( long i = 0 ; i < runs ; i++ )
+		State state( dir, options ) ;
+	test::Report( "State of an empty root", sw.Seconds(), runs ) ;
+}
+
+/// A missing option looked up with Find(), and with operator[] which throws
+/// as the lookups in State, Entry2 and Config did before. Each throw also
+/// captures a backtrace when built with BFD. The times are per 1000 lookups.
+BOOST_AUTO_TEST_CASE( TestLookup )
+{
+	if ( !test::Bench() )
+		return ;
+
+	long runs = std::max( test::BenchParam( "GR_BENCH_RUNS", 100000 ), 1000L ) ;
+	const Val options = Options() ;
+
+	long found = 0 ;
+	test::Stopwatch sw ;
+	for ( long i = 0 ; i < runs ; i++ )
+	{
+		if ( options.Find( "missing" ) != 0 )
+			found++ ;
+	}
+	test::Report( "1000 missing keys, Find()", sw.Seconds(), runs / 1000 ) ;
+
+	test::Stopwatch thrown ;
+	for ( long i = 0 ; i < runs ; i++ )
+	{
+		try
+		{
+			options["missing"] ;
+			found++ ;
+		}
+		catch ( Val::Error& )
+		{
+		}
+	}
+	test::Report( "1000 missing keys, operator[] and catch", thrown.Seconds(), runs / 1000 ) ;
+	BOOST_CHECK_EQUAL( found, 0 ) ;
+}
+
+#ifdef HAVE_BFD
+/// The first backtrace printed loads the symbols of the executable, which
+/// only an exception that is reported should pay for.
+BOOST_AUTO_TEST_CASE( TestBacktrace )
+{
+	if ( !test::Bench() )
+		return ;
+
+	long runs = std::max( test::BenchParam( "GR_BENCH_RUNS", 100000 ), 1000L ) ;
+	test::Stopwatch sw ;
+	for ( long i = 0 ; i < runs ; i++ )
+		Backtrace bt ;
+	test::Report( "1000 backtraces, addresses only", sw.Seconds(), runs / 1000 ) ;
+
+	test::Stopwatch first ;
+	std::string symbols = Backtrace().ToString() ;
+	test::Report( "backtrace, first printed", first.Seconds() ) ;
+
+	test::Stopwatch next ;
+	symbols = Backtrace().ToString() ;
+	test::Report( "backtrace, next printed", next.Seconds() ) ;
+	BOOST_CHECK( !symbols.empty() ) ;
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
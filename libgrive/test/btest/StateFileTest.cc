@@ -0,0 +1,93 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "TestDir.hh"
+
+#include "base/State.hh"
+#include "json/Val.hh"
+#include "util/File.hh"
+#include "util/FileSystem.hh"
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace gr ;
+
+namespace
+{
+	const char state_json[] = "{\"change_stamp\":1,\"shard_depth\":0,\"tree\":{"
+		"\"docs\":{\"ctime\":1,\"tree\":{\"a.txt\":{\"ctime\":2,\"size\":3}}}}}" ;
+
+	struct Fixture : test::TestDir
+	{
+		Fixture()
+		{
+			Write( ".grive_state", state_json ) ;
+		}
+
+		void Save( int depth )
+		{
+			Val options ;
+			options.Add( "path",		Val( dir.string() ) ) ;
+			options.Add( "state-depth",	Val( depth ) ) ;
+			State state( dir, options ) ;
+			state.Write() ;
+		}
+
+		std::string ReadState() const
+		{
+			std::ifstream st( ( dir / ".grive_state" ).string().c_str() ) ;
+			return std::string( std::istreambuf_iterator<char>( st ), std::istreambuf_iterator<char>() ) ;
+		}
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( StateFileTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestShardsAndBack )
+{
+	Save( 1 ) ;
+	BOOST_CHECK( ReadState().find( "a.txt" ) == std::string::npos ) ;
+	BOOST_CHECK( ReadState().find( "\"shard\"" ) != std::string::npos ) ;
+	BOOST_CHECK( fs::is_directory( dir / ".grive_state.d" ) ) ;
+
+	// without "--state-depth", the depth of the last sync is kept
+	Val options ;
+	options.Add( "path",	Val( dir.string() ) ) ;
+	State( dir, options ).Write() ;
+	BOOST_CHECK( ReadState().find( "\"shard_depth\":1" ) != std::string::npos ) ;
+
+	Save( 0 ) ;
+	BOOST_CHECK( ReadState().find( "\"a.txt\":{\"ctime\":2,\"size\":3}" ) != std::string::npos ) ;
+	BOOST_CHECK( ReadState().find( "\"shard\"" ) == std::string::npos ) ;
+	BOOST_CHECK( !fs::exists( dir / ".grive_state.d" ) ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestFailedWrite )
+{
+	// the temporary file cannot be created
+	fs::create_directories( dir / ".grive_state.tmp" ) ;
+	BOOST_CHECK_THROW( Save( 0 ), File::Error ) ;
+	BOOST_CHECK_EQUAL( ReadState(), state_json ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "base/StateRecord.hh"
+#include "json/JsonParser.hh"
+#include "json/JsonWriter.hh"
+#include "util/StringStream.hh"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace gr ;
+
+namespace
+{
+	struct Fixture
+	{
+		static void Load( ValVisitor *loader, const std::string& json )
+		{
+			JsonParser parser( loader ) ;
+			parser.Parse( json.data(), json.size() ) ;
+			parser.Finish() ;
+		}
+
+		static std::string Write( const StateRecord& rec )
+		{
+			StringStream ss ;
+			JsonWriter wr( &ss ) ;
+			rec.Visit( &wr ) ;
+			return ss.Str() ;
+		}
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( StateRecordTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestLoad )
+{
+	StateRecord root ;
+	StateLoader loader( &root ) ;
+	Load( &loader, "{\"change_stamp\":42,\"ignore_regexp\":\"\",\"srv_time\":7,"
+		"\"unknown\":{\"a\":[1,{\"b\":2}]},\"tree\":{"
+		"\"a.txt\":{\"ctime\":10,\"md5\":\"900150983cd24fb0d6963f7d28e17f72\",\"size\":3,\"srv_time\":11},"
+		"\"dir\":{\"ctime\":12,\"summary\":{\"count\":1,\"hash\":\"h\",\"size\":3},\"tree\":{}},"
+		"\"sub\":{\"shard\":\"s1\"}}}" ) ;
+
+	BOOST_CHECK_EQUAL( loader.Header()["change_stamp"].Int(), 42 ) ;
+	BOOST_CHECK( !loader.Header().Has( "unknown" ) ) ;
+	BOOST_CHECK( root.Has( StateRecord::srv_time_field ) ) ;
+	BOOST_CHECK_EQUAL( root.tree.size(), 3u ) ;
+
+	const StateRecord& a = root.tree["a.txt"] ;
+	BOOST_CHECK_EQUAL( a.ctime, 10u ) ;
+	BOOST_CHECK_EQUAL( a.md5.Hex(), "900150983cd24fb0d6963f7d28e17f72" ) ;
+	BOOST_CHECK_EQUAL( a.size, 3u ) ;
+	BOOST_CHECK( !a.IsFolder() ) ;
+
+	const StateRecord& dir = root.tree["dir"] ;
+	BOOST_CHECK( dir.IsFolder() ) ;
+	BOOST_CHECK( !dir.Has( StateRecord::md5_field ) ) ;
+	BOOST_CHECK_EQUAL( dir.ctime, 12u ) ;
+	BOOST_CHECK( dir.tree.empty() ) ;
+
+	BOOST_CHECK( root.tree["sub"].IsFolder() ) ;
+	BOOST_CHECK_EQUAL( root.tree["sub"].shard, "s1" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestRoundTrip )
+{
+	// keys in order, as the DOM used to write them
+	const std::string json = "{\"srv_time\":7,\"tree\":{"
+		"\"a.txt\":{\"ctime\":10,\"md5\":\"900150983cd24fb0d6963f7d28e17f72\",\"size\":3,\"srv_time\":11},"
+		"\"dir\":{\"ctime\":12,\"tree\":{}},"
+		"\"sub\":{\"shard\":\"s1\"}}}" ;
+
+	StateRecord root ;
+	StateLoader loader( &root ) ;
+	Load( &loader, json ) ;
+	BOOST_CHECK_EQUAL( Write( root ), json ) ;
+	BOOST_CHECK_EQUAL( WriteJson( ParseJson( json ) ), json ) ;
+
+	// the folder summaries of earlier versions are not kept
+	StateRecord old ;
+	StateLoader old_loader( &old ) ;
+	Load( &old_loader, "{\"srv_time\":7,\"tree\":{\"dir\":{\"ctime\":12,"
+		"\"summary\":{\"count\":1,\"hash\":\"h\",\"size\":3},\"tree\":{}}}}" ) ;
+	BOOST_CHECK_EQUAL( Write( old ), "{\"srv_time\":7,\"tree\":{\"dir\":{\"ctime\":12,\"tree\":{}}}}" ) ;
+
+	StateRecord::Tree tree ;
+	StateLoader shard( &tree ) ;
+	Load( &shard, "{\"x\":{\"ctime\":1}}" ) ;
+	BOOST_CHECK_EQUAL( tree["x"].ctime, 1u ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,138 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "TestDir.hh"
+
+#include "base/Resource.hh"
+#include "base/State.hh"
+#include "json/Val.hh"
+#include "util/FileSystem.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <string>
+
+using namespace gr ;
+
+namespace
+{
+	struct Fixture : test::TestDir
+	{
+		Fixture()
+		{
+			fs::create_directories( dir / "docs" ) ;
+			Write( "same.txt", "same" ) ;
+			Write( "docs/edited.txt", "edited" ) ;
+			Write( "docs/new.txt", "new" ) ;
+			Write( "touched.txt", "abc" ) ;
+
+			// as left by the last sync. ctime far in the future means unchanged
+			WriteState(
+				"\"same.txt\":{\"ctime\":9999999999,\"md5\":\"x\",\"size\":4},"
+				"\"touched.txt\":{\"ctime\":0,\"md5\":\"900150983cd24fb0d6963f7d28e17f72\",\"size\":3},"
+				"\"gone.txt\":{\"ctime\":1,\"md5\":\"x\",\"size\":1},"
+				"\"docs\":{\"ctime\":1,\"tree\":{"
+					"\"edited.txt\":{\"ctime\":1,\"md5\":\"x\",\"size\":3}}}" ) ;
+		}
+
+		std::map<std::string, std::string> Status( bool hash, const Val& paths = Val() )
+		{
+			Val options ;
+			options.Add( "path", Val( dir.string() ) ) ;
+			options.Add( "no-hash", Val( !hash ) ) ;
+			if ( paths.Is<Val::Array>() )
+				options.Add( "paths", paths ) ;
+
+			State state( dir, options ) ;
+			state.FromLocal( dir ) ;
+
+			std::map<std::string, std::string> result ;
+			state.Status( boost::bind( &Fixture::Add, &result, _1, _2 ) ) ;
+			return result ;
+		}
+
+		static void Add( std::map<std::string, std::string> *result, const std::string& change, const Resource *r )
+		{
+			(*result)[r->RelPath().string()] = change ;
+		}
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( StatusTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestLocalChanges )
+{
+	std::map<std::string, std::string> s = Status( true ) ;
+
+	BOOST_CHECK_EQUAL( s.size(), 3 ) ;
+	BOOST_CHECK_EQUAL( s["docs/new.txt"], "new" ) ;
+	BOOST_CHECK_EQUAL( s["docs/edited.txt"], "changed" ) ;
+	BOOST_CHECK_EQUAL( s["gone.txt"], "deleted" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestNoHash )
+{
+	// same size and checksum, only the ctime is newer
+	std::map<std::string, std::string> s = Status( false ) ;
+
+	BOOST_CHECK_EQUAL( s.size(), 4 ) ;
+	BOOST_CHECK_EQUAL( s["touched.txt"], "changed" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestFingerprint )
+{
+	// the fingerprints decide without the checksums, which are wrong
+	Write( "a.txt", "abc" ) ;
+	Write( "b.txt", "abd" ) ;
+	WriteState(
+		"\"a.txt\":{\"ctime\":0,\"fp\":\"44bc2cf5ad770999\",\"md5\":\"x\",\"size\":3},"
+		"\"b.txt\":{\"ctime\":0,\"fp\":\"44bc2cf5ad770999\",\"md5\":\"900150983cd24fb0d6963f7d28e17f72\",\"size\":3}" ) ;
+	fs::remove_all( dir / "docs" ) ;
+	fs::remove( dir / "same.txt" ) ;
+	fs::remove( dir / "touched.txt" ) ;
+
+	std::map<std::string, std::string> s = Status( true ) ;
+
+	BOOST_CHECK_EQUAL( s.size(), 1 ) ;
+	BOOST_CHECK_EQUAL( s["b.txt"], "changed" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestPaths )
+{
+	fs::create_directories( dir / "fresh" ) ;
+	Write( "fresh/a.txt", "a" ) ;
+
+	// docs/edited.txt is not listed, so it is taken as unchanged
+	Val paths( Val::array_type ) ;
+	paths.Add( Val( std::string( "docs/new.txt" ) ) ) ;
+	paths.Add( Val( std::string( "./gone.txt" ) ) ) ;
+	paths.Add( Val( std::string( "fresh/a.txt" ) ) ) ;
+	paths.Add( Val( std::string( "missing/b.txt" ) ) ) ;
+	std::map<std::string, std::string> s = Status( true, paths ) ;
+
+	BOOST_CHECK_EQUAL( s.size(), 4 ) ;
+	BOOST_CHECK_EQUAL( s["docs/new.txt"], "new" ) ;
+	BOOST_CHECK_EQUAL( s["gone.txt"], "deleted" ) ;
+	BOOST_CHECK_EQUAL( s["fresh"], "new" ) ;
+	BOOST_CHECK_EQUAL( s["fresh/a.txt"], "new" ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,223 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "SimAgent.hh"
+#include "TestDir.hh"
+
+#include "base/Feed.hh"
+#include "base/FolderLister.hh"
+#include "base/State.hh"
+#include "drive3/CommonUri.hh"
+#include "drive3/Entry3.hh"
+#include "drive3/Syncer3.hh"
+#include "json/JsonParser.hh"
+#include "json/Val.hh"
+#include "util/FileSystem.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace gr ;
+using namespace gr::test ;
+
+namespace
+{
+	struct Fixture : TestDir
+	{
+		Fixture()
+		{
+			Add( "a",		true,	"root",	"" ) ;
+			Add( "b",		true,	"a",	"" ) ;
+			Add( "f1",		false,	"root",	"one" ) ;
+			Add( "f2",		false,	"a",	"two" ) ;
+			Add( "f3",		false,	"a",	"three" ) ;
+			Add( "f4",		false,	"b",	"four" ) ;
+		}
+
+		void Add( const std::string& id, bool is_dir, const std::string& parent, const std::string& content )
+		{
+			Item item = { id, is_dir, std::vector<std::string>( 1, parent ), content } ;
+			items.push_back( item ) ;
+		}
+
+		static void Collect( std::set<std::string> *out, const Entry& e )
+		{
+			out->insert( e.SelfHref() + " in " + e.ParentHref() ) ;
+		}
+
+		std::vector<Item>	items ;
+	} ;
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( Syncer3Test, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestEntry )
+{
+	v3::Entry3 file( ParseJson(
+		"{\"id\":\"x1\",\"name\":\"a.txt\",\"mimeType\":\"text/plain\","
+		"\"md5Checksum\":\"" + Md5( "aaa" ).Hex() + "\",\"size\":\"3\",\"version\":\"5\","
+		"\"modifiedTime\":\"2026-01-01T00:00:00.000Z\",\"parents\":[\"" + root_id + "\",\"p2\"],"
+		"\"capabilities\":{\"canEdit\":true}}" ), root_id ) ;
+	BOOST_CHECK_EQUAL( file.Name(), "a.txt" ) ;
+	BOOST_CHECK_EQUAL( file.ResourceID(), "x1" ) ;
+	BOOST_CHECK_EQUAL( file.SelfHref(), files_url + "/x1" ) ;
+	BOOST_CHECK_EQUAL( file.ContentSrc(), files3_url + "/x1?alt=media" ) ;
+	BOOST_CHECK( file.MD5() == Md5( "aaa" ) ) ;
+	BOOST_CHECK_EQUAL( file.Size(), 3u ) ;
+	BOOST_CHECK_EQUAL( file.ETag(), "5" ) ;
+	BOOST_CHECK( file.IsEditable() ) ;
+	BOOST_CHECK( !file.IsDir() ) ;
+	BOOST_CHECK( !file.IsRemoved() ) ;
+
+	// "My Drive" has the href of the root folder, like in v2
+	BOOST_REQUIRE_EQUAL( file.ParentHrefs().size(), 2u ) ;
+	BOOST_CHECK_EQUAL( file.ParentHrefs()[0], "root" ) ;
+	BOOST_CHECK_EQUAL( file.ParentHrefs()[1], files_url + "/p2" ) ;
+
+	v3::Entry3 folder( ParseJson(
+		"{\"id\":\"d1\",\"name\":\"docs\",\"mimeType\":\"" + v3::mime_types::folder + "\","
+		"\"modifiedTime\":\"2026-01-01T00:00:00.000Z\",\"parents\":[\"p2\"]}" ), root_id ) ;
+	BOOST_CHECK( folder.IsDir() ) ;
+	BOOST_CHECK( !folder.IsEditable() ) ;
+	BOOST_CHECK_EQUAL( folder.Size(), 0u ) ;
+
+	// no content to download
+	v3::Entry3 doc( ParseJson(
+		"{\"id\":\"g1\",\"name\":\"doc\",\"mimeType\":\"application/vnd.google-apps.document\","
+		"\"modifiedTime\":\"2026-01-01T00:00:00.000Z\"}" ), root_id ) ;
+	BOOST_CHECK( doc.IsRemoved() ) ;
+
+	v3::Entry3 change( ParseJson( "{\"fileId\":\"x1\",\"removed\":true}" ), root_id ) ;
+	BOOST_CHECK( change.IsRemoved() ) ;
+	BOOST_CHECK( change.IsChange() ) ;
+	BOOST_CHECK_EQUAL( change.ResourceID(), "x1" ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestListing )
+{
+	SimAgent agent( items ) ;
+	v3::Syncer3 syncer( &agent ) ;
+
+	// two items per page
+	std::set<std::string> all ;
+	std::unique_ptr<Feed> feed = syncer.GetAll() ;
+	unsigned pages = 0 ;
+	while ( feed->GetNext( &agent ) )
+	{
+		pages++ ;
+		for ( Feed::iterator i = feed->begin() ; i != feed->end() ; ++i )
+			Collect( &all, *i ) ;
+	}
+	BOOST_CHECK_EQUAL( pages, 3u ) ;
+	BOOST_CHECK_EQUAL( all.size(), items.size() ) ;
+	BOOST_CHECK( all.count( files_url + "/f1 in root" ) == 1 ) ;
+	BOOST_CHECK( all.count( files_url + "/f4 in " + files_url + "/b" ) == 1 ) ;
+
+	std::set<std::string> tree ;
+	FolderLister lister( &syncer, 2 ) ;
+	lister.Run( boost::bind( &Fixture::Collect, &tree, _1 ) ) ;
+	BOOST_CHECK( tree == all ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestRequests )
+{
+	items.clear() ;
+	Add( "a.txt",		false,	"root",	"aaa" ) ;
+	Add( "gone.txt",	false,	"root",	"ggg" ) ;
+
+	Write( "a.txt", "aaa" ) ;
+	Write( "b.txt", "bbb" ) ;
+	Write( "c.txt", "aaa" ) ;
+
+	// gone.txt was deleted locally since the last sync
+	WriteState( "\"a.txt\":" + Record( "aaa", 1767225600 ) + ","
+		"\"gone.txt\":" + Record( "ggg", 1767225600 ) ) ;
+
+	Val options ;
+	options.Add( "path",				Val( dir.string() ) ) ;
+	options.Add( "state-depth",			Val( 0 ) ) ;
+	options.Add( "no-remote-new",		Val( false ) ) ;
+	options.Add( "upload-only",			Val( false ) ) ;
+	options.Add( "no-delete-remote",	Val( false ) ) ;
+	options.Add( "new-rev",				Val( false ) ) ;
+
+	SimAgent agent( items ) ;
+	v3::Syncer3 syncer( &agent ) ;
+	{
+		State state( dir, options ) ;
+		state.FromLocal( dir ) ;
+		std::unique_ptr<Feed> feed = syncer.GetAll() ;
+		while ( feed->GetNext( &agent ) )
+			std::for_each( feed->begin(), feed->end(), boost::bind( &State::FromRemote, &state, _1 ) ) ;
+		state.ResolveEntry() ;
+		state.Sync( &syncer, options ) ;
+	}
+
+	std::vector<std::string>& changes = agent.Stats().changes ;
+	BOOST_REQUIRE_EQUAL( changes.size(), 3u ) ;
+	std::sort( changes.begin(), changes.end() ) ;
+
+	// trashed, not deleted
+	BOOST_CHECK_EQUAL( changes[0], "PATCH " + files3_url + "/gone.txt?fields=id {\"trashed\":true}" ) ;
+
+	// c.txt has the content of a.txt
+	BOOST_CHECK_EQUAL( changes[1], "POST " + files3_url + "/a.txt/copy?fields=" + v3::fields::file +
+		" {\"name\":\"c.txt\",\"parents\":[\"root\"]}" ) ;
+
+	const std::string upload = "POST " + v3::upload_base + "?uploadType=multipart&fields=" + v3::fields::file + " " ;
+	BOOST_CHECK_EQUAL( changes[2].substr( 0, upload.size() ), upload ) ;
+	BOOST_CHECK( changes[2].find( "{\"name\":\"b.txt\",\"parents\":[\"root\"]}" ) != std::string::npos ) ;
+	BOOST_CHECK( changes[2].find( "\r\n\r\nbbb\r\n" ) != std::string::npos ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestPageToken )
+{
+	SimAgent agent( items ) ;
+	v3::Syncer3 syncer( &agent ) ;
+	BOOST_CHECK_EQUAL( syncer.GetChangeStamp( 0 ), -1 ) ;
+	BOOST_CHECK_EQUAL( syncer.GetPageToken(), "8" ) ;
+
+	// the last page of changes tells where the next ones start
+	std::unique_ptr<Feed> feed = syncer.GetChangesFrom( "8" ) ;
+	while ( feed->GetNext( &agent ) )
+		BOOST_CHECK( feed->begin() == feed->end() ) ;
+	BOOST_CHECK_EQUAL( feed->NextChanges(), "9" ) ;
+
+	// the token is kept in the state as it is
+	Val options ;
+	options.Add( "path",		Val( dir.string() ) ) ;
+	options.Add( "state-depth",	Val( 0 ) ) ;
+	{
+		State state( dir, options ) ;
+		state.PageToken( feed->NextChanges() ) ;
+		state.Write() ;
+	}
+	BOOST_CHECK_EQUAL( State( dir, options ).PageToken(), "9" ) ;
+
+	syncer.Watch( "channel", "token", "https://example.com/" ) ;
+	BOOST_REQUIRE_EQUAL( agent.Stats().changes.size(), 1u ) ;
+	BOOST_CHECK( agent.Stats().changes[0].find( "/watch?pageToken=8 " ) != std::string::npos ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "util/Crypt.hh"
+#include "util/FileSystem.hh"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace gr { namespace test {
+
+// a change time in the state that makes any file count as unchanged
+const long long future = 9999999999LL ;
+
+inline Digest Md5( const std::string& content )
+{
+	crypt::MD5 md5 ;
+	md5.Write( content.data(), content.size() ) ;
+	return md5.Get() ;
+}
+
+/*!	\brief	a temporary directory to sync, removed at the end of the test
+
+	Derive the fixture from it. The directory exists by the time the members
+	of the fixture are initialized.
+*/
+struct TestDir
+{
+	TestDir() :
+		dir	( fs::temp_directory_path() / fs::unique_path( "grive-test-%%%%-%%%%" ) )
+	{
+		fs::create_directories( dir ) ;
+	}
+
+	~TestDir()
+	{
+		fs::remove_all( dir ) ;
+	}
+
+	/// Write \a content to the file \a name, relative to the directory.
+	void Write( const std::string& name, const std::string& content ) const
+	{
+		std::ofstream f( ( dir / name ).string().c_str(), std::ios::binary ) ;
+		f << content ;
+	}
+
+	/// Write the state file of the last sync, with \a tree as its tree, in a
+	/// single file.
+	void WriteState( const std::string& tree ) const
+	{
+		Write( ".grive_state", "{\"change_stamp\":1,\"shard_depth\":0,\"tree\":{" + tree + "}}" ) ;
+	}
+
+	/// The state record of an unchanged file with \a content. The server time
+	/// is left out if \a srv_time is negative.
+	static std::string Record( const std::string& content, long long srv_time = -1 )
+	{
+		std::ostringstream ss ;
+		ss << "{\"ctime\":" << future << ",\"md5\":\"" << Md5( content )
+			<< "\",\"size\":" << content.size() ;
+		if ( srv_time >= 0 )
+			ss << ",\"srv_time\":" << srv_time ;
+		ss << "}" ;
+		return ss.str() ;
+	}
+
+	/// The state record of an unchanged folder, with \a tree as its tree.
+	static std::string Folder( const std::string& tree )
+	{
+		std::ostringstream ss ;
+		ss << "{\"ctime\":" << future << ",\"tree\":{" << tree << "}}" ;
+		return ss.str() ;
+	}
+
+	fs::path	dir ;
+} ;
+
+} } // end of namespace gr::test
@@ -51,4 +51,25 @@ BOOST_AUTO_TEST_CASE( TestMap )
 	BOOST_CHECK_EQUAL( obj["key"].As<std::string>(), "value" ) ;
 }
 
+BOOST_AUTO_TEST_CASE( TestFind )
+{
+	Val obj(( Val::Object() )) ;
+	obj.Add( "key", Val( std::string("value") ) ) ;
+	obj.Add( "num", Val( 42 ) ) ;
+
+	BOOST_CHECK( obj.Find( "key" ) == &obj["key"] ) ;
+	BOOST_CHECK( obj.Find( "none" ) == 0 ) ;
+	BOOST_CHECK( Val( 1 ).Find( "key" ) == 0 ) ;
+
+	int num = 0 ;
+	BOOST_CHECK( obj.TryGet( "num", num ) ) ;
+	BOOST_CHECK_EQUAL( num, 42 ) ;
+
+	// absent or of another type: left unchanged
+	std::string str = "default" ;
+	BOOST_CHECK( !obj.TryGet( "none", str ) ) ;
+	BOOST_CHECK( !obj.TryGet( "num", str ) ) ;
+	BOOST_CHECK_EQUAL( str, "default" ) ;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
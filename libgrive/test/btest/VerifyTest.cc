@@ -0,0 +1,140 @@
+/*
+	grive: an GPL program to sync a local directory with Google Drive
+	Copyright (C) 2026  grive2 contributors
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "TestDir.hh"
+
+#include "base/Resource.hh"
+#include "base/State.hh"
+#include "base/Verifier.hh"
+#include "json/Val.hh"
+#include "util/FileSystem.hh"
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <stdexcept>
+#include <string>
+
+using namespace gr ;
+
+namespace
+{
+	struct Fixture : test::TestDir
+	{
+		Fixture() :
+			journal	( dir / ".grive_verify" )
+		{
+			fs::create_directories( dir / "docs" ) ;
+			Write( "a.txt", "abc" ) ;
+			Write( "docs/b.txt", "" ) ;
+			Write( "docs/c.txt", "message digest" ) ;
+
+			Val options ;
+			options.Add( "path", Val( dir.string() ) ) ;
+			state.reset( new State( dir, options ) ) ;
+			state->FromLocal( dir ) ;
+		}
+
+		std::size_t AddAll( Verifier& v )
+		{
+			std::size_t count = 0 ;
+			for ( State::iterator i = state->begin() ; i != state->end() ; ++i )
+				if ( !(*i)->IsFolder() && v.Add( *i ) )
+					count++ ;
+			return count ;
+		}
+
+		static void Collect( std::map<std::string, std::string> *result, Resource *r, const Digest& md5 )
+		{
+			(*result)[r->RelPath().string()] = md5.Hex() ;
+		}
+
+		// stops at the second file
+		static void Interrupt( std::map<std::string, std::string> *result, Resource *r, const Digest& md5 )
+		{
+			if ( !result->empty() )
+				throw std::runtime_error( "interrupted" ) ;
+			Collect( result, r, md5 ) ;
+		}
+
+		fs::path				journal ;
+		std::unique_ptr<State>	state ;
+	} ;
+}
+
+BOOST_FIXTURE_TEST_SUITE( VerifyTest, Fixture )
+
+BOOST_AUTO_TEST_CASE( TestChecksums )
+{
+	Verifier v( journal, 3, 0 ) ;
+	BOOST_CHECK_EQUAL( AddAll( v ), 3 ) ;
+
+	std::map<std::string, std::string> md5 ;
+	v.Run( boost::bind( &Fixture::Collect, &md5, _1, _2 ) ) ;
+
+	BOOST_CHECK_EQUAL( md5.size(), 3 ) ;
+	BOOST_CHECK_EQUAL( md5["a.txt"], "900150983cd24fb0d6963f7d28e17f72" ) ;
+	BOOST_CHECK_EQUAL( md5["docs/b.txt"], "d41d8cd98f00b204e9800998ecf8427e" ) ;
+	BOOST_CHECK_EQUAL( md5["docs/c.txt"], "f96b697d7cb7938d525a2f31aaf161d0" ) ;
+	BOOST_CHECK( !fs::exists( journal ) ) ;
+}
+
+BOOST_AUTO_TEST_CASE( TestResume )
+{
+	std::map<std::string, std::string> first ;
+	{
+		Verifier v( journal, 1, 0 ) ;
+		AddAll( v ) ;
+		BOOST_CHECK_THROW( v.Run( boost::bind( &Fixture::Interrupt, &first, _1, _2 ) ), std::runtime_error ) ;
+	}
+	BOOST_CHECK_EQUAL( first.size(), 1 ) ;
+
+	// only the file checked before the interruption is skipped
+	Verifier v( journal, 2, 0 ) ;
+	BOOST_CHECK_EQUAL( AddAll( v ), 2 ) ;
+
+	std::map<std::string, std::string> second ;
+	v.Run( boost::bind( &Fixture::Collect, &second, _1, _2 ) ) ;
+	BOOST_CHECK_EQUAL( second.size(), 2 ) ;
+	BOOST_CHECK_EQUAL( second.count( first.begin()->first ), 0 ) ;
+	BOOST_CHECK( !fs::exists( journal ) ) ;
+}
+
+// the downloads of --repair are not synced if they are left behind
+BOOST_AUTO_TEST_CASE( TestRepairDownloadIgnored )
+{
+	Write( "docs/.c.txt.grive_verify", "message" ) ;
+	Write( ".a.txt.grive_verify", "abc" ) ;
+	Write( "docs/c.txt.grive_verify", "kept" ) ;
+
+	Val options ;
+	options.Add( "path", Val( dir.string() ) ) ;
+	State st( dir, options ) ;
+	st.FromLocal( dir ) ;
+
+	Verifier v( journal, 1, 0 ) ;
+	std::size_t count = 0 ;
+	for ( State::iterator i = st.begin() ; i != st.end() ; ++i )
+		if ( !(*i)->IsFolder() && v.Add( *i ) )
+			count++ ;
+	BOOST_CHECK_EQUAL( count, 4 ) ;
+}
+
+BOOST_AUTO_TEST_SUITE_END()